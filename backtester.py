@@ -12,19 +12,129 @@ import random
 import sys
 from config import strategy_configs, param_sets, DEFAULT_TIMEFRAME, DEFAULT_INTERVAL, DEFAULT_SPREAD_PERCENTAGE, DEFAULT_SLIPPAGE_PERCENTAGE, indicator_defaults
 
-from indicators import Indicators, calculate_atr, calculate_adx
+from indicators import Indicators, calculate_atr, calculate_adx_values
 from strategy import Strategy
 from core.data_fetcher import DataFetcher
 from core.rate_limiter import RateLimiter, get_shared_rate_limiter
+from core.indicator_cache import cached_indicator
+from core import metrics
 
 try:
-    from backtester_cython import run_backtest_cython
+    from backtester_cython import (run_backtest_cython, run_backtest_batch_cython, run_backtest_windows_cython,
+                                   run_backtest_monte_carlo_cython, run_portfolio_backtest_cython, SteppedBacktest)
     CYTHON_AVAILABLE = True
     logging.info("--- cython imported successfully ---")
 except ImportError as e:
     logging.error(f"--- cython import error: {e} ---")
     CYTHON_AVAILABLE = False
     run_backtest_cython = None
+    run_backtest_batch_cython = None
+    run_backtest_windows_cython = None
+    run_backtest_monte_carlo_cython = None
+    run_portfolio_backtest_cython = None
+    SteppedBacktest = None
+    EXIT_REASONS = {}
+else:
+    from backtester_cython import EXIT_REASONS
+
+SECONDS_PER_YEAR = 365 * 24 * 3600 # Crypto markets trade around the clock
+
+def periods_per_year(data):
+    """Number of bars per year implied by the spacing of a DatetimeIndex (0.0 if unknown)."""
+    if not isinstance(data.index, pd.DatetimeIndex) or len(data.index) < 2:
+        return 0.0
+    bar_seconds = np.median(np.diff(data.index.asi8)) / 1e9
+    return SECONDS_PER_YEAR / bar_seconds if bar_seconds > 0 else 0.0
+
+def checkpoint_interval(n, checkpoints):
+    """Bars between equity checkpoints so that at most `checkpoints` slices cover n bars (0 = none)."""
+    if checkpoints <= 0 or n == 0:
+        return 0
+    return -(-n // checkpoints) # Rounded up, or a remainder would add slices beyond `checkpoints`
+
+def walk_forward_bounds(n, n_windows):
+    """Boundaries of n_windows consecutive, near-equal windows over n bars (fewer if n is small)."""
+    n_windows = max(1, min(int(n_windows), n))
+    return np.linspace(0, n, n_windows + 1).round().astype(np.int64)
+
+def summarize_windows(windows, index, initial_capital, std_penalty=0.0):
+    """
+    JSON-friendly summary of run_backtest_windows_cython output. The robust score is the
+    mean final capital over the windows minus std_penalty times its standard deviation.
+    """
+    final_capitals = windows['final_capital']
+    mean_capital = float(np.mean(final_capitals))
+    std_capital = float(np.std(final_capitals))
+    return {
+        'windows': [
+            {
+                'start_time': str(index[row['start']]),
+                'end_time': str(index[row['end'] - 1]),
+                'bars': int(row['end'] - row['start']),
+                'final_capital': float(row['final_capital']),
+                'total_profit_percentage': float(row['total_profit_percentage']),
+                'total_trades': int(row['total_trades']),
+                'win_rate': float(row['win_rate']),
+                'max_drawdown': float(row['max_drawdown']),
+                'sharpe_ratio': float(row['sharpe_ratio']),
+                'sortino_ratio': float(row['sortino_ratio']),
+                'backtest_trend': 'UP' if row['backtest_trend'] == 1 else 'DOWN',
+            }
+            for row in windows
+        ],
+        'mean_final_capital': mean_capital,
+        'std_final_capital': std_capital,
+        'profitable_windows': int(np.sum(final_capitals > initial_capital)),
+        'robust_score': mean_capital - std_penalty * std_capital,
+    }
+
+def _distribution(values):
+    """Mean, spread and percentiles of one Monte Carlo outcome."""
+    p5, p25, p50, p75, p95 = np.percentile(values, [5, 25, 50, 75, 95])
+    return {
+        'mean': float(np.mean(values)),
+        'std': float(np.std(values)),
+        'min': float(np.min(values)),
+        'p5': float(p5),
+        'p25': float(p25),
+        'p50': float(p50),
+        'p75': float(p75),
+        'p95': float(p95),
+        'max': float(np.max(values)),
+    }
+
+def summarize_monte_carlo(paths, initial_capital):
+    """JSON-friendly summary of run_backtest_monte_carlo_cython output (distributions over the paths)."""
+    final_capitals = paths['final_capital']
+
+    def profit_percentage(capital):
+        return float((capital - initial_capital) / initial_capital * 100.0) if initial_capital else 0.0
+
+    return {
+        'paths': int(len(paths)),
+        'final_capital': _distribution(final_capitals),
+        'max_drawdown': _distribution(paths['max_drawdown']),
+        'total_trades': _distribution(paths['total_trades']),
+        'loss_probability': float(np.mean(final_capitals < initial_capital)),
+        'median_profit_percentage': profit_percentage(np.median(final_capitals)),
+        'p5_profit_percentage': profit_percentage(np.percentile(final_capitals, 5)),
+    }
+
+def trades_to_records(trades, index):
+    """Converts the native trade buffer into JSON-friendly dictionaries."""
+    return [
+        {
+            'entry_time': str(index[trade['entry_index']]),
+            'exit_time': str(index[trade['exit_index']]),
+            'direction': 'long' if trade['direction'] == 1 else 'short',
+            'entry_price': float(trade['entry_price']),
+            'exit_price': float(trade['exit_price']),
+            'size': float(trade['size']),
+            'profit_loss': float(trade['profit_loss']),
+            'exit_reason': EXIT_REASONS.get(int(trade['exit_reason']), 'unknown'),
+        }
+        for trade in trades
+    ]
 
 class Backtester:
     def __init__(self, strategy, config, data_fetcher=None):
@@ -40,9 +150,11 @@ class Backtester:
         else:
             self.data_fetcher = data_fetcher
         self.data = None # Data will be fetched later
+        self.indicator_cache = None # Optional DatasetIndicatorCache bound to self.data
 
-    def set_data(self, data):
+    def set_data(self, data, indicator_cache=None):
         self.data = data
+        self.indicator_cache = indicator_cache
 
     def fetch_data(self, symbol: str, interval: str, start_date: datetime, end_date: datetime):
         """Fetches historical klines data using the internal DataFetcher."""
@@ -60,28 +172,51 @@ class Backtester:
         df = df[['open', 'high', 'low', 'close']].astype(float)
         return df
 
-    def run_backtest(self, params):
-        logging.info("Backtester.run_backtest started.")
-        if not CYTHON_AVAILABLE:
-            logging.error("Cython backtester not available. Please compile it first.")
-            return None
-
+    def _native_inputs(self, params):
+        """Close prices, the four signal arrays, ATR values and the ADX frame the native loop runs on."""
         prices = self.data['close'].to_numpy(dtype=np.float64)
         
         logging.info("Generating signals...")
-        long_entry, short_entry, long_exit, short_exit = self.strategy.generate_signals(self.data, params)
+        with metrics.timer('backtest.signals'):
+            long_entry, short_entry, long_exit, short_exit = self.strategy.generate_signals(self.data, params, indicator_cache=self.indicator_cache)
         logging.info("Signals generated.")
 
-        # Convert to numpy uint8 for Cython
-        long_entry = long_entry.to_numpy(dtype=np.uint8)
-        short_entry = short_entry.to_numpy(dtype=np.uint8)
-        long_exit = long_exit.to_numpy(dtype=np.uint8)
-        short_exit = short_exit.to_numpy(dtype=np.uint8)
-
-        atr_values = calculate_atr(self.data, params.get('atr_period', indicator_defaults['atr_period'])).to_numpy(dtype=np.float64)
+        # Boolean arrays are passed as is; the Cython module reinterprets them as uint8 without copying
+        long_entry = long_entry.to_numpy()
+        short_entry = short_entry.to_numpy()
+        long_exit = long_exit.to_numpy()
+        short_exit = short_exit.to_numpy()
+
+        # ATR and ADX feed the stops and position sizing of the native loop
+        with metrics.timer('backtest.stop_indicators'):
+            atr_period = params.get('atr_period', indicator_defaults['atr_period'])
+            atr_values = cached_indicator(self.indicator_cache, 'atr', (atr_period,), lambda: calculate_atr(self.data, atr_period)).to_numpy(dtype=np.float64)
+
+            # Calculate ADX
+            adx_period = params.get('adx_period', 14) # Assuming adx_period can be a parameter
+            adx_data = cached_indicator(self.indicator_cache, 'adx', (adx_period,), lambda: calculate_adx_values(self.data, window=adx_period))
+        return prices, long_entry, short_entry, long_exit, short_exit, atr_values, adx_data
+
+    def run_backtest(self, params, record_trades=False, walk_forward_windows=0, walk_forward_std_penalty=0.0,
+                     checkpoints=0, on_checkpoint=None):
+        """
+        Runs one backtest over the loaded data. With record_trades the result also holds
+        'trades' (one dict per closed trade) and 'equity_curve' (per-bar time/equity pairs).
+        With walk_forward_windows > 1 the same signals are also evaluated over that many
+        consecutive windows in one native call and summarized under 'walk_forward'.
+        With checkpoints > 0 'equity_checkpoints' holds the equity after each of that many
+        equal slices of the bars, for reporting intermediate values to an Optuna pruner.
+        With on_checkpoint as well, the slices are simulated one at a time and
+        on_checkpoint(step, equity) is called after each; when it returns True the run
+        stops there and only {'stopped_at_checkpoint', 'bars_simulated',
+        'equity_checkpoints'} is returned.
+        """
+        logging.info("Backtester.run_backtest started.")
+        if not CYTHON_AVAILABLE:
+            logging.error("Cython backtester not available. Please compile it first.")
+            return None
 
-        # Calculate ADX
-        adx_data = calculate_adx(self.data, window=params.get('adx_period', 14)) # Assuming adx_period can be a parameter
+        prices, long_entry, short_entry, long_exit, short_exit, atr_values, adx_data = self._native_inputs(params)
         adx = adx_data['adx'].to_numpy(dtype=np.float64)
         pdi = adx_data['pdi'].to_numpy(dtype=np.float64)
         ndi = adx_data['ndi'].to_numpy(dtype=np.float64)
@@ -96,8 +231,202 @@ class Backtester:
             price_change = (prices[-1] - prices[0]) / prices[0]
             daily_volatility = abs(price_change)
 
+        checkpoint_every = checkpoint_interval(len(prices), checkpoints)
         logging.info("Calling Cython backtest module...")
-        cython_results_json = run_backtest_cython(
+        with metrics.timer('backtest.native_loop'):
+            if on_checkpoint is not None and checkpoint_every > 0:
+                # Slice by slice, so a pruned trial does not simulate the bars after its verdict
+                run = SteppedBacktest(prices, long_entry, short_entry, long_exit, short_exit, atr_values, adx, pdi, ndi,
+                                      atr_multiple, fixed_stop_loss_percentage, take_profit_multiple,
+                                      self.initial_capital, params['spread_percentage'], params['slippage_percentage'],
+                                      daily_volatility, record_trades, periods_per_year(self.data))
+                equity_checkpoints = []
+                while not run.done:
+                    equity_checkpoints.append(float(run.advance(checkpoint_every)))
+                    # No verdict on the last slice: the run is complete, stopping would save nothing
+                    if not run.done and on_checkpoint(len(equity_checkpoints), equity_checkpoints[-1]):
+                        logging.info(f"Backtest stopped at checkpoint {len(equity_checkpoints)} "
+                                     f"after {run.bars_done} of {len(prices)} bars")
+                        return {'stopped_at_checkpoint': len(equity_checkpoints), 'bars_simulated': run.bars_done,
+                                'equity_checkpoints': equity_checkpoints}
+                cython_results_json = run.results()
+                cython_results_json['equity_checkpoints'] = equity_checkpoints
+            else:
+                cython_results_json = run_backtest_cython(
+                    prices,
+                    long_entry,
+                    short_entry,
+                    long_exit,
+                    short_exit,
+                    atr_values,
+                    adx,
+                    pdi,
+                    ndi,
+                    atr_multiple,
+                    fixed_stop_loss_percentage,
+                    take_profit_multiple,
+                    self.initial_capital,
+                    params['spread_percentage'],
+                    params['slippage_percentage'],
+                    daily_volatility,
+                    record_trades,
+                    periods_per_year(self.data),
+                    checkpoint_every
+                )
+        logging.info("Cython backtest module returned.")
+
+        # The Cython module might return a JSON string or a dict (on error)
+        if isinstance(cython_results_json, str):
+            results = json.loads(cython_results_json)
+        else:
+            results = cython_results_json
+
+        if checkpoints > 0:
+            results['equity_checkpoints'] = [float(equity) for equity in results.get('equity_checkpoints', [])]
+
+        if walk_forward_windows > 1:
+            # Indicators were computed over the whole series, so each window starts warmed up
+            with metrics.timer('backtest.walk_forward'):
+                windows = run_backtest_windows_cython(
+                    prices,
+                    long_entry,
+                    short_entry,
+                    long_exit,
+                    short_exit,
+                    atr_values,
+                    pdi,
+                    ndi,
+                    walk_forward_bounds(len(prices), walk_forward_windows),
+                    atr_multiple,
+                    fixed_stop_loss_percentage,
+                    take_profit_multiple,
+                    self.initial_capital,
+                    params['spread_percentage'],
+                    params['slippage_percentage'],
+                    periods_per_year(self.data)
+                )
+            results['walk_forward'] = summarize_windows(windows, self.data.index, self.initial_capital, walk_forward_std_penalty)
+
+        if record_trades:
+            results['trades'] = trades_to_records(results['trades'], self.data.index)
+            results['equity_curve'] = [
+                {'time': str(timestamp), 'equity': float(equity)}
+                for timestamp, equity in zip(self.data.index, results['equity_curve'])
+            ]
+        return results
+
+    def run_monte_carlo(self, params, n_paths=1000, noise_fraction=0.5, cost_multiple_max=2.0, seed=0, num_threads=0):
+        """
+        Stress-tests one parameter set over n_paths perturbed copies of the loaded data in one
+        native call. Every close is jittered by normal noise of noise_fraction times the
+        standard deviation of the bar-to-bar log returns, and spread and slippage are scaled
+        by up to cost_multiple_max. Signals stay those of the observed series, so the spread
+        measures sensitivity to fill prices and costs, not whether the parameters generalize
+        (experimental; the optimizer only runs it when OPTIMIZER_MONTE_CARLO_PATHS > 0).
+        Returns the summarize_monte_carlo distributions, or None if the Cython module is unavailable.
+        """
+        if not CYTHON_AVAILABLE:
+            logging.error("Cython backtester not available. Please compile it first.")
+            return None
+
+        prices, long_entry, short_entry, long_exit, short_exit, atr_values, _ = self._native_inputs(params)
+        log_returns = np.diff(np.log(prices[prices > 0]))
+        noise_sigma = noise_fraction * float(np.std(log_returns)) if len(log_returns) > 1 else 0.0
+
+        with metrics.timer('backtest.monte_carlo'):
+            paths = run_backtest_monte_carlo_cython(
+                prices,
+                long_entry,
+                short_entry,
+                long_exit,
+                short_exit,
+                atr_values,
+                params.get('atr_multiple', indicator_defaults['atr_multiple']),
+                params.get('fixed_stop_loss_percentage', indicator_defaults['fixed_stop_loss_percentage']),
+                params.get('take_profit_multiple', indicator_defaults['take_profit_multiple']),
+                self.initial_capital,
+                params['spread_percentage'],
+                params['slippage_percentage'],
+                n_paths,
+                noise_sigma,
+                cost_multiple_max,
+                seed,
+                num_threads
+            )
+        summary = summarize_monte_carlo(paths, self.initial_capital)
+        summary.update({'noise_fraction': noise_fraction, 'cost_multiple_max': cost_multiple_max, 'seed': seed})
+        return summary
+
+    def run_backtest_batch(self, params_list, num_threads=0):
+        """
+        Runs one backtest per parameter set in params_list over the loaded data in a single
+        call to the batched Cython kernel.
+
+        All parameter sets must share spread_percentage and slippage_percentage. ATR is
+        computed once per distinct atr_period and ADX once for the whole batch.
+
+        Returns:
+            numpy structured array (dtype backtester_cython.BATCH_RESULT_DTYPE), one row per
+            parameter set in the same order, or None if the Cython module is unavailable.
+        """
+        if not CYTHON_AVAILABLE:
+            logging.error("Cython backtester not available. Please compile it first.")
+            return None
+        if not params_list:
+            raise ValueError("params_list must contain at least one parameter set.")
+
+        spread_percentage = params_list[0]['spread_percentage']
+        slippage_percentage = params_list[0]['slippage_percentage']
+        for params in params_list:
+            if params['spread_percentage'] != spread_percentage or params['slippage_percentage'] != slippage_percentage:
+                raise ValueError("All parameter sets in a batch must share spread_percentage and slippage_percentage.")
+
+        prices = np.ascontiguousarray(self.data['close'].to_numpy(dtype=np.float64))
+        n_candidates = len(params_list)
+        n = len(prices)
+
+        long_entry = np.empty((n_candidates, n), dtype=np.uint8)
+        short_entry = np.empty((n_candidates, n), dtype=np.uint8)
+        long_exit = np.empty((n_candidates, n), dtype=np.uint8)
+        short_exit = np.empty((n_candidates, n), dtype=np.uint8)
+        atr_multiple = np.empty(n_candidates, dtype=np.float64)
+        fixed_stop_loss_percentage = np.empty(n_candidates, dtype=np.float64)
+        take_profit_multiple = np.empty(n_candidates, dtype=np.float64)
+
+        logging.info(f"Generating signals for {n_candidates} parameter sets...")
+        atr_periods = []
+        for k, params in enumerate(params_list):
+            signals = self.strategy.generate_signals(self.data, params, indicator_cache=self.indicator_cache)
+            for matrix, signal in zip((long_entry, short_entry, long_exit, short_exit), signals):
+                matrix[k] = signal.to_numpy(dtype=np.uint8)
+            atr_periods.append(params.get('atr_period', indicator_defaults['atr_period']))
+            atr_multiple[k] = params.get('atr_multiple', indicator_defaults['atr_multiple'])
+            fixed_stop_loss_percentage[k] = params.get('fixed_stop_loss_percentage', indicator_defaults['fixed_stop_loss_percentage'])
+            take_profit_multiple[k] = params.get('take_profit_multiple', indicator_defaults['take_profit_multiple'])
+
+        # Share a single ATR row when every candidate uses the same period
+        atr_by_period = {
+            period: cached_indicator(self.indicator_cache, 'atr', (period,), lambda: calculate_atr(self.data, period)).to_numpy(dtype=np.float64)
+            for period in set(atr_periods)
+        }
+        if len(atr_by_period) == 1:
+            atr_values = np.ascontiguousarray(next(iter(atr_by_period.values())).reshape(1, n))
+        else:
+            atr_values = np.stack([atr_by_period[period] for period in atr_periods])
+
+        adx_period = params_list[0].get('adx_period', 14)
+        adx_data = cached_indicator(self.indicator_cache, 'adx', (adx_period,), lambda: calculate_adx_values(self.data, window=adx_period))
+        adx = np.ascontiguousarray(adx_data['adx'].to_numpy(dtype=np.float64))
+        pdi = np.ascontiguousarray(adx_data['pdi'].to_numpy(dtype=np.float64))
+        ndi = np.ascontiguousarray(adx_data['ndi'].to_numpy(dtype=np.float64))
+
+        # Calculate daily volatility for position sizing decision
+        daily_volatility = 0.0
+        if n > 1:
+            daily_volatility = abs((prices[-1] - prices[0]) / prices[0])
+
+        logging.info("Calling Cython batch backtest module...")
+        results = run_backtest_batch_cython(
             prices,
             long_entry,
             short_entry,
@@ -111,17 +440,100 @@ class Backtester:
             fixed_stop_loss_percentage,
             take_profit_multiple,
             self.initial_capital,
+            spread_percentage,
+            slippage_percentage,
+            daily_volatility,
+            num_threads
+        )
+        logging.info("Cython batch backtest module returned.")
+        return results
+
+    def run_portfolio_backtest(self, datasets, params, params_by_crypto=None, max_positions=10,
+                               min_position_value=0.0, record_trades=False):
+        """
+        Backtests several cryptos trading from one capital pool (self.initial_capital) in a
+        single native sweep.
+
+        datasets maps crypto ids to OHLC DataFrames; its order is the entry priority when
+        position slots or capital run short. The frames are aligned on the union of their
+        indexes, bars missing for a crypto carry no quote. params apply to every crypto,
+        params_by_crypto optionally overrides them per crypto; spread_percentage and
+        slippage_percentage come from params.
+
+        Returns the portfolio statistics with 'assets' keyed by crypto id and, with
+        record_trades, 'trades' (tagged with their crypto) and 'equity_curve'.
+        """
+        if not CYTHON_AVAILABLE:
+            logging.error("Cython backtester not available. Please compile it first.")
+            return None
+        if not datasets:
+            raise ValueError("datasets must contain at least one crypto.")
+
+        cryptos = list(datasets)
+        index = datasets[cryptos[0]].index
+        for crypto in cryptos[1:]:
+            index = index.union(datasets[crypto].index)
+        n_assets, n = len(cryptos), len(index)
+
+        prices = np.full((n_assets, n), np.nan)
+        long_entry = np.zeros((n_assets, n), dtype=np.uint8)
+        short_entry = np.zeros((n_assets, n), dtype=np.uint8)
+        long_exit = np.zeros((n_assets, n), dtype=np.uint8)
+        short_exit = np.zeros((n_assets, n), dtype=np.uint8)
+        atr_values = np.zeros((n_assets, n))
+        atr_multiple = np.empty(n_assets)
+        fixed_stop_loss_percentage = np.empty(n_assets)
+        take_profit_multiple = np.empty(n_assets)
+
+        logging.info(f"Generating signals for a portfolio of {n_assets} cryptos...")
+        for a, crypto in enumerate(cryptos):
+            data = datasets[crypto]
+            asset_params = {**params, **(params_by_crypto or {}).get(crypto, {})}
+            columns = index.get_indexer(data.index)
+            signals = self.strategy.generate_signals(data, asset_params)
+            for matrix, signal in zip((long_entry, short_entry, long_exit, short_exit), signals):
+                matrix[a, columns] = signal.to_numpy(dtype=np.uint8)
+            prices[a, columns] = data['close'].to_numpy(dtype=np.float64)
+            atr_period = asset_params.get('atr_period', indicator_defaults['atr_period'])
+            atr_values[a, columns] = calculate_atr(data, atr_period).to_numpy(dtype=np.float64)
+            atr_multiple[a] = asset_params.get('atr_multiple', indicator_defaults['atr_multiple'])
+            fixed_stop_loss_percentage[a] = asset_params.get('fixed_stop_loss_percentage', indicator_defaults['fixed_stop_loss_percentage'])
+            take_profit_multiple[a] = asset_params.get('take_profit_multiple', indicator_defaults['take_profit_multiple'])
+
+        logging.info("Calling Cython portfolio backtest module...")
+        results = run_portfolio_backtest_cython(
+            prices,
+            long_entry,
+            short_entry,
+            long_exit,
+            short_exit,
+            atr_values,
+            atr_multiple,
+            fixed_stop_loss_percentage,
+            take_profit_multiple,
+            self.initial_capital,
             params['spread_percentage'],
             params['slippage_percentage'],
-            daily_volatility
+            max_positions,
+            min_position_value,
+            record_trades,
+            periods_per_year(pd.DataFrame(index=index))
         )
-        logging.info("Cython backtest module returned.")
-
-        # The Cython module might return a JSON string or a dict (on error)
-        if isinstance(cython_results_json, str):
-            results = json.loads(cython_results_json)
-        else:
-            results = cython_results_json
+        logging.info("Cython portfolio backtest module returned.")
+
+        results['assets'] = {
+            crypto: {name: row[name].item() for name in row.dtype.names}
+            for crypto, row in zip(cryptos, results['assets'])
+        }
+        if record_trades:
+            records = trades_to_records(results['trades'], index)
+            for record, trade in zip(records, results['trades']):
+                record['crypto'] = cryptos[trade['asset']]
+            results['trades'] = records
+            results['equity_curve'] = [
+                {'time': str(timestamp), 'equity': float(equity)}
+                for timestamp, equity in zip(index, results['equity_curve'])
+            ]
         return results
 
 def display_results(results, params, initial_capital=100.0):
@@ -286,6 +698,9 @@ if __name__ == "__main__":
 
     # --- Search Mode Arguments ---
     parser.add_argument('--num-samples', type=int, default=1000, help='Number of random samples for parameter search.')
+    parser.add_argument('--workers', type=int, default=0, help='Worker processes for parameter search (default: half the CPU cores).')
+    parser.add_argument('--top-n', type=int, default=5, help='Best parameter sets kept and reported by parameter search.')
+    parser.add_argument('--chunk-size', type=int, default=0, help='Parameter sets per worker task (default: automatic).')
 
     # --- Single Run Parameter Arguments ---
     parser.add_argument('--short-sma-period', type=int)
@@ -322,10 +737,6 @@ if __name__ == "__main__":
         strategy_config = strategy_configs[args.strategy]
         strategy = Strategy(indicators, strategy_config)
         
-        # For multiprocessing, each process will need its own DataFetcher
-        # to avoid issues with sharing connections/rate limiters across processes.
-        # The Backtester constructor will handle creating one if not provided.
-        
         # Get param ranges
         if args.crypto in param_sets and args.param_set in param_sets[args.crypto]:
             param_ranges = param_sets[args.crypto][args.param_set]
@@ -341,42 +752,42 @@ if __name__ == "__main__":
             p_set['spread_percentage'] = DEFAULT_SPREAD_PERCENTAGE
             p_set['slippage_percentage'] = DEFAULT_SLIPPAGE_PERCENTAGE
 
-        # Define a helper function for multiprocessing to create its own backtester and fetch data
-        def run_backtest_with_data_fetch(params):
-            # Each process creates its own Backtester and DataFetcher
-            local_backtester = Backtester(strategy, app_config) # Backtester will create its own DataFetcher
-            
-            # Define a reasonable date range for backtesting, e.g., last 90 days
+        # The data is fetched once, through a rate limiter process; workers receive it in shared memory
+        from core.rate_limiter_process import start_rate_limiter_process
+        from core.parallel_sweep import run_parameter_sweep
+        request_queue = multiprocessing.Queue()
+        response_queue = multiprocessing.Queue()
+        rate_limiter_process = multiprocessing.Process(
+            target=start_rate_limiter_process,
+            args=(request_queue, response_queue, app_config),
+            daemon=True
+        )
+        rate_limiter_process.start()
+        backtester = Backtester(strategy, app_config, data_fetcher=DataFetcher(request_queue, response_queue, app_config))
+        try:
             end_date = datetime.now()
             start_date = end_date - timedelta(days=90) # Fetch data for the last 90 days
-            
-            try:
-                data = local_backtester.fetch_data(args.crypto, DEFAULT_TIMEFRAME, start_date, end_date)
-                local_backtester.set_data(data)
-                return local_backtester.run_backtest(params)
-            except Exception as e:
-                logging.error(f"Error in multiprocessing backtest for {args.crypto} with params {params}: {e}")
-                return None
+            data = backtester.fetch_data(args.crypto, DEFAULT_TIMEFRAME, start_date, end_date)
+        except Exception as e:
+            logging.error(f"Failed to fetch data for {args.crypto}: {e}")
+            exit()
+        finally:
+            rate_limiter_process.terminate()
+        logging.info(f"Successfully fetched data for {args.crypto}. Data points: {len(data)}")
 
         # Run backtests in parallel
-        num_processes = os.cpu_count() // 2 if os.cpu_count() > 1 else 1
-        with multiprocessing.Pool(processes=num_processes) as pool:
-            results_list = list(tqdm(pool.imap(run_backtest_with_data_fetch, param_grid), total=len(param_grid)))
-
-        # Find and display best results
-        best_capital = -float('inf')
-        best_params = None
-        best_results = None
-
-        for i, results in enumerate(results_list):
-            if results and results['final_capital'] > best_capital:
-                best_capital = results['final_capital']
-                best_params = param_grid[i]
-                best_results = results
-
-        if best_results:
+        num_processes = args.workers or (os.cpu_count() // 2 if os.cpu_count() > 1 else 1)
+        with tqdm(total=len(param_grid)) as progress_bar:
+            ranked = run_parameter_sweep(data, args.strategy, param_grid, num_processes, top_n=args.top_n,
+                                         chunk_size=args.chunk_size, progress=progress_bar.update)
+
+        # Display best results
+        if ranked:
+            best_params, best_results = ranked[0]
             logging.info("--- Best Results (Search Mode) ---")
             display_results(best_results, best_params)
+            for rank, (params, results) in enumerate(ranked[1:], start=2):
+                logging.info(f"  #{rank}: final capital {results['final_capital']:.2f}, {results['total_trades']} trades")
             # ... (rest of the boundary checking and saving logic)
         else:
             logging.info("No profitable parameters found in search mode.")
@@ -1,15 +1,112 @@
 import numpy as np
 cimport numpy as np
-from libc.math cimport fmax, fmin, fabs
+cimport cython
+from cython.parallel cimport prange
+from libc.math cimport fmax, fmin, fabs, sqrt, log, exp, cos, sin, M_PI
+from libc.stdlib cimport malloc, free
+from libc.string cimport memset
 
 # Define data types for Cython
 ctypedef np.float64_t DTYPE_t
 ctypedef np.uint8_t UBYTE_t
 
-cdef void update_recent_trades(double* recent_trades, int* count, double new_trade):
+# Aggregate statistics produced by one pass of the simulation loop
+cdef struct BacktestStats:
+    double final_capital
+    double total_profit_loss
+    double long_profit
+    double short_profit
+    double max_drawdown
+    int total_trades
+    int winning_trades
+    int losing_trades
+    int num_long_trades
+    int num_short_trades
+    int final_position
+
+# Why a position was closed (exit_reason field of a TradeRecord)
+cdef enum:
+    EXIT_SIGNAL = 1
+    EXIT_TRAILING_STOP = 2
+    EXIT_STOP_LOSS = 3
+    EXIT_TAKE_PROFIT = 4
+    EXIT_END_OF_DATA = 5
+
+EXIT_REASONS = {
+    EXIT_SIGNAL: 'signal',
+    EXIT_TRAILING_STOP: 'trailing_stop',
+    EXIT_STOP_LOSS: 'stop_loss',
+    EXIT_TAKE_PROFIT: 'take_profit',
+    EXIT_END_OF_DATA: 'end_of_data',
+}
+
+# One closed trade; must stay field-for-field identical to TRADE_DTYPE
+cdef struct TradeRecord:
+    np.int64_t entry_index
+    np.int64_t exit_index
+    double entry_price
+    double exit_price
+    double size
+    double profit_loss
+    np.int8_t direction  # 1: Long, -1: Short
+    np.int8_t exit_reason
+
+TRADE_DTYPE = np.dtype([
+    ('entry_index', np.int64),
+    ('exit_index', np.int64),
+    ('entry_price', np.float64),
+    ('exit_price', np.float64),
+    ('size', np.float64),
+    ('profit_loss', np.float64),
+    ('direction', np.int8),
+    ('exit_reason', np.int8),
+], align=True)
+
+# Risk metrics derived from a per-bar equity curve
+cdef struct RiskMetrics:
+    double sharpe_ratio
+    double sortino_ratio
+    Py_ssize_t max_drawdown_duration
+
+# Layout of the structured array returned by run_backtest_batch_cython (one row per candidate)
+BATCH_RESULT_DTYPE = np.dtype([
+    ('final_capital', np.float64),
+    ('total_profit_loss', np.float64),
+    ('total_profit_percentage', np.float64),
+    ('total_trades', np.int32),
+    ('winning_trades', np.int32),
+    ('losing_trades', np.int32),
+    ('win_rate', np.float64),
+    ('max_drawdown', np.float64),
+    ('long_profit', np.float64),
+    ('short_profit', np.float64),
+    ('num_long_trades', np.int32),
+    ('num_short_trades', np.int32),
+    ('final_position', np.int8),
+    ('backtest_trend', np.int8),  # 1: UP, -1: DOWN, 0: NEUTRAL
+], align=True)
+
+# Layout of the structured array returned by run_backtest_windows_cython (one row per window)
+WINDOW_RESULT_DTYPE = np.dtype(
+    [('start', np.int64), ('end', np.int64)]  # Bars [start, end) of the window
+    + [(name, BATCH_RESULT_DTYPE.fields[name][0]) for name in BATCH_RESULT_DTYPE.names]
+    + [('sharpe_ratio', np.float64), ('sortino_ratio', np.float64), ('max_drawdown_duration', np.int64)],
+    align=True)
+
+# Layout of the structured array returned by run_backtest_monte_carlo_cython (one row per path)
+MONTE_CARLO_RESULT_DTYPE = np.dtype([
+    ('final_capital', np.float64),
+    ('max_drawdown', np.float64),
+    ('total_trades', np.int32),
+    ('winning_trades', np.int32),
+    ('spread_percentage', np.float64),  # Costs drawn for the path
+    ('slippage_percentage', np.float64),
+], align=True)
+
+cdef void update_recent_trades(double* recent_trades, int* count, double new_trade) noexcept nogil:
     """Update the recent trades array with a new trade result."""
     cdef int i
-    
+
     if count[0] < 5:
         recent_trades[count[0]] = new_trade
         count[0] += 1
@@ -19,32 +116,32 @@ cdef void update_recent_trades(double* recent_trades, int* count, double new_tra
             recent_trades[i] = recent_trades[i + 1]
         recent_trades[4] = new_trade
 
-cdef double calculate_position_size(double* recent_trades, int count, 
-                                  double base_size, double min_size, double max_size):
+cdef double calculate_position_size(double* recent_trades, int count,
+                                  double base_size, double min_size, double max_size) noexcept nogil:
     """Calculate dynamic position size based on recent performance."""
     cdef int wins = 0
     cdef int i
     cdef double multiplier = 1.0
     cdef double avg_profit = 0.0
     cdef double total_profit = 0.0
-    
+
     if count < 2:
         return base_size
-    
+
     # Calculate average profit of recent trades
     for i in range(max(0, count - 3), count):
         total_profit += recent_trades[i]
-    
+
     if count >= 3:
         avg_profit = total_profit / 3.0
     else:
         avg_profit = total_profit / count
-    
+
     # Count wins in recent trades
     for i in range(max(0, count - 3), count):
         if recent_trades[i] > 0:
             wins += 1
-    
+
     # More aggressive position sizing
     if avg_profit > 5.0:  # Strong recent performance
         multiplier = 2.0  # Double position size
@@ -56,77 +153,201 @@ cdef double calculate_position_size(double* recent_trades, int count,
         multiplier = 0.3  # Significantly reduce size
     else:
         multiplier = 1.0  # Default
-    
+
     # Apply multiplier and enforce limits
     cdef double new_size = base_size * multiplier
     return fmax(min_size, fmin(max_size, new_size))
 
-def run_backtest_cython(np.ndarray[DTYPE_t, ndim=1] prices,
-                        np.ndarray[UBYTE_t, ndim=1] long_entry,
-                        np.ndarray[UBYTE_t, ndim=1] short_entry,
-                        np.ndarray[UBYTE_t, ndim=1] long_exit,
-                        np.ndarray[UBYTE_t, ndim=1] short_exit,
-                        np.ndarray[DTYPE_t, ndim=1] atr_values,
-                        np.ndarray[DTYPE_t, ndim=1] adx,
-                        np.ndarray[DTYPE_t, ndim=1] pdi,
-                        np.ndarray[DTYPE_t, ndim=1] ndi,
+cdef inline void record_trade(TradeRecord* trade, Py_ssize_t entry_index, Py_ssize_t exit_index,
+                              double entry_price, double exit_price, double size, double profit_loss,
+                              int direction, int exit_reason) noexcept nogil:
+    trade.entry_index = entry_index
+    trade.exit_index = exit_index
+    trade.entry_price = entry_price
+    trade.exit_price = exit_price
+    trade.size = size
+    trade.profit_loss = profit_loss
+    trade.direction = <np.int8_t>direction
+    trade.exit_reason = <np.int8_t>exit_reason
+
+cdef void compute_risk_metrics(const DTYPE_t* equity, Py_ssize_t n, double initial_capital,
+                               double periods_per_year, RiskMetrics* metrics) noexcept nogil:
+    """
+    Sharpe and Sortino ratios of the per-bar returns of an equity curve (risk-free rate 0,
+    annualised by sqrt(periods_per_year) when it is positive) and the longest run of bars
+    spent below a previous equity peak.
+    """
+    cdef Py_ssize_t i
+    cdef Py_ssize_t count = 0
+    cdef Py_ssize_t underwater = 0
+    cdef double previous = initial_capital
+    cdef double peak = initial_capital
+    cdef double r, delta
+    cdef double mean = 0.0
+    cdef double m2 = 0.0
+    cdef double downside_sq = 0.0
+    cdef double std, downside
+    cdef double scale = sqrt(periods_per_year) if periods_per_year > 0 else 1.0
+
+    metrics.sharpe_ratio = 0.0
+    metrics.sortino_ratio = 0.0
+    metrics.max_drawdown_duration = 0
+
+    for i in range(n):
+        if previous != 0:
+            # Welford update of the mean and variance of returns
+            r = equity[i] / previous - 1.0
+            count += 1
+            delta = r - mean
+            mean += delta / count
+            m2 += delta * (r - mean)
+            if r < 0:
+                downside_sq += r * r
+        previous = equity[i]
+
+        if equity[i] >= peak:
+            peak = equity[i]
+            underwater = 0
+        else:
+            underwater += 1
+            if underwater > metrics.max_drawdown_duration:
+                metrics.max_drawdown_duration = underwater
+
+    if count < 2:
+        return
+    std = sqrt(m2 / (count - 1))
+    downside = sqrt(downside_sq / count)
+    if std > 0:
+        metrics.sharpe_ratio = mean / std * scale
+    if downside > 0:
+        metrics.sortino_ratio = mean / downside * scale
+
+# Loop state of one simulation between two bars, so a run can stop after any bar and
+# resume (SteppedBacktest); simulate_backtest runs all bars in one go
+cdef struct SimState:
+    Py_ssize_t bar  # Next bar to simulate
+    double current_capital
+    int position  # 0: None, 1: Long, -1: Short
+    double entry_price
+    double highest_price_since_entry
+    double lowest_price_since_entry
+    double trailing_stop_loss
+    double position_size
+    double fixed_stop_loss_price
+    double take_profit_price
+    Py_ssize_t entry_index
+    int total_trades
+    int winning_trades
+    int losing_trades
+    double total_profit_loss
+    double long_profit
+    double short_profit
+    int num_long_trades
+    int num_short_trades
+    double peak_capital
+    double max_drawdown
+    double recent_trades[5]  # Track last 5 trades
+    int recent_trades_count
+    int use_fixed_sizing  # Flag for sizing method
+
+cdef void init_sim_state(SimState* state, double initial_capital, double daily_volatility) noexcept nogil:
+    """Flat account at bar 0; the sizing method is chosen once from the series' volatility."""
+    memset(state, 0, sizeof(SimState))
+    state.current_capital = initial_capital
+    state.peak_capital = initial_capital
+    # Determine sizing method based on volatility (20% daily move threshold)
+    if fabs(daily_volatility) > 0.20:
+        state.use_fixed_sizing = 1
+
+cdef void fill_backtest_stats(const SimState* state, BacktestStats* stats) noexcept nogil:
+    stats.final_capital = state.current_capital
+    stats.total_profit_loss = state.total_profit_loss
+    stats.long_profit = state.long_profit
+    stats.short_profit = state.short_profit
+    stats.max_drawdown = state.max_drawdown
+    stats.total_trades = state.total_trades
+    stats.winning_trades = state.winning_trades
+    stats.losing_trades = state.losing_trades
+    stats.num_long_trades = state.num_long_trades
+    stats.num_short_trades = state.num_short_trades
+    stats.final_position = state.position
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef void simulate_bars(const DTYPE_t* prices,
+                        const UBYTE_t* long_entry,
+                        const UBYTE_t* short_entry,
+                        const UBYTE_t* long_exit,
+                        const UBYTE_t* short_exit,
+                        const DTYPE_t* atr_values,
+                        Py_ssize_t n,
+                        Py_ssize_t stop,
                         double atr_multiple,
                         double fixed_stop_loss_percentage,
                         double take_profit_multiple,
-                        double initial_capital,
                         double spread_percentage,
                         double slippage_percentage,
-                        double daily_volatility=0.0):  # New parameter for volatility
-
-    
-
-    cdef int n = prices.shape[0]
-    cdef double current_capital = initial_capital
-    cdef int position = 0  # 0: None, 1: Long, -1: Short
-    cdef double entry_price = 0.0
-    cdef double highest_price_since_entry = 0.0
-    cdef double lowest_price_since_entry = 0.0
-    cdef double trailing_stop_loss = 0.0
-    cdef double position_size = 0.0
-    cdef double fixed_stop_loss_price = 0.0
-    cdef double take_profit_price = 0.0
-
-    cdef int total_trades = 0
-    cdef int winning_trades = 0
-    cdef int losing_trades = 0
-    cdef double total_profit_loss = 0.0
-    cdef double long_profit = 0.0
-    cdef double short_profit = 0.0
-    cdef int num_long_trades = 0
-    cdef int num_short_trades = 0
-    
+                        SimState* state,
+                        TradeRecord* trades,
+                        DTYPE_t* equity) noexcept nogil:
+    """
+    Core trade simulation loop shared by every entry point: simulates bars state.bar up
+    to stop (exclusive) of a series of n bars and leaves the state at stop. Inputs are
+    only read; the state is held in locals during the loop. When trades is not NULL it
+    must hold at least (n + 1) // 2 records and receives one record per closed trade;
+    when equity is not NULL it receives the marked-to-market capital at the close of
+    every simulated bar.
+    """
+    cdef Py_ssize_t i
+    cdef double current_capital = state.current_capital
+    cdef int position = state.position
+    cdef double entry_price = state.entry_price
+    cdef double highest_price_since_entry = state.highest_price_since_entry
+    cdef double lowest_price_since_entry = state.lowest_price_since_entry
+    cdef double trailing_stop_loss = state.trailing_stop_loss
+    cdef double position_size = state.position_size
+    cdef double fixed_stop_loss_price = state.fixed_stop_loss_price
+    cdef double take_profit_price = state.take_profit_price
+    cdef bint force_long_exit = 0
+    cdef bint force_short_exit = 0
+    cdef int forced_exit_reason = 0
+    cdef Py_ssize_t entry_index = state.entry_index
+    cdef int exit_reason
+
+    cdef int total_trades = state.total_trades
+    cdef int winning_trades = state.winning_trades
+    cdef int losing_trades = state.losing_trades
+    cdef double total_profit_loss = state.total_profit_loss
+    cdef double long_profit = state.long_profit
+    cdef double short_profit = state.short_profit
+    cdef int num_long_trades = state.num_long_trades
+    cdef int num_short_trades = state.num_short_trades
+
     # Max drawdown tracking
-    cdef double peak_capital = initial_capital
-    cdef double max_drawdown = 0.0
+    cdef double peak_capital = state.peak_capital
+    cdef double max_drawdown = state.max_drawdown
     cdef double current_drawdown = 0.0
 
     # Position sizing variables
     cdef double base_position_percentage = 0.20  # 20% base position size for dynamic
     cdef double fixed_position_percentage = 0.95  # 95% for high volatility
-    cdef double volatility_threshold = 0.20  # 20% daily move threshold
     cdef double min_position_percentage = 0.05   # 5% minimum
     cdef double max_position_percentage = 0.95   # 95% maximum
-    cdef double recent_trades[5]  # Track last 5 trades
-    cdef int recent_trades_count = 0
+    cdef double* recent_trades = state.recent_trades
+    cdef int recent_trades_count = state.recent_trades_count
     cdef double current_position_percentage = base_position_percentage
-    cdef int use_fixed_sizing = 0  # Flag for sizing method
-    
-    # Determine sizing method based on volatility
-    if fabs(daily_volatility) > volatility_threshold:
-        use_fixed_sizing = 1
+    cdef int use_fixed_sizing = state.use_fixed_sizing
 
     cdef double current_price, current_ask_price, current_bid_price
     cdef double profit_loss, exit_price, risk_amount
 
-    for i from 0 <= i < n:
+    for i in range(state.bar, stop):
         current_price = prices[i]
         current_ask_price = current_price * (1 + spread_percentage)
         current_bid_price = current_price * (1 - spread_percentage)
+        force_long_exit = 0
+        force_short_exit = 0
+        forced_exit_reason = 0
 
         # Update trailing stop loss for open positions
         if position == 1: # Long position
@@ -134,43 +355,50 @@ def run_backtest_cython(np.ndarray[DTYPE_t, ndim=1] prices,
             if atr_values[i] > 0:
                 trailing_stop_loss = highest_price_since_entry - (atr_values[i] * atr_multiple)
             if current_price <= trailing_stop_loss and trailing_stop_loss > 0:
-                long_exit[i] = 1 # Force exit
+                force_long_exit = 1 # Force exit
+                forced_exit_reason = EXIT_TRAILING_STOP
 
         elif position == -1: # Short position
             lowest_price_since_entry = fmin(lowest_price_since_entry, current_price)
             if atr_values[i] > 0:
                 trailing_stop_loss = lowest_price_since_entry + (atr_values[i] * atr_multiple)
             if current_price >= trailing_stop_loss and trailing_stop_loss > 0:
-                short_exit[i] = 1 # Force exit
+                force_short_exit = 1 # Force exit
+                forced_exit_reason = EXIT_TRAILING_STOP
 
         # Check fixed stop loss and take profit for open positions
         if position == 1: # Long position
             if current_price <= fixed_stop_loss_price and fixed_stop_loss_price > 0:
-                long_exit[i] = 1 # Force exit due to stop loss
+                force_long_exit = 1 # Force exit due to stop loss
+                forced_exit_reason = EXIT_STOP_LOSS
             elif current_price >= take_profit_price and take_profit_price > 0:
-                long_exit[i] = 1 # Force exit due to take profit
+                force_long_exit = 1 # Force exit due to take profit
+                forced_exit_reason = EXIT_TAKE_PROFIT
         elif position == -1: # Short position
             if current_price >= fixed_stop_loss_price and fixed_stop_loss_price > 0:
-                short_exit[i] = 1 # Force exit due to stop loss
+                force_short_exit = 1 # Force exit due to stop loss
+                forced_exit_reason = EXIT_STOP_LOSS
             elif current_price <= take_profit_price and take_profit_price > 0:
-                short_exit[i] = 1 # Force exit due to take profit
+                force_short_exit = 1 # Force exit due to take profit
+                forced_exit_reason = EXIT_TAKE_PROFIT
 
         if position == 0: # No open position
             if long_entry[i]:
                 position = 1
                 # Apply spread and slippage correctly - don't double apply
                 entry_price = current_price * (1 + spread_percentage + slippage_percentage)
+                entry_index = i
                 total_trades += 1
-                
+
                 # Choose position sizing method based on volatility
                 if use_fixed_sizing:
                     # High volatility: use fixed aggressive sizing
                     position_size = current_capital * fixed_position_percentage
                 else:
                     # Low volatility: use dynamic sizing based on recent performance
-                    current_position_percentage = calculate_position_size(recent_trades, recent_trades_count, 
-                                                                       base_position_percentage, 
-                                                                       min_position_percentage, 
+                    current_position_percentage = calculate_position_size(recent_trades, recent_trades_count,
+                                                                       base_position_percentage,
+                                                                       min_position_percentage,
                                                                        max_position_percentage)
                     position_size = current_capital * current_position_percentage
 
@@ -187,17 +415,18 @@ def run_backtest_cython(np.ndarray[DTYPE_t, ndim=1] prices,
                 position = -1
                 # Apply spread and slippage correctly - don't double apply
                 entry_price = current_price * (1 - spread_percentage - slippage_percentage)
+                entry_index = i
                 total_trades += 1
-                
+
                 # Choose position sizing method based on volatility
                 if use_fixed_sizing:
                     # High volatility: use fixed aggressive sizing
                     position_size = current_capital * fixed_position_percentage
                 else:
                     # Low volatility: use dynamic sizing based on recent performance
-                    current_position_percentage = calculate_position_size(recent_trades, recent_trades_count, 
-                                                                       base_position_percentage, 
-                                                                       min_position_percentage, 
+                    current_position_percentage = calculate_position_size(recent_trades, recent_trades_count,
+                                                                       base_position_percentage,
+                                                                       min_position_percentage,
                                                                        max_position_percentage)
                     position_size = current_capital * current_position_percentage
 
@@ -211,12 +440,12 @@ def run_backtest_cython(np.ndarray[DTYPE_t, ndim=1] prices,
                     trailing_stop_loss = lowest_price_since_entry + (atr_values[i] * atr_multiple)
 
         elif position == 1: # Long position
-            if long_exit[i] or i == n - 1:
+            if long_exit[i] or force_long_exit or i == n - 1:
                 # Apply spread and slippage correctly - don't double apply
                 exit_price = current_price * (1 - spread_percentage - slippage_percentage)
                 profit_loss = (exit_price - entry_price) / entry_price * position_size
                 current_capital += profit_loss
-                
+
                 # Update max drawdown tracking
                 if current_capital > peak_capital:
                     peak_capital = current_capital
@@ -224,6 +453,16 @@ def run_backtest_cython(np.ndarray[DTYPE_t, ndim=1] prices,
                 if current_drawdown > max_drawdown:
                     max_drawdown = current_drawdown
 
+                if trades != NULL:
+                    if long_exit[i]:
+                        exit_reason = EXIT_SIGNAL
+                    elif force_long_exit:
+                        exit_reason = forced_exit_reason
+                    else:
+                        exit_reason = EXIT_END_OF_DATA
+                    record_trade(&trades[num_long_trades + num_short_trades], entry_index, i, entry_price,
+                                 exit_price, position_size, profit_loss, 1, exit_reason)
+
                 total_profit_loss += profit_loss
                 long_profit += profit_loss
                 num_long_trades += 1
@@ -244,12 +483,12 @@ def run_backtest_cython(np.ndarray[DTYPE_t, ndim=1] prices,
                 take_profit_price = 0.0
 
         elif position == -1: # Short position
-            if short_exit[i] or i == n - 1:
+            if short_exit[i] or force_short_exit or i == n - 1:
                 # Apply spread and slippage correctly - don't double apply
                 exit_price = current_price * (1 + spread_percentage + slippage_percentage)
                 profit_loss = (entry_price - exit_price) / entry_price * position_size
                 current_capital += profit_loss
-                
+
                 # Update max drawdown tracking
                 if current_capital > peak_capital:
                     peak_capital = current_capital
@@ -257,6 +496,16 @@ def run_backtest_cython(np.ndarray[DTYPE_t, ndim=1] prices,
                 if current_drawdown > max_drawdown:
                     max_drawdown = current_drawdown
 
+                if trades != NULL:
+                    if short_exit[i]:
+                        exit_reason = EXIT_SIGNAL
+                    elif force_short_exit:
+                        exit_reason = forced_exit_reason
+                    else:
+                        exit_reason = EXIT_END_OF_DATA
+                    record_trade(&trades[num_long_trades + num_short_trades], entry_index, i, entry_price,
+                                 exit_price, position_size, profit_loss, -1, exit_reason)
+
                 total_profit_loss += profit_loss
                 short_profit += profit_loss
                 num_short_trades += 1
@@ -276,17 +525,184 @@ def run_backtest_cython(np.ndarray[DTYPE_t, ndim=1] prices,
                 fixed_stop_loss_price = 0.0
                 take_profit_price = 0.0
 
+        if equity != NULL:
+            # Mark the open position to the bar's close
+            if position == 1:
+                equity[i] = current_capital + (current_price - entry_price) / entry_price * position_size
+            elif position == -1:
+                equity[i] = current_capital + (entry_price - current_price) / entry_price * position_size
+            else:
+                equity[i] = current_capital
+
+    state.bar = stop if stop > state.bar else state.bar
+    state.current_capital = current_capital
+    state.position = position
+    state.entry_price = entry_price
+    state.highest_price_since_entry = highest_price_since_entry
+    state.lowest_price_since_entry = lowest_price_since_entry
+    state.trailing_stop_loss = trailing_stop_loss
+    state.position_size = position_size
+    state.fixed_stop_loss_price = fixed_stop_loss_price
+    state.take_profit_price = take_profit_price
+    state.entry_index = entry_index
+    state.total_trades = total_trades
+    state.winning_trades = winning_trades
+    state.losing_trades = losing_trades
+    state.total_profit_loss = total_profit_loss
+    state.long_profit = long_profit
+    state.short_profit = short_profit
+    state.num_long_trades = num_long_trades
+    state.num_short_trades = num_short_trades
+    state.peak_capital = peak_capital
+    state.max_drawdown = max_drawdown
+    state.recent_trades_count = recent_trades_count
+
+cdef void simulate_backtest(const DTYPE_t* prices,
+                            const UBYTE_t* long_entry,
+                            const UBYTE_t* short_entry,
+                            const UBYTE_t* long_exit,
+                            const UBYTE_t* short_exit,
+                            const DTYPE_t* atr_values,
+                            Py_ssize_t n,
+                            double atr_multiple,
+                            double fixed_stop_loss_percentage,
+                            double take_profit_multiple,
+                            double initial_capital,
+                            double spread_percentage,
+                            double slippage_percentage,
+                            double daily_volatility,
+                            BacktestStats* stats,
+                            TradeRecord* trades,
+                            DTYPE_t* equity) noexcept nogil:
+    """One whole-series run of simulate_bars from a flat account."""
+    cdef SimState state
+    init_sim_state(&state, initial_capital, daily_volatility)
+    simulate_bars(prices, long_entry, short_entry, long_exit, short_exit, atr_values, n, n,
+                  atr_multiple, fixed_stop_loss_percentage, take_profit_multiple,
+                  spread_percentage, slippage_percentage, &state, trades, equity)
+    fill_backtest_stats(&state, stats)
+
+def _price_view(values):
+    """Contiguous float64 array over values; no copy when it already is one (read-only is fine)."""
+    return np.ascontiguousarray(values, dtype=np.float64)
+
+def _signal_view(values):
+    """Contiguous uint8 array over a boolean or uint8 signal; booleans are reinterpreted, not copied."""
+    values = np.asarray(values)
+    if values.dtype == np.bool_:
+        values = values.view(np.uint8)
+    return np.ascontiguousarray(values, dtype=np.uint8)
+
+cdef object _simulate_single(prices, long_entry, short_entry, long_exit, short_exit, atr_values,
+                             double atr_multiple, double fixed_stop_loss_percentage,
+                             double take_profit_multiple, double initial_capital,
+                             double spread_percentage, double slippage_percentage,
+                             double daily_volatility, BacktestStats* stats,
+                             TradeRecord* trades, DTYPE_t* equity):
+    """
+    Binds the inputs to read-only views and runs the simulation loop once without the GIL.
+    Inputs are never copied when they are already contiguous arrays of the right dtype.
+    """
+    cdef const DTYPE_t[::1] prices_view = _price_view(prices)
+    cdef const UBYTE_t[::1] long_entry_view = _signal_view(long_entry)
+    cdef const UBYTE_t[::1] short_entry_view = _signal_view(short_entry)
+    cdef const UBYTE_t[::1] long_exit_view = _signal_view(long_exit)
+    cdef const UBYTE_t[::1] short_exit_view = _signal_view(short_exit)
+    cdef const DTYPE_t[::1] atr_view = _price_view(atr_values)
+    cdef Py_ssize_t n = prices_view.shape[0]
+
+    if (long_entry_view.shape[0] != n or short_entry_view.shape[0] != n or long_exit_view.shape[0] != n
+            or short_exit_view.shape[0] != n or atr_view.shape[0] != n):
+        raise ValueError("Signal and ATR arrays must have the same length as prices.")
+
+    if n == 0:
+        with nogil:
+            simulate_backtest(NULL, NULL, NULL, NULL, NULL, NULL, 0, atr_multiple,
+                              fixed_stop_loss_percentage, take_profit_multiple, initial_capital,
+                              spread_percentage, slippage_percentage, daily_volatility,
+                              stats, trades, equity)
+        return None
+
+    with nogil:
+        simulate_backtest(&prices_view[0], &long_entry_view[0], &short_entry_view[0],
+                          &long_exit_view[0], &short_exit_view[0], &atr_view[0], n,
+                          atr_multiple, fixed_stop_loss_percentage, take_profit_multiple,
+                          initial_capital, spread_percentage, slippage_percentage, daily_volatility,
+                          stats, trades, equity)
+    return None
+
+def run_backtest_cython(prices,
+                        long_entry,
+                        short_entry,
+                        long_exit,
+                        short_exit,
+                        atr_values,
+                        adx,
+                        pdi,
+                        ndi,
+                        double atr_multiple,
+                        double fixed_stop_loss_percentage,
+                        double take_profit_multiple,
+                        double initial_capital,
+                        double spread_percentage,
+                        double slippage_percentage,
+                        double daily_volatility=0.0,  # New parameter for volatility
+                        bint record_trades=False,
+                        double periods_per_year=0.0,
+                        Py_ssize_t checkpoint_every=0):
+    """
+    Simulates one parameter set over a price series.
+
+    Inputs may be read-only (e.g. shared memory) and boolean signals are accepted as is;
+    none of them is modified. Sharpe, Sortino and the longest drawdown (in bars) are
+    computed from the per-bar equity curve, annualised with periods_per_year when it is
+    positive. With record_trades the result also holds the closed trades ('trades', a
+    TRADE_DTYPE structured array) and the equity curve itself ('equity_curve').
+    With checkpoint_every > 0 it holds 'equity_checkpoints', the equity at the close of
+    every checkpoint_every-th bar and of the last bar, read from the same per-bar buffer
+    (no extra pass); SteppedBacktest reports the same values one slice at a time.
+    """
+    cdef Py_ssize_t n = len(prices)
+    cdef BacktestStats stats
+
+    # Output buffers, preallocated so the simulation loop never touches Python objects
+    equity_curve = np.empty(n, dtype=np.float64)
+    trades = np.empty((n + 1) // 2 if record_trades else 0, dtype=TRADE_DTYPE)
+    cdef DTYPE_t[::1] equity_view = equity_curve
+    cdef TradeRecord[::1] trades_view = trades
+    cdef DTYPE_t* equity_ptr = NULL
+    cdef TradeRecord* trades_ptr = NULL
+
+    if n > 0:
+        equity_ptr = &equity_view[0]
+        if record_trades:
+            trades_ptr = &trades_view[0]
+
+    _simulate_single(prices, long_entry, short_entry, long_exit, short_exit, atr_values,
+                     atr_multiple, fixed_stop_loss_percentage, take_profit_multiple,
+                     initial_capital, spread_percentage, slippage_percentage, daily_volatility,
+                     &stats, trades_ptr, equity_ptr)
+    return _single_results(&stats, equity_curve, trades, pdi, ndi, initial_capital, periods_per_year,
+                           record_trades, checkpoint_every)
+
+cdef dict _single_results(BacktestStats* stats, equity_curve, trades, pdi, ndi, double initial_capital,
+                          double periods_per_year, bint record_trades, Py_ssize_t checkpoint_every):
+    """The result dict of one simulated series, with risk metrics computed from its equity curve."""
+    cdef Py_ssize_t n = len(equity_curve)
+    cdef RiskMetrics risk
+    cdef DTYPE_t[::1] equity_view = equity_curve
+    cdef DTYPE_t* equity_ptr = &equity_view[0] if n > 0 else NULL
+
+    with nogil:
+        compute_risk_metrics(equity_ptr, n, initial_capital, periods_per_year, &risk)
+
     cdef double win_rate = 0.0
-    if total_trades > 0:
-        win_rate = <double>winning_trades / total_trades
+    if stats.total_trades > 0:
+        win_rate = <double>stats.winning_trades / stats.total_trades
 
     cdef double total_profit_percentage = 0.0
     if initial_capital != 0:
-        total_profit_percentage = ((current_capital - initial_capital) / initial_capital) * 100.0
-
-    # TODO: Implement proper Sharpe Ratio calculation in Cython
-    # For now, return placeholder to unblock frontend
-    cdef double sharpe_ratio = 0.0
+        total_profit_percentage = ((stats.final_capital - initial_capital) / initial_capital) * 100.0
 
     # Determine final trend state based on the last ADX values
     cdef str backtest_trend = "NEUTRAL"
@@ -296,21 +712,1095 @@ def run_backtest_cython(np.ndarray[DTYPE_t, ndim=1] prices,
         else:
             backtest_trend = "DOWN"
 
-    return {
+    results = {
         "initial_capital": initial_capital,
-        "final_capital": current_capital,
-        "total_profit_loss": total_profit_loss,
+        "final_capital": stats.final_capital,
+        "total_profit_loss": stats.total_profit_loss,
         "total_profit_percentage": total_profit_percentage,
-        "total_trades": total_trades,
-        "winning_trades": winning_trades,
-        "losing_trades": losing_trades,
+        "total_trades": stats.total_trades,
+        "winning_trades": stats.winning_trades,
+        "losing_trades": stats.losing_trades,
         "win_rate": win_rate * 100.0, # Convert to percentage
-        "sharpe_ratio": sharpe_ratio,
-        "max_drawdown": max_drawdown,
-        "long_profit": long_profit,
-        "short_profit": short_profit,
-        "num_long_trades": num_long_trades,
-        "num_short_trades": num_short_trades,
-        "final_position": position,
+        "sharpe_ratio": risk.sharpe_ratio,
+        "sortino_ratio": risk.sortino_ratio,
+        "max_drawdown": stats.max_drawdown,
+        "max_drawdown_duration": risk.max_drawdown_duration,
+        "long_profit": stats.long_profit,
+        "short_profit": stats.short_profit,
+        "num_long_trades": stats.num_long_trades,
+        "num_short_trades": stats.num_short_trades,
+        "final_position": stats.final_position,
         "backtest_trend": backtest_trend
     }
+    if record_trades:
+        results["trades"] = trades[:stats.num_long_trades + stats.num_short_trades]
+        results["equity_curve"] = equity_curve
+    if checkpoint_every > 0:
+        # Close of every checkpoint_every-th bar, and of the last bar when it ends a partial slice
+        results["equity_checkpoints"] = equity_curve[
+            np.minimum(np.arange(checkpoint_every, n + checkpoint_every, checkpoint_every), n) - 1]
+    return results
+
+cdef class SteppedBacktest:
+    """
+    run_backtest_cython in resumable steps: advance(bars) simulates the next bars without
+    the GIL and returns the marked-to-market equity after them, so a caller (the Optuna
+    pruner) can abandon a hopeless run before its last bar. results() returns the same
+    dict as run_backtest_cython once every bar has been simulated.
+    """
+    cdef object _inputs  # Keeps the arrays behind the views alive
+    cdef const DTYPE_t[::1] _prices
+    cdef const UBYTE_t[::1] _long_entry
+    cdef const UBYTE_t[::1] _short_entry
+    cdef const UBYTE_t[::1] _long_exit
+    cdef const UBYTE_t[::1] _short_exit
+    cdef const DTYPE_t[::1] _atr
+    cdef object _pdi
+    cdef object _ndi
+    cdef object _equity_curve
+    cdef object _trades
+    cdef DTYPE_t[::1] _equity_view
+    cdef TradeRecord[::1] _trades_view
+    cdef SimState _state
+    cdef Py_ssize_t _n
+    cdef double _atr_multiple
+    cdef double _fixed_stop_loss_percentage
+    cdef double _take_profit_multiple
+    cdef double _initial_capital
+    cdef double _spread_percentage
+    cdef double _slippage_percentage
+    cdef double _periods_per_year
+    cdef bint _record_trades
+
+    def __init__(self, prices, long_entry, short_entry, long_exit, short_exit, atr_values, adx, pdi, ndi,
+                 double atr_multiple, double fixed_stop_loss_percentage, double take_profit_multiple,
+                 double initial_capital, double spread_percentage, double slippage_percentage,
+                 double daily_volatility=0.0, bint record_trades=False, double periods_per_year=0.0):
+        self._inputs = (_price_view(prices), _signal_view(long_entry), _signal_view(short_entry),
+                        _signal_view(long_exit), _signal_view(short_exit), _price_view(atr_values))
+        self._prices, self._long_entry, self._short_entry, self._long_exit, self._short_exit, self._atr = self._inputs
+        self._n = self._prices.shape[0]
+        if (self._long_entry.shape[0] != self._n or self._short_entry.shape[0] != self._n
+                or self._long_exit.shape[0] != self._n or self._short_exit.shape[0] != self._n
+                or self._atr.shape[0] != self._n):
+            raise ValueError("Signal and ATR arrays must have the same length as prices.")
+        self._pdi = pdi
+        self._ndi = ndi
+        self._equity_curve = np.empty(self._n, dtype=np.float64)
+        self._trades = np.empty((self._n + 1) // 2 if record_trades else 0, dtype=TRADE_DTYPE)
+        self._equity_view = self._equity_curve
+        self._trades_view = self._trades
+        self._atr_multiple = atr_multiple
+        self._fixed_stop_loss_percentage = fixed_stop_loss_percentage
+        self._take_profit_multiple = take_profit_multiple
+        self._initial_capital = initial_capital
+        self._spread_percentage = spread_percentage
+        self._slippage_percentage = slippage_percentage
+        self._periods_per_year = periods_per_year
+        self._record_trades = record_trades
+        init_sim_state(&self._state, initial_capital, daily_volatility)
+
+    @property
+    def bars_done(self):
+        return self._state.bar
+
+    @property
+    def done(self):
+        return self._state.bar >= self._n
+
+    def advance(self, Py_ssize_t bars):
+        """Simulates up to `bars` more bars; returns the equity at the close of the last one."""
+        cdef Py_ssize_t stop = min(self._n, self._state.bar + max(bars, 0))
+        cdef TradeRecord* trades_ptr = NULL
+        cdef SimState* state = &self._state
+        if self._n == 0:
+            return self._state.current_capital
+        cdef const DTYPE_t* prices_ptr = &self._prices[0]
+        cdef const UBYTE_t* long_entry_ptr = &self._long_entry[0]
+        cdef const UBYTE_t* short_entry_ptr = &self._short_entry[0]
+        cdef const UBYTE_t* long_exit_ptr = &self._long_exit[0]
+        cdef const UBYTE_t* short_exit_ptr = &self._short_exit[0]
+        cdef const DTYPE_t* atr_ptr = &self._atr[0]
+        cdef DTYPE_t* equity_ptr = &self._equity_view[0]
+        if self._record_trades:
+            trades_ptr = &self._trades_view[0]
+        with nogil:
+            simulate_bars(prices_ptr, long_entry_ptr, short_entry_ptr, long_exit_ptr, short_exit_ptr, atr_ptr,
+                          self._n, stop, self._atr_multiple, self._fixed_stop_loss_percentage,
+                          self._take_profit_multiple, self._spread_percentage, self._slippage_percentage,
+                          state, trades_ptr, equity_ptr)
+        if self._state.bar == 0:
+            return self._state.current_capital
+        return self._equity_view[self._state.bar - 1]
+
+    def results(self):
+        """run_backtest_cython's result dict; every bar must have been simulated."""
+        cdef BacktestStats stats
+        if self._state.bar < self._n:
+            raise RuntimeError(f"{self._n - self._state.bar} bars are still to be simulated.")
+        fill_backtest_stats(&self._state, &stats)
+        return _single_results(&stats, self._equity_curve, self._trades, self._pdi, self._ndi,
+                               self._initial_capital, self._periods_per_year, self._record_trades, 0)
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef _fill_batch_results(results, BacktestStats* stats, Py_ssize_t n_candidates,
+                              double initial_capital, np.int8_t backtest_trend):
+    """Copies per-candidate statistics into the columns of the structured result array."""
+    cdef double[:] final_capital = results['final_capital']
+    cdef double[:] total_profit_loss = results['total_profit_loss']
+    cdef double[:] total_profit_percentage = results['total_profit_percentage']
+    cdef np.int32_t[:] total_trades = results['total_trades']
+    cdef np.int32_t[:] winning_trades = results['winning_trades']
+    cdef np.int32_t[:] losing_trades = results['losing_trades']
+    cdef double[:] win_rate = results['win_rate']
+    cdef double[:] max_drawdown = results['max_drawdown']
+    cdef double[:] long_profit = results['long_profit']
+    cdef double[:] short_profit = results['short_profit']
+    cdef np.int32_t[:] num_long_trades = results['num_long_trades']
+    cdef np.int32_t[:] num_short_trades = results['num_short_trades']
+    cdef np.int8_t[:] final_position = results['final_position']
+    cdef np.int8_t[:] trend = results['backtest_trend']
+    cdef Py_ssize_t k
+
+    for k in range(n_candidates):
+        final_capital[k] = stats[k].final_capital
+        total_profit_loss[k] = stats[k].total_profit_loss
+        total_profit_percentage[k] = 0.0
+        if initial_capital != 0:
+            total_profit_percentage[k] = ((stats[k].final_capital - initial_capital) / initial_capital) * 100.0
+        total_trades[k] = stats[k].total_trades
+        winning_trades[k] = stats[k].winning_trades
+        losing_trades[k] = stats[k].losing_trades
+        win_rate[k] = 0.0
+        if stats[k].total_trades > 0:
+            win_rate[k] = (<double>stats[k].winning_trades / stats[k].total_trades) * 100.0 # Convert to percentage
+        max_drawdown[k] = stats[k].max_drawdown
+        long_profit[k] = stats[k].long_profit
+        short_profit[k] = stats[k].short_profit
+        num_long_trades[k] = stats[k].num_long_trades
+        num_short_trades[k] = stats[k].num_short_trades
+        final_position[k] = <np.int8_t>stats[k].final_position
+        trend[k] = backtest_trend
+
+def run_backtest_into(results,
+                      Py_ssize_t row,
+                      prices,
+                      long_entry,
+                      short_entry,
+                      long_exit,
+                      short_exit,
+                      atr_values,
+                      pdi,
+                      ndi,
+                      double atr_multiple,
+                      double fixed_stop_loss_percentage,
+                      double take_profit_multiple,
+                      double initial_capital,
+                      double spread_percentage,
+                      double slippage_percentage,
+                      double daily_volatility=0.0):
+    """
+    Allocation-free variant of run_backtest_cython for hot loops: the statistics are
+    written into row `row` of a preallocated BATCH_RESULT_DTYPE array instead of a new
+    dict, so the same inputs and result buffer can be reused by every trial.
+    """
+    cdef BacktestStats stats
+    cdef Py_ssize_t n = len(prices)
+    cdef np.int8_t backtest_trend = 0
+
+    if results.dtype != BATCH_RESULT_DTYPE:
+        raise ValueError("results must be an array with dtype BATCH_RESULT_DTYPE.")
+    if row < 0 or row >= results.shape[0]:
+        raise IndexError(f"Result row {row} is out of range.")
+
+    _simulate_single(prices, long_entry, short_entry, long_exit, short_exit, atr_values,
+                     atr_multiple, fixed_stop_loss_percentage, take_profit_multiple,
+                     initial_capital, spread_percentage, slippage_percentage, daily_volatility,
+                     &stats, NULL, NULL)
+
+    # Determine final trend state based on the last ADX values
+    if n > 0:
+        backtest_trend = 1 if pdi[n-1] > ndi[n-1] else -1
+
+    _fill_batch_results(results[row:row + 1], &stats, 1, initial_capital, backtest_trend)
+
+cdef void simulate_batch_candidate(Py_ssize_t k,
+                                   const DTYPE_t* prices,
+                                   const UBYTE_t* long_entry,
+                                   const UBYTE_t* short_entry,
+                                   const UBYTE_t* long_exit,
+                                   const UBYTE_t* short_exit,
+                                   const DTYPE_t* atr_values,
+                                   Py_ssize_t atr_rows,
+                                   Py_ssize_t n,
+                                   const DTYPE_t* atr_multiple,
+                                   const DTYPE_t* fixed_stop_loss_percentage,
+                                   const DTYPE_t* take_profit_multiple,
+                                   double initial_capital,
+                                   double spread_percentage,
+                                   double slippage_percentage,
+                                   double daily_volatility,
+                                   BacktestStats* stats) noexcept nogil:
+    """Simulates candidate k of a batch: row k of the (candidates, n) signal matrices."""
+    cdef Py_ssize_t row = k * n
+    cdef Py_ssize_t atr_row = row if atr_rows > 1 else 0
+    simulate_backtest(prices, long_entry + row, short_entry + row, long_exit + row, short_exit + row,
+                      atr_values + atr_row, n, atr_multiple[k], fixed_stop_loss_percentage[k],
+                      take_profit_multiple[k], initial_capital, spread_percentage, slippage_percentage,
+                      daily_volatility, &stats[k], NULL, NULL)
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def run_backtest_batch_cython(const DTYPE_t[::1] prices,
+                              const UBYTE_t[:, ::1] long_entry,
+                              const UBYTE_t[:, ::1] short_entry,
+                              const UBYTE_t[:, ::1] long_exit,
+                              const UBYTE_t[:, ::1] short_exit,
+                              const DTYPE_t[:, ::1] atr_values,
+                              const DTYPE_t[::1] adx,
+                              const DTYPE_t[::1] pdi,
+                              const DTYPE_t[::1] ndi,
+                              const DTYPE_t[::1] atr_multiple,
+                              const DTYPE_t[::1] fixed_stop_loss_percentage,
+                              const DTYPE_t[::1] take_profit_multiple,
+                              double initial_capital,
+                              double spread_percentage,
+                              double slippage_percentage,
+                              double daily_volatility=0.0,
+                              int num_threads=0):
+    """
+    Evaluates N candidate parameter sets against the same price series in one call.
+
+    Signal matrices have one row per candidate and one column per bar. atr_values is
+    either a single row shared by every candidate or one row per candidate.
+    atr_multiple, fixed_stop_loss_percentage and take_profit_multiple hold one value
+    per candidate. Candidates are simulated without the GIL, spread across OpenMP
+    threads (num_threads <= 0 lets OpenMP decide).
+
+    Returns a structured array with dtype BATCH_RESULT_DTYPE, one row per candidate.
+    """
+    cdef Py_ssize_t n = prices.shape[0]
+    cdef Py_ssize_t n_candidates = long_entry.shape[0]
+    cdef Py_ssize_t atr_rows = atr_values.shape[0]
+    cdef Py_ssize_t k
+    cdef BacktestStats* stats
+    cdef np.int8_t backtest_trend = 0
+    cdef const DTYPE_t* prices_ptr
+    cdef const UBYTE_t* long_entry_ptr
+    cdef const UBYTE_t* short_entry_ptr
+    cdef const UBYTE_t* long_exit_ptr
+    cdef const UBYTE_t* short_exit_ptr
+    cdef const DTYPE_t* atr_ptr
+    cdef const DTYPE_t* atr_multiple_ptr
+    cdef const DTYPE_t* fixed_stop_ptr
+    cdef const DTYPE_t* take_profit_ptr
+
+    if (short_entry.shape[0] != n_candidates or long_exit.shape[0] != n_candidates
+            or short_exit.shape[0] != n_candidates):
+        raise ValueError("All signal matrices must have one row per candidate.")
+    if (long_entry.shape[1] != n or short_entry.shape[1] != n or long_exit.shape[1] != n
+            or short_exit.shape[1] != n or atr_values.shape[1] != n):
+        raise ValueError("Signal and ATR matrices must have one column per price bar.")
+    if atr_rows != 1 and atr_rows != n_candidates:
+        raise ValueError("atr_values must have either 1 row or one row per candidate.")
+    if (atr_multiple.shape[0] != n_candidates or fixed_stop_loss_percentage.shape[0] != n_candidates
+            or take_profit_multiple.shape[0] != n_candidates):
+        raise ValueError("Per-candidate parameter vectors must have one value per candidate.")
+
+    results = np.zeros(n_candidates, dtype=BATCH_RESULT_DTYPE)
+    if n_candidates == 0:
+        return results
+
+    prices_ptr = &prices[0]
+    long_entry_ptr = &long_entry[0, 0]
+    short_entry_ptr = &short_entry[0, 0]
+    long_exit_ptr = &long_exit[0, 0]
+    short_exit_ptr = &short_exit[0, 0]
+    atr_ptr = &atr_values[0, 0]
+    atr_multiple_ptr = &atr_multiple[0]
+    fixed_stop_ptr = &fixed_stop_loss_percentage[0]
+    take_profit_ptr = &take_profit_multiple[0]
+    stats = <BacktestStats*> malloc(n_candidates * sizeof(BacktestStats))
+    if stats == NULL:
+        raise MemoryError("Could not allocate batch backtest statistics.")
+
+    try:
+        with nogil:
+            if num_threads > 0:
+                for k in prange(n_candidates, schedule='dynamic', num_threads=num_threads):
+                    simulate_batch_candidate(k, prices_ptr, long_entry_ptr, short_entry_ptr, long_exit_ptr,
+                                             short_exit_ptr, atr_ptr, atr_rows, n, atr_multiple_ptr,
+                                             fixed_stop_ptr, take_profit_ptr, initial_capital,
+                                             spread_percentage, slippage_percentage, daily_volatility, stats)
+            else:
+                for k in prange(n_candidates, schedule='dynamic'):
+                    simulate_batch_candidate(k, prices_ptr, long_entry_ptr, short_entry_ptr, long_exit_ptr,
+                                             short_exit_ptr, atr_ptr, atr_rows, n, atr_multiple_ptr,
+                                             fixed_stop_ptr, take_profit_ptr, initial_capital,
+                                             spread_percentage, slippage_percentage, daily_volatility, stats)
+
+        # Determine final trend state based on the last ADX values (shared by all candidates)
+        if n > 0:
+            backtest_trend = 1 if pdi[n-1] > ndi[n-1] else -1
+
+        _fill_batch_results(results, stats, n_candidates, initial_capital, backtest_trend)
+    finally:
+        free(stats)
+
+    return results
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def run_backtest_windows_cython(prices,
+                                long_entry,
+                                short_entry,
+                                long_exit,
+                                short_exit,
+                                atr_values,
+                                pdi,
+                                ndi,
+                                window_bounds,
+                                double atr_multiple,
+                                double fixed_stop_loss_percentage,
+                                double take_profit_multiple,
+                                double initial_capital,
+                                double spread_percentage,
+                                double slippage_percentage,
+                                double periods_per_year=0.0):
+    """
+    Walk-forward evaluation of one parameter set over consecutive windows of a series.
+
+    window_bounds holds W + 1 increasing bar indices; window k covers bars
+    [window_bounds[k], window_bounds[k + 1]). Signals and ATR are computed by the caller
+    over the whole series, so every window starts with indicators warmed up on the bars
+    before it. Each window otherwise behaves like its own run_backtest_cython call: it
+    starts flat with initial_capital, closes an open position on its last bar and picks
+    its sizing method from its own price change. All windows are simulated in one pass
+    over the arrays without the GIL.
+
+    Returns a structured array with dtype WINDOW_RESULT_DTYPE, one row per window.
+    """
+    cdef const DTYPE_t[::1] prices_view = _price_view(prices)
+    cdef const UBYTE_t[::1] long_entry_view = _signal_view(long_entry)
+    cdef const UBYTE_t[::1] short_entry_view = _signal_view(short_entry)
+    cdef const UBYTE_t[::1] long_exit_view = _signal_view(long_exit)
+    cdef const UBYTE_t[::1] short_exit_view = _signal_view(short_exit)
+    cdef const DTYPE_t[::1] atr_view = _price_view(atr_values)
+    cdef const DTYPE_t[::1] pdi_view = _price_view(pdi)
+    cdef const DTYPE_t[::1] ndi_view = _price_view(ndi)
+    cdef const np.int64_t[::1] bounds = np.ascontiguousarray(window_bounds, dtype=np.int64)
+    cdef Py_ssize_t n = prices_view.shape[0]
+    cdef Py_ssize_t n_windows = bounds.shape[0] - 1
+    cdef Py_ssize_t k, start, length
+    cdef double volatility
+    cdef BacktestStats* stats
+    cdef RiskMetrics* risk
+
+    if (long_entry_view.shape[0] != n or short_entry_view.shape[0] != n or long_exit_view.shape[0] != n
+            or short_exit_view.shape[0] != n or atr_view.shape[0] != n
+            or pdi_view.shape[0] != n or ndi_view.shape[0] != n):
+        raise ValueError("Signal, ATR and ADX arrays must have the same length as prices.")
+    if n_windows < 1:
+        raise ValueError("window_bounds must hold at least two boundaries.")
+    if bounds[0] < 0 or bounds[n_windows] > n:
+        raise ValueError("window_bounds must lie within the price series.")
+    for k in range(n_windows):
+        if bounds[k + 1] <= bounds[k]:
+            raise ValueError("window_bounds must be strictly increasing.")
+
+    # One equity buffer: each window writes (and reads back) its own slice
+    equity_curve = np.empty(n, dtype=np.float64)
+    cdef DTYPE_t[::1] equity_view = equity_curve
+
+    stats = <BacktestStats*> malloc(n_windows * sizeof(BacktestStats))
+    risk = <RiskMetrics*> malloc(n_windows * sizeof(RiskMetrics))
+    if stats == NULL or risk == NULL:
+        free(stats)
+        free(risk)
+        raise MemoryError("Could not allocate walk-forward statistics.")
+
+    results = np.zeros(n_windows, dtype=WINDOW_RESULT_DTYPE)
+    cdef np.int64_t[:] start_col = results['start']
+    cdef np.int64_t[:] end_col = results['end']
+    cdef double[:] sharpe_col = results['sharpe_ratio']
+    cdef double[:] sortino_col = results['sortino_ratio']
+    cdef np.int64_t[:] duration_col = results['max_drawdown_duration']
+    cdef np.int8_t[:] trend_col = results['backtest_trend']
+    try:
+        with nogil:
+            for k in range(n_windows):
+                start = bounds[k]
+                length = bounds[k + 1] - start
+                # Same sizing decision as a standalone run over the window
+                volatility = 0.0
+                if length > 1 and prices_view[start] != 0:
+                    volatility = fabs((prices_view[start + length - 1] - prices_view[start]) / prices_view[start])
+                simulate_backtest(&prices_view[start], &long_entry_view[start], &short_entry_view[start],
+                                  &long_exit_view[start], &short_exit_view[start], &atr_view[start], length,
+                                  atr_multiple, fixed_stop_loss_percentage, take_profit_multiple,
+                                  initial_capital, spread_percentage, slippage_percentage, volatility,
+                                  &stats[k], NULL, &equity_view[start])
+                compute_risk_metrics(&equity_view[start], length, initial_capital, periods_per_year, &risk[k])
+
+        _fill_batch_results(results, stats, n_windows, initial_capital, 0)
+        for k in range(n_windows):
+            start_col[k] = bounds[k]
+            end_col[k] = bounds[k + 1]
+            sharpe_col[k] = risk[k].sharpe_ratio
+            sortino_col[k] = risk[k].sortino_ratio
+            duration_col[k] = risk[k].max_drawdown_duration
+            trend_col[k] = 1 if pdi_view[bounds[k + 1] - 1] > ndi_view[bounds[k + 1] - 1] else -1
+    finally:
+        free(stats)
+        free(risk)
+
+    return results
+
+# ---------------------------------------------------------------------------
+# Monte Carlo robustness: one parameter set over many perturbed price paths
+# ---------------------------------------------------------------------------
+
+cdef inline np.uint64_t splitmix64(np.uint64_t* state) noexcept nogil:
+    """Next output of the SplitMix64 generator (one 64-bit state per path, no shared state)."""
+    cdef np.uint64_t z
+    state[0] += <np.uint64_t>0x9E3779B97F4A7C15
+    z = state[0]
+    z = (z ^ (z >> 30)) * <np.uint64_t>0xBF58476D1CE4E5B9
+    z = (z ^ (z >> 27)) * <np.uint64_t>0x94D049BB133111EB
+    return z ^ (z >> 31)
+
+cdef inline double uniform_open(np.uint64_t* state) noexcept nogil:
+    """Uniform double in (0, 1]: never 0, so its log is finite."""
+    return <double>((splitmix64(state) >> 11) + 1) * (1.0 / 9007199254740992.0)
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef void simulate_monte_carlo_path(const DTYPE_t* prices,
+                                    const UBYTE_t* long_entry,
+                                    const UBYTE_t* short_entry,
+                                    const UBYTE_t* long_exit,
+                                    const UBYTE_t* short_exit,
+                                    const DTYPE_t* atr_values,
+                                    Py_ssize_t n,
+                                    double atr_multiple,
+                                    double fixed_stop_loss_percentage,
+                                    double take_profit_multiple,
+                                    double initial_capital,
+                                    double spread_percentage,
+                                    double slippage_percentage,
+                                    double noise_sigma,
+                                    double cost_multiple_max,
+                                    np.uint64_t seed,
+                                    Py_ssize_t path,
+                                    BacktestStats* stats,
+                                    double* path_spread,
+                                    double* path_slippage) noexcept nogil:
+    """
+    Simulates path `path`: every close is multiplied by exp(noise_sigma * z) with z standard
+    normal (Box-Muller), and spread and slippage are scaled by factors drawn uniformly from
+    [1, cost_multiple_max]. The path's generator is seeded from (seed, path) only, so the
+    results do not depend on how paths are spread over threads. Signals and ATR are those
+    of the observed series. Sets stats.total_trades to -1 if the path buffer cannot be allocated.
+    """
+    cdef np.uint64_t state = seed ^ ((<np.uint64_t>path + 1) * <np.uint64_t>0xD1B54A32D192ED03)
+    cdef DTYPE_t* path_prices = <DTYPE_t*> malloc(n * sizeof(DTYPE_t))
+    cdef Py_ssize_t i
+    cdef double radius, angle
+    cdef double volatility = 0.0
+
+    if path_prices == NULL:
+        stats.total_trades = -1
+        return
+
+    path_spread[0] = spread_percentage * (1.0 + (cost_multiple_max - 1.0) * uniform_open(&state))
+    path_slippage[0] = slippage_percentage * (1.0 + (cost_multiple_max - 1.0) * uniform_open(&state))
+
+    i = 0
+    while i < n:
+        # Two independent normals per pair of uniforms
+        radius = noise_sigma * sqrt(-2.0 * log(uniform_open(&state)))
+        angle = 2.0 * M_PI * uniform_open(&state)
+        path_prices[i] = prices[i] * exp(radius * cos(angle))
+        if i + 1 < n:
+            path_prices[i + 1] = prices[i + 1] * exp(radius * sin(angle))
+        i += 2
+
+    # Same sizing decision as a standalone run over the path
+    if n > 1 and path_prices[0] != 0:
+        volatility = fabs((path_prices[n - 1] - path_prices[0]) / path_prices[0])
+
+    simulate_backtest(path_prices, long_entry, short_entry, long_exit, short_exit, atr_values, n,
+                      atr_multiple, fixed_stop_loss_percentage, take_profit_multiple, initial_capital,
+                      path_spread[0], path_slippage[0], volatility, stats, NULL, NULL)
+    free(path_prices)
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def run_backtest_monte_carlo_cython(prices,
+                                    long_entry,
+                                    short_entry,
+                                    long_exit,
+                                    short_exit,
+                                    atr_values,
+                                    double atr_multiple,
+                                    double fixed_stop_loss_percentage,
+                                    double take_profit_multiple,
+                                    double initial_capital,
+                                    double spread_percentage,
+                                    double slippage_percentage,
+                                    Py_ssize_t n_paths,
+                                    double noise_sigma=0.0,
+                                    double cost_multiple_max=1.0,
+                                    np.uint64_t seed=0,
+                                    int num_threads=0):
+    """
+    Experimental Monte Carlo robustness test of one parameter set: simulates it over n_paths perturbed
+    copies of the price series (see simulate_monte_carlo_path), spread across OpenMP
+    threads without the GIL (num_threads <= 0 lets OpenMP decide). Each thread allocates
+    one path buffer at a time, so memory stays O(threads * bars). With noise_sigma 0 and
+    cost_multiple_max 1 every path reproduces run_backtest_cython.
+
+    Returns a structured array with dtype MONTE_CARLO_RESULT_DTYPE, one row per path.
+    """
+    cdef const DTYPE_t[::1] prices_view = _price_view(prices)
+    cdef const UBYTE_t[::1] long_entry_view = _signal_view(long_entry)
+    cdef const UBYTE_t[::1] short_entry_view = _signal_view(short_entry)
+    cdef const UBYTE_t[::1] long_exit_view = _signal_view(long_exit)
+    cdef const UBYTE_t[::1] short_exit_view = _signal_view(short_exit)
+    cdef const DTYPE_t[::1] atr_view = _price_view(atr_values)
+    cdef Py_ssize_t n = prices_view.shape[0]
+    cdef Py_ssize_t k
+    cdef BacktestStats* stats
+    cdef double* spreads
+    cdef double* slippages
+
+    if (long_entry_view.shape[0] != n or short_entry_view.shape[0] != n or long_exit_view.shape[0] != n
+            or short_exit_view.shape[0] != n or atr_view.shape[0] != n):
+        raise ValueError("Signal and ATR arrays must have the same length as prices.")
+    if n == 0:
+        raise ValueError("prices must not be empty.")
+    if n_paths < 0 or noise_sigma < 0 or cost_multiple_max < 1.0:
+        raise ValueError("n_paths and noise_sigma must be >= 0 and cost_multiple_max >= 1.")
+
+    results = np.zeros(n_paths, dtype=MONTE_CARLO_RESULT_DTYPE)
+    if n_paths == 0:
+        return results
+
+    stats = <BacktestStats*> malloc(n_paths * sizeof(BacktestStats))
+    spreads = <double*> malloc(n_paths * sizeof(double))
+    slippages = <double*> malloc(n_paths * sizeof(double))
+    if stats == NULL or spreads == NULL or slippages == NULL:
+        free(stats)
+        free(spreads)
+        free(slippages)
+        raise MemoryError("Could not allocate Monte Carlo statistics.")
+
+    cdef double[:] final_capital_col = results['final_capital']
+    cdef double[:] max_drawdown_col = results['max_drawdown']
+    cdef np.int32_t[:] total_trades_col = results['total_trades']
+    cdef np.int32_t[:] winning_trades_col = results['winning_trades']
+    cdef double[:] spread_col = results['spread_percentage']
+    cdef double[:] slippage_col = results['slippage_percentage']
+    try:
+        with nogil:
+            if num_threads > 0:
+                for k in prange(n_paths, schedule='dynamic', num_threads=num_threads):
+                    simulate_monte_carlo_path(&prices_view[0], &long_entry_view[0], &short_entry_view[0],
+                                              &long_exit_view[0], &short_exit_view[0], &atr_view[0], n,
+                                              atr_multiple, fixed_stop_loss_percentage, take_profit_multiple,
+                                              initial_capital, spread_percentage, slippage_percentage,
+                                              noise_sigma, cost_multiple_max, seed, k,
+                                              &stats[k], &spreads[k], &slippages[k])
+            else:
+                for k in prange(n_paths, schedule='dynamic'):
+                    simulate_monte_carlo_path(&prices_view[0], &long_entry_view[0], &short_entry_view[0],
+                                              &long_exit_view[0], &short_exit_view[0], &atr_view[0], n,
+                                              atr_multiple, fixed_stop_loss_percentage, take_profit_multiple,
+                                              initial_capital, spread_percentage, slippage_percentage,
+                                              noise_sigma, cost_multiple_max, seed, k,
+                                              &stats[k], &spreads[k], &slippages[k])
+
+        for k in range(n_paths):
+            if stats[k].total_trades < 0:
+                raise MemoryError("Could not allocate a Monte Carlo price path.")
+            final_capital_col[k] = stats[k].final_capital
+            max_drawdown_col[k] = stats[k].max_drawdown
+            total_trades_col[k] = stats[k].total_trades
+            winning_trades_col[k] = stats[k].winning_trades
+            spread_col[k] = spreads[k]
+            slippage_col[k] = slippages[k]
+    finally:
+        free(stats)
+        free(spreads)
+        free(slippages)
+
+    return results
+
+# ---------------------------------------------------------------------------
+# Portfolio backtest: many cryptos sharing one capital pool
+# ---------------------------------------------------------------------------
+
+# Open position and stop levels of one asset during the portfolio sweep
+cdef struct AssetState:
+    int position  # 0: None, 1: Long, -1: Short
+    double entry_price
+    double position_size  # Capital committed to the position
+    double highest_price_since_entry
+    double lowest_price_since_entry
+    double trailing_stop_loss
+    double fixed_stop_loss_price
+    double take_profit_price
+    double last_price  # Latest quoted close; bars without a quote (NaN) keep it
+    Py_ssize_t last_index
+    Py_ssize_t entry_index
+    Py_ssize_t exit_index  # Bar of the latest exit; no re-entry on that bar
+
+# Per-asset totals of the portfolio sweep
+cdef struct AssetStats:
+    double profit_loss
+    double long_profit
+    double short_profit
+    int total_trades
+    int winning_trades
+    int num_long_trades
+    int num_short_trades
+
+# Portfolio-wide totals of the sweep
+cdef struct PortfolioStats:
+    double final_capital
+    double total_profit_loss
+    double max_drawdown
+    int total_trades
+    int winning_trades
+    int losing_trades
+    int max_open_positions
+    int skipped_entries  # Entry signals refused for lack of a position slot or capital
+    int open_positions
+
+# One closed portfolio trade; must stay field-for-field identical to PORTFOLIO_TRADE_DTYPE
+cdef struct PortfolioTradeRecord:
+    np.int64_t entry_index
+    np.int64_t exit_index
+    double entry_price
+    double exit_price
+    double size
+    double profit_loss
+    np.int8_t direction  # 1: Long, -1: Short
+    np.int8_t exit_reason
+    np.int32_t asset  # Row of the asset in the input matrices
+
+PORTFOLIO_TRADE_DTYPE = np.dtype([
+    ('entry_index', np.int64),
+    ('exit_index', np.int64),
+    ('entry_price', np.float64),
+    ('exit_price', np.float64),
+    ('size', np.float64),
+    ('profit_loss', np.float64),
+    ('direction', np.int8),
+    ('exit_reason', np.int8),
+    ('asset', np.int32),
+], align=True)
+
+# Layout of the per-asset array in run_portfolio_backtest_cython results (one row per asset)
+PORTFOLIO_ASSET_DTYPE = np.dtype([
+    ('profit_loss', np.float64),
+    ('long_profit', np.float64),
+    ('short_profit', np.float64),
+    ('total_trades', np.int32),
+    ('winning_trades', np.int32),
+    ('num_long_trades', np.int32),
+    ('num_short_trades', np.int32),
+    ('final_position', np.int8),
+], align=True)
+
+cdef void _close_portfolio_position(AssetState* state, AssetStats* totals, PortfolioStats* stats,
+                                    Py_ssize_t asset, Py_ssize_t i, int exit_reason,
+                                    double spread_percentage, double slippage_percentage,
+                                    double* capital, double* cash, double* peak_capital,
+                                    double* recent_trades, int* recent_trades_count,
+                                    PortfolioTradeRecord* trades) noexcept nogil:
+    """Closes the open position of one asset at its latest price and books the result."""
+    cdef double exit_price, profit_loss, drawdown
+    cdef PortfolioTradeRecord* trade
+
+    if state.position == 1:
+        exit_price = state.last_price * (1 - spread_percentage - slippage_percentage)
+        profit_loss = (exit_price - state.entry_price) / state.entry_price * state.position_size
+        totals.long_profit += profit_loss
+        totals.num_long_trades += 1
+    else:
+        exit_price = state.last_price * (1 + spread_percentage + slippage_percentage)
+        profit_loss = (state.entry_price - exit_price) / state.entry_price * state.position_size
+        totals.short_profit += profit_loss
+        totals.num_short_trades += 1
+
+    capital[0] += profit_loss
+    cash[0] += state.position_size + profit_loss
+
+    # Max drawdown is tracked on realized capital, as in the single-asset loop
+    if capital[0] > peak_capital[0]:
+        peak_capital[0] = capital[0]
+    drawdown = ((peak_capital[0] - capital[0]) / peak_capital[0]) * 100.0
+    if drawdown > stats.max_drawdown:
+        stats.max_drawdown = drawdown
+
+    if trades != NULL:
+        trade = &trades[stats.total_trades]
+        trade.entry_index = state.entry_index
+        trade.exit_index = i
+        trade.entry_price = state.entry_price
+        trade.exit_price = exit_price
+        trade.size = state.position_size
+        trade.profit_loss = profit_loss
+        trade.direction = <np.int8_t>state.position
+        trade.exit_reason = <np.int8_t>exit_reason
+        trade.asset = <np.int32_t>asset
+
+    totals.profit_loss += profit_loss
+    totals.total_trades += 1
+    stats.total_profit_loss += profit_loss
+    stats.total_trades += 1
+    if profit_loss > 0:
+        totals.winning_trades += 1
+        stats.winning_trades += 1
+    else:
+        stats.losing_trades += 1
+    update_recent_trades(recent_trades, recent_trades_count, profit_loss)
+
+    stats.open_positions -= 1
+    state.position = 0
+    state.position_size = 0.0
+    state.highest_price_since_entry = 0.0
+    state.lowest_price_since_entry = 0.0
+    state.trailing_stop_loss = 0.0
+    state.fixed_stop_loss_price = 0.0
+    state.take_profit_price = 0.0
+    state.exit_index = i
+
+cdef void simulate_portfolio(const DTYPE_t* prices,
+                             const UBYTE_t* long_entry,
+                             const UBYTE_t* short_entry,
+                             const UBYTE_t* long_exit,
+                             const UBYTE_t* short_exit,
+                             const DTYPE_t* atr_values,
+                             Py_ssize_t n_assets,
+                             Py_ssize_t n,
+                             const DTYPE_t* atr_multiple,
+                             const DTYPE_t* fixed_stop_loss_percentage,
+                             const DTYPE_t* take_profit_multiple,
+                             double initial_capital,
+                             double spread_percentage,
+                             double slippage_percentage,
+                             int max_positions,
+                             double min_position_value,
+                             AssetState* states,
+                             AssetStats* totals,
+                             PortfolioStats* stats,
+                             PortfolioTradeRecord* trades,
+                             DTYPE_t* equity) noexcept nogil:
+    """
+    Time-ordered sweep over n bars of n_assets assets sharing one capital pool. Matrices
+    are row-major (n_assets, n): row a holds asset a, so element [a, i] is at a * n + i.
+
+    On every bar, open positions are checked for stops and exit signals first, so capital
+    freed on a bar can fund entries on the same bar. Entries are then taken in row order
+    (callers put their preferred assets first) while fewer than max_positions are open.
+    Each entry commits calculate_position_size() of the realized capital, driven by the
+    portfolio's last trades and capped by the free cash; smaller allocations than
+    min_position_value are skipped. No entries are taken on the last bar, where every
+    open position is closed. NaN prices mark bars without a quote for that asset.
+    """
+    cdef Py_ssize_t i, a, k
+    cdef AssetState* state
+    cdef double capital = initial_capital  # Realized capital: cash plus committed position sizes
+    cdef double cash = initial_capital
+    cdef double peak_capital = initial_capital
+    cdef double recent_trades[5]  # Last 5 trades of the whole portfolio
+    cdef int recent_trades_count = 0
+    cdef double current_price, atr, position_percentage, position_size, risk_amount, value
+    cdef bint force_exit
+    cdef int forced_exit_reason, direction
+
+    # Same sizing bounds as the dynamic mode of the single-asset loop
+    cdef double base_position_percentage = 0.20
+    cdef double min_position_percentage = 0.05
+    cdef double max_position_percentage = 0.95
+
+    stats.total_profit_loss = 0.0
+    stats.max_drawdown = 0.0
+    stats.total_trades = 0
+    stats.winning_trades = 0
+    stats.losing_trades = 0
+    stats.max_open_positions = 0
+    stats.skipped_entries = 0
+    stats.open_positions = 0
+    for a in range(n_assets):
+        states[a].position = 0
+        states[a].position_size = 0.0
+        states[a].last_price = 0.0
+        states[a].last_index = -1
+        states[a].exit_index = -1
+        totals[a].profit_loss = 0.0
+        totals[a].long_profit = 0.0
+        totals[a].short_profit = 0.0
+        totals[a].total_trades = 0
+        totals[a].winning_trades = 0
+        totals[a].num_long_trades = 0
+        totals[a].num_short_trades = 0
+
+    for i in range(n):
+        # Exits first, so that capital freed on this bar can fund its entries
+        for a in range(n_assets):
+            k = a * n + i
+            current_price = prices[k]
+            if current_price != current_price:  # NaN: no quote on this bar
+                continue
+            state = &states[a]
+            state.last_price = current_price
+            state.last_index = i
+            if state.position == 0:
+                continue
+
+            force_exit = 0
+            forced_exit_reason = 0
+            atr = atr_values[k]
+            if state.position == 1:
+                state.highest_price_since_entry = fmax(state.highest_price_since_entry, current_price)
+                if atr > 0:
+                    state.trailing_stop_loss = state.highest_price_since_entry - (atr * atr_multiple[a])
+                if current_price <= state.trailing_stop_loss and state.trailing_stop_loss > 0:
+                    force_exit = 1
+                    forced_exit_reason = EXIT_TRAILING_STOP
+                if current_price <= state.fixed_stop_loss_price and state.fixed_stop_loss_price > 0:
+                    force_exit = 1
+                    forced_exit_reason = EXIT_STOP_LOSS
+                elif current_price >= state.take_profit_price and state.take_profit_price > 0:
+                    force_exit = 1
+                    forced_exit_reason = EXIT_TAKE_PROFIT
+                if long_exit[k]:
+                    _close_portfolio_position(state, &totals[a], stats, a, i, EXIT_SIGNAL, spread_percentage,
+                                              slippage_percentage, &capital, &cash, &peak_capital,
+                                              recent_trades, &recent_trades_count, trades)
+                    continue
+            else:
+                state.lowest_price_since_entry = fmin(state.lowest_price_since_entry, current_price)
+                if atr > 0:
+                    state.trailing_stop_loss = state.lowest_price_since_entry + (atr * atr_multiple[a])
+                if current_price >= state.trailing_stop_loss and state.trailing_stop_loss > 0:
+                    force_exit = 1
+                    forced_exit_reason = EXIT_TRAILING_STOP
+                if current_price >= state.fixed_stop_loss_price and state.fixed_stop_loss_price > 0:
+                    force_exit = 1
+                    forced_exit_reason = EXIT_STOP_LOSS
+                elif current_price <= state.take_profit_price and state.take_profit_price > 0:
+                    force_exit = 1
+                    forced_exit_reason = EXIT_TAKE_PROFIT
+                if short_exit[k]:
+                    _close_portfolio_position(state, &totals[a], stats, a, i, EXIT_SIGNAL, spread_percentage,
+                                              slippage_percentage, &capital, &cash, &peak_capital,
+                                              recent_trades, &recent_trades_count, trades)
+                    continue
+
+            if force_exit:
+                _close_portfolio_position(state, &totals[a], stats, a, i, forced_exit_reason, spread_percentage,
+                                          slippage_percentage, &capital, &cash, &peak_capital,
+                                          recent_trades, &recent_trades_count, trades)
+            elif i == n - 1:
+                _close_portfolio_position(state, &totals[a], stats, a, i, EXIT_END_OF_DATA, spread_percentage,
+                                          slippage_percentage, &capital, &cash, &peak_capital,
+                                          recent_trades, &recent_trades_count, trades)
+
+        if i == n - 1:
+            # Assets without a quote on the last bar close at their latest one
+            for a in range(n_assets):
+                if states[a].position != 0:
+                    _close_portfolio_position(&states[a], &totals[a], stats, a, states[a].last_index,
+                                              EXIT_END_OF_DATA, spread_percentage, slippage_percentage,
+                                              &capital, &cash, &peak_capital,
+                                              recent_trades, &recent_trades_count, trades)
+        else:
+            for a in range(n_assets):
+                k = a * n + i
+                state = &states[a]
+                if state.position != 0 or state.exit_index == i or state.last_index != i:
+                    continue
+                if long_entry[k]:
+                    direction = 1
+                elif short_entry[k]:
+                    direction = -1
+                else:
+                    continue
+
+                if stats.open_positions >= max_positions:
+                    stats.skipped_entries += 1
+                    continue
+                position_percentage = calculate_position_size(recent_trades, recent_trades_count,
+                                                              base_position_percentage,
+                                                              min_position_percentage,
+                                                              max_position_percentage)
+                position_size = fmin(capital * position_percentage, cash)
+                if position_size <= 0 or position_size < min_position_value:
+                    stats.skipped_entries += 1
+                    continue
+
+                current_price = prices[k]
+                atr = atr_values[k]
+                state.position = direction
+                state.position_size = position_size
+                state.entry_index = i
+                cash -= position_size
+                stats.open_positions += 1
+                if stats.open_positions > stats.max_open_positions:
+                    stats.max_open_positions = stats.open_positions
+
+                if direction == 1:
+                    state.entry_price = current_price * (1 + spread_percentage + slippage_percentage)
+                    state.fixed_stop_loss_price = state.entry_price * (1 - fixed_stop_loss_percentage[a])
+                    risk_amount = state.entry_price - state.fixed_stop_loss_price
+                    state.take_profit_price = state.entry_price + (risk_amount * take_profit_multiple[a])
+                    state.highest_price_since_entry = current_price
+                    if atr > 0:
+                        state.trailing_stop_loss = current_price - (atr * atr_multiple[a])
+                else:
+                    state.entry_price = current_price * (1 - spread_percentage - slippage_percentage)
+                    state.fixed_stop_loss_price = state.entry_price * (1 + fixed_stop_loss_percentage[a])
+                    risk_amount = state.fixed_stop_loss_price - state.entry_price
+                    state.take_profit_price = state.entry_price - (risk_amount * take_profit_multiple[a])
+                    state.lowest_price_since_entry = current_price
+                    if atr > 0:
+                        state.trailing_stop_loss = current_price + (atr * atr_multiple[a])
+
+        if equity != NULL:
+            # Free cash plus every open position marked to its latest close
+            value = cash
+            for a in range(n_assets):
+                state = &states[a]
+                if state.position == 1:
+                    value += state.position_size * (1 + (state.last_price - state.entry_price) / state.entry_price)
+                elif state.position == -1:
+                    value += state.position_size * (1 + (state.entry_price - state.last_price) / state.entry_price)
+            equity[i] = value
+
+    stats.final_capital = capital
+
+def run_portfolio_backtest_cython(prices,
+                                  long_entry,
+                                  short_entry,
+                                  long_exit,
+                                  short_exit,
+                                  atr_values,
+                                  atr_multiple,
+                                  fixed_stop_loss_percentage,
+                                  take_profit_multiple,
+                                  double initial_capital,
+                                  double spread_percentage,
+                                  double slippage_percentage,
+                                  int max_positions=10,
+                                  double min_position_value=0.0,
+                                  bint record_trades=False,
+                                  double periods_per_year=0.0):
+    """
+    Simulates many cryptos trading from one capital pool in a single time-ordered sweep.
+
+    prices, the four signal matrices and atr_values are aligned (n_assets, n) arrays, one
+    row per asset over a shared bar index (NaN prices where an asset has no quote).
+    atr_multiple, fixed_stop_loss_percentage and take_profit_multiple are per-asset arrays
+    or scalars. Row order is the entry priority when position slots or capital run short.
+    Inputs may be read-only and are never modified.
+
+    Returns a dict with the portfolio statistics (as run_backtest_cython, plus
+    max_open_positions and skipped_entries) and 'assets', a PORTFOLIO_ASSET_DTYPE array
+    with one row per asset. With record_trades it also holds 'trades' (a
+    PORTFOLIO_TRADE_DTYPE array) and the per-bar 'equity_curve'.
+    """
+    cdef const DTYPE_t[:, ::1] prices_view = _price_view(prices)
+    cdef Py_ssize_t n_assets = prices_view.shape[0]
+    cdef Py_ssize_t n = prices_view.shape[1]
+    cdef const UBYTE_t[:, ::1] long_entry_view = _signal_view(long_entry)
+    cdef const UBYTE_t[:, ::1] short_entry_view = _signal_view(short_entry)
+    cdef const UBYTE_t[:, ::1] long_exit_view = _signal_view(long_exit)
+    cdef const UBYTE_t[:, ::1] short_exit_view = _signal_view(short_exit)
+    cdef const DTYPE_t[:, ::1] atr_view = _price_view(atr_values)
+    cdef const DTYPE_t[::1] atr_multiple_view = _price_view(np.broadcast_to(atr_multiple, (n_assets,)))
+    cdef const DTYPE_t[::1] stop_loss_view = _price_view(np.broadcast_to(fixed_stop_loss_percentage, (n_assets,)))
+    cdef const DTYPE_t[::1] take_profit_view = _price_view(np.broadcast_to(take_profit_multiple, (n_assets,)))
+    cdef PortfolioStats stats
+    cdef RiskMetrics risk
+    cdef AssetState* states
+    cdef AssetStats* totals
+    cdef Py_ssize_t a
+
+    for matrix in (long_entry, short_entry, long_exit, short_exit, atr_values):
+        if np.shape(matrix) != (n_assets, n):
+            raise ValueError("Signal and ATR matrices must have the same shape as prices.")
+    if n_assets == 0 or n == 0:
+        raise ValueError("The portfolio needs at least one asset and one bar.")
+    if max_positions < 1:
+        raise ValueError("max_positions must be at least 1.")
+
+    # Output buffers, preallocated so the sweep never touches Python objects
+    equity_curve = np.empty(n, dtype=np.float64)
+    trades = np.empty(n_assets * ((n + 1) // 2) if record_trades else 0, dtype=PORTFOLIO_TRADE_DTYPE)
+    cdef DTYPE_t[::1] equity_view = equity_curve
+    cdef PortfolioTradeRecord[::1] trades_view = trades
+    cdef PortfolioTradeRecord* trades_ptr = NULL
+    if record_trades:
+        trades_ptr = &trades_view[0]
+
+    states = <AssetState*> malloc(n_assets * sizeof(AssetState))
+    totals = <AssetStats*> malloc(n_assets * sizeof(AssetStats))
+    if states == NULL or totals == NULL:
+        free(states)
+        free(totals)
+        raise MemoryError("Could not allocate portfolio state.")
+
+    assets = np.zeros(n_assets, dtype=PORTFOLIO_ASSET_DTYPE)
+    try:
+        with nogil:
+            simulate_portfolio(&prices_view[0, 0], &long_entry_view[0, 0], &short_entry_view[0, 0],
+                               &long_exit_view[0, 0], &short_exit_view[0, 0], &atr_view[0, 0],
+                               n_assets, n, &atr_multiple_view[0], &stop_loss_view[0], &take_profit_view[0],
+                               initial_capital, spread_percentage, slippage_percentage,
+                               max_positions, min_position_value, states, totals, &stats,
+                               trades_ptr, &equity_view[0])
+            compute_risk_metrics(&equity_view[0], n, initial_capital, periods_per_year, &risk)
+
+        for a in range(n_assets):
+            assets['profit_loss'][a] = totals[a].profit_loss
+            assets['long_profit'][a] = totals[a].long_profit
+            assets['short_profit'][a] = totals[a].short_profit
+            assets['total_trades'][a] = totals[a].total_trades
+            assets['winning_trades'][a] = totals[a].winning_trades
+            assets['num_long_trades'][a] = totals[a].num_long_trades
+            assets['num_short_trades'][a] = totals[a].num_short_trades
+            assets['final_position'][a] = states[a].position
+    finally:
+        free(states)
+        free(totals)
+
+    cdef double total_profit_percentage = 0.0
+    if initial_capital != 0:
+        total_profit_percentage = ((stats.final_capital - initial_capital) / initial_capital) * 100.0
+
+    results = {
+        "initial_capital": initial_capital,
+        "final_capital": stats.final_capital,
+        "total_profit_loss": stats.total_profit_loss,
+        "total_profit_percentage": total_profit_percentage,
+        "total_trades": stats.total_trades,
+        "winning_trades": stats.winning_trades,
+        "losing_trades": stats.losing_trades,
+        "win_rate": (<double>stats.winning_trades / stats.total_trades) * 100.0 if stats.total_trades > 0 else 0.0,
+        "sharpe_ratio": risk.sharpe_ratio,
+        "sortino_ratio": risk.sortino_ratio,
+        "max_drawdown": stats.max_drawdown,
+        "max_drawdown_duration": risk.max_drawdown_duration,
+        "max_open_positions": stats.max_open_positions,
+        "skipped_entries": stats.skipped_entries,
+        "assets": assets,
+    }
+    if record_trades:
+        results["trades"] = trades[:stats.total_trades]
+        results["equity_curve"] = equity_curve
+    return results
@@ -0,0 +1 @@
+"""Benchmark suite for the native hot paths; run with python -m benchmarks (see docs/benchmarks.md)."""
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""
+Runs the benchmark suite: python -m benchmarks [--sizes 1k,100k] [--filter indicators] [--check]
+
+Results are appended to benchmarks/results/<machine>.jsonl and compared against
+the median of the previous runs on the same machine; --check exits non-zero when
+any case got slower than --threshold times its baseline (use before deploying).
+"""
+
+import argparse
+import logging
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from benchmarks.harness import (SIZES, REGISTRY, append_run, baseline, compare, environment,
+                                load_history, time_case)
+
+RESULTS_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'results')
+
+def parse_args(argv=None):
+    parser = argparse.ArgumentParser(description="Benchmark the backtest, indicator and optimizer hot paths.")
+    parser.add_argument('--sizes', default=None,
+                        help=f"Comma-separated bar counts to run, of {', '.join(SIZES)} (default: each case's own)")
+    parser.add_argument('--filter', default=None, help="Only run cases whose name matches this regex")
+    parser.add_argument('--repeat', type=int, default=5, help="Timed samples per case (default: 5)")
+    parser.add_argument('--min-time', type=float, default=0.2, help="Minimum seconds per sample (default: 0.2)")
+    parser.add_argument('--results', default=None, help="History file (default: benchmarks/results/<machine>.jsonl)")
+    parser.add_argument('--baseline-runs', type=int, default=5, help="Previous runs the baseline is the median of")
+    parser.add_argument('--threshold', type=float, default=1.25, help="Slowdown ratio reported as a regression")
+    parser.add_argument('--check', action='store_true', help="Exit with status 1 when a regression is found")
+    parser.add_argument('--no-save', action='store_true', help="Do not append this run to the history")
+    parser.add_argument('--list', action='store_true', help="List the cases and exit")
+    return parser.parse_args(argv)
+
+def _format_seconds(seconds):
+    for unit, scale in (('s', 1), ('ms', 1e-3), ('us', 1e-6)):
+        if seconds >= scale:
+            return f"{seconds / scale:8.2f} {unit}"
+    return f"{seconds / 1e-9:8.2f} ns"
+
+def main(argv=None):
+    args = parse_args(argv)
+    logging.basicConfig(level=logging.WARNING) # The code under test logs at INFO per call
+    import benchmarks.cases # Registers the cases
+
+    sizes = args.sizes.split(',') if args.sizes else None
+    unknown = [size for size in sizes or () if size not in SIZES]
+    if unknown:
+        print(f"Unknown sizes: {', '.join(unknown)}", file=sys.stderr)
+        return 2
+    pattern = re.compile(args.filter) if args.filter else None
+    cases = [case for case in REGISTRY if pattern is None or pattern.search(case.name)]
+    if args.list:
+        for case in cases:
+            print(f"{case.name}  [{', '.join(case.sizes)}]")
+        return 0
+
+    env = environment()
+    results_path = args.results or os.path.join(RESULTS_DIR, f"{env['machine'] or 'unknown'}.jsonl")
+    reference = baseline(load_history(results_path), args.baseline_runs)
+
+    results = []
+    for case in cases:
+        for size in case.sizes:
+            if sizes is not None and size not in sizes:
+                continue
+            result = time_case(case, size, repeat=args.repeat, min_time=args.min_time)
+            results.append(result)
+            per_bar = f"  {result['ns_per_bar']:10.1f} ns/bar" if result['ns_per_bar'] is not None else ''
+            base = reference.get((case.name, size))
+            change = f"  x{result['median_s'] / base:.2f} vs baseline" if base else ''
+            print(f"{case.name:55s} {size:>5s}  {_format_seconds(result['median_s'])}{per_bar}{change}", flush=True)
+
+    env = environment() # Library versions are known once the cases imported them
+    if not args.no_save:
+        append_run(results_path, results, env)
+        print(f"\nResults appended to {results_path}")
+
+    regressions = compare(results, reference, args.threshold)
+    for regression in regressions:
+        print(f"REGRESSION {regression['name']} [{regression['size']}]: {_format_seconds(regression['median_s']).strip()} "
+              f"vs {_format_seconds(regression['baseline_s']).strip()} (x{regression['ratio']:.2f})")
+    return 1 if args.check and regressions else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,122 @@
+"""
+Benchmark cases for the native hot paths: the backtest loop, every indicator,
+each strategy's signal generation, swing-point discovery, and a full optimizer
+run. All data is synthetic with a fixed seed, so runs are comparable.
+"""
+
+import logging
+import os
+import tempfile
+from functools import lru_cache
+
+import numpy as np
+import pandas as pd
+
+from benchmarks.harness import SIZES, benchmark
+from config import strategy_configs, indicator_defaults, DEFAULT_SPREAD_PERCENTAGE, DEFAULT_SLIPPAGE_PERCENTAGE
+import indicators
+from indicators import Indicators, calculate_atr, calculate_adx_values
+from strategy import Strategy, get_trade_signal
+from lines import find_swing_points, auto_discover_percentage_change
+
+SEED = 42
+OPTIMIZER_TRIALS = 20
+
+BACKTEST_PARAMS = {
+    **indicator_defaults,
+    'short_ema_period': indicator_defaults['short_ema'],
+    'long_ema_period': indicator_defaults['long_ema'],
+    'spread_percentage': DEFAULT_SPREAD_PERCENTAGE,
+    'slippage_percentage': DEFAULT_SLIPPAGE_PERCENTAGE,
+}
+
+@lru_cache(maxsize=len(SIZES))
+def synthetic_ohlcv(n_bars: int) -> pd.DataFrame:
+    """Random-walk 30m candles; cached per size and never mutated by the cases."""
+    rng = np.random.default_rng(SEED)
+    close = 100 * np.exp(np.cumsum(rng.normal(0, 0.004, n_bars)))
+    spread = np.abs(rng.normal(0, 0.002, n_bars)) * close
+    df = pd.DataFrame({
+        'open': np.roll(close, 1),
+        'high': close + spread,
+        'low': close - spread,
+        'close': close,
+        'volume': rng.integers(1_000, 10_000, n_bars).astype(np.float64),
+    }, index=pd.date_range('2023-01-01', periods=n_bars, freq='30min'))
+    df.iloc[0, 0] = close[0]
+    df['price'] = df['close'] # Column name used by lines.py
+    return df
+
+# --- Backtest loop ---
+
+def _backtest_inputs(n_bars):
+    from backtester import periods_per_year
+    df = synthetic_ohlcv(n_bars)
+    signals = Strategy(Indicators(), strategy_configs['EMA_Only']).generate_signals(df, BACKTEST_PARAMS)
+    adx = calculate_adx_values(df, window=BACKTEST_PARAMS['adx_period'])
+    prices = df['close'].to_numpy(dtype=np.float64)
+    return (
+        prices, *(signal.to_numpy() for signal in signals),
+        calculate_atr(df, BACKTEST_PARAMS['atr_period']).to_numpy(dtype=np.float64),
+        adx['adx'].to_numpy(dtype=np.float64), adx['pdi'].to_numpy(dtype=np.float64), adx['ndi'].to_numpy(dtype=np.float64),
+        BACKTEST_PARAMS['atr_multiple'], BACKTEST_PARAMS['fixed_stop_loss_percentage'], BACKTEST_PARAMS['take_profit_multiple'],
+        100.0, BACKTEST_PARAMS['spread_percentage'], BACKTEST_PARAMS['slippage_percentage'],
+        abs(prices[-1] - prices[0]) / prices[0], False, periods_per_year(df),
+    )
+
+@benchmark('backtest.run_backtest_cython', _backtest_inputs)
+def bench_run_backtest_cython(args):
+    from backtester_cython import run_backtest_cython
+    run_backtest_cython(*args)
+
+# --- Indicators ---
+
+INDICATOR_CALLS = {
+    'sma': lambda df: indicators.calculate_sma(df, 20),
+    'ema': lambda df: indicators.calculate_ema(df, 20),
+    'rsi': lambda df: indicators.calculate_rsi(df, 14),
+    'macd': lambda df: indicators.calculate_macd(df, 26, 12, 9),
+    'bbands': lambda df: indicators.calculate_bbands(df, 20, 2),
+    'atr': lambda df: indicators.calculate_atr(df, 14),
+    'adx_values': lambda df: indicators.calculate_adx_values(df, 14),
+    'adx': lambda df: indicators.calculate_adx(df, 14),
+}
+
+for _name, _call in INDICATOR_CALLS.items():
+    benchmark(f'indicators.calculate_{_name}', synthetic_ohlcv)(_call)
+
+# --- Signal generation, per strategy ---
+
+def _register_strategy(name):
+    @benchmark(f'strategy.get_trade_signal[{name}]', synthetic_ohlcv)
+    def bench_get_trade_signal(df):
+        get_trade_signal(df, strategy_configs[name], BACKTEST_PARAMS)
+
+for _strategy in strategy_configs:
+    _register_strategy(_strategy)
+
+# --- Swing points and line discovery ---
+
+@benchmark('lines.find_swing_points', synthetic_ohlcv)
+def bench_find_swing_points(df):
+    find_swing_points(df, percentage_change=0.02)
+
+# Every candidate threshold fits all pairs of its swing points, so cost grows quadratically past 10k bars
+@benchmark('lines.auto_discover_percentage_change', synthetic_ohlcv, sizes=('1k', '10k'))
+def bench_auto_discover_percentage_change(df):
+    auto_discover_percentage_change(df, df.index[0])
+
+# --- Full optimizer run ---
+
+def _optimizer_inputs(n_bars):
+    os.environ['OPTIMIZER_STUDY_STORAGE'] = 'memory' # No warm start: every run starts from the same state
+    from core.optimizer import BayesianOptimizer
+    results_dir = tempfile.mkdtemp(prefix='benchmark_optimizer_')
+    optimizer = BayesianOptimizer(results_dir=results_dir, logger=logging.getLogger('benchmarks.optimizer'))
+    return optimizer, synthetic_ohlcv(n_bars)
+
+@benchmark(f'optimizer.optimize_single_crypto[{OPTIMIZER_TRIALS} trials]', _optimizer_inputs,
+           sizes=('1k', '10k'), per_bar=False, repeat=3)
+def bench_optimize_single_crypto(state):
+    optimizer, df = state
+    optimizer.optimize_single_crypto('benchmark', 'EMA_Only', n_trials=OPTIMIZER_TRIALS, data=df)
@@ -0,0 +1,121 @@
+"""
+Minimal benchmark harness: registered cases, repeat-until-stable timing, and a
+per-machine JSONL history that each run is compared against.
+
+A case is a setup(n_bars) returning the state and a run(state) that is timed;
+setup cost is never measured. Every case/size is warmed up once, then run
+`repeat` times (each sample at least min_time seconds long, looping run() as
+often as needed); the median sample is what is reported and compared.
+"""
+
+import json
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import time
+from datetime import datetime
+from typing import Any, Callable, Dict, List, Optional
+
+SIZES = {'1k': 1_000, '10k': 10_000, '100k': 100_000, '1M': 1_000_000}
+DEFAULT_SIZES = ('1k', '100k', '1M')
+
+class Benchmark:
+    def __init__(self, name: str, setup: Callable[[int], Any], run: Callable[[Any], Any],
+                 sizes=DEFAULT_SIZES, per_bar: bool = True, repeat: Optional[int] = None):
+        self.name = name
+        self.setup = setup
+        self.run = run
+        self.sizes = tuple(sizes) # Labels of SIZES this case is measured at
+        self.per_bar = per_bar # Also report the time per bar
+        self.repeat = repeat # Overrides the run's repeat count for slow cases
+
+REGISTRY: List[Benchmark] = []
+
+def benchmark(name: str, setup: Callable[[int], Any], sizes=DEFAULT_SIZES, per_bar: bool = True,
+              repeat: Optional[int] = None):
+    """Decorator registering run(state) as a benchmark case."""
+    def register(run):
+        REGISTRY.append(Benchmark(name, setup, run, sizes, per_bar, repeat))
+        return run
+    return register
+
+def time_case(case: Benchmark, size: str, repeat: int = 5, min_time: float = 0.2) -> Dict[str, Any]:
+    n_bars = SIZES[size]
+    repeat = case.repeat or repeat
+    state = case.setup(n_bars)
+    case.run(state) # Warm-up: imports, caches, first-call allocations
+    samples = []
+    for _ in range(repeat):
+        loops, start = 0, time.perf_counter()
+        while True:
+            case.run(state)
+            loops += 1
+            elapsed = time.perf_counter() - start
+            if elapsed >= min_time:
+                break
+        samples.append(elapsed / loops)
+    median = statistics.median(samples)
+    return {
+        'name': case.name,
+        'size': size,
+        'bars': n_bars,
+        'median_s': median,
+        'min_s': min(samples),
+        'stdev_s': statistics.stdev(samples) if len(samples) > 1 else 0.0,
+        'ns_per_bar': median / n_bars * 1e9 if case.per_bar else None,
+        'repeat': repeat,
+    }
+
+def _git_commit() -> Optional[str]:
+    try:
+        return subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], capture_output=True, text=True,
+                              cwd=os.path.dirname(os.path.abspath(__file__)), timeout=10).stdout.strip() or None
+    except (OSError, subprocess.SubprocessError):
+        return None
+
+def environment() -> Dict[str, Any]:
+    """What a result depends on besides the code: machine, interpreter, library versions."""
+    env = {'machine': platform.node(), 'platform': platform.platform(), 'python': platform.python_version(),
+           'cpu_count': os.cpu_count(), 'commit': _git_commit()}
+    for module in ('numpy', 'pandas', 'optuna'):
+        if module in sys.modules:
+            env[module] = getattr(sys.modules[module], '__version__', None)
+    return env
+
+def load_history(path: str) -> List[Dict[str, Any]]:
+    if not os.path.exists(path):
+        return []
+    runs = []
+    with open(path, 'r') as f:
+        for line in f:
+            try:
+                runs.append(json.loads(line))
+            except json.JSONDecodeError:
+                continue # Torn line of an interrupted run
+    return runs
+
+def append_run(path: str, results: List[Dict[str, Any]], env: Dict[str, Any]) -> None:
+    os.makedirs(os.path.dirname(path) or '.', exist_ok=True)
+    with open(path, 'a') as f:
+        f.write(json.dumps({'timestamp': datetime.now().isoformat(), 'environment': env, 'results': results}) + '\n')
+
+def baseline(history: List[Dict[str, Any]], last_runs: int = 5) -> Dict[tuple, float]:
+    """Per (name, size), the median of its medians over the last last_runs runs that measured it."""
+    samples: Dict[tuple, List[float]] = {}
+    for run in reversed(history):
+        for result in run['results']:
+            key = (result['name'], result['size'])
+            if len(samples.setdefault(key, [])) < last_runs:
+                samples[key].append(result['median_s'])
+    return {key: statistics.median(values) for key, values in samples.items()}
+
+def compare(results: List[Dict[str, Any]], reference: Dict[tuple, float], threshold: float = 1.25) -> List[Dict[str, Any]]:
+    """Results slower than threshold times their baseline, with the ratio."""
+    regressions = []
+    for result in results:
+        base = reference.get((result['name'], result['size']))
+        if base and result['median_s'] > threshold * base:
+            regressions.append({**result, 'baseline_s': base, 'ratio': result['median_s'] / base})
+    return regressions
@@ -1,10 +1,26 @@
 """
 Core module for shared trading functionality.
+
+The exports are imported on first access: TradingEngine pulls in pandas, optuna,
+scipy and matplotlib, which light modules such as core.job_status_manager or
+core.metrics (and the processes that only need those) should not pay for.
 """
 
-from .app_config import Config
-from .trading_engine import TradingEngine
-from .result_manager import ResultManager
-from .data_manager import DataManager
+from importlib import import_module
+
+_EXPORTS = {
+    'Config': '.app_config',
+    'TradingEngine': '.trading_engine',
+    'ResultManager': '.result_manager',
+    'DataManager': '.data_manager',
+}
+
+__all__ = list(_EXPORTS)
 
-__all__ = ['Config', 'TradingEngine', 'ResultManager', 'DataManager']
+def __getattr__(name):
+    module = _EXPORTS.get(name)
+    if module is None:
+        raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
+    value = getattr(import_module(module, __name__), name)
+    globals()[name] = value # Later lookups skip __getattr__
+    return value
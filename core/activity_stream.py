@@ -0,0 +1,99 @@
+"""
+Non-blocking websocket fan-out of the paper trader's activity messages.
+
+The trading loops push entries into bounded ring buffers (collections.deque
+appends and pops are atomic, so pushing takes no lock and never waits on a
+client). An emitter thread drains them every flush interval and sends one
+'trader_activity_batch' event per batch. Noisy per-crypto stages are coalesced
+to their latest message per crypto and, when the buffers overflow, lose their
+oldest entries first; decisions and lifecycle messages have their own buffer.
+"""
+
+import itertools
+import logging
+import threading
+from collections import deque
+from typing import Any, Dict, List, Optional
+
+from core import metrics
+
+logger = logging.getLogger(__name__)
+
+BATCH_EVENT = 'trader_activity_batch'
+PRIORITY_STAGES = frozenset({'Lifecycle', 'Decision', 'Signal', 'Strategy'}) # Never coalesced, buffered apart
+COALESCED_STAGES = frozenset({'Analysis', 'Monitoring'}) # Only the latest message per crypto is sent
+
+class ActivityStream:
+    def __init__(self, socketio: Any, capacity: int = 1000, flush_seconds: float = 0.25, max_batch: int = 100):
+        self.socketio = socketio
+        self.flush_seconds = flush_seconds
+        self.max_batch = max_batch
+        self._priority = deque(maxlen=capacity)
+        self._noisy = deque(maxlen=capacity)
+        self._sequence = itertools.count() # next() is atomic; orders entries across both buffers
+        self._wakeup = threading.Event()
+        self._closed = False
+        self._thread: Optional[threading.Thread] = None
+        self._start_lock = threading.Lock()
+
+    def push(self, entry: Dict[str, Any]) -> None:
+        """Queues an activity entry; returns at once, dropping the oldest entry of a full buffer."""
+        buffer = self._priority if entry.get('stage') in PRIORITY_STAGES else self._noisy
+        if len(buffer) == buffer.maxlen:
+            metrics.inc('activity_stream.dropped')
+        buffer.append((next(self._sequence), entry))
+        if self._thread is None:
+            self._start()
+
+    def _start(self) -> None:
+        with self._start_lock:
+            if self._thread is None and not self._closed:
+                self._thread = threading.Thread(target=self._run, daemon=True, name='ActivityStream')
+                self._thread.start()
+
+    def _run(self) -> None:
+        while not self._closed:
+            self._wakeup.wait(self.flush_seconds)
+            while self.flush() == self.max_batch: # Backlog: send the rest without waiting
+                pass
+
+    def _take(self) -> List[Dict[str, Any]]:
+        """Up to max_batch entries in push order, priority entries first when over budget."""
+        taken = []
+        for buffer in (self._priority, self._noisy):
+            while len(taken) < self.max_batch:
+                try:
+                    taken.append(buffer.popleft())
+                except IndexError:
+                    break
+        taken.sort(key=lambda item: item[0])
+        return [entry for _, entry in taken]
+
+    def flush(self) -> int:
+        """Emits one coalesced batch of the queued entries; returns how many entries it took."""
+        entries = self._take()
+        if not entries:
+            return 0
+        latest = {}
+        for index, entry in enumerate(entries):
+            if entry.get('stage') in COALESCED_STAGES:
+                latest[(entry['stage'], entry.get('crypto_id'))] = index
+        batch = [entry for index, entry in enumerate(entries)
+                 if entry.get('stage') not in COALESCED_STAGES or latest[(entry['stage'], entry.get('crypto_id'))] == index]
+        metrics.inc('activity_stream.coalesced', len(entries) - len(batch))
+        metrics.set_gauge('activity_stream.queued', len(self._priority) + len(self._noisy))
+        try:
+            with metrics.timer('activity_stream.emit'):
+                self.socketio.emit(BATCH_EVENT, batch)
+        except Exception as e:
+            logger.error(f"Error emitting websocket activity: {e}")
+        return len(entries)
+
+    def close(self) -> None:
+        """Stops the emitter after sending what is still queued."""
+        self._closed = True
+        self._wakeup.set()
+        if self._thread is not None:
+            self._thread.join(timeout=max(1.0, 4 * self.flush_seconds))
+        while self.flush():
+            pass
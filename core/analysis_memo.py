@@ -0,0 +1,113 @@
+"""
+Content-addressed memo of TradingEngine.analyze_crypto results.
+
+An analysis is fully determined by (crypto, strategy, parameters, timeframe), the
+backtest result it reports and the candles it runs on, so it is keyed by a hash
+of those inputs plus the timestamp and values of the latest candle (a forming
+candle is revised in place, under the same timestamp). Lookups go to an in-process LRU first and then
+to the saved analysis files, through the result index's content_key column, so
+repeated requests for the same inputs are answered without rerunning swing-line
+discovery, backtest selection or chart generation.
+"""
+
+import copy
+import hashlib
+import json
+import logging
+import threading
+from collections import OrderedDict
+from typing import Any, Dict, Optional
+
+logger = logging.getLogger(__name__)
+
+def analysis_memo_key(crypto_id: str, strategy_name: Optional[str], parameters: Optional[Dict[str, Any]],
+                      timeframe_days: float, latest_candle, latest_values=None, source=None) -> str:
+    """
+    sha256 of the canonical JSON of the analysis inputs. latest_values are the latest
+    candle's OHLC values and source identifies the backtest result the analysis reports.
+    """
+    payload = {
+        'crypto_id': crypto_id,
+        'strategy': strategy_name,
+        'parameters': parameters or {},
+        'timeframe_days': float(timeframe_days),
+        'latest_candle': str(latest_candle),
+        'latest_values': [float(value) for value in latest_values] if latest_values is not None else None,
+        'source': source,
+    }
+    canonical = json.dumps(payload, sort_keys=True, separators=(',', ':'), default=str)
+    return hashlib.sha256(canonical.encode('utf-8')).hexdigest()
+
+class AnalysisMemo:
+    """Thread-safe LRU of analysis results backed by the analyses saved by a ResultManager."""
+
+    def __init__(self, result_manager, max_entries: int = 128):
+        self.result_manager = result_manager
+        self.max_entries = max_entries
+        self._entries: "OrderedDict[str, Dict[str, Any]]" = OrderedDict()
+        self._lock = threading.Lock()
+        self.hits = 0
+        self.persistent_hits = 0
+        self.misses = 0
+
+    def __getstate__(self):
+        # TradingEngine gets pickled; the lock and the in-process tier stay behind
+        state = self.__dict__.copy()
+        del state['_lock']
+        state['_entries'] = OrderedDict()
+        return state
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        self._lock = threading.Lock()
+
+    def get(self, key: str) -> Optional[Dict[str, Any]]:
+        """Returns a copy of the analysis memoized under key, or None."""
+        with self._lock:
+            entry = self._entries.get(key)
+            if entry is not None:
+                self._entries.move_to_end(key)
+                self.hits += 1
+                return copy.deepcopy(entry)
+
+        try:
+            entry = self.result_manager.get_analysis_by_memo_key(key)
+        except Exception as e:
+            logger.warning(f"Could not look up memoized analysis {key[:12]}: {e}")
+            entry = None
+
+        with self._lock:
+            if entry is None:
+                self.misses += 1
+                return None
+            self.persistent_hits += 1
+            self._remember(key, entry)
+        return copy.deepcopy(entry)
+
+    def put(self, key: str, result: Dict[str, Any]) -> None:
+        """Memoizes a copy of result in the in-process tier (the caller saves it for the persistent one)."""
+        entry = copy.deepcopy(result)
+        with self._lock:
+            self._remember(key, entry)
+
+    def _remember(self, key: str, entry: Dict[str, Any]) -> None:
+        if self.max_entries <= 0:
+            return
+        self._entries[key] = entry
+        self._entries.move_to_end(key)
+        while len(self._entries) > self.max_entries:
+            self._entries.popitem(last=False)
+
+    def clear(self) -> None:
+        with self._lock:
+            self._entries.clear()
+
+    def stats(self) -> Dict[str, Any]:
+        with self._lock:
+            return {
+                'hits': self.hits,
+                'persistent_hits': self.persistent_hits,
+                'misses': self.misses,
+                'entries': len(self._entries),
+                'max_entries': self.max_entries,
+            }
@@ -59,10 +59,52 @@ class Config:
         self.PAPER_TRADING_SPREAD_PERCENTAGE = self.get_env_var('PAPER_TRADING_SPREAD_PERCENTAGE', 0.01, type=float)
         self.PAPER_TRADING_SLIPPAGE_PERCENTAGE = self.get_env_var('PAPER_TRADING_SLIPPAGE_PERCENTAGE', 0.0005, type=float)
         self.PAPER_TRADING_MIN_PROFIT_BUFFER = self.get_env_var('PAPER_TRADING_MIN_PROFIT_BUFFER', 5, type=float)
+        self.PAPER_TRADING_LEDGER_SNAPSHOT_EVENTS = self.get_env_var('PAPER_TRADING_LEDGER_SNAPSHOT_EVENTS', 200, type=int) # Ledger events between compacting snapshots
+        self.PAPER_TRADING_INCREMENTAL_SIGNALS = self.get_env_var('PAPER_TRADING_INCREMENTAL_SIGNALS', False, type=bool) # Keep indicator state between analysis cycles (signals over all candles seen, not the fetched window)
+        self.ACTIVITY_STREAM_CAPACITY = self.get_env_var('ACTIVITY_STREAM_CAPACITY', 1000, type=int) # Activity messages buffered per class before the oldest are dropped
+        self.ACTIVITY_STREAM_FLUSH_SECONDS = self.get_env_var('ACTIVITY_STREAM_FLUSH_SECONDS', 0.25, type=float) # Cadence of trader_activity_batch websocket events
+        self.ACTIVITY_STREAM_MAX_BATCH = self.get_env_var('ACTIVITY_STREAM_MAX_BATCH', 100, type=int)
+
+        # Analysis configuration
+        self.ANALYSIS_MEMO_MAX_ENTRIES = self.get_env_var('ANALYSIS_MEMO_MAX_ENTRIES', 128, type=int) # In-process tier of the analysis memo (0 = saved analyses only)
 
         # CoinGecko Rate Limiter Configuration
         self.COINGECKO_REQUESTS_PER_MINUTE = int(os.getenv('COINGECKO_REQUESTS_PER_MINUTE', 7)) # Default to 7 requests/minute
         self.COINGECKO_SECONDS_PER_REQUEST = float(os.getenv('COINGECKO_SECONDS_PER_REQUEST', 1.11)) # Default to 1.11 seconds/request
+        self.IPC_ARENA_MB = self.get_env_var('IPC_ARENA_MB', 16, type=int) # Shared-memory arena for large rate-limiter replies, per requesting process
+        self.CANDLE_RESAMPLER_MAX_ENTRIES = self.get_env_var('CANDLE_RESAMPLER_MAX_ENTRIES', 64, type=int) # Derived candle series kept per process (crypto, source and target interval)
+        self.HTTP_POOL_SIZE = self.get_env_var('HTTP_POOL_SIZE', 10, type=int) # Kept-alive connections per host of the pooled HTTP session
+        self.HTTP_RETRIES = self.get_env_var('HTTP_RETRIES', 3, type=int) # Retries of connection errors, timeouts and 429/5xx responses
+        self.HTTP_RETRY_BASE_SECONDS = self.get_env_var('HTTP_RETRY_BASE_SECONDS', 1.0, type=float) # Backoff cap of the first retry, doubled per retry (full jitter)
+        self.HTTP_RETRY_MAX_SECONDS = self.get_env_var('HTTP_RETRY_MAX_SECONDS', 30.0, type=float)
+
+        # Optimization configuration
+        self.INDICATOR_CACHE_MAX_MB = self.get_env_var('INDICATOR_CACHE_MAX_MB', 256, type=int) # Memory budget of the per-study indicator cache
+        # Worker processes running the trials of one study concurrently (1 = serial, 0 = one per CPU core)
+        trial_workers = self.get_env_var('OPTIMIZER_TRIAL_WORKERS', 1, type=int)
+        self.OPTIMIZER_TRIAL_WORKERS = trial_workers if trial_workers > 0 else (os.cpu_count() or 1)
+        self.OPTIMIZER_KEEP_TRIAL_WORKERS = self.get_env_var('OPTIMIZER_KEEP_TRIAL_WORKERS', True, type=bool) # Reuse one warm worker pool across studies
+        # Walk-forward objective: score trials over this many consecutive windows (1 = whole series only)
+        self.OPTIMIZER_WALK_FORWARD_WINDOWS = self.get_env_var('OPTIMIZER_WALK_FORWARD_WINDOWS', 1, type=int)
+        self.OPTIMIZER_WALK_FORWARD_STD_PENALTY = self.get_env_var('OPTIMIZER_WALK_FORWARD_STD_PENALTY', 1.0, type=float) # Weight of the spread between windows
+        # Optuna storage URL of the persistent trial archives, one per objective ('' = scheduler DB, 'memory' = no archive)
+        self.OPTIMIZER_STUDY_STORAGE = self.get_env_var('OPTIMIZER_STUDY_STORAGE', '')
+        self.OPTIMIZER_WARM_START_TRIALS = self.get_env_var('OPTIMIZER_WARM_START_TRIALS', 5, type=int) # Earlier best parameter sets re-evaluated first
+        # Pruner judging checkpointed equity: 'median', 'hyperband' or 'none'. The native loop
+        # runs in slices between checkpoints, so a pruned trial stops simulating bars
+        self.OPTIMIZER_PRUNER = self.get_env_var('OPTIMIZER_PRUNER', 'median').lower()
+        self.OPTIMIZER_PRUNING_CHECKPOINTS = self.get_env_var('OPTIMIZER_PRUNING_CHECKPOINTS', 10, type=int) # Intermediate values reported per trial
+        self.OPTIMIZER_PRUNING_STARTUP_TRIALS = self.get_env_var('OPTIMIZER_PRUNING_STARTUP_TRIALS', 5, type=int) # Trials completed before the median pruner acts
+        # Experimental Monte Carlo stress test of the best parameters (0 = off). Signals are not
+        # regenerated per path, so it measures fill-price and cost sensitivity only
+        self.OPTIMIZER_MONTE_CARLO_PATHS = self.get_env_var('OPTIMIZER_MONTE_CARLO_PATHS', 0, type=int)
+        self.OPTIMIZER_MONTE_CARLO_NOISE = self.get_env_var('OPTIMIZER_MONTE_CARLO_NOISE', 0.5, type=float) # Price jitter, in standard deviations of the bar returns
+        self.OPTIMIZER_MONTE_CARLO_COST_MULTIPLE = self.get_env_var('OPTIMIZER_MONTE_CARLO_COST_MULTIPLE', 2.0, type=float) # Spread/slippage scaled by up to this factor
+
+        # Hot-path metrics (core/metrics.py), served by /api/metrics
+        self.METRICS_ENABLED = self.get_env_var('METRICS_ENABLED', True, type=bool)
+        self.METRICS_PUBLISH_SECONDS = self.get_env_var('METRICS_PUBLISH_SECONDS', 5.0, type=float) # Min interval between writes of a job's or process's metrics
+        self.METRICS_RECENT_JOBS = self.get_env_var('METRICS_RECENT_JOBS', 20, type=int) # Finished jobs still exported, besides running ones
         
         # Ensure directories exist
         self._create_directories()
@@ -6,7 +6,7 @@ Eliminates the need for subprocess calls and provides direct Python access.
 import sys
 import os
 import logging
-from typing import Dict, Any, Optional, List
+from typing import Dict, Any, Optional, List, Callable
 import json
 from datetime import datetime, timedelta
 import numpy as np
@@ -16,6 +16,7 @@ import pandas as pd
 sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
 
 from core.app_config import Config
+from core import metrics
 
 try:
     from backtester import Backtester
@@ -73,7 +74,13 @@ class BacktesterWrapper:
                           parameters: Dict[str, Any],
                           timeframe: str = "7d",
                           interval: str = "30m",
-                          data: pd.DataFrame = None) -> Dict[str, Any]:
+                          data: pd.DataFrame = None,
+                          indicator_cache=None,
+                          include_trades: bool = False,
+                          walk_forward_windows: int = 0,
+                          walk_forward_std_penalty: float = 0.0,
+                          checkpoints: int = 0,
+                          on_checkpoint: Optional[Callable[[int, float], bool]] = None) -> Dict[str, Any]:
         """
         Run a single backtest with specified parameters.
         
@@ -84,6 +91,15 @@ class BacktesterWrapper:
             timeframe: Data timeframe (e.g., "7d", "30d")
             interval: Data interval (e.g., "30m", "1h")
             data: Pre-fetched data (optional)
+            indicator_cache: Shared IndicatorCache (optional), bound to this dataset before use
+            include_trades: Also return the trade list and equity curve
+            walk_forward_windows: Also evaluate the parameters over this many consecutive
+                windows (results under 'walk_forward'; 0 or 1 disables it)
+            walk_forward_std_penalty: Weight of the spread between windows in the robust score
+            checkpoints: Also return the equity after each of this many slices of the bars
+                ('equity_checkpoints', for trial pruning)
+            on_checkpoint: Called with (step, equity) after each checkpoint but the last;
+                returning True stops the backtest (result with 'pruned' and 'stopped_at_checkpoint')
             
         Returns:
             Backtest results dictionary
@@ -118,7 +134,8 @@ class BacktesterWrapper:
                 end_date = datetime.now()
                 timeframe_days = self._timeframe_to_days(timeframe)
                 start_date = end_date - timedelta(days=timeframe_days)
-                data = backtester.fetch_data(crypto, interval, start_date, end_date)
+                with metrics.timer('backtest.fetch_data'):
+                    data = backtester.fetch_data(crypto, interval, start_date, end_date)
             
             if data is None or len(data) == 0:
                 self.logger.error(f"No data available for {crypto} for timeframe {timeframe}")
@@ -131,7 +148,8 @@ class BacktesterWrapper:
                     'timestamp': datetime.now().isoformat()
                 }
             
-            backtester.set_data(data) # Set the fetched data
+            dataset_cache = indicator_cache.for_dataset(crypto, interval, data) if indicator_cache is not None else None
+            backtester.set_data(data, indicator_cache=dataset_cache) # Set the fetched data
             
             # Add required parameters for backtester
             backtest_params = parameters.copy()
@@ -139,7 +157,11 @@ class BacktesterWrapper:
             backtest_params['slippage_percentage'] = backtest_params.get('slippage_percentage', DEFAULT_SLIPPAGE_PERCENTAGE)
             
             # Run the backtest
-            result = backtester.run_backtest(backtest_params)
+            result = backtester.run_backtest(backtest_params, record_trades=include_trades,
+                                             walk_forward_windows=walk_forward_windows,
+                                             walk_forward_std_penalty=walk_forward_std_penalty,
+                                             checkpoints=checkpoints,
+                                             on_checkpoint=on_checkpoint)
             
             if result is None:
                 self.logger.error(f"Backtest returned None for {crypto}/{strategy}")
@@ -152,6 +174,19 @@ class BacktesterWrapper:
                     'timestamp': datetime.now().isoformat()
                 }
             
+            if result.get('stopped_at_checkpoint'):
+                return {
+                    'crypto': crypto,
+                    'strategy': strategy,
+                    'parameters': parameters,
+                    'success': False,
+                    'pruned': True,
+                    'stopped_at_checkpoint': result['stopped_at_checkpoint'],
+                    'bars_simulated': result['bars_simulated'],
+                    'equity_checkpoints': result['equity_checkpoints'],
+                    'timestamp': datetime.now().isoformat()
+                }
+
             # Ensure the result is a plain, JSON-serializable dictionary to break any circular references
             try:
                 serializable_result = json.loads(json.dumps(result))
@@ -176,6 +211,50 @@ class BacktesterWrapper:
                 'timestamp': datetime.now().isoformat()
             }
     
+    def run_monte_carlo(self,
+                        crypto: str,
+                        strategy: str,
+                        parameters: Dict[str, Any],
+                        timeframe: str = "7d",
+                        interval: str = "30m",
+                        data: pd.DataFrame = None,
+                        indicator_cache=None,
+                        n_paths: int = 1000,
+                        noise_fraction: float = 0.5,
+                        cost_multiple_max: float = 2.0,
+                        seed: int = 0) -> Optional[Dict[str, Any]]:
+        """
+        Experimental Monte Carlo robustness test of one parameter set (Backtester.run_monte_carlo): the
+        distributions of final capital and max drawdown over n_paths perturbed price paths
+        and spread/slippage scenarios. Returns None when it cannot run.
+        """
+        if not BACKTESTER_AVAILABLE or strategy not in strategy_configs:
+            return None
+
+        try:
+            backtester = Backtester(Strategy(strategy, strategy_configs[strategy]), strategy_configs[strategy],
+                                    data_fetcher=self.data_fetcher)
+            if data is None:
+                end_date = datetime.now()
+                start_date = end_date - timedelta(days=self._timeframe_to_days(timeframe))
+                with metrics.timer('backtest.fetch_data'):
+                    data = backtester.fetch_data(crypto, interval, start_date, end_date)
+            if data is None or len(data) < 2:
+                self.logger.warning(f"Not enough data for a Monte Carlo run of {crypto}/{strategy}")
+                return None
+
+            dataset_cache = indicator_cache.for_dataset(crypto, interval, data) if indicator_cache is not None else None
+            backtester.set_data(data, indicator_cache=dataset_cache)
+
+            backtest_params = parameters.copy()
+            backtest_params['spread_percentage'] = backtest_params.get('spread_percentage', DEFAULT_SPREAD_PERCENTAGE)
+            backtest_params['slippage_percentage'] = backtest_params.get('slippage_percentage', DEFAULT_SLIPPAGE_PERCENTAGE)
+            return backtester.run_monte_carlo(backtest_params, n_paths=n_paths, noise_fraction=noise_fraction,
+                                              cost_multiple_max=cost_multiple_max, seed=seed)
+        except Exception as e:
+            self.logger.error(f"Monte Carlo run failed for {crypto}/{strategy}: {e}")
+            return None
+
     def run_batch_backtest(self, 
                          test_configs: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
         """
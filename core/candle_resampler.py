@@ -0,0 +1,115 @@
+"""
+Candles of coarser intervals derived from one stored OHLC history.
+
+CoinGecko timestamps a candle at its close, so a candle belongs to the bucket
+ending at the next multiple of the target interval (UTC). Aggregation is one
+vectorized pass: bucket boundaries are found with np.flatnonzero and the
+high/low of every bucket with ufunc.reduceat. Derived series are cached per
+(crypto, source interval, target interval) and rebuilt only when the source
+history changed.
+"""
+
+import logging
+import threading
+from collections import OrderedDict
+from typing import Optional, Tuple
+
+import numpy as np
+
+from .ohlc_store import OHLC_RECORD_DTYPE
+from . import metrics
+
+logger = logging.getLogger(__name__)
+
+# Intervals candles can be requested at, in seconds
+RESAMPLE_INTERVALS = {
+    '30m': 30 * 60,
+    '1h': 3600,
+    '4h': 4 * 3600,
+    '1d': 86400,
+    '4d': 4 * 86400,
+}
+
+def can_resample(source: str, target: str) -> bool:
+    """target candles can be built from source candles (a whole number of them per bucket)."""
+    if source not in RESAMPLE_INTERVALS or target not in RESAMPLE_INTERVALS:
+        return False
+    return RESAMPLE_INTERVALS[target] % RESAMPLE_INTERVALS[source] == 0
+
+def resample_records(records: np.ndarray, source: str, target: str) -> np.ndarray:
+    """
+    Aggregates sorted source records into target candles (open of the first, close of
+    the last, max high, min low). A leading bucket the history only partly covers is
+    dropped; a trailing one is kept, like the still forming last candle of a fetch.
+    """
+    if source == target or len(records) == 0:
+        return records
+    if not can_resample(source, target):
+        raise ValueError(f"{target} candles cannot be built from {source} candles")
+    step_ms = RESAMPLE_INTERVALS[target] * 1000
+    timestamps = records['timestamp']
+    buckets = -(-timestamps // step_ms) * step_ms # Close time of the bucket each candle falls in
+    starts = np.flatnonzero(np.concatenate(([True], buckets[1:] != buckets[:-1])))
+    ends = np.append(starts[1:], len(records)) - 1
+
+    per_bucket = RESAMPLE_INTERVALS[target] // RESAMPLE_INTERVALS[source]
+    if len(starts) > 1 and ends[0] - starts[0] + 1 < per_bucket:
+        starts, ends = starts[1:], ends[1:]
+
+    resampled = np.empty(len(starts), dtype=OHLC_RECORD_DTYPE)
+    resampled['timestamp'] = buckets[starts]
+    resampled['open'] = records['open'][starts]
+    resampled['close'] = records['close'][ends]
+    resampled['high'] = np.maximum.reduceat(records['high'], starts)
+    resampled['low'] = np.minimum.reduceat(records['low'], starts)
+    return resampled
+
+class CandleResampler:
+    """LRU of derived candle series, keyed by crypto and source/target interval."""
+
+    def __init__(self, max_entries: int = 64):
+        self.max_entries = max_entries
+        self._entries: "OrderedDict[Tuple[str, str, str], Tuple[Tuple, np.ndarray]]" = OrderedDict()
+        self._lock = threading.Lock()
+
+    @staticmethod
+    def _version(records: np.ndarray) -> Tuple:
+        # Merges append candles or rewrite the file (length or first candle change) and may
+        # update the last candle in place, so these identify the stored history
+        if len(records) == 0:
+            return (0,)
+        return (len(records), int(records['timestamp'][0]), records[-1].tobytes())
+
+    def resample(self, crypto_id: str, records: np.ndarray, source: str, target: str,
+                 start_ms: Optional[int] = None) -> np.ndarray:
+        """
+        target candles of the whole stored source history (records), from start_ms on.
+        The returned array is shared with the cache and read-only.
+        """
+        if source == target:
+            resampled = records
+        else:
+            key = (crypto_id, source, target)
+            version = self._version(records)
+            with self._lock:
+                entry = self._entries.get(key)
+                if entry is not None and entry[0] == version:
+                    self._entries.move_to_end(key)
+                    resampled = entry[1]
+                else:
+                    resampled = None
+            if resampled is not None:
+                metrics.inc('candle_resampler.hits')
+            else:
+                metrics.inc('candle_resampler.misses')
+                with metrics.timer('candle_resampler.aggregate'):
+                    resampled = resample_records(records, source, target)
+                resampled.flags.writeable = False
+                with self._lock:
+                    self._entries[key] = (version, resampled)
+                    self._entries.move_to_end(key)
+                    while len(self._entries) > self.max_entries:
+                        self._entries.popitem(last=False)
+        if start_ms is None:
+            return resampled
+        return resampled[int(np.searchsorted(resampled['timestamp'], start_ms, side='left')):]
@@ -6,39 +6,13 @@ Consolidates logic from get_volatile_cryptos.py and volatile_crypto_optimizer.py
 import requests
 import json
 import logging
-import time
 from datetime import datetime, timedelta
 from typing import Dict, List, Optional, Tuple
 import os
-from functools import wraps
 
 from .data_fetcher import DataFetcher # New import
-
-def retry_on_exception(retries=3, delay=5, backoff=2, exception_to_check=Exception):
-    """
-    A decorator to retry a function call on exception with exponential backoff.
-    Re-raises the exception on failure.
-    """
-    def decorator(func):
-        @wraps(func)
-        def wrapper(*args, **kwargs):
-            _delay = delay
-            last_exception = None
-            for i in range(retries):
-                try:
-                    return func(*args, **kwargs)
-                except exception_to_check as e:
-                    last_exception = e
-                    logging.warning(f"Caught {e}, retrying in {_delay} seconds... ({i+1}/{retries})")
-                    time.sleep(_delay)
-                    _delay *= backoff
-            logging.error(f"Function {func.__name__} failed after {retries} retries.")
-            if last_exception:
-                raise last_exception
-        return wrapper
-    return decorator
-
 from .exceptions import CoinGeckoAPIError # Import from exceptions.py
+from .market_snapshot import MarketSnapshot, get_snapshot, publish_snapshot
 
 class CryptoDiscovery:
     """
@@ -67,48 +41,50 @@ class CryptoDiscovery:
         """
         Fetch volatile cryptocurrencies based on 24h price change.
         """
+        return self._market_snapshot(cache_hours, force_refresh).volatile(min_volatility, limit)
+
+    def _market_snapshot(self, cache_hours: int = 24, force_refresh: bool = False) -> MarketSnapshot:
+        """
+        The in-memory snapshot of the market list: rebuilt from the cache file only when the
+        file changed since, and from CoinGecko when the cache is stale or force_refresh is set.
+        """
         cache_file = os.path.join(self.cache_dir, "volatile_cryptos.json")
-        all_cryptos = []
 
         if not force_refresh and self._is_cache_valid(cache_file, cache_hours):
+            snapshot = get_snapshot(cache_file)
+            if snapshot is not None:
+                return snapshot
             self.logger.info("`force_refresh` is false and cache is valid. Using cached volatile crypto data.")
-            all_cryptos = self._load_cache(cache_file)
-        else:
-            self.logger.info("Fetching volatile cryptos from CoinGecko")
-            url = "https://api.coingecko.com/api/v3/coins/markets" # Base URL is now hardcoded or managed by DataFetcher
-            params = {
-                'vs_currency': 'usd',
-                'order': 'market_cap_desc',
-                'per_page': 250,
-                'page': 1,
-                'sparkline': False,
-                'price_change_percentage': '24h',
-                'order': 'volume_desc'
-            }
-            
-            try:
-                if self.data_fetcher is None:
-                    raise ValueError("DataFetcher not initialized in CryptoDiscovery.")
-                data = self.data_fetcher.make_coingecko_request(url, params=params) # Assuming DataFetcher has this method
-                all_cryptos = self._process_crypto_data(data)
-                self._save_cache(cache_file, all_cryptos)
-                self.logger.info(f"Found and cached {len(all_cryptos)} cryptos")
-                
-            except requests.exceptions.HTTPError as e:
-                status_code = e.response.status_code if e.response else None
-                if status_code == 429:
-                    raise CoinGeckoAPIError(f"Rate limit exceeded: {e}", status_code=status_code) from e
-                raise CoinGeckoAPIError(f"Failed to fetch data from CoinGecko: {e}", status_code=status_code) from e
-            except requests.exceptions.RequestException as e:
-                raise CoinGeckoAPIError(f"Failed to fetch data from CoinGecko: {e}") from e
+            return publish_snapshot(cache_file, self._load_cache(cache_file))
 
-        volatile_cryptos = [
-            crypto for crypto in all_cryptos
-            if abs(crypto.get('price_change_percentage_24h', 0)) >= min_volatility
-        ]
-        
-        volatile_cryptos.sort(key=lambda x: x['volatility_score'], reverse=True)
-        return volatile_cryptos[:limit]
+        self.logger.info("Fetching volatile cryptos from CoinGecko")
+        url = "https://api.coingecko.com/api/v3/coins/markets" # Base URL is now hardcoded or managed by DataFetcher
+        params = {
+            'vs_currency': 'usd',
+            'order': 'market_cap_desc',
+            'per_page': 250,
+            'page': 1,
+            'sparkline': False,
+            'price_change_percentage': '24h',
+            'order': 'volume_desc'
+        }
+
+        try:
+            if self.data_fetcher is None:
+                raise ValueError("DataFetcher not initialized in CryptoDiscovery.")
+            data = self.data_fetcher.make_coingecko_request(url, params=params) # Assuming DataFetcher has this method
+            all_cryptos = self._process_crypto_data(data)
+            self._save_cache(cache_file, all_cryptos)
+            self.logger.info(f"Found and cached {len(all_cryptos)} cryptos")
+            return publish_snapshot(cache_file, all_cryptos)
+
+        except requests.exceptions.HTTPError as e:
+            status_code = e.response.status_code if e.response else None
+            if status_code == 429:
+                raise CoinGeckoAPIError(f"Rate limit exceeded: {e}", status_code=status_code) from e
+            raise CoinGeckoAPIError(f"Failed to fetch data from CoinGecko: {e}", status_code=status_code) from e
+        except requests.exceptions.RequestException as e:
+            raise CoinGeckoAPIError(f"Failed to fetch data from CoinGecko: {e}") from e
 
     def update_exchanges_for_cached_cryptos(self,
                                           crypto_ids_to_update: Optional[List[str]] = None,
@@ -147,6 +123,7 @@ class CryptoDiscovery:
                     crypto['exchanges'] = self.get_crypto_exchanges(crypto['id'])
                     updated_count += 1
                     self._save_cache(cache_file, all_cryptos)
+                    publish_snapshot(cache_file, all_cryptos) # Readers pick up the exchanges without re-reading the file
                     self.logger.info(f"Updated and saved exchanges for {crypto.get('name', 'N/A')}")
                 except CoinGeckoAPIError as e:
                     self.logger.error(f"Could not fetch exchanges for {crypto.get('name', 'N/A')}: {e}")
@@ -166,28 +143,9 @@ class CryptoDiscovery:
         """
         Get top gaining and losing cryptocurrencies.
         """
-        volatile_cryptos = self.get_volatile_cryptos()
-        
-        if not volatile_cryptos:
-            return {'gainers': [], 'losers': []}
-        
-        sorted_cryptos = sorted(volatile_cryptos, 
-                              key=lambda x: x.get('price_change_percentage_24h', 0), 
-                              reverse=True)
-        
-        result = {}
-        
-        if include_gainers:
-            gainers = [crypto for crypto in sorted_cryptos 
-                      if crypto.get('price_change_percentage_24h', 0) > 0]
-            result['gainers'] = gainers[:count]
-        
-        if include_losers:
-            losers = [crypto for crypto in sorted_cryptos 
-                     if crypto.get('price_change_percentage_24h', 0) < 0]
-            result['losers'] = losers[-count:]
-        
-        return result
+        # Ranked among the default get_volatile_cryptos() list (top 100 with |change| >= 5%)
+        return self._market_snapshot().top_movers(count, min_volatility=5.0, limit=100,
+                                                  include_gainers=include_gainers, include_losers=include_losers)
     
     def get_crypto_by_volatility(self, min_volatility: float = 20.0) -> List[Dict]:
         """
@@ -260,8 +218,17 @@ class CryptoDiscovery:
     
     def search_cryptos(self, query: str, limit: int = 10) -> List[Dict]:
         """
-        Search for cryptocurrencies by name or symbol.
+        Search for cryptocurrencies by name or symbol. Coins of the cached market list are
+        answered from its index when one matches exactly or enough of them match by prefix.
         """
+        cache_file = os.path.join(self.cache_dir, "volatile_cryptos.json")
+        snapshot = get_snapshot(cache_file)
+        if snapshot is None and os.path.exists(cache_file):
+            snapshot = publish_snapshot(cache_file, self._load_cache(cache_file)) # However old: no refresh for a search
+        local_results, exact = snapshot.search(query, limit) if snapshot is not None else ([], False)
+        if exact or (local_results and len(local_results) >= limit):
+            return local_results
+
         url = f"https://api.coingecko.com/api/v3/search" # Base URL is now hardcoded or managed by DataFetcher
         params = {'query': query}
         
@@ -347,10 +314,12 @@ class CryptoDiscovery:
             return []
     
     def _save_cache(self, cache_file: str, data: List[Dict]) -> None:
-        """Save data to cache file."""
+        """Save data to cache file (atomically: readers never see a partly written list)."""
         try:
-            with open(cache_file, 'w') as f:
+            temp_file = cache_file + ".tmp"
+            with open(temp_file, 'w') as f:
                 json.dump(data, f, indent=2)
+            os.replace(temp_file, cache_file)
         except OSError as e:
             self.logger.error(f"Error saving cache: {e}")
     
@@ -5,156 +5,284 @@ from datetime import datetime, timedelta
 import os
 import json
 import time
-from functools import wraps
 from typing import Optional, Dict
 import multiprocessing
+import socket
+import threading
+import asyncio
 import uuid
+from concurrent.futures import Future
 
 from .exceptions import CoinGeckoRateLimitError, CoinGeckoAPIError
+from .rate_limiter import request_key
+from .fetch_planner import FetchPlanner
+from .ipc_channels import ReplyChannel
+from .http_client import http_get
+from .ohlc_store import OHLCStore, INTERVAL_SECONDS, coingecko_interval, records_to_dataframe
+from .candle_resampler import CandleResampler, RESAMPLE_INTERVALS, can_resample
+from . import metrics
 
 def _perform_request_static(url: str, params: Optional[Dict] = None, timeout: int = 30):
+    """Runs in the rate limiter process; transient failures are retried there (RetryPolicy)."""
     try:
-        response = requests.get(url, params=params, timeout=timeout)
-        return response
+        return http_get(url, params=params, timeout=timeout)
     except requests.exceptions.HTTPError as e:
         status_code = e.response.status_code if e.response else None
         if status_code == 429:
             raise CoinGeckoRateLimitError(f"Rate limit exceeded: {e}")
         raise CoinGeckoAPIError(f"Failed to fetch data from CoinGecko: {e}", status_code=status_code)
+    except (requests.exceptions.ConnectionError, requests.exceptions.Timeout):
+        raise # Retryable: left as is for the limiter's RetryPolicy
     except requests.exceptions.RequestException as e:
         raise CoinGeckoAPIError(f"Failed to fetch data from CoinGecko: {e}")
 
-def retry_on_exception(retries=3, delay=5, backoff=2, exception_to_check=Exception):
-    """
-    A decorator to retry a function call on exception with exponential backoff.
-    Re-raises the exception on failure.
-    """
-    def decorator(func):
-        @wraps(func)
-        def wrapper(*args, **kwargs):
-            _delay = delay
-            last_exception = None
-            for i in range(retries):
-                try:
-                    return func(*args, **kwargs)
-                except exception_to_check as e:
-                    last_exception = e
-                    logging.warning(f"Caught {e}, retrying in {_delay} seconds... ({i+1}/{retries})")
-                    time.sleep(_delay)
-                    _delay *= backoff
-            logging.error(f"Function {func.__name__} failed after {retries} retries.")
-            if last_exception:
-                raise last_exception
-        return wrapper
-    return decorator
-
 from core.app_config import Config
 
 class DataFetcher:
+    OHLC_TTL_SECONDS = 30 * 60
+    PRICE_TTL_SECONDS = 60
+
     def __init__(self, request_queue: multiprocessing.Queue, response_queue: multiprocessing.Queue, config: Config):
         self.request_queue = request_queue
         self.response_queue = response_queue
         self.config = config or Config()
         self.logger = logging.getLogger(__name__)
+        self.ohlc_store = OHLCStore(os.path.join(self.config.CACHE_DIR, 'ohlc'))
+        self.candle_resampler = CandleResampler(max_entries=self.config.CANDLE_RESAMPLER_MAX_ENTRIES)
+        self._pending = {} # request_id -> Future of the limiter's response
+        self._inflight = {} # request_key -> Future shared by identical concurrent requests
+        self._pending_lock = threading.Lock()
+        self._dispatcher = None
+        self._reply_channel = None
+        self._reply_channel_supported = hasattr(socket, 'AF_UNIX')
+        self._price_cache = {} # crypto_id -> (price, fetched_at), fed by every price or market fetch
 
-    def fetch_ohlc_data(self, crypto_id, days):
-        """Fetches OHLC data from CoinGecko, with a 30-minute cache."""
+    @staticmethod
+    def _ohlc_window(days):
+        """(interval, start_ms) of the candles covering the last `days` days."""
         days = int(days)
-        ttl_seconds = 30 * 60
+        return coingecko_interval(days), int((time.time() - days * 86400) * 1000)
 
-        cache_dir = self.config.CACHE_DIR
-        safe_crypto_id = crypto_id.replace(" ", "_").lower()
-        cache_filename = f"{safe_crypto_id}_{days}d_ohlc.json"
-        cache_filepath = os.path.join(cache_dir, cache_filename)
+    def _history_covers(self, crypto_id, interval, start_ms) -> bool:
+        """The stored `interval` history was refreshed in the last 30 minutes and reaches back to start_ms."""
+        # The first returned candle may start up to two bars after the requested start
+        coverage_slack_ms = 2 * INTERVAL_SECONDS[interval] * 1000
+        age_seconds = self.ohlc_store.age_seconds(crypto_id, interval)
+        if age_seconds is None or age_seconds >= self.OHLC_TTL_SECONDS:
+            return False
+        first = self.ohlc_store.read(crypto_id, interval)[:1]
+        return len(first) > 0 and int(first['timestamp'][0]) <= start_ms + coverage_slack_ms
 
-        os.makedirs(cache_dir, exist_ok=True)
+    def _fresh_source(self, crypto_id, days, interval):
+        """Finest stored history that is fresh, covers the last `days` days and aggregates into `interval`."""
+        _, start_ms = self._ohlc_window(days)
+        for source in sorted(INTERVAL_SECONDS, key=INTERVAL_SECONDS.get):
+            if can_resample(source, interval) and self._history_covers(crypto_id, source, start_ms):
+                return source
+        return None
 
-        if os.path.exists(cache_filepath):
-            file_mod_time = os.path.getmtime(cache_filepath)
-            age_seconds = time.time() - file_mod_time
-            if age_seconds < ttl_seconds:
-                self.logger.info(f"Cache hit for {crypto_id} (OHLC). Reading from {cache_filepath}")
-                try:
-                    with open(cache_filepath, 'r') as f:
-                        return json.load(f)
-                except (json.JSONDecodeError, IOError) as e:
-                    self.logger.warning(f"Failed to read cache file {cache_filepath}: {e}. Re-fetching.")
-            else:
-                self.logger.info(f"Cache stale for {crypto_id} (OHLC).")
+    def _candle_interval(self, days, interval):
+        """interval, or the native one of the window when the resampler does not know it."""
+        native = coingecko_interval(int(days))
+        if interval is None or interval == native:
+            return native
+        if interval not in RESAMPLE_INTERVALS:
+            self.logger.warning(f"Unsupported candle interval {interval}; using {native} candles")
+            return native
+        return interval
+
+    def _read_candles(self, crypto_id, days, interval, source=None):
+        """The stored candles of the last `days` days at `interval`, aggregated from `source` (default: native)."""
+        native, start_ms = self._ohlc_window(days)
+        source = source or native
+        if not can_resample(source, interval):
+            self.logger.warning(f"No {interval} candles derivable from the {source} history of {crypto_id}; using {source} candles")
+            interval = source
+        if source == interval:
+            return self.ohlc_store.read(crypto_id, source, start_ms=start_ms)
+        return self.candle_resampler.resample(crypto_id, self.ohlc_store.read(crypto_id, source), source, interval,
+                                              start_ms=start_ms)
+
+    def is_ohlc_cached(self, crypto_id, days, interval=None) -> bool:
+        """Some stored history refreshed in the last 30 minutes covers the last `days` days at `interval` or finer."""
+        return self._fresh_source(crypto_id, days, self._candle_interval(days, interval)) is not None
+
+    def read_cached_ohlc(self, crypto_id, days, interval=None):
+        """The stored records of the last `days` days, however old, without fetching."""
+        interval = self._candle_interval(days, interval)
+        return self._read_candles(crypto_id, days, interval, self._fresh_source(crypto_id, days, interval))
+
+    def fetch_ohlc_data(self, crypto_id, days, interval=None):
+        """
+        Returns the OHLC records (OHLC_RECORD_DTYPE) of the last `days` days, in candles of
+        `interval` (default: the granularity CoinGecko returns for that window). They are
+        served from the finest memory-mapped history that was refreshed in the last 30
+        minutes and covers the range, aggregated by the candle resampler when it is finer
+        than `interval`; otherwise they are fetched from CoinGecko and merged into the
+        history first.
+        """
+        days = int(days)
+        interval = self._candle_interval(days, interval)
+        native, start_ms = self._ohlc_window(days)
+        source = self._fresh_source(crypto_id, days, interval)
+        if source is not None:
+            self.logger.info(f"Cache hit for {crypto_id} (OHLC, {interval} from {source}).")
+            metrics.inc('ohlc_cache.hits')
+            with metrics.timer('ohlc_store.read'):
+                return self._read_candles(crypto_id, days, interval, source)
 
         self.logger.info(f"Cache miss or stale for {crypto_id} (OHLC). Fetching from CoinGecko.")
+        metrics.inc('ohlc_cache.misses')
         url = f"https://api.coingecko.com/api/v3/coins/{crypto_id}/ohlc?vs_currency=usd&days={days}"
         try:
             data = self.make_coingecko_request(url)
             self.logger.info(f"Successfully fetched OHLC data for {crypto_id} from CoinGecko.")
 
-            with open(cache_filepath, 'w') as f:
-                json.dump(data, f)
-            self.logger.info(f"Saved data to cache: {cache_filepath}")
+            if data:
+                with metrics.timer('ohlc_store.merge'):
+                    added = self.ohlc_store.merge(crypto_id, native, data)
+                self.logger.info(f"Merged {added} new candles into {self.ohlc_store.path(crypto_id, native)}")
 
-            return data
+            return self._read_candles(crypto_id, days, interval)
         except requests.exceptions.HTTPError as errh:
             if errh.response.status_code == 429:
                 raise CoinGeckoRateLimitError(f"CoinGecko API rate limit exceeded for {crypto_id}.") from errh
             else:
                 self.logger.warning(f"HTTP Error fetching data for {crypto_id}: {errh}")
-                if os.path.exists(cache_filepath):
+                stale = self._read_candles(crypto_id, days, interval)
+                if len(stale) > 0:
                     self.logger.warning("API call failed. Returning stale cache data.")
-                    with open(cache_filepath, 'r') as f:
-                        return json.load(f)
+                    return stale
                 raise
         except requests.exceptions.RequestException as err:
             self.logger.error(f"Request failed for {crypto_id}: {err}")
-            if os.path.exists(cache_filepath):
+            stale = self._read_candles(crypto_id, days, interval)
+            if len(stale) > 0:
                 self.logger.warning("API call failed. Returning stale cache data.")
-                with open(cache_filepath, 'r') as f:
-                    return json.load(f)
+                return stale
             raise
 
     def fetch_klines(self, symbol: str, interval: str, start_time: int, end_time: int):
-        """Fetches klines data from CoinGecko."""
+        """[timestamp, open, high, low, close] rows in `interval` candles, through the history store."""
         days = (end_time - start_time) / (1000 * 60 * 60 * 24)
         if days < 1:
             days = 1
         days = int(days)
-        url = f"https://api.coingecko.com/api/v3/coins/{symbol}/ohlc?vs_currency=usd&days={days}"
         try:
-            return self.make_coingecko_request(url)
+            return self.fetch_ohlc_data(symbol, days, interval=interval).tolist()
         except requests.exceptions.RequestException as e:
             self.logger.error(f"Error fetching klines for {symbol}: {e}")
             raise
 
-    def make_coingecko_request(self, url: str, params: Optional[Dict] = None) -> Dict:
-        request_id = str(uuid.uuid4())
-        
-        self.request_queue.put((_perform_request_static, (url,), {'params': params, 'timeout': 30}, request_id))
+    def _resolve(self, request_id, result):
+        """Completes the future of a request; returns False when the request is not ours."""
+        with self._pending_lock:
+            future = self._pending.pop(request_id, None)
+            metrics.set_gauge('rate_limiter.queue_depth', len(self._pending))
+        if future is None:
+            return False
+        if isinstance(result, Exception):
+            future.set_exception(result)
+        else:
+            future.set_result(result)
+        return True
 
+    def _dispatch_responses(self):
+        """Routes the limiter's response-queue replies to the futures of their requests, with blocking reads."""
         while True:
             result, received_request_id = self.response_queue.get()
-            if received_request_id == request_id:
-                if isinstance(result, Exception):
-                    raise result
-                
-                response = result
-                response.raise_for_status()
-                return response.json()
-            else:
+            if not self._resolve(received_request_id, result):
+                # Response to another reader of the same queue; hand it back
                 self.response_queue.put((result, received_request_id))
                 time.sleep(0.01)
 
-    def get_crypto_data_merged(self, crypto_id, days):
-        """Fetches OHLC data from CoinGecko and returns it as a Pandas DataFrame."""
+    def _get_reply_channel(self):
+        """This process's reply channel (one per PID, so forked copies get their own); None if unsupported."""
+        # Called with _pending_lock held
+        if self._reply_channel is not None and self._reply_channel.pid == os.getpid():
+            return self._reply_channel
+        self._reply_channel = None
+        if not self._reply_channel_supported:
+            return None
+        try:
+            self._reply_channel = ReplyChannel(self._on_channel_reply, self.config.IPC_ARENA_MB * 1024 * 1024)
+        except Exception as e:
+            self.logger.warning(f"Reply channel unavailable ({e}); using the shared response queue.")
+            self._reply_channel_supported = False
+        return self._reply_channel
+
+    def _on_channel_reply(self, request_id, result):
+        if not self._resolve(request_id, result):
+            self.logger.warning(f"Dropping reply to unknown request {request_id}")
+
+    def _forget_inflight(self, key, future):
+        with self._pending_lock:
+            if self._inflight.get(key) is future:
+                del self._inflight[key]
+
+    def submit_coingecko_request(self, url: str, params: Optional[Dict] = None) -> Future:
+        """
+        Queues a rate-limited GET and returns the Future of its response. Concurrent
+        identical requests (same URL and params) share one Future, hence one upstream call.
+        """
+        key = request_key(_perform_request_static, (url,), {'params': params})
+        with self._pending_lock:
+            future = self._inflight.get(key)
+            if future is not None:
+                self.logger.debug(f"Coalesced in-flight request for {url}")
+                metrics.inc('rate_limiter.coalesced_requests')
+                return future
+            future = Future()
+            request_id = str(uuid.uuid4())
+            self._pending[request_id] = future
+            self._inflight[key] = future
+            metrics.inc('rate_limiter.requests')
+            metrics.set_gauge('rate_limiter.queue_depth', len(self._pending))
+            channel = self._get_reply_channel()
+            if channel is None and (self._dispatcher is None or not self._dispatcher.is_alive()):
+                self._dispatcher = threading.Thread(target=self._dispatch_responses, daemon=True, name='DataFetcherResponses')
+                self._dispatcher.start()
+        future.add_done_callback(lambda done: self._forget_inflight(key, done))
+
+        message = (_perform_request_static, (url,), {'params': params, 'timeout': 30}, request_id)
+        if channel is not None:
+            message += (channel.reply_to,) # Answered on our own channel, not the shared response queue
+        try:
+            self.request_queue.put(message)
+        except Exception as e:
+            with self._pending_lock:
+                self._pending.pop(request_id, None)
+            future.set_exception(e)
+        return future
+
+    @staticmethod
+    def _response_json(response):
+        response.raise_for_status()
+        return response.json()
+
+    def make_coingecko_request(self, url: str, params: Optional[Dict] = None) -> Dict:
+        # Queueing for a token plus the upstream call, as seen by the requester
+        with metrics.timer('rate_limiter.wait'):
+            response = self.submit_coingecko_request(url, params).result()
+        return self._response_json(response)
+
+    async def make_coingecko_request_async(self, url: str, params: Optional[Dict] = None) -> Dict:
+        """make_coingecko_request for coroutines: awaits the response instead of blocking a thread."""
+        with metrics.timer('rate_limiter.wait'):
+            response = await asyncio.wrap_future(self.submit_coingecko_request(url, params))
+        return self._response_json(response)
+
+    def get_crypto_data_merged(self, crypto_id, days, interval=None):
+        """Fetches OHLC data (in `interval` candles, see fetch_ohlc_data) and returns it as a Pandas DataFrame."""
         fetch_days = int(days) if days else 1
-        ohlc_data = self.fetch_ohlc_data(crypto_id, fetch_days)
+        ohlc_data = self.fetch_ohlc_data(crypto_id, fetch_days, interval=interval)
 
-        if ohlc_data is None or not ohlc_data:
+        if ohlc_data is None or len(ohlc_data) == 0:
             self.logger.warning(f"No OHLC data returned for {crypto_id} after fetching.")
             return None
 
-        ohlc_df = pd.DataFrame(ohlc_data, columns=['timestamp', 'open', 'high', 'low', 'close'])
-        ohlc_df['timestamp'] = pd.to_datetime(ohlc_df['timestamp'], unit='ms')
-        ohlc_df.set_index('timestamp', inplace=True)
-        ohlc_df.sort_index(inplace=True)
+        # Records are stored sorted and de-duplicated, so no parsing or sorting is needed here
+        ohlc_df = records_to_dataframe(ohlc_data)
 
         self.logger.info(f"Processed {len(ohlc_df)} data points for {crypto_id}")
 
@@ -165,13 +293,51 @@ class DataFetcher:
         ids_string = ",".join(crypto_ids)
         url = f"https://api.coingecko.com/api/v3/simple/price?ids={ids_string}&vs_currencies=usd"
         data = self.make_coingecko_request(url)
-        return {crypto_id: data.get(crypto_id, {}).get('usd') for crypto_id in crypto_ids}
+        prices = {crypto_id: data.get(crypto_id, {}).get('usd') for crypto_id in crypto_ids}
+        self.remember_prices(prices)
+        return prices
+
+    def remember_prices(self, prices):
+        """Records freshly fetched prices (None values are ignored) in the per-coin price cache."""
+        now = time.time()
+        for crypto_id, price in prices.items():
+            if price is not None:
+                self._price_cache[crypto_id] = (price, now)
+
+    def cached_prices(self, crypto_ids):
+        """Prices of crypto_ids fetched in the last PRICE_TTL_SECONDS, by crypto_id."""
+        now = time.time()
+        fresh = {}
+        for crypto_id in crypto_ids:
+            entry = self._price_cache.get(crypto_id)
+            if entry is not None and now - entry[1] < self.PRICE_TTL_SECONDS:
+                fresh[crypto_id] = entry[0]
+        metrics.inc('price_cache.hits', len(fresh))
+        metrics.inc('price_cache.misses', len(crypto_ids) - len(fresh))
+        return fresh
+
+    def fetch_planned(self, prices=(), ohlc=(), markets=()):
+        """
+        Fetches a whole cycle's data needs with the fewest rate-limited requests; see
+        core/fetch_planner.py. ohlc lists (crypto_id, days) pairs.
+        """
+        planner = FetchPlanner(self)
+        planner.need_prices(prices)
+        planner.need_markets(markets)
+        for crypto_id, days in ohlc:
+            planner.need_ohlc(crypto_id, days)
+        return planner.execute()
 
     def get_current_prices(self, crypto_ids):
         """Fetches the current prices of a list of cryptos from CoinGecko, with 1-minute caching."""
         if not crypto_ids:
             return {}
 
+        fresh = self.cached_prices(crypto_ids)
+        if len(fresh) == len(set(crypto_ids)):
+            self.logger.info(f"Cache hit for prices of {len(crypto_ids)} cryptos.")
+            return fresh
+
         sorted_ids = sorted(crypto_ids)
         cache_key = ",".join(sorted_ids)
         cache_dir = self.config.CACHE_DIR
@@ -186,16 +352,18 @@ class DataFetcher:
             age_seconds = time.time() - file_mod_time
             if age_seconds < ttl_seconds:
                 self.logger.info(f"Cache hit for prices of {len(crypto_ids)} cryptos.")
+                metrics.inc('json_cache.hits')
                 try:
-                    with open(cache_filepath, 'r') as f:
+                    with metrics.timer('json_cache.read'), open(cache_filepath, 'r') as f:
                         return json.load(f)
                 except (json.JSONDecodeError, IOError) as e:
                     self.logger.warning(f"Failed to read price cache file: {e}. Re-fetching.")
 
         self.logger.info(f"Cache miss for prices of {len(crypto_ids)} cryptos. Fetching from API.")
+        metrics.inc('json_cache.misses')
         try:
             prices = self._get_current_prices_from_api(crypto_ids)
-            with open(cache_filepath, 'w') as f:
+            with metrics.timer('json_cache.write'), open(cache_filepath, 'w') as f:
                 json.dump(prices, f)
             return prices
         except requests.exceptions.HTTPError as e:
@@ -208,7 +376,6 @@ class DataFetcher:
             self.logger.error(f"Error fetching current prices for {', '.join(crypto_ids)}: {e}")
             return {crypto_id: None for crypto_id in crypto_ids}
 
-    @retry_on_exception(retries=3, delay=5, backoff=2, exception_to_check=requests.exceptions.RequestException)
     def _get_current_price_from_api(self, crypto_id):
         """DEPRECATED: Fetches the current price of a single crypto. Use get_current_prices for batching."""
         self.logger.warning("DEPRECATED: _get_current_price_from_api is deprecated. Use get_current_prices.")
@@ -0,0 +1,247 @@
+"""
+Append-only event ledger with periodic snapshots.
+
+State changes are appended as one JSON line per event ({"seq", "type", "data"})
+to `<base>.events.jsonl`, so a write costs one small append however large the
+state has grown. Every `snapshot_every` events the folded state is written to
+`<base>.snapshot.json` (atomically, via .tmp + os.replace) together with the
+seq of the last event it contains, and the event log is started afresh.
+Loading reads the snapshot and replays only the events after its seq; a torn
+last line left by a crash is ignored.
+
+The ledger does not know what the events mean: `apply(state, type, data)`
+folds one event into the state, and the same function rebuilds it on load.
+
+Several writers may share the files: every append, compaction and snapshot
+read takes an exclusive flock on `<base>.lock` and first folds in the events
+other instances appended (or reloads after their compaction), so seqs stay
+unique and nothing is lost. Within a process, open_ledger() hands out one
+instance per base path.
+"""
+
+import copy
+import json
+import logging
+import os
+import threading
+from contextlib import contextmanager
+from typing import Any, Callable, Dict, Optional
+
+try:
+    import fcntl
+except ImportError: # Not on POSIX; writers are only serialized within the process
+    fcntl = None
+
+logger = logging.getLogger(__name__)
+
+ApplyFn = Callable[[Dict[str, Any], str, Any], None]
+
+def _read_snapshot(path: str):
+    if not os.path.exists(path):
+        return None
+    try:
+        with open(path, 'r') as f:
+            return json.load(f)
+    except (OSError, json.JSONDecodeError) as e:
+        logger.error(f"Could not read ledger snapshot {path}: {e}")
+        return None
+
+def _replay(events_path: str, state: Dict[str, Any], after_seq: int, apply: ApplyFn):
+    """Folds the events after after_seq into state; returns (last seq, events replayed)."""
+    last_seq, replayed = after_seq, 0
+    if not os.path.exists(events_path):
+        return last_seq, replayed
+    with open(events_path, 'r') as f:
+        for line_number, line in enumerate(f, start=1):
+            try:
+                event = json.loads(line)
+            except json.JSONDecodeError:
+                logger.warning(f"Skipping unreadable event on line {line_number} of {events_path}")
+                continue
+            if event['seq'] <= after_seq:
+                continue # Already folded into the snapshot
+            apply(state, event['type'], event['data'])
+            last_seq, replayed = event['seq'], replayed + 1
+    return last_seq, replayed
+
+def _file_identity(path: str):
+    """(inode, mtime_ns, size) of path, or None when it does not exist."""
+    try:
+        stat = os.stat(path)
+    except OSError:
+        return None
+    return stat.st_ino, stat.st_mtime_ns, stat.st_size
+
+def _trim_torn_tail(events_path: str) -> None:
+    """Drops a partial last line, so the next append starts on a line of its own."""
+    if not os.path.exists(events_path):
+        return
+    with open(events_path, 'rb+') as f:
+        data = f.read()
+        if data and not data.endswith(b'\n'):
+            f.truncate(data.rfind(b'\n') + 1)
+            logger.warning(f"Dropped a partial last event from {events_path}")
+
+def load_ledger_state(base_path: str, initial_state: Dict[str, Any], apply: ApplyFn) -> Dict[str, Any]:
+    """Read-only load of a ledger's state (snapshot plus tail replay) for other processes."""
+    snapshot = _read_snapshot(base_path + '.snapshot.json')
+    state = snapshot['state'] if snapshot else copy.deepcopy(initial_state)
+    _replay(base_path + '.events.jsonl', state, snapshot['seq'] if snapshot else 0, apply)
+    return state
+
+class EventLedger:
+    """Event log plus snapshot of one piece of state, safe to share between processes."""
+
+    def __init__(self, base_path: str, initial_state: Dict[str, Any], apply: ApplyFn,
+                 snapshot_every: int = 200, legacy_path: Optional[str] = None,
+                 from_legacy: Optional[Callable[[Any], Dict[str, Any]]] = None):
+        self.base_path = base_path
+        self.snapshot_path = base_path + '.snapshot.json'
+        self.events_path = base_path + '.events.jsonl'
+        self.lock_path = base_path + '.lock'
+        self.initial_state = initial_state
+        self.apply = apply
+        self.snapshot_every = max(1, snapshot_every)
+        self._lock = threading.Lock()
+
+        with self._lock, self._file_lock():
+            if legacy_path and os.path.exists(legacy_path) and not os.path.exists(self.snapshot_path) \
+                    and not os.path.exists(self.events_path):
+                self.state, self.seq = copy.deepcopy(initial_state), 0
+                self._import_legacy(legacy_path, from_legacy)
+            _trim_torn_tail(self.events_path)
+            self._load()
+            self._events_file = open(self.events_path, 'a')
+        logger.info(f"Loaded ledger {base_path}: snapshot at seq {self.snapshot_seq}, "
+                    f"{self.events_since_snapshot} events replayed")
+
+    @contextmanager
+    def _file_lock(self):
+        """Serializes writers of the ledger files across processes (and instances)."""
+        if fcntl is None:
+            yield
+            return
+        with open(self.lock_path, 'a') as lock_file:
+            fcntl.flock(lock_file, fcntl.LOCK_EX)
+            try:
+                yield
+            finally:
+                fcntl.flock(lock_file, fcntl.LOCK_UN)
+
+    def _load(self) -> None:
+        """Rebuilds the state from the snapshot and the whole event log."""
+        snapshot = _read_snapshot(self.snapshot_path)
+        self._snapshot_identity = _file_identity(self.snapshot_path)
+        if snapshot is not None:
+            self.state, self.snapshot_seq = snapshot['state'], snapshot['seq']
+        else:
+            self.state, self.snapshot_seq = copy.deepcopy(self.initial_state), 0
+        self.seq = self.snapshot_seq
+        self.events_since_snapshot = 0
+        self._offset = 0 # Bytes of the event log folded into the state
+        self._read_new_events()
+
+    def _read_new_events(self) -> None:
+        """Folds the complete event lines after _offset into the state."""
+        if not os.path.exists(self.events_path):
+            return
+        with open(self.events_path, 'rb') as f:
+            f.seek(self._offset)
+            for line in f:
+                if not line.endswith(b'\n'):
+                    break # Torn by a crash; trimmed by the next instance that opens the ledger
+                self._offset += len(line)
+                try:
+                    event = json.loads(line)
+                except json.JSONDecodeError:
+                    logger.warning(f"Skipping unreadable event in {self.events_path}")
+                    continue
+                if event['seq'] <= self.seq:
+                    continue # Already folded into the snapshot
+                self.apply(self.state, event['type'], event['data'])
+                self.seq = event['seq']
+                self.events_since_snapshot += 1
+
+    def _sync(self) -> None:
+        """Catches up with the other writers; call with both locks held."""
+        if (_file_identity(self.snapshot_path) != self._snapshot_identity
+                or (_file_identity(self.events_path) or (0, 0, 0))[2] < self._offset):
+            self._load() # Another writer compacted the log
+        else:
+            self._read_new_events()
+
+    def _import_legacy(self, legacy_path: str, from_legacy) -> None:
+        """One-time migration from the former rewrite-everything JSON file."""
+        try:
+            with open(legacy_path, 'r') as f:
+                legacy = json.load(f)
+        except (OSError, json.JSONDecodeError) as e:
+            logger.error(f"Could not import {legacy_path} into ledger {self.base_path}: {e}")
+            return
+        self.state = from_legacy(legacy) if from_legacy else legacy
+        self._write_snapshot()
+        logger.info(f"Imported {legacy_path} into ledger {self.base_path}")
+
+    def append(self, event_type: str, data: Any) -> None:
+        """Folds one event into the state and appends it to the log."""
+        with self._lock, self._file_lock():
+            self._sync()
+            line = json.dumps({'seq': self.seq + 1, 'type': event_type, 'data': data})
+            self.apply(self.state, event_type, json.loads(line)['data']) # The state holds its own copy
+            self.seq += 1
+            self._events_file.write(line + '\n')
+            self._events_file.flush()
+            self._offset += len(line) + 1 # json.dumps output is ASCII
+            self.events_since_snapshot += 1
+            if self.events_since_snapshot >= self.snapshot_every:
+                self._compact()
+
+    def snapshot(self, key: Optional[str] = None) -> Any:
+        """Deep copy of the current state, or of its entry key."""
+        with self._lock, self._file_lock():
+            self._sync()
+            return copy.deepcopy(self.state if key is None else self.state[key])
+
+    def _write_snapshot(self) -> None:
+        temp_path = self.snapshot_path + '.tmp'
+        with open(temp_path, 'w') as f:
+            json.dump({'seq': self.seq, 'state': self.state}, f)
+            f.flush()
+            os.fsync(f.fileno())
+        os.replace(temp_path, self.snapshot_path)
+        self._snapshot_identity = _file_identity(self.snapshot_path)
+
+    def _compact(self) -> None:
+        try:
+            self._write_snapshot()
+        except OSError as e:
+            logger.error(f"Could not write ledger snapshot {self.snapshot_path}: {e}")
+            return
+        # Events up to seq are in the snapshot now; a crash before truncation only replays nothing.
+        # The append handle (O_APPEND) and the handles of other writers keep working after it.
+        os.truncate(self.events_path, 0)
+        self._offset = 0
+        self.snapshot_seq = self.seq
+        self.events_since_snapshot = 0
+        logger.debug(f"Compacted ledger {self.base_path} at seq {self.seq}")
+
+    def close(self) -> None:
+        with self._lock:
+            self._events_file.close()
+        with _ledgers_lock:
+            if _ledgers.get(os.path.abspath(self.base_path)) is self:
+                del _ledgers[os.path.abspath(self.base_path)]
+
+# One instance per ledger within the process, shared by every engine that opens it
+_ledgers: Dict[str, EventLedger] = {}
+_ledgers_lock = threading.Lock()
+
+def open_ledger(base_path: str, initial_state: Dict[str, Any], apply: ApplyFn, **kwargs) -> EventLedger:
+    """The process's EventLedger of base_path, created on first use (kwargs as for EventLedger)."""
+    key = os.path.abspath(base_path)
+    with _ledgers_lock:
+        ledger = _ledgers.get(key)
+        if ledger is None:
+            ledger = EventLedger(base_path, initial_state, apply, **kwargs)
+            _ledgers[key] = ledger
+        return ledger
@@ -0,0 +1,152 @@
+"""
+Batched fetch planner for DataFetcher.
+
+Callers declare everything a cycle needs (current prices, OHLC windows, market
+rows) and the planner turns it into the fewest rate-limited CoinGecko requests:
+needs already satisfied by the local caches (per-coin price cache, OHLC history
+store) are dropped, price needs are served from market rows when both are asked
+for, OHLC windows of one crypto and candle interval fold into the widest one,
+and ids are batched into the multi-id endpoints (/simple/price, /coins/markets).
+CoinGecko has no multi-coin /ohlc endpoint, so OHLC stays one request per crypto
+and interval. The remaining requests are issued concurrently; the rate limiter
+paces them and coalesces duplicates with other callers.
+"""
+
+import logging
+from collections import namedtuple
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, Iterable, Optional
+
+from .ohlc_store import coingecko_interval, records_to_dataframe
+
+logger = logging.getLogger(__name__)
+
+MARKETS_URL = "https://api.coingecko.com/api/v3/coins/markets"
+MAX_IDS_PER_PRICE_REQUEST = 100 # Keeps /simple/price URLs well under common length limits
+MAX_IDS_PER_MARKETS_REQUEST = 250 # CoinGecko's per_page maximum
+MAX_CONCURRENT_REQUESTS = 8
+
+FetchPlan = namedtuple('FetchPlan', [
+    'price_batches',   # tuples of crypto ids for /simple/price
+    'market_batches',  # tuples of crypto ids for /coins/markets
+    'ohlc_fetches',    # (crypto_id, interval) -> widest days to fetch
+    'cached_prices',   # crypto_id -> price already in the price cache
+    'ohlc_needs',      # (crypto_id, days) pairs to serve from the history store
+    'price_needs',     # crypto ids whose price was asked for
+])
+
+def request_count(plan: FetchPlan) -> int:
+    return len(plan.price_batches) + len(plan.market_batches) + len(plan.ohlc_fetches)
+
+def _batches(ids, size):
+    ids = sorted(ids)
+    return [tuple(ids[i:i + size]) for i in range(0, len(ids), size)]
+
+class FetchResult:
+    """Outcome of a plan. errors is keyed by ('prices', id), ('markets', id) or ('ohlc', id, days)."""
+
+    def __init__(self, requests: int):
+        self.requests = requests
+        self.prices: Dict[str, Optional[float]] = {}
+        self.markets: Dict[str, dict] = {}
+        self.ohlc = {} # (crypto_id, days) -> DataFrame or None
+        self.errors: Dict[tuple, Exception] = {}
+
+class FetchPlanner:
+    """Collects the data needs of one cycle and fetches them with the fewest requests."""
+
+    def __init__(self, data_fetcher):
+        self.data_fetcher = data_fetcher
+        self._prices = set()
+        self._markets = set()
+        self._ohlc = set()
+
+    def need_prices(self, crypto_ids: Iterable[str]) -> None:
+        self._prices.update(crypto_ids)
+
+    def need_markets(self, crypto_ids: Iterable[str]) -> None:
+        self._markets.update(crypto_ids)
+
+    def need_ohlc(self, crypto_id: str, days) -> None:
+        # Same day rounding as DataFetcher.get_crypto_data_merged
+        self._ohlc.add((crypto_id, int(days) if days else 1))
+
+    def plan(self) -> FetchPlan:
+        ohlc_fetches = {}
+        for crypto_id, days in sorted(self._ohlc):
+            if self.data_fetcher.is_ohlc_cached(crypto_id, days):
+                continue
+            key = (crypto_id, coingecko_interval(days))
+            ohlc_fetches[key] = max(ohlc_fetches.get(key, 0), days)
+
+        # Market rows carry the current price, so those ids need no price request
+        price_ids = self._prices - self._markets
+        cached_prices = self.data_fetcher.cached_prices(price_ids)
+        return FetchPlan(
+            price_batches=_batches(price_ids - set(cached_prices), MAX_IDS_PER_PRICE_REQUEST),
+            market_batches=_batches(self._markets, MAX_IDS_PER_MARKETS_REQUEST),
+            ohlc_fetches=ohlc_fetches,
+            cached_prices=cached_prices,
+            ohlc_needs=sorted(self._ohlc),
+            price_needs=frozenset(self._prices),
+        )
+
+    def _fetch_markets(self, crypto_ids):
+        params = {'vs_currency': 'usd', 'ids': ','.join(crypto_ids), 'per_page': len(crypto_ids), 'page': 1}
+        rows = self.data_fetcher.make_coingecko_request(MARKETS_URL, params=params) or []
+        self.data_fetcher.remember_prices({row['id']: row.get('current_price') for row in rows if 'id' in row})
+        return rows
+
+    def execute(self, plan: Optional[FetchPlan] = None) -> FetchResult:
+        plan = plan or self.plan()
+        result = FetchResult(request_count(plan))
+        logger.info(f"Fetch plan: {result.requests} requests ({len(plan.price_batches)} price, "
+                    f"{len(plan.market_batches)} market, {len(plan.ohlc_fetches)} OHLC) for "
+                    f"{len(plan.price_needs)} prices, {len(self._markets)} market rows and {len(plan.ohlc_needs)} OHLC windows")
+
+        ohlc_errors = {}
+        if result.requests:
+            with ThreadPoolExecutor(max_workers=min(MAX_CONCURRENT_REQUESTS, result.requests)) as executor:
+                price_futures = [(batch, executor.submit(self.data_fetcher._get_current_prices_from_api, list(batch)))
+                                 for batch in plan.price_batches]
+                market_futures = [(batch, executor.submit(self._fetch_markets, batch)) for batch in plan.market_batches]
+                ohlc_futures = [(key, executor.submit(self.data_fetcher.fetch_ohlc_data, key[0], days))
+                                for key, days in plan.ohlc_fetches.items()]
+
+                for batch, future in price_futures:
+                    try:
+                        result.prices.update(future.result())
+                    except Exception as e:
+                        logger.error(f"Error fetching current prices for {', '.join(batch)}: {e}")
+                        result.errors.update({('prices', crypto_id): e for crypto_id in batch})
+                for batch, future in market_futures:
+                    try:
+                        result.markets.update({row['id']: row for row in future.result() if 'id' in row})
+                    except Exception as e:
+                        logger.error(f"Error fetching market data for {', '.join(batch)}: {e}")
+                        result.errors.update({('markets', crypto_id): e for crypto_id in batch})
+                for key, future in ohlc_futures:
+                    try:
+                        future.result()
+                    except Exception as e:
+                        logger.error(f"Error fetching OHLC data for {key[0]} ({key[1]}): {e}")
+                        ohlc_errors[key] = e
+
+        result.prices.update(plan.cached_prices)
+        for crypto_id in plan.price_needs:
+            if crypto_id in result.markets:
+                result.prices[crypto_id] = result.markets[crypto_id].get('current_price')
+            elif ('markets', crypto_id) in result.errors:
+                result.errors[('prices', crypto_id)] = result.errors[('markets', crypto_id)]
+            result.prices.setdefault(crypto_id, None)
+
+        for crypto_id, days in plan.ohlc_needs:
+            error = ohlc_errors.get((crypto_id, coingecko_interval(days)))
+            if error is not None:
+                result.errors[('ohlc', crypto_id, days)] = error
+                result.ohlc[(crypto_id, days)] = None
+                continue
+            # Fresh now: either it was cached or the (wider) fetch above just merged it in
+            records = self.data_fetcher.read_cached_ohlc(crypto_id, days)
+            result.ohlc[(crypto_id, days)] = records_to_dataframe(records) if len(records) > 0 else None
+        return result
@@ -0,0 +1,93 @@
+"""
+Pooled HTTP client for CoinGecko calls and the retry policy of the rate limiter.
+
+Every process keeps one requests.Session whose connection pool is reused by all
+threads (keep-alive, gzip), so consecutive calls skip the TCP and TLS
+handshakes. Retries are not done here: RetryPolicy tells the RateLimiter how long
+to wait before another attempt, and the limiter waits on its event loop (taking a
+new token per attempt) instead of sleeping in a worker thread.
+"""
+
+import logging
+import os
+import random
+import threading
+from email.utils import parsedate_to_datetime
+from datetime import datetime, timezone
+from typing import Any, Optional
+
+import requests
+from requests.adapters import HTTPAdapter
+
+from core.app_config import Config
+
+logger = logging.getLogger(__name__)
+
+RETRY_STATUS_CODES = frozenset({429, 500, 502, 503, 504})
+
+_session: Optional[requests.Session] = None
+_session_pid: Optional[int] = None
+_session_lock = threading.Lock()
+
+def get_session() -> requests.Session:
+    """This process's shared session; a forked child builds its own (sockets are not shared)."""
+    global _session, _session_pid
+    if _session is None or _session_pid != os.getpid():
+        with _session_lock:
+            if _session is None or _session_pid != os.getpid():
+                config = Config()
+                session = requests.Session()
+                adapter = HTTPAdapter(pool_connections=4, pool_maxsize=config.HTTP_POOL_SIZE, max_retries=0)
+                session.mount('https://', adapter)
+                session.mount('http://', adapter)
+                session.headers.update({'Accept-Encoding': 'gzip, deflate', 'Connection': 'keep-alive'})
+                _session, _session_pid = session, os.getpid()
+    return _session
+
+def http_get(url: str, params: Optional[dict] = None, timeout: float = 30) -> requests.Response:
+    """GET through the pooled session; the response is returned whatever its status."""
+    return get_session().get(url, params=params, timeout=timeout)
+
+def _retry_after_seconds(response: requests.Response) -> Optional[float]:
+    value = response.headers.get('Retry-After')
+    if not value:
+        return None
+    try:
+        return max(0.0, float(value))
+    except ValueError:
+        pass
+    try:
+        return max(0.0, (parsedate_to_datetime(value) - datetime.now(timezone.utc)).total_seconds())
+    except (TypeError, ValueError):
+        return None
+
+class RetryPolicy:
+    """
+    Exponential backoff with full jitter for transient failures: connection errors,
+    timeouts and 429/5xx responses. A Retry-After header is honoured (within max_delay).
+    """
+
+    def __init__(self, retries: int = 3, base_delay: float = 1.0, max_delay: float = 30.0):
+        self.retries = retries
+        self.base_delay = base_delay
+        self.max_delay = max_delay
+
+    @classmethod
+    def from_config(cls, config) -> "RetryPolicy":
+        return cls(config.HTTP_RETRIES, config.HTTP_RETRY_BASE_SECONDS, config.HTTP_RETRY_MAX_SECONDS)
+
+    def delay(self, attempt: int, result: Any = None, error: Optional[BaseException] = None) -> Optional[float]:
+        """Seconds to wait before retrying after attempt (0-based), or None to return result/error as is."""
+        if attempt >= self.retries:
+            return None
+        if error is not None:
+            if not isinstance(error, (requests.exceptions.ConnectionError, requests.exceptions.Timeout)):
+                return None
+        elif not isinstance(result, requests.Response) or result.status_code not in RETRY_STATUS_CODES:
+            return None
+        backoff = random.uniform(0, min(self.max_delay, self.base_delay * (2 ** attempt)))
+        if isinstance(result, requests.Response):
+            retry_after = _retry_after_seconds(result)
+            if retry_after is not None:
+                return min(self.max_delay, max(backoff, retry_after))
+        return backoff
@@ -0,0 +1,135 @@
+"""
+Memoizing indicator cache shared by the trials of an optimization study.
+
+The OHLC data of a study never changes, so indicators are keyed by
+(crypto, interval, indicator, parameters) plus a fingerprint of the dataset and
+computed at most once. The cache is thread-safe (optimize_volatile_cryptos runs
+studies in a ThreadPoolExecutor) and bounded by an LRU byte budget.
+"""
+
+import logging
+import threading
+from collections import OrderedDict
+from typing import Any, Callable, Dict, Hashable, Tuple
+
+import numpy as np
+import pandas as pd
+
+from core import metrics
+
+logger = logging.getLogger(__name__)
+
+def _nbytes(value: Any) -> int:
+    """Approximate memory footprint of a cached indicator."""
+    if isinstance(value, pd.DataFrame):
+        return int(value.memory_usage(index=False).sum())
+    if isinstance(value, (pd.Series, np.ndarray)):
+        return int(value.nbytes)
+    if isinstance(value, (tuple, list)):
+        return sum(_nbytes(item) for item in value)
+    return 64
+
+def dataset_fingerprint(data: pd.DataFrame) -> Tuple:
+    """Cheap identity of an OHLC dataset: length, first/last timestamp and last close."""
+    if data is None or len(data) == 0:
+        return (0,)
+    last_close = float(data['close'].iloc[-1]) if 'close' in data else None
+    return (len(data), str(data.index[0]), str(data.index[-1]), last_close)
+
+class IndicatorCache:
+    """Thread-safe LRU cache of indicator results with hit/miss counters."""
+
+    def __init__(self, max_bytes: int = 256 * 1024 * 1024):
+        self.max_bytes = max_bytes
+        self._entries: "OrderedDict[Hashable, Tuple[Any, int]]" = OrderedDict()
+        self._pending: Dict[Hashable, threading.Event] = {}
+        self._lock = threading.Lock()
+        self._current_bytes = 0
+        self.hits = 0
+        self.misses = 0
+        self.evictions = 0
+
+    def for_dataset(self, crypto: str, interval: str, data: pd.DataFrame) -> "DatasetIndicatorCache":
+        """Returns a view of the cache bound to one dataset."""
+        return DatasetIndicatorCache(self, (crypto, interval, dataset_fingerprint(data)))
+
+    def get_or_compute(self, key: Hashable, compute: Callable[[], Any]) -> Any:
+        """
+        Returns the cached value for key, computing it with compute() on a miss.
+        Concurrent callers asking for the same missing key wait for the first one.
+        Cached values are shared and must be treated as read-only.
+        """
+        while True:
+            with self._lock:
+                entry = self._entries.get(key)
+                if entry is not None:
+                    self._entries.move_to_end(key)
+                    self.hits += 1
+                    metrics.inc('indicator_cache.hits')
+                    return entry[0]
+                pending = self._pending.get(key)
+                if pending is None:
+                    pending = threading.Event()
+                    self._pending[key] = pending
+                    self.misses += 1
+                    metrics.inc('indicator_cache.misses')
+                    break
+            # Another thread is computing this key; retry once it is done
+            pending.wait()
+
+        try:
+            value = compute()
+            self._store(key, value)
+            return value
+        finally:
+            with self._lock:
+                self._pending.pop(key, None)
+            pending.set()
+
+    def _store(self, key: Hashable, value: Any) -> None:
+        size = _nbytes(value)
+        with self._lock:
+            if size > self.max_bytes:
+                logger.debug(f"Indicator {key} ({size} bytes) exceeds the cache budget, not cached.")
+                return
+            self._entries[key] = (value, size)
+            self._current_bytes += size
+            while self._current_bytes > self.max_bytes and self._entries:
+                _, (_, evicted_size) = self._entries.popitem(last=False)
+                self._current_bytes -= evicted_size
+                self.evictions += 1
+
+    def clear(self) -> None:
+        with self._lock:
+            self._entries.clear()
+            self._current_bytes = 0
+
+    def stats(self) -> Dict[str, Any]:
+        """Counters suitable for the job status file."""
+        with self._lock:
+            lookups = self.hits + self.misses
+            return {
+                'hits': self.hits,
+                'misses': self.misses,
+                'hit_rate': (self.hits / lookups) if lookups else 0.0,
+                'evictions': self.evictions,
+                'entries': len(self._entries),
+                'bytes': self._current_bytes,
+                'max_bytes': self.max_bytes,
+            }
+
+class DatasetIndicatorCache:
+    """IndicatorCache view whose keys are prefixed with one dataset's identity."""
+
+    def __init__(self, cache: IndicatorCache, dataset_key: Tuple):
+        self.cache = cache
+        self.dataset_key = dataset_key
+
+    def get_or_compute(self, indicator: str, params: Tuple, compute: Callable[[], Any]) -> Any:
+        return self.cache.get_or_compute(self.dataset_key + (indicator, params), compute)
+
+def cached_indicator(indicator_cache, indicator: str, params: Tuple, compute: Callable[[], Any]) -> Any:
+    """Uses indicator_cache when one is given, otherwise computes directly."""
+    if indicator_cache is None:
+        return compute()
+    return indicator_cache.get_or_compute(indicator, params, compute)
@@ -0,0 +1,176 @@
+"""
+Reply transport between the rate limiter process and its requesters.
+
+Every requesting process owns a ReplyChannel: a private Unix-socket listener the
+limiter process connects back to, plus a shared-memory PayloadArena. Requests
+name their channel, so replies go straight to their requester instead of through
+one response queue that every consumer has to poll. Large response bodies are
+written by the limiter process into the requester's arena as raw bytes and only
+a small descriptor crosses the socket; the requester decodes the body straight
+from shared memory, with no pickling of the HTTP response on either side.
+
+The arena is a single-producer/single-consumer ring: the limiter process only
+advances the write head, the requester only advances the release head, and
+bodies are released in the order they were written (the order replies arrive).
+"""
+
+import atexit
+import logging
+import multiprocessing
+import os
+import struct
+import threading
+from multiprocessing import shared_memory
+from multiprocessing.connection import Client, Listener
+from typing import Any, Callable, Optional, Tuple
+
+import requests
+from requests.structures import CaseInsensitiveDict
+
+logger = logging.getLogger(__name__)
+
+ARENA_MIN_BYTES = 16 * 1024 # Smaller bodies are cheaper to send inline
+_HEADER = struct.Struct('<QQ') # write head (producer), release head (consumer), as running byte counts
+
+class PayloadArena:
+    """Ring buffer of response bodies in a shared memory block."""
+
+    def __init__(self, name: Optional[str] = None, size: int = 0):
+        if name is None:
+            self._shm = shared_memory.SharedMemory(create=True, size=_HEADER.size + size)
+            _HEADER.pack_into(self._shm.buf, 0, 0, 0)
+            self.owner = True
+        else:
+            self._shm = shared_memory.SharedMemory(name=name)
+            self.owner = False
+        self.name = self._shm.name
+        self.capacity = self._shm.size - _HEADER.size
+
+    def _heads(self) -> Tuple[int, int]:
+        return _HEADER.unpack_from(self._shm.buf, 0)
+
+    def write(self, data: bytes) -> Optional[Tuple[int, int]]:
+        """Producer: copies data in, returning (start, length), or None when it does not fit right now."""
+        length = len(data)
+        write_head, release_head = self._heads()
+        position = write_head % self.capacity
+        # Bodies never wrap around the end of the block; the tail is skipped instead
+        padding = self.capacity - position if position + length > self.capacity else 0
+        start = write_head + padding
+        if length > self.capacity or start + length - release_head > self.capacity:
+            return None
+        offset = _HEADER.size + start % self.capacity
+        self._shm.buf[offset:offset + length] = data
+        struct.pack_into('<Q', self._shm.buf, 0, start + length)
+        return start, length
+
+    def view(self, start: int, length: int) -> memoryview:
+        """Consumer: the body written at start, valid until release() passes it."""
+        offset = _HEADER.size + start % self.capacity
+        return self._shm.buf[offset:offset + length]
+
+    def release(self, end: int) -> None:
+        """Consumer: frees everything written before the running byte count end."""
+        struct.pack_into('<Q', self._shm.buf, 8, end)
+
+    def close(self) -> None:
+        self._shm.close()
+        if self.owner:
+            try:
+                self._shm.unlink()
+            except FileNotFoundError:
+                pass
+
+def _response_meta(response: requests.Response) -> dict:
+    return {'status_code': response.status_code, 'reason': response.reason, 'url': response.url,
+            'encoding': response.encoding, 'headers': dict(response.headers)}
+
+def _build_response(meta: dict, body: bytes) -> requests.Response:
+    """Rebuilds a requests.Response, so raise_for_status() and json() behave as upstream."""
+    response = requests.Response()
+    response.status_code = meta['status_code']
+    response.reason = meta['reason']
+    response.url = meta['url']
+    response.encoding = meta['encoding']
+    response.headers = CaseInsensitiveDict(meta['headers'])
+    response._content = body
+    return response
+
+class ReplyChannel:
+    """Requester side: receives the replies addressed to this process."""
+
+    def __init__(self, on_reply: Callable[[str, Any], None], arena_bytes: int):
+        self.on_reply = on_reply
+        self.pid = os.getpid()
+        self._authkey = bytes(multiprocessing.current_process().authkey)
+        self.arena = PayloadArena(size=arena_bytes)
+        self.listener = Listener(family='AF_UNIX', authkey=self._authkey)
+        self.address = self.listener.address
+        self._closed = False
+        threading.Thread(target=self._accept_loop, daemon=True, name='ReplyChannel').start()
+        atexit.register(self.close)
+        logger.info(f"Reply channel {self.address} with a {arena_bytes // 1024} KiB payload arena created for PID {self.pid}")
+
+    @property
+    def reply_to(self) -> Tuple[str, str]:
+        """Picklable address that travels with each request."""
+        return self.address, self.arena.name
+
+    def _accept_loop(self) -> None:
+        while not self._closed:
+            try:
+                conn = self.listener.accept()
+            except (OSError, EOFError):
+                break
+            except multiprocessing.AuthenticationError as e:
+                logger.warning(f"Rejected reply connection on {self.address}: {e}")
+                continue
+            threading.Thread(target=self._read_loop, args=(conn,), daemon=True, name='ReplyChannelReader').start()
+
+    def _read_loop(self, conn) -> None:
+        with conn:
+            while True:
+                try:
+                    kind, request_id, payload = conn.recv()
+                except (EOFError, OSError):
+                    break
+                if kind == 'arena':
+                    meta, start, length = payload
+                    body = bytes(self.arena.view(start, length))
+                    self.arena.release(start + length)
+                    payload = _build_response(meta, body)
+                self.on_reply(request_id, payload)
+
+    def close(self) -> None:
+        if self._closed or os.getpid() != self.pid:
+            return
+        self._closed = True
+        try:
+            self.listener.close()
+        except OSError:
+            pass
+        self.arena.close()
+
+class ReplySender:
+    """Limiter process side: sends the replies of one requester."""
+
+    def __init__(self, reply_to: Tuple[str, str]):
+        address, arena_name = reply_to
+        self.conn = Client(address, family='AF_UNIX', authkey=bytes(multiprocessing.current_process().authkey))
+        self.arena = PayloadArena(name=arena_name)
+        # Replies are sent from limiter callbacks; arena order must match send order
+        self._lock = threading.Lock()
+
+    def send(self, request_id: str, result: Any) -> None:
+        with self._lock:
+            if isinstance(result, requests.Response) and len(result.content) >= ARENA_MIN_BYTES:
+                slot = self.arena.write(result.content)
+                if slot is not None:
+                    self.conn.send(('arena', request_id, (_response_meta(result),) + slot))
+                    return
+                logger.debug(f"Payload arena {self.arena.name} full; sending reply {request_id} inline")
+            self.conn.send(('inline', request_id, result))
+
+    def close(self) -> None:
+        self.conn.close()
+        self.arena.close()
@@ -1,10 +1,19 @@
+import atexit
 import json
 import os
 import logging
+import threading
+import time
+from contextlib import contextmanager
 from pathlib import Path
 from datetime import datetime
 import signal # Added import
 
+try:
+    import fcntl
+except ImportError: # Not on POSIX; writes are still atomic, only unserialized across processes
+    fcntl = None
+
 logger = logging.getLogger(__name__)
 
 # Define the directory for job status files relative to the project root
@@ -12,147 +21,344 @@ logger = logging.getLogger(__name__)
 PROJECT_ROOT = Path(__file__).parent.parent
 JOB_STATUS_DIR = PROJECT_ROOT / "data" / "job_status"
 
+CONTROL_POLL_SECONDS = 0.5 # How often watched status files are checked for changes by other processes
+STATUS_FLUSH_SECONDS = 1.0 # Max delay of a progress update that does not change a job's status
+WATCH_IDLE_SECONDS = 60.0 # Jobs whose stop flag nobody asked for this long are no longer watched
+
 def _get_status_filepath(job_id: str) -> Path:
     """Returns the full path to a job's status file."""
     return JOB_STATUS_DIR / f"{job_id}.json"
 
-def update_job_status(job_id: str, status: str, message: str = None, progress: float = None, log_path: str = None):
+@contextmanager
+def _status_file_lock(job_id: str):
+    """Serializes read-modify-write cycles on a job's status file, across threads and processes."""
+    with _control.lock_for(job_id):
+        if fcntl is None:
+            yield
+            return
+        os.makedirs(JOB_STATUS_DIR, exist_ok=True)
+        with open(JOB_STATUS_DIR / f"{job_id}.lock", 'a') as lock_file:
+            fcntl.flock(lock_file, fcntl.LOCK_EX)
+            try:
+                yield
+            finally:
+                fcntl.flock(lock_file, fcntl.LOCK_UN)
+
+def _read_status_file(filepath: Path) -> dict:
+    """The status file's content; {} when it is missing or unreadable."""
+    try:
+        with open(filepath, 'r') as f:
+            content = f.read().strip()
+        return json.loads(content) if content else {}
+    except (OSError, json.JSONDecodeError):
+        return {}
+
+def _write_status_file(filepath: Path, job_status: dict) -> None:
+    """Atomic write (temp file + rename), so readers never see a partial status."""
+    temp_filepath = str(filepath) + ".tmp"
+    with open(temp_filepath, 'w') as f:
+        json.dump(job_status, f, indent=2)
+    os.replace(temp_filepath, filepath)
+
+class _JobControl:
     """
-    Updates the status of a job by writing to its dedicated JSON file.
+    In-process view of the jobs this process runs or checks. Stop flags are cached:
+    is_job_stop_requested() is a set lookup, and a background thread stats the status
+    files of watched jobs every CONTROL_POLL_SECONDS, re-reading only those another
+    process changed. Progress updates that keep a job's status are held back and
+    written at most every STATUS_FLUSH_SECONDS, merged into the file's current content
+    so fields written by other processes (stop_requested, pids) are preserved.
     """
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._file_locks = {} # job_id -> threading.Lock
+        self._stopped = set()
+        self._watched = {} # job_id -> [mtime_ns of the status file when read, last asked]
+        self._pending = {} # job_id -> [fields to write, due time]
+        self._written_status = {} # job_id -> status last written by this process
+        self._thread = None
+        self._pid = None
+
+    def lock_for(self, job_id: str) -> threading.Lock:
+        with self._lock:
+            return self._file_locks.setdefault(job_id, threading.Lock())
+
+    def _ensure_thread(self) -> None:
+        # Called with _lock held; a forked child starts its own thread
+        if self._thread is None or self._pid != os.getpid() or not self._thread.is_alive():
+            self._pid = os.getpid()
+            self._thread = threading.Thread(target=self._run, daemon=True, name='JobControl')
+            self._thread.start()
+
+    def _run(self) -> None:
+        while True:
+            time.sleep(CONTROL_POLL_SECONDS)
+            try:
+                self._poll()
+                self.flush(due_only=True)
+            except Exception as e:
+                logger.error(f"Job control poll failed: {e}")
+
+    def _refresh(self, job_id: str) -> None:
+        """Re-reads the stop flag of job_id if its status file changed since it was last read."""
+        filepath = _get_status_filepath(job_id)
+        try:
+            mtime_ns = filepath.stat().st_mtime_ns
+        except FileNotFoundError:
+            mtime_ns = None
+        with self._lock:
+            watch = self._watched.get(job_id)
+            if watch is None or watch[0] == mtime_ns:
+                return
+            watch[0] = mtime_ns
+        stop_requested = mtime_ns is not None and _read_status_file(filepath).get("stop_requested", False)
+        with self._lock:
+            if stop_requested:
+                self._stopped.add(job_id)
+            else:
+                self._stopped.discard(job_id) # Reset, or status file removed
+
+    def _poll(self) -> None:
+        now = time.monotonic()
+        with self._lock:
+            for job_id, (_, last_asked) in list(self._watched.items()):
+                if now - last_asked > WATCH_IDLE_SECONDS:
+                    del self._watched[job_id]
+            watched = list(self._watched)
+        for job_id in watched:
+            self._refresh(job_id)
+
+    def stop_requested(self, job_id: str) -> bool:
+        with self._lock:
+            watch = self._watched.get(job_id)
+            if watch is not None:
+                watch[1] = time.monotonic()
+                return job_id in self._stopped
+            self._watched[job_id] = [-1, time.monotonic()] # Never a real mtime: read now
+            self._ensure_thread()
+        self._refresh(job_id)
+        with self._lock:
+            return job_id in self._stopped
+
+    def mark_stopped(self, job_id: str) -> None:
+        with self._lock:
+            self._stopped.add(job_id)
+
+    def written_status(self, job_id: str):
+        with self._lock:
+            return self._written_status.get(job_id)
+
+    def defer(self, job_id: str, fields: dict) -> None:
+        with self._lock:
+            pending = self._pending.get(job_id)
+            if pending is None:
+                self._pending[job_id] = [dict(fields), time.monotonic() + STATUS_FLUSH_SECONDS]
+            else:
+                pending[0].update(fields)
+            self._ensure_thread()
+
+    def take_pending(self, job_id: str) -> dict:
+        with self._lock:
+            pending = self._pending.pop(job_id, None)
+        return pending[0] if pending else {}
+
+    def pending_fields(self, job_id: str) -> dict:
+        with self._lock:
+            pending = self._pending.get(job_id)
+            return dict(pending[0]) if pending else {}
+
+    def flush(self, job_id: str = None, due_only: bool = False) -> None:
+        """Writes held-back updates: of job_id, of every job, or of those past their due time."""
+        now = time.monotonic()
+        with self._lock:
+            job_ids = [j for j, (_, due) in self._pending.items()
+                       if (job_id is None or j == job_id) and (not due_only or due <= now)]
+        for pending_job_id in job_ids:
+            fields = self.take_pending(pending_job_id)
+            if fields:
+                _write_fields(pending_job_id, fields)
+
+    def record_written(self, job_id: str, status: str) -> None:
+        with self._lock:
+            self._written_status[job_id] = status
+
+_control = _JobControl()
+atexit.register(_control.flush) # Batched progress of jobs still running at exit
+
+def _write_fields(job_id: str, fields: dict) -> None:
+    """Merges fields into the job's status file under the file lock."""
     os.makedirs(JOB_STATUS_DIR, exist_ok=True)
     filepath = _get_status_filepath(job_id)
-    
-    # Try to read existing data to preserve fields like 'log_path' and 'pids'
-    if os.path.exists(filepath):
-        with open(filepath, 'r') as f:
-            try:
-                content = f.read().strip()
-                if content:
-                    job_status = json.loads(content)
-                else:
-                    job_status = {}
-            except json.JSONDecodeError:
-                job_status = {} # Start fresh if file is corrupted
-    else:
-        job_status = {}
-
-    # Update status fields
-    job_status.update({
+    try:
+        with _status_file_lock(job_id):
+            job_status = _read_status_file(filepath)
+            job_status.update(fields)
+            # Ensure stop_requested and pids are always present
+            job_status.setdefault("stop_requested", False)
+            job_status.setdefault("pids", [])
+            _write_status_file(filepath, job_status)
+        if "status" in fields:
+            _control.record_written(job_id, fields["status"])
+    except Exception as e:
+        logger.error(f"Failed to update status for job {job_id}: {e}")
+
+def update_job_status(job_id: str, status: str, message: str = None, progress: float = None, log_path: str = None):
+    """
+    Updates the status of a job in its dedicated JSON file. Status changes are written
+    at once; updates that only change the message or progress of a job whose status
+    this process already wrote are batched (see _JobControl).
+    """
+    fields = {
         "job_id": job_id,
         "status": status,
         "timestamp": datetime.now().isoformat(),
-    })
-
+    }
     if message is not None:
-        job_status["message"] = message
+        fields["message"] = message
     if progress is not None:
-        job_status["progress"] = progress
+        fields["progress"] = progress
     if log_path is not None:
-        job_status["log_path"] = log_path
+        fields["log_path"] = log_path
 
-    # Ensure stop_requested and pids are always present
-    if "stop_requested" not in job_status:
-        job_status["stop_requested"] = False
-    if "pids" not in job_status: # Initialize pids list
-        job_status["pids"] = []
+    if _control.written_status(job_id) == status and _get_status_filepath(job_id).exists():
+        _control.defer(job_id, fields)
+        logger.debug(f"Job {job_id} status update batched: {status}")
+        return
+    _write_fields(job_id, {**_control.take_pending(job_id), **fields})
+    logger.info(f"Job {job_id} status updated to: {status}")
+
+def flush_job_status(job_id: str = None):
+    """Writes batched status updates now (of one job, or of all jobs of this process)."""
+    _control.flush(job_id)
+
+def update_job_stats(job_id: str, name: str, stats: dict):
+    """
+    Stores a block of counters (e.g. indicator cache hits/misses) under `name` in the job's
+    status file without touching its status, message or progress.
+    """
+    filepath = _get_status_filepath(job_id)
+    if not filepath.exists():
+        return
 
     try:
-        # Write to a temporary file first
-        temp_filepath = str(filepath) + ".tmp"
-        with open(temp_filepath, 'w') as f:
-            json.dump(job_status, f, indent=2)
-        # Atomically rename the temporary file to the final destination
-        os.replace(temp_filepath, filepath)
-        logger.info(f"Job {job_id} status updated to: {status}")
+        with _status_file_lock(job_id):
+            job_status = _read_status_file(filepath)
+            if "timestamp" not in job_status: # Unreadable file; never overwrite it with a partial status
+                return
+            job_status[name] = stats
+            _write_status_file(filepath, job_status)
     except Exception as e:
-        logger.error(f"Failed to update status for job {job_id}: {e}")
+        logger.error(f"Failed to update {name} stats for job {job_id}: {e}")
+
+def recent_job_metrics(limit: int = 20) -> dict:
+    """
+    job_id -> 'metrics' block of every running job and of the `limit` most recently
+    updated other jobs that have one (see core/metrics.py).
+    """
+    if not JOB_STATUS_DIR.exists():
+        return {}
+    paths = sorted(JOB_STATUS_DIR.glob("*.json"), key=lambda path: path.stat().st_mtime, reverse=True)
+    job_metrics, finished = {}, 0
+    for path in paths:
+        try:
+            with open(path, 'r') as f:
+                job_status = json.load(f)
+        except (OSError, json.JSONDecodeError):
+            continue # Being rewritten, or corrupted
+        if "metrics" not in job_status:
+            continue
+        if job_status.get("status") != "running":
+            if finished >= limit:
+                continue
+            finished += 1
+        job_metrics[job_status.get("job_id", path.stem)] = job_status["metrics"]
+    return job_metrics
 
 def get_job_status(job_id: str) -> dict:
     """
-    Retrieves the status of a job from its JSON file.
+    Retrieves the status of a job from its JSON file, with this process's batched updates applied.
     Returns a dictionary with status information, or a default 'unknown' status if not found.
     """
     filepath = _get_status_filepath(job_id)
-    if filepath.exists():
-        for attempt in range(3):
-            try:
-                with open(filepath, 'r') as f:
-                    content = f.read().strip()
-                    if not content:
-                        if attempt < 2:
-                            import time
-                            time.sleep(0.1)
-                            continue
-                        return {"job_id": job_id, "status": "unknown", "message": "Status file is empty."}
-                    return json.loads(content)
-            except Exception as e:
-                if attempt < 2:
-                    import time
-                    time.sleep(0.1)
-                    continue
-                logger.error(f"Failed to read status for job {job_id}: {e}")
-                return {"job_id": job_id, "status": "error", "message": f"Failed to read status file: {e}"}
-    else:
+    if not filepath.exists():
         return {"job_id": job_id, "status": "unknown", "message": "Status file not found."}
+    try:
+        with open(filepath, 'r') as f:
+            content = f.read().strip()
+    except OSError as e:
+        logger.error(f"Failed to read status for job {job_id}: {e}")
+        return {"job_id": job_id, "status": "error", "message": f"Failed to read status file: {e}"}
+    if not content:
+        return {"job_id": job_id, "status": "unknown", "message": "Status file is empty."}
+    try:
+        job_status = json.loads(content)
+    except json.JSONDecodeError as e:
+        logger.error(f"Failed to read status for job {job_id}: {e}")
+        return {"job_id": job_id, "status": "error", "message": f"Failed to read status file: {e}"}
+    job_status.update(_control.pending_fields(job_id))
+    return job_status
 
 def register_job_process(job_id: str, pid: int):
     """
     Registers a process ID (PID) with a job.
     """
     filepath = _get_status_filepath(job_id)
-    job_status = get_job_status(job_id) # Get current status
-    
-    if "pids" not in job_status:
-        job_status["pids"] = []
-    
-    if pid not in job_status["pids"]:
-        job_status["pids"].append(pid)
-        try:
-            with open(filepath, 'w') as f:
-                json.dump(job_status, f, indent=2)
-            logger.info(f"Registered PID {pid} for job {job_id}.")
-        except Exception as e:
-            logger.error(f"Failed to register PID {pid} for job {job_id}: {e}")
+    os.makedirs(JOB_STATUS_DIR, exist_ok=True)
+    try:
+        with _status_file_lock(job_id):
+            job_status = _read_status_file(filepath)
+            pids = job_status.setdefault("pids", [])
+            if pid in pids:
+                return
+            pids.append(pid)
+            _write_status_file(filepath, job_status)
+        logger.info(f"Registered PID {pid} for job {job_id}.")
+    except Exception as e:
+        logger.error(f"Failed to register PID {pid} for job {job_id}: {e}")
 
 def unregister_job_process(job_id: str, pid: int):
     """
     Unregisters a process ID (PID) from a job.
     """
     filepath = _get_status_filepath(job_id)
-    job_status = get_job_status(job_id) # Get current status
-
-    if "pids" in job_status and pid in job_status["pids"]:
-        job_status["pids"].remove(pid)
-        try:
-            with open(filepath, 'w') as f:
-                json.dump(job_status, f, indent=2)
-            logger.info(f"Unregistered PID {pid} from job {job_id}.")
-        except Exception as e:
-            logger.error(f"Failed to unregister PID {pid} for job {job_id}: {e}")
+    if not filepath.exists():
+        return
+    try:
+        with _status_file_lock(job_id):
+            job_status = _read_status_file(filepath)
+            if pid not in job_status.get("pids", []):
+                return
+            job_status["pids"].remove(pid)
+            _write_status_file(filepath, job_status)
+        logger.info(f"Unregistered PID {pid} from job {job_id}.")
+    except Exception as e:
+        logger.error(f"Failed to unregister PID {pid} for job {job_id}: {e}")
 
 def request_job_stop(job_id: str):
     """
     Sets a flag in the job's status file indicating that a stop has been requested.
-    Also attempts to terminate any registered processes for the job.
+    Also attempts to terminate any registered processes for the job. Trials in this
+    process see the flag at once, those in other processes within CONTROL_POLL_SECONDS.
     """
+    _control.mark_stopped(job_id)
     filepath = _get_status_filepath(job_id)
-    job_status = {}
-    if filepath.exists():
-        try:
-            with open(filepath, 'r') as f:
-                content = f.read().strip()
-                if content:
-                    job_status = json.loads(content)
-        except json.JSONDecodeError:
-            pass # File corrupted, start with empty status
-
-    job_status["stop_requested"] = True
-    job_status["timestamp"] = datetime.now().isoformat()
-    job_status["message"] = "Stop requested."
-    
+    os.makedirs(JOB_STATUS_DIR, exist_ok=True)
+    try:
+        with _status_file_lock(job_id):
+            job_status = _read_status_file(filepath)
+            job_status["stop_requested"] = True
+            job_status["timestamp"] = datetime.now().isoformat()
+            job_status["message"] = "Stop requested."
+            pids_to_terminate = job_status.get("pids", [])
+            # Clear PIDs before attempting termination
+            job_status["pids"] = []
+            _write_status_file(filepath, job_status)
+    except Exception as e:
+        logger.error(f"Failed to request stop for job {job_id}: {e}")
+        return
+
     # Attempt to terminate registered processes
-    pids_to_terminate = job_status.get("pids", [])
     for pid in pids_to_terminate:
         try:
             os.kill(pid, signal.SIGTERM)
@@ -168,40 +374,11 @@ def request_job_stop(job_id: str):
                 logger.warning(f"PID {pid} for job {job_id} not found (already terminated?).")
             except Exception as e_kill:
                 logger.error(f"Failed to send SIGKILL to PID {pid} for job {job_id}: {e_kill}")
-    
-    # Clear PIDs after attempting termination
-    job_status["pids"] = []
-
-    try:
-        with open(filepath, 'w') as f:
-            json.dump(job_status, f, indent=2)
-        logger.info(f"Stop requested for job {job_id}. Registered processes terminated.")
-    except Exception as e:
-        logger.error(f"Failed to request stop for job {job_id}: {e}")
+    logger.info(f"Stop requested for job {job_id}. Registered processes terminated.")
 
 def is_job_stop_requested(job_id: str) -> bool:
     """
-    Checks if a stop has been requested for a given job.
+    Checks if a stop has been requested for a given job. A memory read once the job
+    is watched; the first check of a job in this process reads its status file.
     """
-    filepath = _get_status_filepath(job_id)
-    if filepath.exists():
-        for attempt in range(3):
-            try:
-                with open(filepath, 'r') as f:
-                    content = f.read().strip()
-                    if not content:
-                        if attempt < 2:
-                            import time
-                            time.sleep(0.1)
-                            continue
-                        return False
-                    job_status = json.loads(content)
-                    return job_status.get("stop_requested", False)
-            except Exception as e:
-                if attempt < 2:
-                    import time
-                    time.sleep(0.1)
-                    continue
-                logger.error(f"Failed to read stop request for job {job_id}: {e}")
-                return False
-    return False
+    return _control.stop_requested(job_id)
@@ -0,0 +1,114 @@
+"""
+In-memory columnar snapshot of the cached market list (volatile_cryptos.json).
+
+The snapshot is built once per version of the cache file and shared by every
+CryptoDiscovery of the process. Rankings are argsorted when it is built, so
+the volatile list, top movers and symbol/name lookups read the first K rows of
+a precomputed order instead of reloading and re-sorting the whole list.
+"""
+
+import bisect
+import os
+import threading
+from typing import Dict, List, Optional, Tuple
+
+import numpy as np
+
+def _number(value) -> float:
+    return float(value) if isinstance(value, (int, float)) else 0.0
+
+def file_version(path: str) -> Optional[Tuple[int, int]]:
+    """(mtime_ns, size) of path, or None when it does not exist."""
+    try:
+        stat = os.stat(path)
+    except OSError:
+        return None
+    return stat.st_mtime_ns, stat.st_size
+
+class MarketSnapshot:
+    """Rows of one processed market list with their volatility and 24h change rankings."""
+
+    def __init__(self, rows: List[Dict], version: Optional[Tuple[int, int]] = None):
+        self.rows = rows
+        self.version = version
+        volatility = np.array([_number(row.get('volatility_score')) for row in rows], dtype=np.float64)
+        change = np.array([_number(row.get('price_change_percentage_24h')) for row in rows], dtype=np.float64)
+        self._change = change
+        # Stable descending orders: ties keep the list order, as list.sort(reverse=True) does
+        self._by_volatility = np.argsort(-volatility, kind='stable')
+        self._abs_change_by_volatility = np.abs(change)[self._by_volatility]
+        # Processed rows score volatility as |24h change|; then the threshold is a binary search
+        self._threshold_sorted = bool(np.all(np.diff(self._abs_change_by_volatility) <= 0))
+        self._search_keys = sorted(
+            (str(value).lower(), i) for i, row in enumerate(rows)
+            for value in {row.get('symbol'), row.get('id'), row.get('name')} if value
+        )
+        self._search_words = [key for key, _ in self._search_keys]
+
+    def _copies(self, indices) -> List[Dict]:
+        # Copies, so callers can annotate their results without touching the shared rows
+        return [dict(self.rows[i]) for i in indices]
+
+    def _volatile_indices(self, min_volatility: float, limit: int) -> np.ndarray:
+        if self._threshold_sorted:
+            # Count of leading entries with |change| >= min_volatility in the descending column
+            passing = len(self._abs_change_by_volatility) - int(np.searchsorted(
+                self._abs_change_by_volatility[::-1], min_volatility, side='left'))
+            return self._by_volatility[:passing][:limit]
+        return self._by_volatility[self._abs_change_by_volatility >= min_volatility][:limit]
+
+    def volatile(self, min_volatility: float, limit: int) -> List[Dict]:
+        """The `limit` most volatile rows with |24h change| >= min_volatility, most volatile first."""
+        return self._copies(self._volatile_indices(min_volatility, limit))
+
+    def top_movers(self, count: int, min_volatility: float, limit: int,
+                   include_gainers: bool = True, include_losers: bool = True) -> Dict[str, List[Dict]]:
+        """Gainers and losers among volatile(min_volatility, limit), ordered by 24h change (descending)."""
+        candidates = self._volatile_indices(min_volatility, limit)
+        if len(candidates) == 0:
+            return {'gainers': [], 'losers': []}
+        by_change = candidates[np.argsort(-self._change[candidates], kind='stable')]
+        result = {}
+        if include_gainers:
+            result['gainers'] = self._copies(by_change[self._change[by_change] > 0][:count])
+        if include_losers:
+            result['losers'] = self._copies(by_change[self._change[by_change] < 0][-count:])
+        return result
+
+    def search(self, query: str, limit: int) -> Tuple[List[Dict], bool]:
+        """
+        Rows whose symbol, id or name starts with query (case-insensitive), exact matches
+        first, and whether any of them matched exactly.
+        """
+        query = query.strip().lower()
+        if not query:
+            return [], False
+        matched: Dict[int, bool] = {} # row -> matched one of its keys exactly
+        position = bisect.bisect_left(self._search_words, query)
+        while position < len(self._search_keys) and self._search_words[position].startswith(query):
+            word, i = self._search_keys[position]
+            matched[i] = matched.get(i, False) or word == query
+            position += 1
+        exact = [i for i, is_exact in matched.items() if is_exact]
+        prefix = [i for i, is_exact in matched.items() if not is_exact]
+        ranked = exact + sorted(prefix, key=lambda i: self.rows[i].get('market_cap_rank') or float('inf'))
+        return self._copies(ranked[:limit]), bool(exact)
+
+# Shared by the CryptoDiscovery instances of the process, by cache file path
+_snapshots: Dict[str, MarketSnapshot] = {}
+_snapshots_lock = threading.Lock()
+
+def get_snapshot(cache_file: str) -> Optional[MarketSnapshot]:
+    """The snapshot of cache_file if it was built from the file's current version."""
+    with _snapshots_lock:
+        snapshot = _snapshots.get(cache_file)
+    if snapshot is not None and snapshot.version == file_version(cache_file):
+        return snapshot
+    return None
+
+def publish_snapshot(cache_file: str, rows: List[Dict]) -> MarketSnapshot:
+    """Builds the snapshot of rows, just read from or written to cache_file."""
+    snapshot = MarketSnapshot(rows, file_version(cache_file))
+    with _snapshots_lock:
+        _snapshots[cache_file] = snapshot
+    return snapshot
@@ -0,0 +1,296 @@
+"""
+Low-overhead hot-path instrumentation: counters, gauges and fixed-bucket timing
+histograms, served in Prometheus text format by /api/metrics.
+
+Every sample goes to this process's registry (PROCESS) and to the registries
+bound to the calling thread with bind(), e.g. the registry of the optimization
+job being run (job_registry). Recording is a perf_counter() pair and a dict
+update under a lock, cheap enough for per-trial and per-request stages (never
+per bar). Job registries are written to the job's status file
+(job_status_manager.update_job_stats) and other processes' registries to
+<DATA_DIR>/metrics/<name>-<pid>.json, both at most every METRICS_PUBLISH_SECONDS,
+so the API process can serve the metrics of jobs and of the rate limiter
+process it does not run itself.
+"""
+
+import bisect
+import json
+import logging
+import os
+import threading
+import time
+from contextlib import contextmanager
+from typing import Any, Dict, Iterable, List, Optional, Tuple
+
+from core.app_config import Config
+from core import job_status_manager
+
+logger = logging.getLogger(__name__)
+
+# Upper bounds in seconds, from a cache read to a throttled API call
+BUCKETS = (0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0)
+
+class MetricsRegistry:
+    """Named counters, gauges and histograms; names are dotted, e.g. 'backtest.signals'."""
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self.started_at = time.time()
+        self.counters: Dict[str, float] = {}
+        self.gauges: Dict[str, float] = {}
+        self.histograms: Dict[str, list] = {} # name -> [per-bucket counts (last = +Inf), sum, count]
+        self.last_published = 0.0
+
+    def inc(self, name: str, value: float = 1) -> None:
+        with self._lock:
+            self.counters[name] = self.counters.get(name, 0) + value
+
+    def set_gauge(self, name: str, value: float) -> None:
+        with self._lock:
+            self.gauges[name] = value
+
+    def observe(self, name: str, seconds: float) -> None:
+        bucket = bisect.bisect_left(BUCKETS, seconds)
+        with self._lock:
+            histogram = self.histograms.get(name)
+            if histogram is None:
+                histogram = self.histograms[name] = [[0] * (len(BUCKETS) + 1), 0.0, 0]
+            histogram[0][bucket] += 1
+            histogram[1] += seconds
+            histogram[2] += 1
+
+    def merge(self, snapshot: Dict[str, Any]) -> None:
+        """Adds the samples of another registry's snapshot (e.g. returned by a worker process)."""
+        with self._lock:
+            for name, value in snapshot.get('counters', {}).items():
+                self.counters[name] = self.counters.get(name, 0) + value
+            self.gauges.update(snapshot.get('gauges', {}))
+            for name, other in snapshot.get('histograms', {}).items():
+                histogram = self.histograms.get(name)
+                if histogram is None:
+                    histogram = self.histograms[name] = [[0] * (len(BUCKETS) + 1), 0.0, 0]
+                histogram[0] = [a + b for a, b in zip(histogram[0], other['buckets'])]
+                histogram[1] += other['sum']
+                histogram[2] += other['count']
+
+    def snapshot(self) -> Dict[str, Any]:
+        """JSON-friendly copy, with trials/sec and the hit ratio of every '<x>.hits'/'<x>.misses' pair."""
+        now = time.time()
+        with self._lock:
+            counters = dict(self.counters)
+            snapshot = {
+                'started_at': self.started_at,
+                'updated_at': now,
+                'counters': counters,
+                'gauges': dict(self.gauges),
+                'histograms': {name: {'buckets': list(h[0]), 'sum': h[1], 'count': h[2]} for name, h in self.histograms.items()},
+            }
+        elapsed = now - self.started_at
+        snapshot['trials_per_second'] = counters.get('optimizer.trials', 0) / elapsed if elapsed > 0 else 0.0
+        snapshot['hit_ratios'] = {}
+        for name, hits in counters.items():
+            if name.endswith('.hits'):
+                prefix = name[:-len('.hits')]
+                lookups = hits + counters.get(prefix + '.misses', 0)
+                snapshot['hit_ratios'][prefix] = hits / lookups if lookups else 0.0
+        return snapshot
+
+PROCESS = MetricsRegistry()
+
+_config: Optional[Config] = None
+_local = threading.local()
+_jobs: Dict[str, MetricsRegistry] = {}
+_jobs_lock = threading.Lock()
+
+def _settings() -> Config:
+    global _config
+    if _config is None:
+        _config = Config()
+    return _config
+
+def enabled() -> bool:
+    return _settings().METRICS_ENABLED
+
+def _targets() -> Tuple[MetricsRegistry, ...]:
+    return (PROCESS,) + getattr(_local, 'bound', ())
+
+@contextmanager
+def bind(registry: Optional[MetricsRegistry]):
+    """Also records this thread's samples into registry (if any) until the block exits."""
+    previous = getattr(_local, 'bound', ())
+    if registry is not None:
+        _local.bound = previous + (registry,)
+    try:
+        yield registry
+    finally:
+        _local.bound = previous
+
+def inc(name: str, value: float = 1) -> None:
+    if enabled():
+        for registry in _targets():
+            registry.inc(name, value)
+
+def set_gauge(name: str, value: float) -> None:
+    if enabled():
+        for registry in _targets():
+            registry.set_gauge(name, value)
+
+def observe(name: str, seconds: float) -> None:
+    if enabled():
+        for registry in _targets():
+            registry.observe(name, seconds)
+
+def merge(snapshot: Dict[str, Any]) -> None:
+    """Adds a worker's samples to this thread's registries."""
+    if enabled():
+        for registry in _targets():
+            registry.merge(snapshot)
+
+class timer:
+    """Context manager recording the duration of its block in the histogram `name`."""
+    __slots__ = ('name', 'start')
+
+    def __init__(self, name: str):
+        self.name = name
+
+    def __enter__(self):
+        self.start = time.perf_counter()
+        return self
+
+    def __exit__(self, exc_type, exc, tb):
+        observe(self.name, time.perf_counter() - self.start)
+        return False
+
+# --- Per-job registries ---
+
+def job_registry(job_id: str) -> MetricsRegistry:
+    with _jobs_lock:
+        registry = _jobs.get(job_id)
+        if registry is None:
+            registry = _jobs[job_id] = MetricsRegistry()
+            while len(_jobs) > _settings().METRICS_RECENT_JOBS:
+                del _jobs[next(iter(_jobs))] # Oldest job first
+        return registry
+
+def publish_job(job_id: str, force: bool = False) -> None:
+    """Stores the job's metrics under 'metrics' in its status file, at most every METRICS_PUBLISH_SECONDS."""
+    if not enabled():
+        return
+    registry = job_registry(job_id)
+    now = time.time()
+    if not force and now - registry.last_published < _settings().METRICS_PUBLISH_SECONDS:
+        return
+    registry.last_published = now
+    job_status_manager.update_job_stats(job_id, 'metrics', registry.snapshot())
+
+# --- Per-process snapshots ---
+
+def _process_metrics_dir() -> str:
+    return os.path.join(_settings().DATA_DIR, 'metrics')
+
+def publish_process(name: str, force: bool = False) -> None:
+    """Writes this process's registry to <DATA_DIR>/metrics/<name>-<pid>.json, throttled."""
+    if not enabled():
+        return
+    now = time.time()
+    if not force and now - PROCESS.last_published < _settings().METRICS_PUBLISH_SECONDS:
+        return
+    PROCESS.last_published = now
+    directory = _process_metrics_dir()
+    filepath = os.path.join(directory, f"{name}-{os.getpid()}.json")
+    temp_filepath = filepath + '.tmp'
+    try:
+        os.makedirs(directory, exist_ok=True)
+        with open(temp_filepath, 'w') as f:
+            json.dump(PROCESS.snapshot(), f)
+        os.replace(temp_filepath, filepath)
+    except OSError as e:
+        logger.warning(f"Could not publish metrics to {filepath}: {e}")
+
+def _pid_alive(pid: int) -> bool:
+    try:
+        os.kill(pid, 0)
+    except ProcessLookupError:
+        return False
+    except PermissionError:
+        return True
+    return True
+
+def published_processes() -> List[Tuple[str, int, Dict[str, Any]]]:
+    """(name, pid, snapshot) of the other live processes that published their metrics."""
+    directory = _process_metrics_dir()
+    if not os.path.isdir(directory):
+        return []
+    processes = []
+    for filename in sorted(os.listdir(directory)):
+        if not filename.endswith('.json'):
+            continue
+        name, _, pid = filename[:-len('.json')].rpartition('-')
+        if not pid.isdigit() or int(pid) == os.getpid():
+            continue
+        filepath = os.path.join(directory, filename)
+        if not _pid_alive(int(pid)):
+            try:
+                os.remove(filepath) # Left behind by a process that exited
+            except OSError:
+                pass
+            continue
+        try:
+            with open(filepath, 'r') as f:
+                processes.append((name, int(pid), json.load(f)))
+        except (OSError, json.JSONDecodeError):
+            continue
+    return processes
+
+def collect_sources(process_name: str = 'web') -> List[Tuple[Dict[str, Any], Dict[str, Any]]]:
+    """(labels, snapshot) of this process, the other publishing processes and the recent jobs."""
+    sources = [({'process': process_name}, PROCESS.snapshot())]
+    sources += [({'process': name}, snapshot) for name, _, snapshot in published_processes()]
+    sources += [({'job_id': job_id}, snapshot)
+                for job_id, snapshot in job_status_manager.recent_job_metrics(_settings().METRICS_RECENT_JOBS).items()]
+    return sources
+
+# --- Prometheus text format ---
+
+def _metric_name(name: str, suffix: str = '') -> str:
+    sanitized = ''.join(c if c.isalnum() else '_' for c in name)
+    return f"pricer_{sanitized}{suffix}"
+
+def _escape(value: Any) -> str:
+    return str(value).replace('\\', '\\\\').replace('"', '\\"').replace('\n', '\\n')
+
+def _labels(labels: Dict[str, Any], extra: Optional[Dict[str, Any]] = None) -> str:
+    merged = {**labels, **(extra or {})}
+    if not merged:
+        return ''
+    return '{' + ','.join(f'{key}="{_escape(value)}"' for key, value in merged.items()) + '}'
+
+def render_prometheus(sources: Iterable[Tuple[Dict[str, Any], Dict[str, Any]]]) -> str:
+    """Prometheus exposition text of (labels, snapshot) pairs; one family per metric name."""
+    families: Dict[str, Tuple[str, List[str]]] = {}
+
+    def add(family: str, kind: str, line: str):
+        families.setdefault(family, (kind, []))[1].append(line)
+
+    for labels, snapshot in sources:
+        for name, value in snapshot.get('counters', {}).items():
+            family = _metric_name(name, '_total')
+            add(family, 'counter', f"{family}{_labels(labels)} {value}")
+        for name, value in snapshot.get('gauges', {}).items():
+            family = _metric_name(name)
+            add(family, 'gauge', f"{family}{_labels(labels)} {value}")
+        for name, histogram in snapshot.get('histograms', {}).items():
+            family = _metric_name(name, '_seconds')
+            cumulative = 0
+            for bound, count in zip(BUCKETS + (float('inf'),), histogram['buckets']):
+                cumulative += count
+                le = '+Inf' if bound == float('inf') else repr(bound)
+                add(family, 'histogram', f"{family}_bucket{_labels(labels, {'le': le})} {cumulative}")
+            add(family, 'histogram', f"{family}_sum{_labels(labels)} {histogram['sum']}")
+            add(family, 'histogram', f"{family}_count{_labels(labels)} {histogram['count']}")
+
+    lines = []
+    for family, (kind, samples) in families.items():
+        lines.append(f"# TYPE {family} {kind}")
+        lines.extend(samples)
+    return '\n'.join(lines) + '\n'
@@ -0,0 +1,157 @@
+"""
+Memory-mapped OHLC history store.
+
+Each crypto/interval pair has one binary file of fixed-width records
+(timestamp in ms, open, high, low, close) sorted by timestamp. Reads map the
+file read-only, so loading is zero-copy and worker processes reading the same
+history share its page-cache pages. Fetches are merged in by appending the
+candles newer than the stored history; only a fetch that reaches further back
+than the stored history rewrites the file (atomically, via .tmp + os.replace).
+"""
+
+import logging
+import os
+import time
+from contextlib import contextmanager
+from typing import Optional
+
+import numpy as np
+import pandas as pd
+
+try:
+    import fcntl
+except ImportError:  # Windows: writers are not serialised across processes
+    fcntl = None
+
+logger = logging.getLogger(__name__)
+
+OHLC_RECORD_DTYPE = np.dtype([
+    ('timestamp', '<i8'),  # Candle time, ms since epoch
+    ('open', '<f8'),
+    ('high', '<f8'),
+    ('low', '<f8'),
+    ('close', '<f8'),
+])
+
+# Candle granularity returned by CoinGecko's /ohlc endpoint, in seconds
+INTERVAL_SECONDS = {'30m': 30 * 60, '4h': 4 * 3600, '4d': 4 * 86400}
+
+def coingecko_interval(days: int) -> str:
+    """Granularity CoinGecko uses for an /ohlc request covering `days` days."""
+    if days <= 2:
+        return '30m'
+    if days <= 30:
+        return '4h'
+    return '4d'
+
+def rows_to_records(rows) -> np.ndarray:
+    """Converts [[timestamp, open, high, low, close], ...] into sorted, de-duplicated records."""
+    values = np.asarray(rows, dtype=np.float64).reshape(-1, 5)
+    records = np.empty(len(values), dtype=OHLC_RECORD_DTYPE)
+    records['timestamp'] = values[:, 0].astype(np.int64)
+    for column, name in enumerate(('open', 'high', 'low', 'close'), start=1):
+        records[name] = values[:, column]
+    return _sorted_unique(records)
+
+def _sorted_unique(records: np.ndarray) -> np.ndarray:
+    """Sorts by timestamp keeping the last occurrence of each timestamp."""
+    records = records[np.argsort(records['timestamp'], kind='stable')]
+    if len(records) < 2:
+        return records
+    keep = np.append(records['timestamp'][1:] != records['timestamp'][:-1], True)
+    return records[keep]
+
+def records_to_dataframe(records: np.ndarray) -> pd.DataFrame:
+    """Builds the timestamp-indexed OHLC DataFrame used throughout the app."""
+    index = pd.DatetimeIndex(records['timestamp'].astype('datetime64[ms]'), name='timestamp')
+    return pd.DataFrame({name: records[name] for name in ('open', 'high', 'low', 'close')}, index=index)
+
+class OHLCStore:
+    """Append-only OHLC history files, one per crypto and interval."""
+
+    def __init__(self, root_dir: str):
+        self.root_dir = root_dir
+        os.makedirs(root_dir, exist_ok=True)
+
+    def path(self, crypto_id: str, interval: str) -> str:
+        safe_crypto_id = crypto_id.replace(" ", "_").lower()
+        return os.path.join(self.root_dir, f"{safe_crypto_id}_{interval}.ohlc")
+
+    def age_seconds(self, crypto_id: str, interval: str) -> Optional[float]:
+        """Seconds since the history was last merged, or None if there is none."""
+        path = self.path(crypto_id, interval)
+        if not os.path.exists(path):
+            return None
+        return time.time() - os.path.getmtime(path)
+
+    def read(self, crypto_id: str, interval: str, start_ms: int = None, end_ms: int = None) -> np.ndarray:
+        """
+        Returns the stored records with start_ms <= timestamp <= end_ms as a read-only
+        memory-mapped view (an empty array when nothing is stored).
+        """
+        path = self.path(crypto_id, interval)
+        if not os.path.exists(path) or os.path.getsize(path) < OHLC_RECORD_DTYPE.itemsize:
+            return np.empty(0, dtype=OHLC_RECORD_DTYPE)
+        records = np.memmap(path, dtype=OHLC_RECORD_DTYPE, mode='r',
+                            shape=(os.path.getsize(path) // OHLC_RECORD_DTYPE.itemsize,))
+        timestamps = records['timestamp']
+        lo = 0 if start_ms is None else int(np.searchsorted(timestamps, start_ms, side='left'))
+        hi = len(records) if end_ms is None else int(np.searchsorted(timestamps, end_ms, side='right'))
+        return records[lo:hi]
+
+    def merge(self, crypto_id: str, interval: str, rows) -> int:
+        """
+        Merges freshly fetched rows into the stored history and returns how many new
+        candles were added. A re-fetched last candle (still forming when it was stored)
+        is updated in place.
+        """
+        new = rows if isinstance(rows, np.ndarray) and rows.dtype == OHLC_RECORD_DTYPE else rows_to_records(rows)
+        path = self.path(crypto_id, interval)
+        with self._locked(path):
+            existing = self.read(crypto_id, interval)
+            if len(new) == 0:
+                return 0
+            if len(existing) == 0:
+                self._rewrite(path, new)
+                return len(new)
+
+            first_ts = int(existing['timestamp'][0])
+            last_ts = int(existing['timestamp'][-1])
+            if int(new['timestamp'][0]) < first_ts:
+                # The fetch reaches further back than the history: rewrite the whole file
+                merged = _sorted_unique(np.concatenate([np.array(existing), new]))
+                added = len(merged) - len(existing)
+                del existing
+                self._rewrite(path, merged)
+                return added
+
+            del existing
+            last_update = new[new['timestamp'] == last_ts]
+            tail = new[new['timestamp'] > last_ts]
+            with open(path, 'r+b') as f:
+                if len(last_update):
+                    f.seek(-OHLC_RECORD_DTYPE.itemsize, os.SEEK_END)
+                    f.write(last_update[-1:].tobytes())
+                f.seek(0, os.SEEK_END)
+                f.write(tail.tobytes())
+            os.utime(path)  # Marks the history as freshly fetched even when nothing was appended
+            return len(tail)
+
+    def _rewrite(self, path: str, records: np.ndarray) -> None:
+        temp_path = path + ".tmp"
+        with open(temp_path, 'wb') as f:
+            f.write(np.ascontiguousarray(records).tobytes())
+        os.replace(temp_path, path)  # Readers holding the old mapping keep a consistent view
+
+    @contextmanager
+    def _locked(self, path: str):
+        """Serialises writers of one history file across processes."""
+        if fcntl is None:
+            yield
+            return
+        with open(path + ".lock", 'a') as lock_file:
+            fcntl.flock(lock_file, fcntl.LOCK_EX)
+            try:
+                yield
+            finally:
+                fcntl.flock(lock_file, fcntl.LOCK_UN)
@@ -11,6 +11,9 @@ import logging
 import os
 import time
 import random
+import sqlite3
+import threading
+import uuid
 from datetime import datetime
 from typing import Dict, List, Optional, Any, Tuple
 from pathlib import Path
@@ -21,6 +24,9 @@ from . import job_status_manager # Added import
 
 from .backtester_wrapper import BacktesterWrapper # New import
 from .data_fetcher import DataFetcher # New import
+from .indicator_cache import IndicatorCache
+from . import metrics
+from .parallel_trials import ParallelTrialRunner
 
 from .exceptions import JobStopRequestedError, CoinGeckoRateLimitError # New import
 
@@ -48,6 +54,7 @@ class RateLimitStopper:
 from .parameter_manager import ParameterManager
 from .crypto_discovery import CryptoDiscovery
 from .result_manager import ResultManager
+from .result_index import ResultIndex
 from .app_config import Config
 from config import DEFAULT_TIMEFRAME, DEFAULT_INTERVAL
 
@@ -84,7 +91,12 @@ class BayesianOptimizer:
         self.param_manager = ParameterManager(param_set_name='small')
         self.crypto_discovery = CryptoDiscovery(results_dir, data_fetcher=self.data_fetcher)
         self.result_manager = ResultManager(self.config)
+        self.result_index = ResultIndex(results_dir) # Indexed best_params_* results of results_dir
         self.backtester_wrapper = BacktesterWrapper(self.config, data_fetcher=self.data_fetcher) # Initialize BacktesterWrapper
+        # Shared by all trials and by the worker threads of optimize_volatile_cryptos
+        self.indicator_cache = IndicatorCache(max_bytes=self.config.INDICATOR_CACHE_MAX_MB * 1024 * 1024)
+        self._study_storage = None # Created on first use, shared by all studies of this optimizer
+        self._study_storage_lock = threading.Lock()
         
         # Ensure results directory exists
         os.makedirs(results_dir, exist_ok=True)
@@ -127,17 +139,54 @@ class BayesianOptimizer:
             self.logger.error(f"Unknown strategy: {strategy}")
             raise ValueError(f"Unknown strategy: {strategy}")
         
-        # Create study
+        # The sampler and pruner only see this run's trials: earlier values were scored on older
+        # candles. A persistent archive study per objective keeps the trials of every run, and its
+        # best parameter sets are enqueued to be re-evaluated on the current data
         study_name = f"{crypto}_{strategy}_{int(time.time())}"
         study = optuna.create_study(
             direction='maximize',
             study_name=study_name,
-            sampler=optuna.samplers.TPESampler(seed=self.seed)
+            sampler=optuna.samplers.TPESampler(seed=self.seed),
+            pruner=self._create_pruner()
         )
-        
+        archive = None
+        storage = self._get_study_storage()
+        if storage is not None:
+            study_name = self._archive_study_name(crypto, strategy)
+            archive = optuna.create_study(direction='maximize', study_name=study_name, storage=storage, load_if_exists=True)
+            self._warm_start(study, archive, crypto, strategy)
+        run_id = uuid.uuid4().hex # Tags this run's trials in the archive
+        trial_results: Dict[int, Dict[str, Any]] = {} # Full backtest results of this run's trials; the study keeps scalars only
+        job_metrics = metrics.job_registry(job_id) if job_id else None
+        
+        # Run trials concurrently on worker processes when configured; they need the dataset up front
+        trial_runner = None
+        trial_workers = self.config.OPTIMIZER_TRIAL_WORKERS
+        if trial_workers > 1:
+            if data is None:
+                self.logger.info(f"Parallel trials need pre-fetched data; running {crypto} trials serially.")
+            else:
+                trial_runner = ParallelTrialRunner(
+                    data, crypto, strategy, DEFAULT_TIMEFRAME, DEFAULT_INTERVAL, trial_workers,
+                    cache_max_bytes=self.config.INDICATOR_CACHE_MAX_MB * 1024 * 1024,
+                    walk_forward_windows=self.config.OPTIMIZER_WALK_FORWARD_WINDOWS,
+                    walk_forward_std_penalty=self.config.OPTIMIZER_WALK_FORWARD_STD_PENALTY,
+                    checkpoints=self._pruning_checkpoints(),
+                    keep_workers=self.config.OPTIMIZER_KEEP_TRIAL_WORKERS
+                )
+
         # Define objective function
         def objective(trial):
-            return self._objective_function(trial, crypto, strategy, job_id, data)
+            trial.set_user_attr("run_id", run_id)
+            # Trials run on Optuna's threads; bind the job's registry to each of them
+            with metrics.bind(job_metrics):
+                metrics.inc('optimizer.trials')
+                try:
+                    with metrics.timer('optimizer.trial'):
+                        return self._objective_function(trial, crypto, strategy, job_id, data, trial_runner, trial_results)
+                finally:
+                    if job_id:
+                        metrics.publish_job(job_id)
         
         # Run optimization
         start_time = time.time()
@@ -150,7 +199,8 @@ class BayesianOptimizer:
                 job_stop_callback = JobStopCallback(job_id, self.logger)
                 callbacks.append(job_stop_callback)
             
-            study.optimize(objective, n_trials=n_trials, timeout=timeout, callbacks=callbacks)
+            study.optimize(objective, n_trials=n_trials, timeout=timeout, callbacks=callbacks,
+                           n_jobs=trial_workers if trial_runner else 1)
         except KeyboardInterrupt:
             self.logger.warning("Optimization interrupted by user")
             raise # Re-raise to stop the study
@@ -163,12 +213,29 @@ class BayesianOptimizer:
         except Exception as e:
             self.logger.error(f"Optimization failed: {e}", exc_info=True)
             raise
+        finally:
+            if trial_runner:
+                trial_runner.close()
+            if job_id:
+                metrics.publish_job(job_id, force=True)
         
         end_time = time.time()
 
+        cache_stats = trial_runner.cache_stats() if trial_runner else self.indicator_cache.stats()
+        self.logger.info(f"Indicator cache after {crypto}/{strategy}: {cache_stats['hits']} hits, {cache_stats['misses']} misses, {cache_stats['bytes']} bytes")
+        if job_id:
+            job_status_manager.update_job_stats(job_id, 'indicator_cache', cache_stats)
+
+        run_trials = study.get_trials(deepcopy=False)
+        if archive is not None:
+            try:
+                archive.add_trials([t for t in run_trials if t.state == optuna.trial.TrialState.COMPLETE])
+            except Exception as e:
+                self.logger.warning(f"Could not archive the trials of {crypto}/{strategy} in {study_name}: {e}")
+
         # Check if optimization stopped due to rate limit
         consecutive_rate_limit_failures = 0
-        for t in reversed(study.trials):
+        for t in reversed(run_trials):
             if t.state == optuna.trial.TrialState.FAIL and math.isnan(t.value) and t.user_attrs.get("rate_limit_hit"):
                 consecutive_rate_limit_failures += 1
             else:
@@ -181,7 +248,7 @@ class BayesianOptimizer:
                 'strategy': strategy,
                 'error': "Optimization stopped due to persistent CoinGecko API rate limit.",
                 'timestamp': datetime.now().isoformat(),
-                'n_trials': len(study.trials),
+                'n_trials': len(run_trials),
                 'best_value': None,
                 'best_params': {},
                 'optimization_time': end_time - start_time,
@@ -190,15 +257,20 @@ class BayesianOptimizer:
             }
         
         # Compile results
-        best_trial = study.best_trial
-        backtest_result = best_trial.user_attrs.get("backtest_result") if best_trial else None
+        completed = [t for t in run_trials if t.state == optuna.trial.TrialState.COMPLETE]
+        if not completed:
+            raise ValueError(f"No trials completed for {crypto}/{strategy}.")
+        best_trial = max(completed, key=lambda t: t.value)
+        backtest_result = None
+        if best_trial:
+            backtest_result = trial_results.get(best_trial.number) or best_trial.user_attrs.get("backtest_summary")
 
         results = {
             'crypto': crypto,
             'strategy': strategy,
-            'n_trials': len(study.trials),
-            'best_value': study.best_value if study.best_trial else None,
-            'best_params': study.best_params if study.best_trial else {},
+            'n_trials': len(run_trials),
+            'best_value': best_trial.value if best_trial else None,
+            'best_params': best_trial.params if best_trial else {},
             'optimization_time': end_time - start_time,
             'timestamp': datetime.now().isoformat(),
             'study_name': study_name,
@@ -211,10 +283,29 @@ class BayesianOptimizer:
                     'params': trial.params,
                     'state': trial.state.name
                 }
-                for trial in study.trials
+                for trial in run_trials
             ]
         }
         
+        # Experimental, off by default: how sensitive the winner is to fill prices and costs (informational only)
+        if self.config.OPTIMIZER_MONTE_CARLO_PATHS > 0 and results['best_params']:
+            monte_carlo = self.backtester_wrapper.run_monte_carlo(
+                crypto, strategy, results['best_params'],
+                timeframe=DEFAULT_TIMEFRAME,
+                interval=DEFAULT_INTERVAL,
+                data=data,
+                indicator_cache=self.indicator_cache,
+                n_paths=self.config.OPTIMIZER_MONTE_CARLO_PATHS,
+                noise_fraction=self.config.OPTIMIZER_MONTE_CARLO_NOISE,
+                cost_multiple_max=self.config.OPTIMIZER_MONTE_CARLO_COST_MULTIPLE,
+                seed=self.seed or 0
+            )
+            if monte_carlo:
+                results['monte_carlo'] = monte_carlo
+                self.logger.info(f"Monte Carlo for {crypto}/{strategy} over {monte_carlo['paths']} paths: "
+                                 f"median profit {monte_carlo['median_profit_percentage']:.2f}%, "
+                                 f"loss probability {monte_carlo['loss_probability']:.2%}")
+
         # Save results
         self._save_optimization_results(results)
         
@@ -262,17 +353,25 @@ class BayesianOptimizer:
         # Pre-fetch data for all selected cryptos
         self.logger.info(f"Pre-fetching data for {len(selected_cryptos)} cryptos...")
         prefetched_data = {}
-        for crypto in selected_cryptos:
+        days = int(DEFAULT_TIMEFRAME)
+        try:
+            # One planned batch: cached histories are skipped and the rest are fetched concurrently
+            with metrics.bind(metrics.job_registry(job_id) if job_id else None), metrics.timer('optimizer.prefetch'):
+                batch = self.data_fetcher.fetch_planned(ohlc=[(crypto['id'], days) for crypto in selected_cryptos])
+        except Exception as e:
+            self.logger.error(f"Error pre-fetching data: {e}")
+            batch = None
+        for crypto in selected_cryptos if batch is not None else []:
             crypto_id = crypto['id']
-            try:
-                df = self.data_fetcher.get_crypto_data_merged(crypto_id, days=int(DEFAULT_TIMEFRAME))
-                if df is not None and not df.empty:
-                    prefetched_data[crypto_id] = df
-                    self.logger.info(f"Successfully pre-fetched data for {crypto_id}")
-                else:
-                    self.logger.warning(f"Could not pre-fetch data for {crypto_id}")
-            except Exception as e:
-                self.logger.error(f"Error pre-fetching data for {crypto_id}: {e}")
+            error = batch.errors.get(('ohlc', crypto_id, days))
+            df = batch.ohlc.get((crypto_id, days))
+            if error is not None:
+                self.logger.error(f"Error pre-fetching data for {crypto_id}: {error}")
+            elif df is not None and not df.empty:
+                prefetched_data[crypto_id] = df
+                self.logger.info(f"Successfully pre-fetched data for {crypto_id}")
+            else:
+                self.logger.warning(f"Could not pre-fetch data for {crypto_id}")
 
         # Run parallel optimization
         results = []
@@ -393,7 +492,9 @@ class BayesianOptimizer:
         self.logger.info(f"Batch optimization completed. Best overall: {batch_results['best_overall']}")
         return batch_results
     
-    def _objective_function(self, trial, crypto: str, strategy: str, job_id: str, data: pd.DataFrame = None) -> float:
+    def _objective_function(self, trial, crypto: str, strategy: str, job_id: str, data: pd.DataFrame = None,
+                            trial_runner: Optional[ParallelTrialRunner] = None,
+                            trial_results: Optional[Dict[int, Dict[str, Any]]] = None) -> float:
         """
         Objective function for Optuna optimization.
         
@@ -403,9 +504,12 @@ class BayesianOptimizer:
             strategy: Trading strategy name
             job_id: The ID of the parent job (for process tracking)
             data: Pre-fetched data (optional)
+            trial_runner: Worker pool to run the backtest on (optional, parallel mode)
+            trial_results: Receives the full backtest result by trial number (optional)
             
         Returns:
-            Objective value (profit percentage)
+            Objective value: final capital, or the walk-forward robust score when
+            OPTIMIZER_WALK_FORWARD_WINDOWS > 1
         """
         # Check for job stop request at the beginning of each trial
         if job_id and job_status_manager.is_job_stop_requested(job_id):
@@ -416,40 +520,148 @@ class BayesianOptimizer:
         params = self.param_manager.suggest_parameters(trial, strategy)
         self.logger.info(f"Trial {trial.number}: Testing params {params}")
         
+        def on_checkpoint(step: int, equity: float) -> bool:
+            # Called between native slices of the bars; True stops the backtest there
+            trial.report(equity, step)
+            return trial.should_prune()
+
+        pruning = on_checkpoint if self._pruning_checkpoints() > 0 else None
         try:
-            # Run backtest using the BacktesterWrapper
-            backtest_result = self.backtester_wrapper.run_single_backtest(
-                crypto=crypto,
-                strategy=strategy,
-                parameters=params,
-                timeframe=DEFAULT_TIMEFRAME, # Use a fixed timeframe for optimization
-                interval=DEFAULT_INTERVAL, # Use a fixed interval for optimization
-                data=data
-            )
+            if trial_runner is not None:
+                # Parallel mode: the worker process holds the dataset and its own indicator cache
+                backtest_result = trial_runner.run_backtest(params, on_checkpoint=pruning)
+            else:
+                # Run backtest using the BacktesterWrapper
+                backtest_result = self.backtester_wrapper.run_single_backtest(
+                    crypto=crypto,
+                    strategy=strategy,
+                    parameters=params,
+                    timeframe=DEFAULT_TIMEFRAME, # Use a fixed timeframe for optimization
+                    interval=DEFAULT_INTERVAL, # Use a fixed interval for optimization
+                    data=data,
+                    indicator_cache=self.indicator_cache,
+                    walk_forward_windows=self.config.OPTIMIZER_WALK_FORWARD_WINDOWS,
+                    walk_forward_std_penalty=self.config.OPTIMIZER_WALK_FORWARD_STD_PENALTY,
+                    checkpoints=self._pruning_checkpoints(),
+                    on_checkpoint=pruning
+                )
             
+            if backtest_result and backtest_result.get('pruned'):
+                self.logger.info(f"Trial {trial.number} pruned at checkpoint {backtest_result['stopped_at_checkpoint']} "
+                                 f"after {backtest_result['bars_simulated']} bars")
+                metrics.inc('optimizer.trials_pruned')
+                raise optuna.TrialPruned()
+
             if backtest_result and backtest_result.get('success'):
                 final_capital = backtest_result.get('final_capital', 0.0)
                 
-                # Store the full backtest result in the trial's user attributes
-                trial.set_user_attr("backtest_result", backtest_result)
+                # The persistent study only gets the scalar statistics; checkpoints, walk-forward
+                # windows and metrics would grow the scheduler DB with every trial of every run
+                trial.set_user_attr("backtest_summary", {key: value for key, value in backtest_result.items()
+                                                         if value is None or isinstance(value, (bool, int, float, str))})
+                if trial_results is not None:
+                    trial_results[trial.number] = backtest_result
+
+                # Earlier checkpoints were reported as the backtest ran; the last one has no verdict
+                equity_checkpoints = backtest_result.get('equity_checkpoints') or []
+                if pruning is not None and equity_checkpoints:
+                    trial.report(equity_checkpoints[-1], len(equity_checkpoints))
                 
+                walk_forward = backtest_result.get('walk_forward')
+                if walk_forward:
+                    # Penalizes parameters that only work in part of the series
+                    self.logger.info(f"Trial {trial.number} completed. Final Capital: {final_capital:.2f}, "
+                                     f"walk-forward score: {walk_forward['robust_score']:.2f} over {len(walk_forward['windows'])} windows")
+                    return walk_forward['robust_score']
                 self.logger.info(f"Trial {trial.number} completed. Final Capital: {final_capital:.2f}")
                 return final_capital
             else:
                 error_message = backtest_result.get('error', 'Unknown error') if backtest_result else 'No result'
                 self.logger.warning(f"Backtest failed for trial {trial.number}: {error_message}")
+                metrics.inc('optimizer.trials_failed')
                 if "CoinGecko API rate limit exceeded" in error_message:
                     raise CoinGeckoRateLimitError(f"CoinGecko API rate limit exceeded. Optimization stopped.")
                 return -100.0 # Penalty for failed runs
                 
+        except optuna.TrialPruned:
+            raise
         except CoinGeckoRateLimitError as e:
             self.logger.error(f"CoinGecko API rate limit exceeded during trial {trial.number}: {e}")
             trial.set_user_attr("rate_limit_hit", True)
             raise # Re-raise to be caught by the RateLimitStopper callback
         except Exception as e:
             self.logger.error(f"An unexpected error occurred during backtester execution for trial {trial.number}: {e}", exc_info=True)
+            metrics.inc('optimizer.trials_failed')
             return -100.0
     
+    def _get_study_storage(self) -> Optional[optuna.storages.RDBStorage]:
+        """Shared RDB storage of persistent studies, or None when OPTIMIZER_STUDY_STORAGE is 'memory'."""
+        url = self.config.OPTIMIZER_STUDY_STORAGE or self.config.get_db_uri()
+        if url == 'memory':
+            return None
+        with self._study_storage_lock:
+            if self._study_storage is None:
+                engine_kwargs = {}
+                if url.startswith('sqlite'):
+                    # Studies of concurrent cryptos write to one file; wait for its lock rather than fail
+                    engine_kwargs = {'connect_args': {'timeout': 30}}
+                self._study_storage = optuna.storages.RDBStorage(url=url, engine_kwargs=engine_kwargs)
+            return self._study_storage
+
+    def _archive_study_name(self, crypto: str, strategy: str) -> str:
+        """
+        Persistent study of one objective: trials scored with other walk-forward settings or
+        another timeframe are not comparable, so each fingerprint gets its own archive.
+        """
+        return (f"{crypto}_{strategy}_{DEFAULT_INTERVAL}_{DEFAULT_TIMEFRAME}"
+                f"_wf{self.config.OPTIMIZER_WALK_FORWARD_WINDOWS}_p{self.config.OPTIMIZER_WALK_FORWARD_STD_PENALTY:g}")
+
+    def _warm_start(self, study: optuna.study.Study, archive: optuna.study.Study, crypto: str, strategy: str) -> None:
+        """
+        Enqueues the saved best parameters and the top archived trials in this run's study,
+        so they are re-evaluated on the current data before the sampler explores further.
+        Their archived values only rank them; the sampler never sees them.
+        """
+        limit = self.config.OPTIMIZER_WARM_START_TRIALS
+        if limit <= 0:
+            return
+        candidates = []
+        saved = self.load_optimization_results(crypto, strategy)
+        if saved and saved.get('best_params'):
+            candidates.append(saved['best_params'])
+        previous = archive.get_trials(deepcopy=False, states=(optuna.trial.TrialState.COMPLETE,))
+        candidates.extend(t.params for t in sorted(previous, key=lambda t: t.value, reverse=True))
+
+        enqueued = []
+        for params in candidates:
+            if len(enqueued) >= limit:
+                break
+            if params and params not in enqueued:
+                study.enqueue_trial(params)
+                enqueued.append(params)
+        if enqueued:
+            self.logger.info(f"Warm-starting {archive.study_name} with {len(enqueued)} earlier parameter sets "
+                             f"({len(previous)} trials on record)")
+
+    def _pruning_checkpoints(self) -> int:
+        """Equity checkpoints each trial reports (0 when pruning is disabled)."""
+        if self.config.OPTIMIZER_PRUNER == 'none':
+            return 0
+        return max(1, self.config.OPTIMIZER_PRUNING_CHECKPOINTS)
+
+    def _create_pruner(self) -> optuna.pruners.BasePruner:
+        """Pruner selected by OPTIMIZER_PRUNER; steps are equity checkpoints, not bars."""
+        checkpoints = self._pruning_checkpoints()
+        if self.config.OPTIMIZER_PRUNER == 'hyperband':
+            return optuna.pruners.HyperbandPruner(min_resource=1, max_resource=checkpoints, reduction_factor=3)
+        if self.config.OPTIMIZER_PRUNER == 'median':
+            # Judge trials only after the first fifth of the bars
+            return optuna.pruners.MedianPruner(n_startup_trials=self.config.OPTIMIZER_PRUNING_STARTUP_TRIALS,
+                                               n_warmup_steps=max(1, checkpoints // 5))
+        if self.config.OPTIMIZER_PRUNER != 'none':
+            self.logger.warning(f"Unknown OPTIMIZER_PRUNER '{self.config.OPTIMIZER_PRUNER}'; pruning disabled.")
+        return optuna.pruners.NopPruner()
+
     def _find_best_result(self, results: List[Dict]) -> Optional[Dict]:
         """Find the best result from a list of optimization results."""
         valid_results = [r for r in results if 'best_value' in r and r['best_value'] is not None]
@@ -463,22 +675,15 @@ class BayesianOptimizer:
         """Save single optimization results to file using a temporary file for atomic write."""
         filename = f"best_params_{results['crypto']}_{results['strategy']}.json"
         filepath = os.path.join(self.results_dir, filename)
-        temp_filepath = filepath + ".tmp"
         
         try:
-            with open(temp_filepath, 'w') as f:
-                json.dump(results, f, indent=2)
-            os.replace(temp_filepath, filepath) # Atomic rename
+            # Atomic write (.tmp + rename); the temp file is cleaned up on failure
+            self.result_index.write(filepath, 'optimization', results, crypto_id=results['crypto'], strategy=results['strategy'])
             self.logger.info(f"Results saved to {filepath}")
         except OSError as e:
             self.logger.error(f"Error saving results to {filepath}: {e}")
-            # Clean up temp file if rename failed
-            if os.path.exists(temp_filepath):
-                os.remove(temp_filepath)
         except Exception as e:
             self.logger.error(f"Unexpected error saving results to {filepath}: {e}")
-            if os.path.exists(temp_filepath):
-                os.remove(temp_filepath)
     
     def _save_batch_results(self, results: Dict[str, Any]) -> None:
         """Save batch optimization results to file using a temporary file for atomic write."""
@@ -524,60 +729,64 @@ class BayesianOptimizer:
             self.logger.error(f"Error reading file {filepath}: {e}")
             return None
     
+    def _validated_result(self, filename: str, result: Dict, available_strategies) -> Optional[Dict]:
+        """Corrects the strategy of a stored optimization result, or returns None if it stays invalid."""
+        strategy = result.get('strategy')
+        
+        # 1. Try to correct known typos
+        if isinstance(strategy, str):
+            if strategy.lower() == 'emea':
+                strategy = 'EMA_Only'
+                result['strategy'] = strategy # Correct in memory
+        
+        # 2. If strategy is invalid or blank, try to infer from filename
+        if not strategy or strategy not in available_strategies:
+            try:
+                # Filename format: best_params_{crypto}_{strategy}.json
+                parts = filename.replace('best_params_', '').replace('.json', '').split('_')
+                if len(parts) > 1:
+                    strategy_from_filename = parts[1]
+                    if strategy_from_filename in available_strategies:
+                        self.logger.warning(f"Correcting strategy for {filename}. Was '{strategy}', now '{strategy_from_filename}'.")
+                        result['strategy'] = strategy_from_filename
+            except Exception as e:
+                self.logger.error(f"Could not infer strategy from filename {filename}: {e}")
+
+        # 3. Only keep it if the strategy is now valid
+        if result.get('strategy') in available_strategies:
+            return result
+        self.logger.warning(f"Skipping {filename} due to invalid or missing strategy: '{result.get('strategy')}'")
+        return None
+
     def get_all_results(self) -> List[Dict]:
-        """Get all optimization results from the results directory."""
+        """Get all optimization results from the result index."""
         results = []
         available_strategies = self.param_manager.get_available_strategies()
         
         try:
-            for filename in os.listdir(self.results_dir):
-                if filename.startswith('best_params_') and filename.endswith('.json'):
-                    filepath = os.path.join(self.results_dir, filename)
-                    try:
-                        with open(filepath, 'r') as f:
-                            result = json.load(f)
-                            
-                            # --- Data Validation and Correction ---
-                            strategy = result.get('strategy')
-                            
-                            # 1. Try to correct known typos
-                            if isinstance(strategy, str):
-                                if strategy.lower() == 'emea':
-                                    strategy = 'EMA_Only'
-                                    result['strategy'] = strategy # Correct in memory
-                            
-                            # 2. If strategy is invalid or blank, try to infer from filename
-                            if not strategy or strategy not in available_strategies:
-                                try:
-                                    # Filename format: best_params_{crypto}_{strategy}.json
-                                    parts = filename.replace('best_params_', '').replace('.json', '').split('_')
-                                    if len(parts) > 1:
-                                        strategy_from_filename = parts[1]
-                                        if strategy_from_filename in available_strategies:
-                                            self.logger.warning(f"Correcting strategy for {filename}. Was '{strategy}', now '{strategy_from_filename}'.")
-                                            result['strategy'] = strategy_from_filename
-                                except Exception as e:
-                                    self.logger.error(f"Could not infer strategy from filename {filename}: {e}")
-
-                            # 3. Only append if the strategy is now valid
-                            if result.get('strategy') in available_strategies:
-                                results.append(result)
-                            else:
-                                self.logger.warning(f"Skipping {filename} due to invalid or missing strategy: '{result.get('strategy')}'")
-
-                    except (OSError, json.JSONDecodeError) as e:
-                        self.logger.warning(f"Could not load or parse {filename}: {e}")
-        except OSError as e:
-            self.logger.error(f"Error reading results directory: {e}")
+            for entry in self.result_index.query('optimization'):
+                result = self._validated_result(os.path.basename(entry.path), entry.document, available_strategies)
+                if result is not None:
+                    results.append(result)
+        except (OSError, sqlite3.Error) as e:
+            self.logger.error(f"Error reading result index: {e}")
         
         return results
     
     def get_top_results(self, limit: int = 10) -> List[Dict]:
         """Get top optimization results by performance."""
-        all_results = self.get_all_results()
+        available_strategies = self.param_manager.get_available_strategies()
+        results = []
         
-        # Filter valid results and sort by best value
-        valid_results = [r for r in all_results if r.get('best_value') is not None]
-        valid_results.sort(key=lambda x: x['best_value'], reverse=True)
+        # The index yields results with a best value, best first; stop at the first `limit` valid ones
+        try:
+            for entry in self.result_index.query('optimization', order_by='profit'):
+                result = self._validated_result(os.path.basename(entry.path), entry.document, available_strategies)
+                if result is not None:
+                    results.append(result)
+                    if len(results) >= limit:
+                        break
+        except (OSError, sqlite3.Error) as e:
+            self.logger.error(f"Error reading result index: {e}")
         
-        return valid_results[:limit]
\ No newline at end of file
+        return results
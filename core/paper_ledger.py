@@ -0,0 +1,67 @@
+"""
+Event types of the paper trader's ledgers (see core/event_ledger.py).
+
+Trades ledger (`paper_trades`), state {'open_positions', 'trade_history', 'available_capital'}:
+    open    {'position', 'available_capital'}
+    close   {'position_id', 'trade', 'available_capital'}
+    update  {'position_id', 'fields'}  changed fields of an open position (stops, freeze flag)
+
+Analysis ledger (`paper_analysis_history`), state {'entries'}:
+    analysis  one analysis entry; only the last ANALYSIS_HISTORY_LIMIT are kept
+"""
+
+import os
+import uuid
+from typing import Any, Dict, List
+
+from .event_ledger import load_ledger_state
+
+ANALYSIS_HISTORY_LIMIT = 100
+
+TRADES_LEDGER = 'paper_trades'
+ANALYSIS_LEDGER = 'paper_analysis_history'
+
+def initial_trades_state(total_capital: float) -> Dict[str, Any]:
+    return {'open_positions': [], 'trade_history': [], 'available_capital': total_capital}
+
+def apply_trade_event(state: Dict[str, Any], event_type: str, data: Dict[str, Any]) -> None:
+    if event_type == 'open':
+        state['open_positions'].append(data['position'])
+    elif event_type == 'close':
+        state['open_positions'] = [p for p in state['open_positions'] if p.get('position_id') != data['position_id']]
+        state['trade_history'].append(data['trade'])
+    elif event_type == 'update':
+        for position in state['open_positions']:
+            if position.get('position_id') == data['position_id']:
+                position.update(data['fields'])
+    if 'available_capital' in data:
+        state['available_capital'] = data['available_capital']
+
+def trades_from_legacy(legacy: Dict[str, Any]) -> Dict[str, Any]:
+    """State from the former paper_trades.json; positions get the ids events refer to."""
+    open_positions = legacy.get('open_positions', [])
+    for position in open_positions:
+        position.setdefault('position_id', str(uuid.uuid4()))
+    return {
+        'open_positions': open_positions,
+        'trade_history': legacy.get('trade_history', []),
+        'available_capital': legacy.get('available_capital', legacy.get('portfolio_value')),
+    }
+
+def initial_analysis_state() -> Dict[str, Any]:
+    return {'entries': []}
+
+def apply_analysis_event(state: Dict[str, Any], event_type: str, data: Dict[str, Any]) -> None:
+    if event_type == 'analysis':
+        state['entries'].append(data)
+        del state['entries'][:-ANALYSIS_HISTORY_LIMIT]
+
+def analysis_from_legacy(legacy: List[Dict[str, Any]]) -> Dict[str, Any]:
+    return {'entries': legacy[-ANALYSIS_HISTORY_LIMIT:]}
+
+def load_analysis_history(results_dir: str) -> List[Dict[str, Any]]:
+    """Analysis history as last written by the paper trader, without taking over its ledger."""
+    base_path = os.path.join(results_dir, ANALYSIS_LEDGER)
+    if not os.path.exists(base_path + '.snapshot.json') and not os.path.exists(base_path + '.events.jsonl'):
+        return []
+    return load_ledger_state(base_path, initial_analysis_state(), apply_analysis_event)['entries']
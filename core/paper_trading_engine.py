@@ -13,6 +13,7 @@ from core.rate_limiter import RateLimiter, get_shared_rate_limiter
 
 from pricer_compatibility_fix import find_best_result_file
 from strategy import Strategy
+from streaming_signals import get_signal_stream, prune_signal_streams
 from indicators import Indicators, calculate_adx
 from config import strategy_configs, DEFAULT_INTERVAL
 import json
@@ -21,6 +22,10 @@ from core.crypto_discovery import CryptoDiscovery
 from core.trading_engine import TradingEngine
 from core.optimizer import CoinGeckoRateLimitError
 from core.result_manager import ResultManager # Import ResultManager
+from core.event_ledger import open_ledger
+from core.activity_stream import ActivityStream
+from core import paper_ledger
+from core import metrics
 
 from core.scheduler import get_scheduler
 
@@ -43,6 +48,11 @@ class PaperTradingEngine:
         self.logger.debug(f"PaperTradingEngine init: received data_fetcher is {type(data_fetcher)}") # Add this line
         self.data_fetcher = data_fetcher # Store data_fetcher
         self.socketio = socketio # Store socketio
+        # Activity messages are sent in batches by a background emitter, never from the trading loops
+        self.activity_stream = ActivityStream(
+            socketio, capacity=config.ACTIVITY_STREAM_CAPACITY,
+            flush_seconds=config.ACTIVITY_STREAM_FLUSH_SECONDS, max_batch=config.ACTIVITY_STREAM_MAX_BATCH
+        ) if socketio else None
         
         # If data_fetcher is not provided, create a default one using the global coingecko_rate_limiter
         if self.data_fetcher is None:
@@ -75,26 +85,30 @@ class PaperTradingEngine:
         self.trades_log_path = os.path.join(self.config.RESULTS_DIR, 'paper_trades.json')
         self.analysis_history_path = os.path.join(self.config.RESULTS_DIR, 'paper_analysis_history.json')
 
-        # Load existing analysis history if available
-        if os.path.exists(self.analysis_history_path):
-            try:
-                with open(self.analysis_history_path, 'r') as f:
-                    self.analysis_history = json.load(f)
-                logging.info(f"Loaded {len(self.analysis_history)} entries into analysis history from {self.analysis_history_path}")
-            except Exception as e:
-                logging.error(f"Failed to load analysis history from {self.analysis_history_path}: {e}")
-
-        # Load existing trades if available
-        if os.path.exists(self.trades_log_path):
-            try:
-                with open(self.trades_log_path, 'r') as f:
-                    trades_data = json.load(f)
-                    self.open_positions = trades_data.get('open_positions', [])
-                    self.trade_history = trades_data.get('trade_history', [])
-                    self.available_capital = trades_data.get('available_capital', trades_data.get('portfolio_value', self.total_capital))
-                logging.info(f"Loaded {len(self.open_positions)} open positions and {len(self.trade_history)} trade history entries from {self.trades_log_path}")
-            except Exception as e:
-                logging.error(f"Failed to load trades from {self.trades_log_path}: {e}")
+        # Append-only ledgers (snapshot + event tail), shared by the engines of the process;
+        # the former JSON files are imported once
+        snapshot_every = self.config.PAPER_TRADING_LEDGER_SNAPSHOT_EVENTS
+        self.analysis_ledger = open_ledger(
+            os.path.join(self.config.RESULTS_DIR, paper_ledger.ANALYSIS_LEDGER),
+            paper_ledger.initial_analysis_state(), paper_ledger.apply_analysis_event,
+            snapshot_every=snapshot_every, legacy_path=self.analysis_history_path,
+            from_legacy=paper_ledger.analysis_from_legacy
+        )
+        self.analysis_history = self.analysis_ledger.snapshot()['entries']
+        logging.info(f"Loaded {len(self.analysis_history)} entries into analysis history")
+
+        self.trade_ledger = open_ledger(
+            os.path.join(self.config.RESULTS_DIR, paper_ledger.TRADES_LEDGER),
+            paper_ledger.initial_trades_state(self.total_capital), paper_ledger.apply_trade_event,
+            snapshot_every=snapshot_every, legacy_path=self.trades_log_path,
+            from_legacy=paper_ledger.trades_from_legacy
+        )
+        trades_data = self.trade_ledger.snapshot()
+        self.open_positions = trades_data['open_positions']
+        self.trade_history = trades_data['trade_history']
+        if trades_data['available_capital'] is not None:
+            self.available_capital = trades_data['available_capital']
+        logging.info(f"Loaded {len(self.open_positions)} open positions and {len(self.trade_history)} trade history entries")
 
         self.crypto_discovery = CryptoDiscovery(cache_dir=self.config.CACHE_DIR, data_fetcher=self.data_fetcher) # Pass data_fetcher
         self.trading_engine = trading_engine # Use the passed trading_engine
@@ -105,20 +119,16 @@ class PaperTradingEngine:
         logging.info(f"Max Concurrent Positions: {self.max_concurrent_positions}")
 
     def _emit_activity(self, stage: str, message: str, crypto_id: str = None, details: Dict = None):
-        """Emits a structured log message to the frontend via websocket."""
-        if not self.socketio:
+        """Queues a structured log message for the frontend; sent in the next websocket batch."""
+        if not self.activity_stream:
             return
-        try:
-            log_entry = {
-                "timestamp": datetime.now().isoformat(),
-                "stage": stage,
-                "message": message,
-                "crypto_id": crypto_id,
-                "details": details or {}
-            }
-            self.socketio.emit('trader_activity', log_entry)
-        except Exception as e:
-            self.logger.error(f"Error emitting websocket activity: {e}")
+        self.activity_stream.push({
+            "timestamp": datetime.now().isoformat(),
+            "stage": stage,
+            "message": message,
+            "crypto_id": crypto_id,
+            "details": details or {}
+        })
 
     def _log_trade(self, trade_data: Dict):
         """Logs trade data to a daily file for the specific crypto."""
@@ -404,26 +414,38 @@ class PaperTradingEngine:
         logging.info(f"Best profitable strategy for {crypto_id}: {best_strategy.config['name']} with profit {best_strategy.profit:.2f}%")
         return best_strategy
 
-    def _get_trade_signal(self, df: pd.DataFrame, strategy: Strategy, open_position_signal: str = None) -> Tuple[str, List[str]]:
-        signal = self._get_trade_signal_for_latest(df, strategy, open_position_signal)
+    def _get_trade_signal(self, df: pd.DataFrame, strategy: Strategy, open_position_signal: str = None, crypto_id: str = None) -> Tuple[str, List[str]]:
+        signal = self._get_trade_signal_for_latest(df, strategy, open_position_signal, crypto_id=crypto_id)
         return signal, [strategy.config.get('name', 'N/A')] if signal != "HOLD" else []
 
-    def _get_trade_signal_for_latest(self, df: pd.DataFrame, strategy: Strategy, open_position_signal: str = None):
+    def _get_trade_signal_for_latest(self, df: pd.DataFrame, strategy: Strategy, open_position_signal: str = None, crypto_id: str = None):
         try:
-            # Generate signals from the strategy
-            long_entry, short_entry, long_exit, short_exit = strategy.generate_signals(df, strategy.params)
+            if crypto_id and self.config.PAPER_TRADING_INCREMENTAL_SIGNALS:
+                # Only the candles added since the last cycle go through the indicators; the
+                # evaluator is process-wide, so it survives the per-job engine instances. Its
+                # indicators span every candle seen, not just this window (see streaming_signals)
+                stream = get_signal_stream(crypto_id, strategy.config, strategy.params)
+                with stream.lock:
+                    stream.update(df)
+                    long_entry, short_entry, long_exit, short_exit = stream.latest_signals()
+            else:
+                # Generate signals from the strategy
+                signals = strategy.generate_signals(df, strategy.params)
+                long_entry, short_entry, long_exit, short_exit = (
+                    bool(signal.iloc[-1]) if not signal.empty else False for signal in signals
+                )
 
             # Prioritize exit signals
-            if open_position_signal == "LONG" and not long_exit.empty and long_exit.iloc[-1]:
+            if open_position_signal == "LONG" and long_exit:
                 return "EXIT_LONG"
-            elif open_position_signal == "SHORT" and not short_exit.empty and short_exit.iloc[-1]:
+            elif open_position_signal == "SHORT" and short_exit:
                 return "EXIT_SHORT"
 
             # Then check entry signals if no position is open
             if not open_position_signal:
-                if not long_entry.empty and long_entry.iloc[-1]:
+                if long_entry:
                     return "LONG"
-                elif not short_entry.empty and short_entry.iloc[-1]:
+                elif short_entry:
                     return "SHORT"
             
             return "HOLD"
@@ -446,6 +468,7 @@ class PaperTradingEngine:
         open_position_cryptos = {p['crypto_id'] for p in self.open_positions}
         
         cryptos_to_analyze = volatile_crypto_ids | open_position_cryptos
+        prune_signal_streams(cryptos_to_analyze)
         
         self._emit_activity(stage="Discovery", message=f"Found {len(volatile_cryptos)} volatile cryptos and {len(open_position_cryptos)} with open positions.", details={'volatile': volatile_cryptos, 'open': list(open_position_cryptos)})
         logging.info(f"Found {len(volatile_cryptos)} volatile cryptos: {volatile_cryptos}")
@@ -519,7 +542,7 @@ class PaperTradingEngine:
             time.sleep(self.config.DATA_FETCH_DELAY_SECONDS)
 
             open_position_signal_type = open_position['signal'] if open_position else None
-            signal, contributing_strategies = self._get_trade_signal(df, best_strategy, open_position_signal=open_position_signal_type)
+            signal, contributing_strategies = self._get_trade_signal(df, best_strategy, open_position_signal=open_position_signal_type, crypto_id=crypto_id)
 
             self._emit_activity(stage="Signal", message=f"Generated signal: {signal}", crypto_id=crypto_id, details={'strategy': best_strategy.config['name']})
             logging.info(f"Signal for {crypto_id} using {best_strategy.config['name']}: {signal}")
@@ -560,8 +583,8 @@ class PaperTradingEngine:
             updated_analysis_state[crypto_id] = analysis_entry # Add to the new state
 
             self.analysis_history.append(analysis_entry)
-            self.analysis_history = self.analysis_history[-100:]
-            self._save_analysis_history()
+            self.analysis_history = self.analysis_history[-paper_ledger.ANALYSIS_HISTORY_LIMIT:]
+            self._save_analysis_entry(analysis_entry)
 
             if signal != "HOLD" and not is_stale: # Only execute trade if not stale
                 reason = f"{signal} triggered by {', '.join(contributing_strategies)}"
@@ -600,7 +623,7 @@ class PaperTradingEngine:
                 "position_id": position.get('position_id') # Assuming position_id might be added later
             }
             self._log_trade(trade_data)
-            self._save_trades()
+            self._record_trade_event('open', {'position': position, 'available_capital': self.available_capital})
 
 
     def price_monitoring_task(self):
@@ -619,7 +642,10 @@ class PaperTradingEngine:
             return
 
         crypto_ids_to_monitor = [p['crypto_id'] for p in self.open_positions]
-        prices = self.data_fetcher.get_current_prices(crypto_ids_to_monitor) # Use data_fetcher
+        # Prices and the OHLC windows of the stale checks, batched into the fewest requests
+        cycle_data = self.data_fetcher.fetch_planned(prices=crypto_ids_to_monitor,
+                                                     ohlc=[(crypto_id, 1) for crypto_id in crypto_ids_to_monitor])
+        prices = cycle_data.prices
 
         for position in self.open_positions[:]: # Iterate over a copy
             current_price = prices.get(position['crypto_id'])
@@ -627,12 +653,12 @@ class PaperTradingEngine:
                 logging.warning(f"Could not fetch price for {position['crypto_id']} during monitoring.")
                 continue
 
-            # Fetch OHLC data for stale check
-            try:
-                df_for_stale_check = self.data_fetcher.get_crypto_data_merged(position['crypto_id'], days=1)
-            except CoinGeckoRateLimitError as e:
-                self._emit_activity(stage="Data", message="Rate limit hit during stale check, skipping.", crypto_id=position['crypto_id'], details={"error": str(e)})
-                logging.warning(f"Rate limit hit for {position['crypto_id']} during stale check: {e}. Skipping this crypto for now.")
+            # OHLC data for stale check
+            df_for_stale_check = cycle_data.ohlc.get((position['crypto_id'], 1))
+            fetch_error = cycle_data.errors.get(('ohlc', position['crypto_id'], 1))
+            if isinstance(fetch_error, CoinGeckoRateLimitError):
+                self._emit_activity(stage="Data", message="Rate limit hit during stale check, skipping.", crypto_id=position['crypto_id'], details={"error": str(fetch_error)})
+                logging.warning(f"Rate limit hit for {position['crypto_id']} during stale check: {fetch_error}. Skipping this crypto for now.")
                 continue
             if df_for_stale_check is None or df_for_stale_check.empty:
                 self._emit_activity(stage="Data", message="No data found for stale check, skipping.", crypto_id=position['crypto_id'])
@@ -723,6 +749,8 @@ class PaperTradingEngine:
                 self._close_position(position, current_price, "stop-loss")
                 continue # Move to the next position
 
+        self._save_position_updates()
+
     def _close_position(self, position, exit_price, reason):
         # Use _place_order to simulate the close
         closed_trade = self._place_order(position['crypto_id'], "CLOSE", reason, exit_price, position_to_close=position)
@@ -748,7 +776,8 @@ class PaperTradingEngine:
                 "position_id": position.get('position_id')
             }
             self._log_trade(trade_data)
-            self._save_trades()
+            self._record_trade_event('close', {'position_id': position.get('position_id'), 'trade': closed_trade,
+                                               'available_capital': self.available_capital})
 
     def _place_order(self, crypto_id, order_type, signal, current_price, params=None, position_to_close=None, backtest_result=None, entry_reason=None, atr_value=None):
         if order_type == "BUY": # Opening a LONG position
@@ -766,6 +795,7 @@ class PaperTradingEngine:
             take_profit_price = current_price + (risk_amount * take_profit_multiple) # Calculate take_profit_price
 
             position = {
+                "position_id": str(uuid.uuid4()), # Referenced by the ledger's close and update events
                 "crypto_id": crypto_id,
                 "signal": signal,
                 "entry_price": current_price,
@@ -802,6 +832,7 @@ class PaperTradingEngine:
             take_profit_price = current_price - (risk_amount * take_profit_multiple) # Calculate take_profit_price for SHORT
 
             position = {
+                "position_id": str(uuid.uuid4()), # Referenced by the ledger's close and update events
                 "crypto_id": crypto_id,
                 "signal": signal,
                 "entry_price": current_price,
@@ -859,23 +890,27 @@ class PaperTradingEngine:
         
         return None
 
-    def _save_trades(self):
+    def _record_trade_event(self, event_type: str, data: Dict):
+        """Appends one event to the trades ledger (O(1), however long the history is)."""
         try:
-            all_trades = {
-                "open_positions": self.open_positions,
-                "trade_history": self.trade_history,
-                "available_capital": self.available_capital
-            }
-            with open(self.trades_log_path, 'w') as f:
-                json.dump(all_trades, f, indent=4)
+            self.trade_ledger.append(event_type, data)
         except Exception as e:
-            logging.error(f"Failed to save trades log: {e}")
+            logging.error(f"Failed to record {event_type} event in trades ledger: {e}")
+
+    def _save_position_updates(self):
+        """Records the fields of open positions changed in place since they were last recorded (stops, freeze flag)."""
+        recorded = {p.get('position_id'): p for p in self.trade_ledger.snapshot('open_positions')}
+        for position in self.open_positions:
+            stored = recorded.get(position.get('position_id'))
+            if stored is None:
+                continue
+            fields = {key: value for key, value in position.items() if stored.get(key) != value}
+            if fields:
+                self._record_trade_event('update', {'position_id': position['position_id'], 'fields': fields})
 
-    def _save_analysis_history(self):
+    def _save_analysis_entry(self, analysis_entry: Dict):
         try:
-            analysis_history_path = os.path.join(self.config.RESULTS_DIR, 'paper_analysis_history.json')
-            with open(analysis_history_path, 'w') as f:
-                json.dump(self.analysis_history, f, indent=4)
+            self.analysis_ledger.append('analysis', analysis_entry)
         except Exception as e:
             logging.error(f"Failed to save analysis history: {e}")
 
@@ -889,10 +924,12 @@ def run_analysis_task(job_id, config: Config):
 
     try:
         engine = PaperTradingEngine(config=config)
-        engine.analysis_task()
+        with metrics.timer('paper_trading.analysis_cycle'):
+            engine.analysis_task()
         logger.info("Analysis task job finished.")
     except Exception as e:
         logger.error(f"An error occurred during the analysis task job: {e}", exc_info=True)
+    metrics.publish_process('paper_trader')
 
 
 def run_price_monitoring_task(job_id, config: Config):
@@ -904,7 +941,9 @@ def run_price_monitoring_task(job_id, config: Config):
 
     try:
         engine = PaperTradingEngine(config=config)
-        engine.price_monitoring_task()
+        with metrics.timer('paper_trading.monitoring_cycle'):
+            engine.price_monitoring_task()
         logger.info("Price monitoring task job finished.")
     except Exception as e:
-        logger.error(f"An error occurred during the price monitoring task job: {e}", exc_info=True)
\ No newline at end of file
+        logger.error(f"An error occurred during the price monitoring task job: {e}", exc_info=True)
+    metrics.publish_process('paper_trader')
\ No newline at end of file
@@ -0,0 +1,200 @@
+"""
+Parallel parameter sweep over one dataset (the search mode of backtester.py).
+
+The caller fetches the dataset once. Its OHLC columns and every indicator the
+grid's parameter sets will look up are computed once and published into shared
+memory; worker processes attach at start-up and read the indicators through
+read-only views instead of recomputing them. The grid is handed out in chunks,
+each worker returns only the best results of its chunk, and the parent folds
+them into a heap of the best top_n as chunks complete.
+"""
+
+import heapq
+import logging
+import math
+import multiprocessing
+from concurrent.futures import ProcessPoolExecutor, as_completed
+from multiprocessing import shared_memory
+from typing import Any, Callable, Dict, Hashable, List, Optional, Tuple
+
+import numpy as np
+import pandas as pd
+
+from config import strategy_configs, indicator_defaults
+from indicators import calculate_atr, calculate_adx_values
+from strategy import indicator_requests
+from .parallel_trials import SharedOHLC, attach_shared_ohlc
+from . import metrics
+
+logger = logging.getLogger(__name__)
+
+CHUNKS_PER_WORKER = 8 # Enough chunks for load balancing, few enough to keep dispatch overhead low
+
+# Per-process state populated by _init_worker
+_worker_state: Dict[str, Any] = {}
+
+def sweep_indicator_requests(strategy_config: dict, params: dict) -> List[Tuple[str, Tuple, Callable]]:
+    """(indicator, params tuple, compute(df)) of everything Backtester.run_backtest looks up for params."""
+    requests = list(indicator_requests(strategy_config, params).values())
+    # Stop and sizing indicators, keyed as in Backtester.run_backtest
+    atr_period = params.get('atr_period', indicator_defaults['atr_period'])
+    adx_period = params.get('adx_period', 14)
+    requests.append(('atr', (atr_period,), lambda df: calculate_atr(df, atr_period)))
+    requests.append(('adx', (adx_period,), lambda df: calculate_adx_values(df, window=adx_period)))
+    return requests
+
+class SharedIndicators:
+    """Indicator Series/DataFrames of one dataset copied into a single shared memory block."""
+
+    def __init__(self, values: Dict[Tuple[str, Tuple], Any], length: int):
+        self.length = length
+        self.layout = [] # (indicator, params, column names or None for a Series, first row)
+        rows = []
+        for (indicator, params), value in values.items():
+            if isinstance(value, pd.DataFrame):
+                self.layout.append((indicator, params, list(value.columns), len(rows)))
+                rows.extend(value[column].to_numpy(dtype=np.float64) for column in value.columns)
+            else:
+                self.layout.append((indicator, params, None, len(rows)))
+                rows.append(np.asarray(value, dtype=np.float64))
+        self.n_rows = len(rows)
+        self._shm = shared_memory.SharedMemory(create=True, size=max(8, self.n_rows * length * 8))
+        block = np.ndarray((self.n_rows, length), dtype=np.float64, buffer=self._shm.buf)
+        for row, values_row in enumerate(rows):
+            block[row] = values_row
+        del block
+
+    def descriptor(self) -> Dict[str, Any]:
+        """Picklable handle passed to worker initializers."""
+        return {'name': self._shm.name, 'length': self.length, 'n_rows': self.n_rows, 'layout': self.layout}
+
+    def close(self) -> None:
+        self._shm.close()
+        try:
+            self._shm.unlink()
+        except FileNotFoundError:
+            pass
+
+class SharedIndicatorView:
+    """
+    Worker-side indicator cache over a SharedIndicators block, with the interface of
+    DatasetIndicatorCache. Published indicators are zero-copy read-only views; anything
+    else is computed on first use and kept for the worker's lifetime.
+    """
+
+    def __init__(self, descriptor: Dict[str, Any], index: pd.Index):
+        self._shm = shared_memory.SharedMemory(name=descriptor['name']) # Open while the worker lives
+        block = np.ndarray((descriptor['n_rows'], descriptor['length']), dtype=np.float64, buffer=self._shm.buf)
+        block.flags.writeable = False
+        self._values: Dict[Hashable, Any] = {}
+        for indicator, params, columns, first_row in descriptor['layout']:
+            if columns is None:
+                value = pd.Series(block[first_row], index=index, copy=False)
+            else:
+                value = pd.DataFrame({column: block[first_row + k] for k, column in enumerate(columns)}, index=index, copy=False)
+            self._values[(indicator, params)] = value
+        self.hits = 0
+        self.misses = 0
+
+    def get_or_compute(self, indicator: str, params: Tuple, compute: Callable[[], Any]) -> Any:
+        value = self._values.get((indicator, params))
+        if value is not None:
+            self.hits += 1
+            return value
+        self.misses += 1
+        value = self._values[(indicator, params)] = compute()
+        return value
+
+def _init_worker(ohlc_descriptor: Dict[str, Any], indicators_descriptor: Dict[str, Any],
+                 strategy_name: str, initial_capital: float) -> None:
+    """Worker initializer: attach to the shared dataset and indicators and build one Backtester."""
+    from backtester import Backtester
+    from indicators import Indicators
+    from strategy import Strategy
+    from .app_config import Config
+    from .data_fetcher import DataFetcher
+
+    config = Config()
+    data = attach_shared_ohlc(ohlc_descriptor)
+    # The dataset is set up front, so the fetcher is never asked to hit the network
+    backtester = Backtester(Strategy(Indicators(), strategy_configs[strategy_name]), config,
+                            data_fetcher=DataFetcher(None, None, config))
+    backtester.initial_capital = initial_capital
+    backtester.set_data(data, indicator_cache=SharedIndicatorView(indicators_descriptor, data.index))
+    _worker_state['backtester'] = backtester
+
+def _keep_best(heap: list, item: Tuple, top_n: int) -> None:
+    """Keeps the top_n largest (final_capital, -grid index, result) items in a min-heap."""
+    if len(heap) < top_n:
+        heapq.heappush(heap, item)
+    elif item[:2] > heap[0][:2]:
+        heapq.heapreplace(heap, item)
+
+def _run_chunk(start: int, params_chunk: List[Dict[str, Any]], top_n: int):
+    """Backtests grid[start:start + len(params_chunk)]; returns (count, failures, best items of the chunk)."""
+    backtester = _worker_state['backtester']
+    best, failed = [], 0
+    for offset, params in enumerate(params_chunk):
+        try:
+            result = backtester.run_backtest(params)
+        except Exception as e:
+            logger.error(f"Sweep backtest failed with params {params}: {e}")
+            result = None
+        if not result or not math.isfinite(result['final_capital']):
+            failed += 1
+            continue
+        # The grid index breaks ties (earlier wins), so result dicts are never compared
+        _keep_best(best, (result['final_capital'], -(start + offset), result), top_n)
+    return len(params_chunk), failed, best
+
+def run_parameter_sweep(data: pd.DataFrame, strategy_name: str, param_grid: List[Dict[str, Any]], workers: int,
+                        top_n: int = 5, chunk_size: int = 0, initial_capital: float = 100.0,
+                        progress: Optional[Callable[[int], None]] = None) -> List[Tuple[Dict[str, Any], Dict[str, Any]]]:
+    """
+    Backtests every parameter set of param_grid over data on `workers` processes.
+    Returns the top_n (params, result) pairs by final capital, best first; progress
+    (if given) is called with the number of backtests of each completed chunk.
+    """
+    if not param_grid:
+        return []
+    strategy_config = strategy_configs[strategy_name]
+
+    with metrics.timer('sweep.precompute'):
+        computes = {}
+        for params in param_grid:
+            for indicator, key, compute in sweep_indicator_requests(strategy_config, params):
+                computes.setdefault((indicator, key), compute)
+        values = {key: compute(data) for key, compute in computes.items()}
+    logger.info(f"Precomputed {len(values)} indicators for {len(param_grid)} parameter sets")
+
+    chunk_size = chunk_size or max(1, math.ceil(len(param_grid) / (workers * CHUNKS_PER_WORKER)))
+    shared_data = SharedOHLC(data)
+    shared_indicators = SharedIndicators(values, len(data))
+    del values
+    best, evaluated, failed = [], 0, 0
+    try:
+        with ProcessPoolExecutor(
+            max_workers=workers,
+            mp_context=multiprocessing.get_context(),
+            initializer=_init_worker,
+            initargs=(shared_data.descriptor(), shared_indicators.descriptor(), strategy_name, initial_capital)
+        ) as executor:
+            futures = [executor.submit(_run_chunk, start, param_grid[start:start + chunk_size], top_n)
+                       for start in range(0, len(param_grid), chunk_size)]
+            for future in as_completed(futures):
+                count, chunk_failed, chunk_best = future.result()
+                for item in chunk_best:
+                    _keep_best(best, item, top_n)
+                evaluated += count
+                failed += chunk_failed
+                if progress:
+                    progress(count)
+    finally:
+        shared_indicators.close()
+        shared_data.close()
+
+    metrics.inc('sweep.backtests', evaluated)
+    if failed:
+        logger.warning(f"{failed} of {evaluated} sweep backtests failed or returned no result")
+    ranked = sorted(best, key=lambda item: item[:2], reverse=True)
+    return [(param_grid[-neg_index], result) for _, neg_index, result in ranked]
@@ -0,0 +1,290 @@
+"""
+Process-pool execution of optimization trials.
+
+The OHLC dataset of a study is published once into shared memory; a worker
+process attaches to it on its first trial of the study, rebuilds the DataFrame
+and keeps it with its BacktesterWrapper and IndicatorCache. Only trial
+parameters and result dictionaries cross the process boundary afterwards.
+
+The pool is kept warm between studies (get_worker_pool): workers forked for one
+study, with pandas, optuna and the strategy tables already imported, run the
+trials of the next ones, so a study no longer pays for starting its workers.
+"""
+
+import atexit
+import logging
+import multiprocessing
+import os
+import threading
+from collections import OrderedDict
+from concurrent.futures import ProcessPoolExecutor
+from concurrent.futures.process import BrokenProcessPool
+from multiprocessing import shared_memory
+from typing import Any, Callable, Dict, Optional, Tuple
+
+import numpy as np
+import pandas as pd
+
+from .indicator_cache import IndicatorCache
+from . import metrics
+
+logger = logging.getLogger(__name__)
+
+# Per-process state populated by _init_worker
+_worker_state: Dict[str, Any] = {}
+
+class SharedOHLC:
+    """An OHLC DataFrame copied once into a shared memory block."""
+
+    def __init__(self, data: pd.DataFrame):
+        self.columns = [c for c in ('open', 'high', 'low', 'close', 'volume') if c in data.columns]
+        self.length = len(data)
+        self.index_name = data.index.name
+        self.is_datetime_index = isinstance(data.index, pd.DatetimeIndex)
+        self.tz = str(data.index.tz) if self.is_datetime_index and data.index.tz is not None else None
+        # One float64 row per column plus one int64 row for the index
+        nbytes = max(8, (len(self.columns) + 1) * self.length * 8)
+        self._shm = shared_memory.SharedMemory(create=True, size=nbytes)
+        block = np.ndarray((len(self.columns) + 1, self.length), dtype=np.float64, buffer=self._shm.buf)
+        for row, column in enumerate(self.columns):
+            block[row] = data[column].to_numpy(dtype=np.float64)
+        if self.is_datetime_index:
+            index = data.index.as_unit('ns') if hasattr(data.index, 'as_unit') else data.index
+            index_values = index.asi8
+        else:
+            index_values = np.arange(self.length, dtype=np.int64)
+        block[-1].view(np.int64)[:] = index_values
+
+    def descriptor(self) -> Dict[str, Any]:
+        """Picklable handle passed to worker initializers."""
+        return {
+            'name': self._shm.name,
+            'columns': self.columns,
+            'length': self.length,
+            'index_name': self.index_name,
+            'is_datetime_index': self.is_datetime_index,
+            'tz': self.tz,
+        }
+
+    def close(self) -> None:
+        self._shm.close()
+        try:
+            self._shm.unlink()
+        except FileNotFoundError:
+            pass
+
+def attach_shared_ohlc(descriptor: Dict[str, Any]) -> pd.DataFrame:
+    """Rebuilds the DataFrame published by SharedOHLC (one copy per worker process)."""
+    shm = shared_memory.SharedMemory(name=descriptor['name'])
+    try:
+        columns = descriptor['columns']
+        block = np.ndarray((len(columns) + 1, descriptor['length']), dtype=np.float64, buffer=shm.buf)
+        index_values = block[-1].view(np.int64).copy()
+        if descriptor['is_datetime_index']:
+            index = pd.DatetimeIndex(index_values.view('datetime64[ns]'), name=descriptor['index_name'])
+            if descriptor['tz']:
+                index = index.tz_localize('UTC').tz_convert(descriptor['tz'])
+        else:
+            index = pd.RangeIndex(descriptor['length'], name=descriptor['index_name'])
+        data = pd.DataFrame({column: block[row].copy() for row, column in enumerate(columns)}, index=index)
+        del block
+    finally:
+        shm.close()
+    return data
+
+WORKER_DATASETS = 4 # Datasets a worker keeps attached; studies of a batch may run side by side
+
+def _init_worker(cache_max_bytes: int) -> None:
+    """Worker initializer: build the backtest objects reused by every trial the worker runs."""
+    from .app_config import Config
+    from .backtester_wrapper import BacktesterWrapper
+    from .data_fetcher import DataFetcher
+
+    config = Config()
+    # Trials always receive the dataset, so the fetcher is never asked to hit the network
+    data_fetcher = DataFetcher(None, None, config)
+    _worker_state['datasets'] = OrderedDict() # shared memory name -> DataFrame, least recently used first
+    _worker_state['wrapper'] = BacktesterWrapper(config, data_fetcher=data_fetcher)
+    # Keyed by dataset fingerprint, so one LRU serves every study the worker sees
+    _worker_state['indicator_cache'] = IndicatorCache(max_bytes=cache_max_bytes)
+
+def _worker_dataset(descriptor: Dict[str, Any]) -> pd.DataFrame:
+    datasets = _worker_state['datasets']
+    data = datasets.get(descriptor['name'])
+    if data is None:
+        data = datasets[descriptor['name']] = attach_shared_ohlc(descriptor)
+        while len(datasets) > WORKER_DATASETS:
+            datasets.popitem(last=False)
+    else:
+        datasets.move_to_end(descriptor['name'])
+    return data
+
+def _run_trial(descriptor: Dict[str, Any], crypto: str, strategy: str, params: Dict[str, Any], timeframe: str, interval: str,
+               walk_forward_windows: int = 0, walk_forward_std_penalty: float = 0.0, checkpoints: int = 0,
+               verdicts=None):
+    """
+    Runs one backtest inside a worker process. Its stage metrics and the indicator cache
+    lookups it made go back with the result, with the cache's current size.
+    With `verdicts` (a Pipe end) each checkpoint's (step, equity) is sent to the parent,
+    whose reply says whether to stop the backtest there.
+    """
+    on_checkpoint = None
+    if verdicts is not None:
+        def on_checkpoint(step: int, equity: float) -> bool:
+            verdicts.send((step, equity))
+            return verdicts.recv()
+    indicator_cache = _worker_state['indicator_cache']
+    before = indicator_cache.stats()
+    trial_metrics = metrics.MetricsRegistry()
+    with metrics.bind(trial_metrics):
+        result = _worker_state['wrapper'].run_single_backtest(
+            crypto=crypto,
+            strategy=strategy,
+            parameters=params,
+            timeframe=timeframe,
+            interval=interval,
+            data=_worker_dataset(descriptor),
+            indicator_cache=indicator_cache,
+            walk_forward_windows=walk_forward_windows,
+            walk_forward_std_penalty=walk_forward_std_penalty,
+            checkpoints=checkpoints,
+            on_checkpoint=on_checkpoint
+        )
+    if verdicts is not None:
+        verdicts.close()
+    cache_stats = indicator_cache.stats()
+    for counter in ('hits', 'misses', 'evictions'):
+        cache_stats[counter] -= before[counter]
+    return result, os.getpid(), cache_stats, trial_metrics.snapshot()
+
+# The process's warm pools, by (max_workers, cache_max_bytes); in practice a single one
+_pools: Dict[Tuple[int, int], ProcessPoolExecutor] = {}
+_pools_lock = threading.Lock()
+
+def _new_pool(max_workers: int, cache_max_bytes: int) -> ProcessPoolExecutor:
+    return ProcessPoolExecutor(
+        max_workers=max_workers,
+        mp_context=multiprocessing.get_context(),
+        initializer=_init_worker,
+        initargs=(cache_max_bytes,)
+    )
+
+def get_worker_pool(max_workers: int, cache_max_bytes: int) -> ProcessPoolExecutor:
+    """The warm trial pool for these settings, started on first use and shared by later studies."""
+    with _pools_lock:
+        pool = _pools.get((max_workers, cache_max_bytes))
+        if pool is None:
+            pool = _pools[(max_workers, cache_max_bytes)] = _new_pool(max_workers, cache_max_bytes)
+            logger.info(f"Started warm pool of {max_workers} trial workers")
+        return pool
+
+def discard_worker_pool(pool: Optional[ProcessPoolExecutor] = None) -> None:
+    """Shuts down `pool` (every warm pool when None); the next study starts a new one."""
+    with _pools_lock:
+        for settings, candidate in list(_pools.items()):
+            if pool is None or candidate is pool:
+                del _pools[settings]
+                candidate.shutdown(wait=False, cancel_futures=True)
+
+atexit.register(discard_worker_pool)
+
+class ParallelTrialRunner:
+    """
+    Runs the backtests of one study's trials on a pool of worker processes.
+
+    Optuna still drives the study (study.optimize with n_jobs threads, so callbacks and
+    study.stop() behave as in the serial mode); every thread hands its backtest to the
+    pool and waits, which keeps the CPU-bound work out of the parent's GIL. With
+    keep_workers the warm pool is used and left running when the study is done.
+    """
+
+    def __init__(self, data: pd.DataFrame, crypto: str, strategy: str, timeframe: str, interval: str,
+                 max_workers: int, cache_max_bytes: int = 256 * 1024 * 1024,
+                 walk_forward_windows: int = 0, walk_forward_std_penalty: float = 0.0, checkpoints: int = 0,
+                 keep_workers: bool = True):
+        self.crypto = crypto
+        self.strategy = strategy
+        self.timeframe = timeframe
+        self.interval = interval
+        self.max_workers = max_workers
+        self.walk_forward_windows = walk_forward_windows
+        self.walk_forward_std_penalty = walk_forward_std_penalty
+        self.checkpoints = checkpoints
+        self._shared_data = SharedOHLC(data)
+        self._descriptor = self._shared_data.descriptor()
+        self._cache_counters = {'hits': 0, 'misses': 0, 'evictions': 0} # This study's lookups
+        self._worker_cache_sizes: Dict[int, Dict[str, Any]] = {} # pid -> latest entries/bytes/max_bytes
+        self._stats_lock = threading.Lock()
+        self._owns_executor = not keep_workers
+        if keep_workers:
+            self._executor = get_worker_pool(max_workers, cache_max_bytes)
+        else:
+            self._executor = _new_pool(max_workers, cache_max_bytes)
+            logger.info(f"Started {max_workers} trial workers for {crypto}/{strategy}")
+
+    def run_backtest(self, params: Dict[str, Any],
+                     on_checkpoint: Optional[Callable[[int, float], bool]] = None) -> Dict[str, Any]:
+        """
+        Submits one trial's backtest to the pool and blocks until it finishes. With on_checkpoint,
+        the calling thread answers the worker's checkpoints as the backtest runs (True stops it).
+        """
+        conn = worker_conn = None
+        if on_checkpoint is not None and self.checkpoints > 0:
+            conn, worker_conn = multiprocessing.Pipe()
+        try:
+            future = self._executor.submit(
+                _run_trial, self._descriptor, self.crypto, self.strategy, params, self.timeframe, self.interval,
+                self.walk_forward_windows, self.walk_forward_std_penalty, self.checkpoints, worker_conn
+            )
+            while conn is not None and not future.done():
+                if conn.poll(0.05):
+                    try:
+                        step, equity = conn.recv()
+                    except EOFError:
+                        break # The worker closed its end; the result follows
+                    conn.send(bool(on_checkpoint(step, equity)))
+            result, pid, cache_stats, trial_metrics = future.result()
+        except BrokenProcessPool:
+            if not self._owns_executor:
+                discard_worker_pool(self._executor) # A worker died; later studies get a fresh pool
+            raise
+        finally:
+            for end in (conn, worker_conn):
+                if end is not None:
+                    end.close()
+        with self._stats_lock:
+            for counter in self._cache_counters:
+                self._cache_counters[counter] += cache_stats[counter]
+            self._worker_cache_sizes[pid] = cache_stats
+        metrics.merge(trial_metrics) # Into the registries of the calling trial thread
+        return result
+
+    def cache_stats(self) -> Dict[str, Any]:
+        """This study's indicator cache counters, summed over all workers, and the workers' cache sizes."""
+        with self._stats_lock:
+            counters = dict(self._cache_counters)
+            per_worker = list(self._worker_cache_sizes.values())
+        hits, misses = counters['hits'], counters['misses']
+        return {
+            'hits': hits,
+            'misses': misses,
+            'hit_rate': (hits / (hits + misses)) if (hits + misses) else 0.0,
+            'evictions': counters['evictions'],
+            'entries': sum(s['entries'] for s in per_worker),
+            'bytes': sum(s['bytes'] for s in per_worker),
+            'max_bytes': sum(s['max_bytes'] for s in per_worker),
+            'workers': len(per_worker),
+        }
+
+    def close(self) -> None:
+        # Workers copied the dataset when they attached, so the block can go at once
+        if self._owns_executor:
+            self._executor.shutdown(wait=True, cancel_futures=True)
+        self._shared_data.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc, tb):
+        self.close()
+        return False
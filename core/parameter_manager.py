@@ -27,6 +27,9 @@ class ParameterRange:
     constraint_func: Optional[callable] = None
     description: str = ""
 
+# param_set_name -> strategy -> parameter -> ParameterRange, built once per process (and inherited by forked workers)
+_RANGES_BY_PARAM_SET: Dict[str, Dict[str, Dict[str, ParameterRange]]] = {}
+
 class ParameterManager:
     """
     Centralized parameter management for all trading strategies.
@@ -36,7 +39,10 @@ class ParameterManager:
     def __init__(self, param_set_name: str = 'small'):
         self.max_data_points = 300  # Conservative estimate for 7 days of 30min data
         self.param_set_name = param_set_name
-        self._parameter_ranges = self._define_parameter_ranges()
+        ranges = _RANGES_BY_PARAM_SET.get(param_set_name)
+        if ranges is None:
+            ranges = _RANGES_BY_PARAM_SET[param_set_name] = self._define_parameter_ranges()
+        self._parameter_ranges = ranges # Shared and never mutated
     
     def _define_parameter_ranges(self) -> Dict[str, Dict[str, ParameterRange]]:
         """Define parameter ranges for all strategies based on the selected parameter set."""
@@ -1,88 +1,143 @@
-import time
-import threading
-from collections import deque
+import asyncio
+import functools
+import json
 import logging
+import threading
+import time
+
+from core import metrics
+
+def request_key(func, args, kwargs):
+    """Coalescing key of a call: the function and its arguments (URL, query params, ...)."""
+    name = getattr(func, '__qualname__', repr(func))
+    return json.dumps([name, list(args), kwargs], sort_keys=True, default=str)
 
 class RateLimiter:
-    def __init__(self, requests_per_minute, seconds_per_request):
+    """
+    Event-driven rate limiter. The bucket holds requests_per_minute tokens; a spent
+    token comes back 60s after it was spent (so no 60s window ever sees more than
+    requests_per_minute requests) and two requests are at least seconds_per_request
+    apart. Callers wait on futures of an asyncio loop running in a background thread,
+    woken by timers instead of polling, and identical in-flight calls (same
+    coalesce_key) share a single upstream call. With a retry_policy (see
+    core/http_client.py) transient failures are retried after the policy's delay,
+    awaited on the loop, each attempt spending a token of its own.
+    """
+
+    WINDOW_SECONDS = 60
+
+    def __init__(self, requests_per_minute, seconds_per_request, retry_policy=None):
         self.requests_per_minute = requests_per_minute
         self.seconds_per_request = seconds_per_request
-        self.request_timestamps = deque()
-        self.request_queue = deque()
-        self.lock = threading.Lock()
+        self.retry_policy = retry_policy
         self.logger = logging.getLogger(__name__)
+        self._loop = asyncio.new_event_loop()
+        self._tokens = requests_per_minute
+        self._token_returned = asyncio.Event()
+        self._turn = asyncio.Lock() # Waiters acquire tokens in arrival order
+        self._next_request_at = 0.0
+        self._inflight = {} # coalesce_key -> task, touched only on the loop thread
+        self._waiting = 0 # Calls waiting for a token
+        self.upstream_requests = 0
+        self.coalesced_requests = 0
+        self.retried_requests = 0
         self.logger.info(f"RateLimiter initialized with {requests_per_minute} req/min and {seconds_per_request}s/req.")
-        self.thread = threading.Thread(target=self._process_queue, daemon=True)
+        self.thread = threading.Thread(target=self._loop.run_forever, daemon=True, name='RateLimiter')
         self.thread.start()
         logging.info(f"RateLimiter instance created: {id(self)}")
 
-    def _process_queue(self):
+    async def _acquire(self):
+        started = time.perf_counter()
+        self._waiting += 1
+        metrics.set_gauge('rate_limiter.waiting', self._waiting)
+        try:
+            async with self._turn:
+                while self._tokens == 0:
+                    self.logger.warning(f"Rate limit reached ({self.requests_per_minute} req/min). Waiting for a token.")
+                    self._token_returned.clear()
+                    await self._token_returned.wait()
+                delay = self._next_request_at - self._loop.time()
+                if delay > 0:
+                    await asyncio.sleep(delay)
+                self._tokens -= 1
+                self._next_request_at = self._loop.time() + self.seconds_per_request
+                self._loop.call_later(self.WINDOW_SECONDS, self._return_token)
+        finally:
+            self._waiting -= 1
+            metrics.set_gauge('rate_limiter.waiting', self._waiting)
+        metrics.observe('rate_limiter.token_wait', time.perf_counter() - started)
+        metrics.set_gauge('rate_limiter.tokens_available', self._tokens)
+
+    def _return_token(self):
+        self._tokens += 1
+        self._token_returned.set()
+
+    async def _call(self, func, args, kwargs):
+        attempt = 0
         while True:
-            if self.request_queue:
-                time_to_wait = 0
-                with self.lock:
-                    now = time.time()
-                    # Clean up old timestamps
-                    while (self.request_timestamps and
-                           now - self.request_timestamps[0] > 60):
-                        self.request_timestamps.popleft()
-
-                    self.logger.debug(f"Rate limiter check: {len(self.request_timestamps)} requests in last 60s.")
-                    if len(self.request_timestamps) >= self.requests_per_minute:
-                        time_to_wait = 60 - (now - self.request_timestamps[0])
-                        self.logger.warning(f"Rate limit reached ({len(self.request_timestamps)}/{self.requests_per_minute} req/min). Waiting for {time_to_wait:.2f}s.")
-
-                if time_to_wait > 0:
-                    time.sleep(time_to_wait)
-                    continue # Re-evaluate after waiting
-
-                # If we are here, we can process a request.
-                with self.lock:
-                    if not self.request_queue:
-                        continue
-                    request = self.request_queue.popleft()
-
-                try:
-                    self.logger.debug(f"RateLimiter {id(self)}: Processing request for {request['func'].__name__}")
-                    result = request['func'](*request['args'], **request['kwargs'])
-                    request['callback'](result)
-                    with self.lock:
-                        self.request_timestamps.append(time.time())
-                    self.logger.debug(f"Request sent. Sleeping for {self.seconds_per_request}s.")
-
-                except Exception as e:
-                    request['callback'](e)
-
-                time.sleep(self.seconds_per_request)
-            else:
-                time.sleep(0.1)
-
-    def make_request(self, func, *args, **kwargs):
-        logging.debug(f"RateLimiter {id(self)}: make_request called for {func.__name__}")
-        callback_event = threading.Event() # Use threading.Event
-        result = None
-        error = None
-
-        def callback(res):
-            nonlocal result, error
-            if isinstance(res, Exception):
-                error = res
-            else:
-                result = res
-            callback_event.set()
-
-        with self.lock:
-            self.request_queue.append({
-                'func': func,
-                'args': args,
-                'kwargs': kwargs,
-                'callback': callback
-            })
-
-        callback_event.wait()
-        if error:
-            raise error
-        return result
+            await self._acquire()
+            self.upstream_requests += 1
+            metrics.inc('rate_limiter.upstream_requests')
+            self.logger.debug(f"RateLimiter {id(self)}: Processing request for {getattr(func, '__name__', func)}")
+            result, error = None, None
+            try:
+                # The call itself blocks (requests), so it runs in the loop's executor
+                result = await self._loop.run_in_executor(None, functools.partial(func, *args, **kwargs))
+            except Exception as e:
+                error = e
+            delay = self.retry_policy.delay(attempt, result, error) if self.retry_policy else None
+            if delay is None:
+                if error is not None:
+                    raise error
+                return result
+            attempt += 1
+            self.retried_requests += 1
+            metrics.inc('rate_limiter.retries')
+            failure = error if error is not None else f"HTTP {getattr(result, 'status_code', '?')}"
+            self.logger.warning(f"RateLimiter: {getattr(func, '__name__', func)} failed ({failure}), retry {attempt} in {delay:.1f}s")
+            await asyncio.sleep(delay) # Holds no thread; only this call's coroutine waits
+
+    async def submit(self, func, args=(), kwargs=None, coalesce_key=None):
+        """Coroutine (on the limiter's loop) returning func(*args, **kwargs) once a token is available."""
+        kwargs = kwargs or {}
+        if coalesce_key is not None:
+            shared = self._inflight.get(coalesce_key)
+            if shared is not None:
+                self.coalesced_requests += 1
+                self.logger.debug(f"RateLimiter {id(self)}: Coalesced request for {getattr(func, '__name__', func)}")
+                return await asyncio.shield(shared)
+        task = self._loop.create_task(self._call(func, args, kwargs))
+        if coalesce_key is not None:
+            self._inflight[coalesce_key] = task
+            task.add_done_callback(lambda _: self._inflight.pop(coalesce_key, None))
+        # Shielded, so a cancelled waiter never cancels a call other waiters share
+        return await asyncio.shield(task)
+
+    def submit_threadsafe(self, func, *args, coalesce_key=None, **kwargs):
+        """Schedules a call from any thread; returns a concurrent.futures.Future of its result."""
+        logging.debug(f"RateLimiter {id(self)}: request submitted for {getattr(func, '__name__', func)}")
+        return asyncio.run_coroutine_threadsafe(self.submit(func, args, kwargs, coalesce_key), self._loop)
+
+    def make_request(self, func, *args, coalesce_key=None, **kwargs):
+        """Blocking call: waits for a token, runs func and returns its result (or raises its error)."""
+        return self.submit_threadsafe(func, *args, coalesce_key=coalesce_key, **kwargs).result()
+
+    async def make_request_async(self, func, *args, coalesce_key=None, **kwargs):
+        """make_request for coroutines running on any other event loop."""
+        return await asyncio.wrap_future(self.submit_threadsafe(func, *args, coalesce_key=coalesce_key, **kwargs))
+
+    def stats(self):
+        return {
+            'tokens_available': self._tokens,
+            'upstream_requests': self.upstream_requests,
+            'coalesced_requests': self.coalesced_requests,
+            'retried_requests': self.retried_requests,
+            'inflight': len(self._inflight),
+            'waiting': self._waiting,
+        }
+
+    def shutdown(self):
+        self._loop.call_soon_threadsafe(self._loop.stop)
 
 
 _shared_rate_limiter = None
@@ -94,5 +149,7 @@ def get_shared_rate_limiter(requests_per_minute=7, seconds_per_request=1.11):
     return _shared_rate_limiter
 
 def shutdown_shared_rate_limiter():
-    # No explicit shutdown needed for a thread-safe in-memory rate limiter
-    pass
\ No newline at end of file
+    global _shared_rate_limiter
+    if _shared_rate_limiter is not None:
+        _shared_rate_limiter.shutdown()
+        _shared_rate_limiter = None
@@ -1,41 +1,82 @@
 import time
-import threading
-from collections import deque
+import functools
 import logging
 import multiprocessing
 
 from core.app_config import Config
-from core.rate_limiter import RateLimiter # Import the simplified RateLimiter
+from core.rate_limiter import RateLimiter, request_key
+from core.ipc_channels import ReplySender
+from core.http_client import RetryPolicy
+from core import metrics
+
+class _Replies:
+    """Routes results to their requester's reply channel, or to the shared response queue."""
+
+    def __init__(self, response_queue: multiprocessing.Queue):
+        self.response_queue = response_queue
+        self.senders = {} # reply_to -> ReplySender
+        self.logger = logging.getLogger(__name__)
+
+    def sender(self, reply_to):
+        if reply_to is None:
+            return None
+        sender = self.senders.get(reply_to)
+        if sender is None:
+            sender = ReplySender(reply_to)
+            self.senders[reply_to] = sender
+        return sender
+
+    def send(self, reply_to, request_id, result):
+        if reply_to is None:
+            self.response_queue.put((result, request_id))
+            return
+        try:
+            self.sender(reply_to).send(request_id, result)
+        except (OSError, EOFError) as e:
+            # The requester went away; drop its channel so a restarted one reconnects
+            self.logger.warning(f"Rate Limiter Process: Could not reply to {reply_to[0]}: {e}")
+            sender = self.senders.pop(reply_to, None)
+            if sender is not None:
+                sender.close()
+
+    def on_done(self, reply_to, request_id, future):
+        """Done-callback of a limited call: sends its result (or error) back to the caller."""
+        error = future.exception()
+        self.send(reply_to, request_id, error if error is not None else future.result())
 
 def start_rate_limiter_process(request_queue: multiprocessing.Queue, response_queue: multiprocessing.Queue, config: Config):
     """
     Starts a dedicated process to manage the RateLimiter.
-    All rate-limited requests are sent to this process via request_queue,
-    and responses are sent back via response_queue.
+    All rate-limited requests are sent to this process via request_queue. A
+    request naming a reply channel (core/ipc_channels.py) is answered on it, with
+    large bodies passed through the requester's shared-memory arena; other
+    responses are sent back via response_queue. Requests are handed to the
+    limiter as they arrive, so identical ones waiting for a token are coalesced
+    into a single upstream call whose response goes to every requester.
     """
     logger = logging.getLogger(__name__)
     logger.info("Rate Limiter Process started.")
 
-    # Instantiate the simplified RateLimiter
     rate_limiter = RateLimiter(
         requests_per_minute=config.COINGECKO_REQUESTS_PER_MINUTE,
-        seconds_per_request=config.COINGECKO_SECONDS_PER_REQUEST
+        seconds_per_request=config.COINGECKO_SECONDS_PER_REQUEST,
+        retry_policy=RetryPolicy.from_config(config) # Backoff waits on the limiter's loop, not in a thread
     )
+    replies = _Replies(response_queue)
 
+    request_id = None
+    reply_to = None
     while True:
         try:
-            # Get request from queue (blocking call)
-            func_name, args, kwargs, request_id = request_queue.get()
-            logger.debug(f"Rate Limiter Process: Received request {request_id} for {func_name}")
-
-            def process_callback(result):
-                response_queue.put((result, request_id))
-
-            try:
-                result = rate_limiter.make_request(func_name, *args, **kwargs)
-                process_callback(result)
-            except Exception as e:
-                process_callback(e)
+            # Get request from queue (blocking call); (func, args, kwargs, request_id[, reply_to])
+            message = request_queue.get()
+            func, args, kwargs, request_id = message[:4]
+            reply_to = message[4] if len(message) > 4 else None
+            logger.debug(f"Rate Limiter Process: Received request {request_id} for {getattr(func, '__name__', func)}")
+            replies.sender(reply_to) # Connect before the call, so callbacks only send
+            future = rate_limiter.submit_threadsafe(func, *args, coalesce_key=request_key(func, args, kwargs), **kwargs)
+            future.add_done_callback(functools.partial(replies.on_done, reply_to, request_id))
+            metrics.publish_process('rate_limiter') # Served by /api/metrics of the web process
 
         except KeyboardInterrupt:
             logger.info("Rate Limiter Process received KeyboardInterrupt. Shutting down.")
@@ -43,7 +84,10 @@ def start_rate_limiter_process(request_queue: multiprocessing.Queue, response_qu
         except Exception as e:
             logger.error(f"Rate Limiter Process: An error occurred: {e}", exc_info=True)
             # If an error occurs, send it back to the caller
-            response_queue.put((e, request_id))
+            try:
+                replies.send(reply_to, request_id, e)
+            except Exception:
+                response_queue.put((e, request_id))
             time.sleep(1) # Prevent busy-looping on continuous errors
 
 if __name__ == '__main__':
@@ -0,0 +1,254 @@
+"""
+SQLite index of the JSON result files in a results directory.
+
+The JSON files stay the source of truth (other tools read them directly); the
+index keeps one row per file with its kind, crypto, strategy, record id, content
+key, creation time and profit, plus the document itself, so history, lookup and
+top-N queries are index scans that never touch the directory. Files written through
+ResultIndex.write are indexed as they are written. Files changed behind the
+index's back are picked up by a reconcile pass, triggered when the directory's
+mtime no longer matches the one recorded at the last write or sync.
+"""
+
+import json
+import logging
+import os
+import sqlite3
+import time
+from collections import namedtuple
+from contextlib import contextmanager
+from typing import Any, Dict, Iterator, Optional
+
+logger = logging.getLogger(__name__)
+
+# The database lives in a subdirectory so its own journal files never touch the results directory's mtime
+INDEX_DIRNAME = ".index"
+INDEX_FILENAME = "results.sqlite3"
+
+# Filename prefix -> kind of result
+KIND_PREFIXES = (
+    ('analysis_', 'analysis'),
+    ('backtest_', 'backtest'),
+    ('best_params_', 'optimization'),
+)
+
+# Document field stored in the profit column, per kind
+PROFIT_FIELDS = {'backtest': 'net_profit', 'optimization': 'best_value'}
+
+# Document field stored in the record_id column, per kind
+RECORD_ID_FIELDS = {'analysis': 'analysis_id', 'backtest': 'backtest_id'}
+
+# Document field stored in the content_key column, per kind (see core/analysis_memo.py)
+CONTENT_KEY_FIELDS = {'analysis': 'memo_key'}
+
+IndexedResult = namedtuple('IndexedResult', ['path', 'crypto_id', 'strategy', 'document'])
+
+SCHEMA = """
+CREATE TABLE IF NOT EXISTS results (
+    path TEXT PRIMARY KEY,
+    kind TEXT NOT NULL,
+    crypto_id TEXT,
+    strategy TEXT,
+    record_id TEXT,
+    created_at REAL NOT NULL,
+    profit REAL,
+    mtime_ns INTEGER NOT NULL,
+    size INTEGER NOT NULL,
+    document TEXT NOT NULL,
+    content_key TEXT
+);
+CREATE INDEX IF NOT EXISTS idx_results_created ON results (kind, created_at DESC);
+CREATE INDEX IF NOT EXISTS idx_results_crypto ON results (kind, crypto_id, created_at DESC);
+CREATE INDEX IF NOT EXISTS idx_results_strategy ON results (kind, strategy, created_at DESC);
+CREATE INDEX IF NOT EXISTS idx_results_profit ON results (kind, profit DESC);
+CREATE INDEX IF NOT EXISTS idx_results_record ON results (kind, record_id);
+CREATE TABLE IF NOT EXISTS meta (
+    key TEXT PRIMARY KEY,
+    value INTEGER
+);
+"""
+
+def _kind_of(filename: str) -> Optional[str]:
+    if not filename.endswith('.json'):
+        return None
+    for prefix, kind in KIND_PREFIXES:
+        if filename.startswith(prefix):
+            return kind
+    return None
+
+def _keys_from_filename(kind: str, filename: str, document: Dict[str, Any]):
+    """(crypto_id, strategy) of a file found on disk, from its content or its name."""
+    parts = filename[:-len('.json')].split('_')
+    if kind == 'analysis':
+        # analysis_{crypto}_{YYYYmmdd}_{HHMMSS}.json
+        return '_'.join(parts[1:-2]) or None, document.get('strategy_used')
+    if kind == 'backtest':
+        # backtest_{crypto}_{strategy}_{YYYYmmdd}_{HHMMSS}.json
+        return (parts[1] if len(parts) > 1 else None), ('_'.join(parts[2:-2]) or None)
+    # best_params_{crypto}_{strategy}.json
+    crypto_id = document.get('crypto') or (parts[2] if len(parts) > 2 else None)
+    strategy = document.get('strategy') or ('_'.join(parts[3:]) or None)
+    return crypto_id, strategy
+
+def _number(value) -> Optional[float]:
+    return float(value) if isinstance(value, (int, float)) and not isinstance(value, bool) else None
+
+class ResultIndex:
+    """Indexed view of the analysis_*, backtest_* and best_params_* files of a results directory."""
+
+    def __init__(self, results_dir: str):
+        self.results_dir = results_dir
+        os.makedirs(results_dir, exist_ok=True)
+        os.makedirs(os.path.join(results_dir, INDEX_DIRNAME), exist_ok=True)
+        self.db_path = os.path.join(results_dir, INDEX_DIRNAME, INDEX_FILENAME)
+        with self._connect() as conn:
+            conn.execute("PRAGMA journal_mode=WAL")
+            conn.executescript(SCHEMA)
+            self._migrate(conn)
+        self._sync_if_changed()
+
+    @staticmethod
+    def _migrate(conn) -> None:
+        # Indexes created before the content_key column existed get it added in place
+        columns = {row[1] for row in conn.execute("PRAGMA table_info(results)")}
+        if 'content_key' not in columns:
+            conn.execute("ALTER TABLE results ADD COLUMN content_key TEXT")
+        conn.execute("CREATE INDEX IF NOT EXISTS idx_results_content_key ON results (kind, content_key)")
+
+    @contextmanager
+    def _connect(self):
+        # A connection per operation keeps the index safe across threads and forked workers
+        conn = sqlite3.connect(self.db_path, timeout=30)
+        try:
+            with conn:
+                yield conn
+        finally:
+            conn.close()
+
+    def _dir_mtime_ns(self) -> int:
+        return os.stat(self.results_dir).st_mtime_ns
+
+    def write(self, path: str, kind: str, document: Dict[str, Any], crypto_id: str = None, strategy: str = None) -> None:
+        """Atomically writes document as JSON to path (.tmp + os.replace) and indexes it."""
+        dir_mtime_before = self._dir_mtime_ns()
+        temp_path = path + ".tmp"
+        try:
+            with open(temp_path, 'w') as f:
+                json.dump(document, f, indent=2, default=str)
+            os.replace(temp_path, path)
+        except Exception:
+            if os.path.exists(temp_path):
+                os.remove(temp_path)
+            raise
+        stat = os.stat(path)
+        with self._connect() as conn:
+            self._upsert(conn, path, kind, crypto_id, strategy, document, time.time(), stat)
+            # Our own write is the only directory change if it was in sync before it
+            conn.execute("UPDATE meta SET value = ? WHERE key = 'dir_mtime_ns' AND value = ?",
+                         (self._dir_mtime_ns(), dir_mtime_before))
+
+    def _upsert(self, conn, path, kind, crypto_id, strategy, document, created_at, stat) -> None:
+        profit_field = PROFIT_FIELDS.get(kind)
+        record_id_field = RECORD_ID_FIELDS.get(kind)
+        record_id = document.get(record_id_field) if record_id_field else None
+        content_key_field = CONTENT_KEY_FIELDS.get(kind)
+        content_key = document.get(content_key_field) if content_key_field else None
+        conn.execute(
+            "INSERT OR REPLACE INTO results (path, kind, crypto_id, strategy, record_id, created_at, profit, mtime_ns, size, document, content_key) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+            (path, kind, crypto_id, strategy, None if record_id is None else str(record_id), created_at,
+             _number(document.get(profit_field)) if profit_field else None,
+             stat.st_mtime_ns, stat.st_size, json.dumps(document, default=str),
+             None if content_key is None else str(content_key)))
+
+    def _sync_if_changed(self) -> None:
+        try:
+            dir_mtime = self._dir_mtime_ns()
+            with self._connect() as conn:
+                row = conn.execute("SELECT value FROM meta WHERE key = 'dir_mtime_ns'").fetchone()
+            if row is None or row[0] != dir_mtime:
+                self.sync()
+        except (OSError, sqlite3.Error) as e:
+            logger.error(f"Could not check result index freshness for {self.results_dir}: {e}")
+
+    def sync(self) -> int:
+        """
+        Reconciles the index with the directory: (re)indexes files whose size or mtime
+        changed and drops rows of files that no longer exist. Returns the number of
+        files (re)indexed.
+        """
+        dir_mtime = self._dir_mtime_ns()
+        with self._connect() as conn:
+            known = {path: (mtime_ns, size) for path, mtime_ns, size in
+                     conn.execute("SELECT path, mtime_ns, size FROM results")}
+        seen = set()
+        indexed = 0
+        with os.scandir(self.results_dir) as entries, self._connect() as conn:
+            for entry in entries:
+                kind = _kind_of(entry.name)
+                if kind is None or not entry.is_file():
+                    continue
+                stat = entry.stat()
+                seen.add(entry.path)
+                if known.get(entry.path) == (stat.st_mtime_ns, stat.st_size):
+                    continue
+                try:
+                    with open(entry.path, 'r') as f:
+                        document = json.load(f)
+                except (OSError, json.JSONDecodeError) as e:
+                    logger.warning(f"Could not index {entry.path}: {e}")
+                    continue
+                if not isinstance(document, dict):
+                    continue
+                crypto_id, strategy = _keys_from_filename(kind, entry.name, document)
+                self._upsert(conn, entry.path, kind, crypto_id, strategy, document, stat.st_mtime, stat)
+                indexed += 1
+            conn.executemany("DELETE FROM results WHERE path = ?", [(path,) for path in known if path not in seen])
+            conn.execute("INSERT OR REPLACE INTO meta (key, value) VALUES ('dir_mtime_ns', ?)", (dir_mtime,))
+        if indexed:
+            logger.info(f"Result index for {self.results_dir}: indexed {indexed} changed files")
+        return indexed
+
+    def query(self, kind: str, crypto_id: str = None, strategy: str = None, record_id: str = None,
+              content_key: str = None, min_profit: float = None, order_by: str = 'created_at', limit: int = None) -> Iterator[IndexedResult]:
+        """
+        Yields indexed results of one kind, newest first (order_by='created_at') or most
+        profitable first (order_by='profit', which skips rows without a profit).
+        Rows whose file has disappeared are dropped instead of yielded.
+        """
+        self._sync_if_changed()
+        clauses, args = ["kind = ?"], [kind]
+        for column, value in (('crypto_id', crypto_id), ('strategy', strategy), ('record_id', record_id),
+                              ('content_key', content_key)):
+            if value is not None:
+                clauses.append(f"{column} = ?")
+                args.append(value)
+        if min_profit is not None:
+            clauses.append("profit > ?")
+            args.append(min_profit)
+        if order_by == 'profit':
+            clauses.append("profit IS NOT NULL")
+            order = "profit DESC"
+        elif order_by == 'created_at':
+            order = "created_at DESC"
+        else:
+            raise ValueError(f"Unsupported order_by: {order_by}")
+        sql = f"SELECT path, crypto_id, strategy, document FROM results WHERE {' AND '.join(clauses)} ORDER BY {order}"
+        if limit is not None:
+            sql += " LIMIT ?"
+            args.append(int(limit))
+
+        with self._connect() as conn:
+            rows = conn.execute(sql, args).fetchall()
+        for path, row_crypto_id, row_strategy, document in rows:
+            if not os.path.exists(path):
+                with self._connect() as conn:
+                    conn.execute("DELETE FROM results WHERE path = ?", (path,))
+                continue
+            yield IndexedResult(path, row_crypto_id, row_strategy, json.loads(document))
+
+    def exists(self, kind: str, crypto_id: str) -> bool:
+        self._sync_if_changed()
+        with self._connect() as conn:
+            return conn.execute("SELECT 1 FROM results WHERE kind = ? AND crypto_id = ? LIMIT 1",
+                                (kind, crypto_id)).fetchone() is not None
@@ -4,12 +4,13 @@ Result storage and retrieval manager.
 
 import json
 import os
-import glob
 from datetime import datetime
 from typing import Dict, List, Optional, Any
 import logging
 
 from core.app_config import Config
+from core.result_index import ResultIndex
+from core.paper_ledger import load_analysis_history
 
 logger = logging.getLogger(__name__)
 
@@ -21,6 +22,7 @@ class ResultManager:
         self.results_dir = self.config.RESULTS_DIR
         os.makedirs(self.results_dir, exist_ok=True)
         self.logger = logging.getLogger(__name__) # Add this line
+        self.index = ResultIndex(self.results_dir) # History and lookups are index queries, not directory scans
         self.logger.info(f"ResultManager initialized. Results directory: {self.results_dir}")
     
     def save_analysis_result(self, crypto_id: str, result_data: Dict[str, Any]) -> str:
@@ -33,8 +35,8 @@ class ResultManager:
         logger.info(f"Generated filepath for analysis result: {filepath}")
         
         try:
-            with open(filepath, 'w') as f:
-                json.dump(result_data, f, indent=2, default=str)
+            self.index.write(filepath, 'analysis', result_data, crypto_id=crypto_id,
+                             strategy=result_data.get('strategy_used'))
             logger.info(f"Successfully saved analysis result to {filepath}")
             return filepath
         except Exception as e:
@@ -48,12 +50,8 @@ class ResultManager:
         Checks if a cryptocurrency has existing optimization results.
         This is a placeholder and needs proper implementation based on actual optimization results.
         """
-        has_optimization_results = False
-        # Check if any analysis result files exist for the crypto_id
-        pattern = f"analysis_{crypto_id}_*.json"
-        files = glob.glob(os.path.join(self.results_dir, pattern))
-        if files:
-            has_optimization_results = True
+        # Check if any analysis result exists for the crypto_id
+        has_optimization_results = self.index.exists('analysis', crypto_id)
 
         return {
             'crypto_id': crypto_id,
@@ -70,8 +68,7 @@ class ResultManager:
         filename = f"backtest_{crypto_id}_{strategy_name_safe}_{timestamp}.json"
         filepath = os.path.join(self.results_dir, filename)
         
-        with open(filepath, 'w') as f:
-            json.dump(result, f, indent=2, default=str)
+        self.index.write(filepath, 'backtest', result, crypto_id=crypto_id, strategy=strategy_name_safe)
         
         return filepath
     
@@ -79,21 +76,14 @@ class ResultManager:
         """Get analysis history."""
         if crypto_id:
             crypto_id = crypto_id.replace(' ', '-').lower()
-        pattern = f"analysis_{crypto_id}_*.json" if crypto_id else "analysis_*.json"
-        files = glob.glob(os.path.join(self.results_dir, pattern))
-        files.sort(reverse=True)  # Most recent first
         
         results = []
-        for filepath in files[:limit]:
-            try:
-                with open(filepath, 'r') as f:
-                    result = json.load(f)
-                    result['file_path'] = filepath
-                    if 'strategy_used' in result:
-                        result['strategy'] = result['strategy_used']
-                    results.append(result)
-            except Exception as e:
-                print(f"Error loading {filepath}: {e}")
+        for entry in self.index.query('analysis', crypto_id=crypto_id or None, limit=limit):  # Most recent first
+            result = entry.document
+            result['file_path'] = entry.path
+            if 'strategy_used' in result:
+                result['strategy'] = result['strategy_used']
+            results.append(result)
         
         return results
     
@@ -104,41 +94,16 @@ class ResultManager:
         """Get backtest history."""
         if crypto_id:
             crypto_id = crypto_id.replace(' ', '-').lower()
-        
-        if crypto_id and strategy_name:
-            pattern = f"backtest_{crypto_id}_{strategy_name}_*.json"
-        elif crypto_id:
-            pattern = f"backtest_{crypto_id}_*.json"
-        elif strategy_name:
-            pattern = f"backtest_*_{strategy_name}_*.json"
-        else:
-            pattern = "backtest_*.json"
-        
-        files = glob.glob(os.path.join(self.results_dir, pattern))
-        self.logger.debug(f"get_backtest_history: Searching for pattern '{pattern}'. Found files: {files}")
-        files.sort(reverse=True)  # Most recent first
+        strategy_name_safe = strategy_name.replace(' ', '-') if strategy_name else None
+        self.logger.debug(f"get_backtest_history: crypto_id={crypto_id}, strategy={strategy_name_safe}, limit={limit}")
         
         results = []
-        for filepath in files[:limit]:
-            try:
-                with open(filepath, 'r') as f:
-                    result = json.load(f)
-                    result['file_path'] = filepath
-                    # Extract strategy from filename
-                    try:
-                        filename = os.path.basename(filepath)
-                        filename_no_ext = filename[:-5]
-                        parts = filename_no_ext.split('_')
-                        if len(parts) > 3 and parts[0] == 'backtest':
-                            strategy_parts = parts[2:-2]
-                            strategy_name_safe = '_'.join(strategy_parts)
-                            result['strategy'] = strategy_name_safe.replace('-', ' ')
-                    except Exception as e:
-                        self.logger.warning(f"Could not parse strategy from filename {filepath}: {e}")
-                    results.append(result)
-                    self.logger.debug(f"get_backtest_history: Successfully loaded {filepath}. Content: {result}")
-            except Exception as e:
-                self.logger.error(f"get_backtest_history: Error loading {filepath}: {e}")
+        for entry in self.index.query('backtest', crypto_id=crypto_id or None, strategy=strategy_name_safe, limit=limit):  # Most recent first
+            result = entry.document
+            result['file_path'] = entry.path
+            if entry.strategy:
+                result['strategy'] = entry.strategy.replace('-', ' ')
+            results.append(result)
         
         return results
     
@@ -147,67 +112,40 @@ class ResultManager:
                            strategy_name: Optional[str] = None,
                            limit: int = 50) -> List[Dict[str, Any]]:
         """Get optimization history."""
-        if crypto_id and strategy_name:
-            pattern = f"best_params_{crypto_id}_{strategy_name}.json"
-        elif crypto_id:
-            pattern = f"best_params_{crypto_id}_*.json"
-        elif strategy_name:
-            pattern = f"best_params_*_{strategy_name}.json"
-        else:
-            pattern = "best_params_*.json"
-        
-        files = glob.glob(os.path.join(self.results_dir, pattern))
-        files.sort(reverse=True)  # Most recent first
-        
         results = []
-        for filepath in files[:limit]:
-            try:
-                with open(filepath, 'r') as f:
-                    result = json.load(f)
-                    result['file_path'] = filepath
-                    # Extract strategy from filename
-                    try:
-                        filename = os.path.basename(filepath)
-                        parts = filename.split('_')
-                        if len(parts) > 3 and parts[0] == 'best' and parts[1] == 'params':
-                            result['strategy'] = parts[3].replace('.json', '')
-                    except Exception as e:
-                        self.logger.warning(f"Could not parse strategy from filename {filepath}: {e}")
-                    results.append(result)
-            except Exception as e:
-                print(f"Error loading {filepath}: {e}")
+        for entry in self.index.query('optimization', crypto_id=crypto_id or None, strategy=strategy_name or None, limit=limit):
+            result = entry.document
+            result['file_path'] = entry.path
+            if entry.strategy:
+                result['strategy'] = entry.strategy
+            results.append(result)
         
         return results
 
     def get_analysis_by_id(self, analysis_id: str) -> Optional[Dict[str, Any]]:
         """Get specific analysis by ID."""
-        files = glob.glob(os.path.join(self.results_dir, "analysis_*.json"))
-        
-        for filepath in files:
-            try:
-                with open(filepath, 'r') as f:
-                    result = json.load(f)
-                    if result.get('analysis_id') == analysis_id:
-                        result['file_path'] = filepath
-                        return result
-            except Exception as e:
-                print(f"Error loading {filepath}: {e}")
+        for entry in self.index.query('analysis', record_id=str(analysis_id), limit=1):
+            result = entry.document
+            result['file_path'] = entry.path
+            return result
         
         return None
-    
+
+    def get_analysis_by_memo_key(self, memo_key: str) -> Optional[Dict[str, Any]]:
+        """Get the most recent analysis saved under a content-addressed memo key."""
+        for entry in self.index.query('analysis', content_key=str(memo_key), limit=1):
+            result = entry.document
+            result['file_path'] = entry.path
+            return result
+
+        return None
+
     def get_backtest_by_id(self, backtest_id: str) -> Optional[Dict[str, Any]]:
         """Get specific backtest by ID."""
-        files = glob.glob(os.path.join(self.results_dir, "backtest_*.json"))
-        
-        for filepath in files:
-            try:
-                with open(filepath, 'r') as f:
-                    result = json.load(f)
-                    if result.get('backtest_id') == backtest_id:
-                        result['file_path'] = filepath
-                        return result
-            except Exception as e:
-                print(f"Error loading {filepath}: {e}")
+        for entry in self.index.query('backtest', record_id=str(backtest_id), limit=1):
+            result = entry.document
+            result['file_path'] = entry.path
+            return result
         
         return None
 
@@ -219,27 +157,19 @@ class ResultManager:
         crypto_id = crypto_id.replace(' ', '-').lower()
         fiat_id = fiat_id.replace(' ', '-').lower() # Assuming fiat_id is also part of the filename pattern if needed
 
-        # Get all backtest history for the crypto_id
-        # The pattern needs to be flexible enough to catch all strategies for the crypto_id
-        pattern = f"backtest_{crypto_id}_*.json"
-        files = glob.glob(os.path.join(self.results_dir, pattern))
-        
-        profitable_results = []
-        for filepath in files:
-            try:
-                with open(filepath, 'r') as f:
-                    result = json.load(f)
-                    # Check if the result is for the correct fiat_id (if applicable in the result content)
-                    # And if it's profitable
-                    if result.get('net_profit', 0) > 0: # Assuming 'net_profit' is a key in the result
-                        profitable_results.append(result)
-            except Exception as e:
-                self.logger.error(f"Error loading backtest result from {filepath}: {e}")
-        
-        return profitable_results
+        # The index stores each backtest's 'net_profit' in its profit column
+        return [entry.document for entry in self.index.query('backtest', crypto_id=crypto_id, min_profit=0)]
 
     def load_paper_analysis_history(self) -> List[Dict[str, Any]]:
-        """Loads the paper trading analysis history."""
+        """Loads the paper trading analysis history (snapshot plus event tail of its ledger)."""
+        try:
+            history = load_analysis_history(self.results_dir)
+        except Exception as e:
+            self.logger.error(f"Error loading paper analysis history from {self.results_dir}: {e}")
+            return []
+        if history:
+            return history
+        # Not migrated yet: the paper trader imports the legacy file on its next start
         filepath = os.path.join(self.results_dir, 'paper_analysis_history.json')
         if os.path.exists(filepath):
             try:
@@ -17,6 +17,7 @@ import traceback # ADD THIS IMPORT
 sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
 
 from .result_manager import ResultManager
+from .analysis_memo import AnalysisMemo, analysis_memo_key
 from .data_manager import DataManager
 from .app_config import Config
 from .parameter_manager import ParameterManager
@@ -25,8 +26,6 @@ from .optimizer import BayesianOptimizer
 from .backtester_wrapper import BacktesterWrapper
 import config # Import the top-level config.py
 
-from lines import find_swing_points, find_support_resistance_lines, analyze_line_durations, auto_discover_percentage_change, predict_next_move
-from chart import generate_chart
 from .scheduler import get_scheduler # Import get_scheduler
 
 class TradingEngine:
@@ -42,6 +41,7 @@ class TradingEngine:
         self.logger.debug(f"TradingEngine init: data_fetcher is {type(data_fetcher)}")
         self.data_fetcher = data_fetcher # Store the data_fetcher
         self.result_manager = ResultManager(self.config)
+        self.analysis_memo = AnalysisMemo(self.result_manager, max_entries=self.config.ANALYSIS_MEMO_MAX_ENTRIES)
         self.data_manager = DataManager(self.config.CACHE_DIR)
         
         # Initialize unified components
@@ -238,7 +238,8 @@ class TradingEngine:
                     parameters: Dict[str, Any],
                     timeframe: str = "7d",
                     interval: str = "30m",
-                    save_result: bool = True) -> Dict[str, Any]:
+                    save_result: bool = True,
+                    include_trades: bool = False) -> Dict[str, Any]:
         """
         Run comprehensive backtest.
         
@@ -249,6 +250,7 @@ class TradingEngine:
             timeframe: Data timeframe (e.g., "7d", "30d")
             interval: Data interval (e.g., "30m", "1h")
             save_result: Whether to save the result
+            include_trades: Also return the trade list and equity curve
             
         Returns:
             Backtest results dictionary
@@ -267,7 +269,8 @@ class TradingEngine:
                 strategy=strategy_name,
                 parameters=parameters,
                 timeframe=timeframe,
-                interval=interval
+                interval=interval,
+                include_trades=include_trades
             )
             
             # Enhance result with metadata
@@ -504,27 +507,6 @@ class TradingEngine:
                     # If no strategy_name and no custom_params, parameters will be determined later
                     parameters = {}
             
-            # Check for existing analysis result (already implemented)
-            existing_analyses = self.result_manager.get_analysis_history(crypto_id=crypto_id)
-            for existing_analysis in existing_analyses:
-                # Convert timeframe to days for comparison
-                existing_timeframe_days = existing_analysis.get('timeframe_days')
-                requested_timeframe_days = self._timeframe_to_days(timeframe)
-
-                # Compare parameters. Handle cases where parameters_used might be a string (JSON dump)
-                existing_params = existing_analysis.get('parameters_used')
-                if isinstance(existing_params, str):
-                    try:
-                        existing_params = json.loads(existing_params)
-                    except json.JSONDecodeError:
-                        existing_params = {}
-
-                if (existing_analysis.get('strategy_used') == strategy_name and
-                    existing_timeframe_days == requested_timeframe_days and
-                    existing_params == parameters):
-                    self.logger.info(f"Found existing analysis for {crypto_id} with strategy {strategy_name}. Returning existing result.")
-                    return existing_analysis
-
             # 1. Find the youngest optimized backtest result
             optimized_results = self.result_manager.get_optimization_history(crypto_id=crypto_id, strategy_name=strategy_name if strategy_name else None)
             youngest_optimized_backtest = None
@@ -575,6 +557,25 @@ class TradingEngine:
                     'final_position': 0,
                 }
 
+            # Answer repeated requests for the same inputs and candles from the memo. The key is
+            # taken once the strategy and parameters are resolved (the selected result supplies
+            # them when strategy_name is None) and covers the values of the latest candle, which
+            # is revised in place while it forms
+            timeframe_days = self._timeframe_to_days(timeframe)
+            analysis_df = self._load_analysis_data(crypto_id, timeframe_days)
+            memo_key = None
+            if analysis_df is not None and not analysis_df.empty:
+                resolved_strategy = strategy_name or result_for_analysis.get('strategy')
+                resolved_parameters = parameters or result_for_analysis.get('best_params') or result_for_analysis.get('parameters')
+                candle_columns = [c for c in ('open', 'high', 'low', 'close', 'volume') if c in analysis_df.columns]
+                memo_key = analysis_memo_key(crypto_id, resolved_strategy, resolved_parameters, timeframe_days,
+                                             analysis_df.index[-1], analysis_df[candle_columns].iloc[-1].tolist(),
+                                             source=[result_for_analysis.get('strategy'), result_for_analysis.get('timestamp')])
+                memoized = self.analysis_memo.get(memo_key)
+                if memoized is not None:
+                    self.logger.info(f"Found memoized analysis for {crypto_id} with strategy {resolved_strategy}. Returning existing result.")
+                    return memoized
+
             backtest_result_data = None
             if result_for_analysis and (result_for_analysis.get('backtest_result') is not None or result_for_analysis.get('total_profit_percentage') is not None):
                 # Determine the actual backtest data, which might be nested
@@ -597,7 +598,7 @@ class TradingEngine:
                 'analysis_type': 'backtest_analysis',
                 'strategy_used': result_for_analysis.get('strategy') if result_for_analysis else 'Unknown',
                 'parameters_source': 'custom' if custom_params else 'optimized',
-                'timeframe_days': self._timeframe_to_days(timeframe),
+                'timeframe_days': timeframe_days,
                 'analysis_timestamp': datetime.now().isoformat(),
                 'backtest_result': backtest_result_data
             }
@@ -619,6 +620,9 @@ class TradingEngine:
                 analysis_result['current_signal'] = 'HOLD'
 
             # --- Support/Resistance Analysis ---
+            # Imported on first analysis: scipy and matplotlib are among the slowest imports at start-up
+            from lines import find_swing_points, find_support_resistance_lines, auto_discover_percentage_change, predict_next_move
+            from chart import generate_chart
             df: Optional[pd.DataFrame] = None
             resistance_lines: List[Dict[str, Any]] = []
             support_lines: List[Dict[str, Any]] = []
@@ -627,10 +631,7 @@ class TradingEngine:
             latest_price_point: Optional[pd.Series] = None
             first_timestamp: Optional[datetime] = None
             try:
-                timeframe_days = self._timeframe_to_days(timeframe)
-                if self.data_fetcher is None:
-                    raise ValueError("DataFetcher not initialized in TradingEngine.")
-                df = self.data_fetcher.get_crypto_data_merged(crypto_id, int(timeframe_days))
+                df = analysis_df # Fetched above for the memo key
                 if df is not None and not df.empty:
                     self.logger.debug(f"DataFrame for S/R analysis: {df.head()}")
                     df['price'] = df['close'] # Add a 'price' column for swing point analysis
@@ -739,8 +740,12 @@ class TradingEngine:
             log_result.pop('chart_data', None)
             self.logger.info(f"Final analysis_result: {log_result}")
             
-            # Save the analysis result
+            # Save the analysis result; the memo key makes the saved file the persistent memo tier
+            if memo_key is not None:
+                analysis_result['memo_key'] = memo_key
             self.result_manager.save_analysis_result(crypto_id, analysis_result)
+            if memo_key is not None:
+                self.analysis_memo.put(memo_key, analysis_result)
 
             self.logger.info(f"Analysis completed for {crypto_id}")
             return analysis_result
@@ -749,6 +754,16 @@ class TradingEngine:
             self.logger.error(f"Analysis failed for {crypto_id}: {str(e)}")
             raise e
     
+    def _load_analysis_data(self, crypto_id: str, timeframe_days: float) -> Optional[pd.DataFrame]:
+        """OHLC data an analysis runs on, or None when it cannot be fetched."""
+        try:
+            if self.data_fetcher is None:
+                raise ValueError("DataFetcher not initialized in TradingEngine.")
+            return self.data_fetcher.get_crypto_data_merged(crypto_id, int(timeframe_days))
+        except Exception as e:
+            self.logger.error(f"Error fetching analysis data for {crypto_id}: {e}")
+            return None
+
     # ========== System Health ==========
     
     def health_check(self) -> Dict[str, Any]:
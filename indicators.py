@@ -1,6 +1,14 @@
+import numpy as np
 import pandas as pd
 import ta
 
+try:
+    import indicators_cython
+    NATIVE_INDICATORS_AVAILABLE = True
+except ImportError:
+    indicators_cython = None
+    NATIVE_INDICATORS_AVAILABLE = False
+
 class Indicators:
     def get_indicator(self, name, df, params):
         if name == 'sma':
@@ -20,26 +28,61 @@ class Indicators:
         else:
             return None
 
+def native_inputs(df, columns=('close',)):
+    """
+    Returns contiguous float64 arrays for the given columns when the native indicator
+    engine can be used on them, otherwise None (module not built or data contains NaN).
+    """
+    if not NATIVE_INDICATORS_AVAILABLE:
+        return None
+    arrays = []
+    for column in columns:
+        values = np.ascontiguousarray(df[column].to_numpy(dtype=np.float64))
+        if np.isnan(values).any():
+            return None
+        arrays.append(values)
+    return arrays
+
+def _native_window(window):
+    """Window arguments the native engine accepts; anything else keeps the pandas/ta behaviour."""
+    return isinstance(window, (int, np.integer)) and not isinstance(window, bool) and window >= 1
+
 def calculate_sma(df, window):
     """Calculates the Simple Moving Average (SMA) manually."""
     if window >= len(df):
         return pd.Series([float('nan')] * len(df), index=df.index)
-    
+
+    arrays = native_inputs(df) if _native_window(window) else None
+    if arrays is not None:
+        return pd.Series(indicators_cython.sma(arrays[0], window), index=df.index, name='close')
+
     sma = df['close'].rolling(window=window).mean()
     return sma
 
 def calculate_ema(df, window):
     """Calculates the Exponential Moving Average (EMA) manually."""
+    arrays = native_inputs(df) if _native_window(window) else None
+    if arrays is not None:
+        return pd.Series(indicators_cython.ema(arrays[0], window), index=df.index, name='close')
+
     ema = df['close'].ewm(span=window, adjust=False).mean()
     return ema
 
 
 def calculate_rsi(df, window=14):
     """Calculates the Relative Strength Index (RSI)"""
+    arrays = native_inputs(df) if _native_window(window) else None
+    if arrays is not None:
+        return pd.Series(indicators_cython.rsi(arrays[0], window), index=df.index, name='rsi')
     return ta.momentum.rsi(df['close'], window=window)
 
 def calculate_macd(df, window_slow=26, window_fast=12, window_sign=9):
     """Calculates the Moving Average Convergence Divergence (MACD)"""
+    arrays = native_inputs(df) if all(_native_window(w) for w in (window_slow, window_fast, window_sign)) else None
+    if arrays is not None:
+        macd_line, macd_signal = indicators_cython.macd(arrays[0], window_slow, window_fast, window_sign)
+        return pd.DataFrame({'MACD': macd_line, 'Signal': macd_signal}, index=df.index)
+
     macd_line = ta.trend.macd(df['close'], window_slow=window_slow, window_fast=window_fast)
     macd_signal = ta.trend.macd_signal(df['close'], window_slow=window_slow, window_fast=window_fast, window_sign=window_sign)
     
@@ -48,6 +91,11 @@ def calculate_macd(df, window_slow=26, window_fast=12, window_sign=9):
 
 def calculate_bbands(df, window=20, window_dev=2):
     """Calculates the Bollinger Bands"""
+    arrays = native_inputs(df) if _native_window(window) else None
+    if arrays is not None:
+        bb_mavg, bb_hband, bb_lband = indicators_cython.bbands(arrays[0], window, window_dev)
+        return pd.DataFrame({'bb_mavg': bb_mavg, 'bb_hband': bb_hband, 'bb_lband': bb_lband}, index=df.index)
+
     indicator_bb = ta.volatility.BollingerBands(close=df['close'], window=window, window_dev=window_dev)
     bb_df = pd.DataFrame({
         'bb_mavg': indicator_bb.bollinger_mavg(),
@@ -60,16 +108,29 @@ def calculate_atr(df, window=14):
     """Calculates the Average True Range (ATR)"""
     if window >= len(df):
         window = len(df) - 1
+    arrays = native_inputs(df, ('high', 'low', 'close')) if _native_window(window) else None
+    if arrays is not None:
+        return pd.Series(indicators_cython.atr(*arrays, window), index=df.index, name='atr')
     return ta.volatility.average_true_range(high=df['high'], low=df['low'], close=df['close'], window=window)
 
+def calculate_adx_values(df, window=14):
+    """Calculates the numeric ADX columns (adx, pdi, ndi) without the trend labels"""
+    arrays = native_inputs(df, ('high', 'low', 'close')) if _native_window(window) and window <= len(df) else None
+    if arrays is not None:
+        adx, pdi, ndi = indicators_cython.adx(*arrays, window)
+        adx_df = pd.DataFrame({'adx': adx, 'pdi': pdi, 'ndi': ndi}, index=df.index)
+    else:
+        adx_indicator = ta.trend.ADXIndicator(high=df['high'], low=df['low'], close=df['close'], window=window)
+        adx_df = pd.DataFrame({
+            'adx': adx_indicator.adx(),
+            'pdi': adx_indicator.adx_pos(), # +DI
+            'ndi': adx_indicator.adx_neg()  # -DI
+        })
+    return adx_df
+
 def calculate_adx(df, window=14):
     """Calculates the Average Directional Movement Index (ADX)"""
-    adx_indicator = ta.trend.ADXIndicator(high=df['high'], low=df['low'], close=df['close'], window=window)
-    adx_df = pd.DataFrame({
-        'adx': adx_indicator.adx(),
-        'pdi': adx_indicator.adx_pos(), # +DI
-        'ndi': adx_indicator.adx_neg()  # -DI
-    })
+    adx_df = calculate_adx_values(df, window)
 
     # Determine ADX Trend (Strength)
     adx_df['adx_trend'] = 'No strong trend'
@@ -81,7 +142,7 @@ def calculate_adx(df, window=14):
     adx_df.loc[adx_df['pdi'] > adx_df['ndi'], 'adx_direction'] = 'Up'
     adx_df.loc[adx_df['ndi'] > adx_df['pdi'], 'adx_direction'] = 'Down'
 
-    # Combine trend and direction
-    adx_df['adx_full_trend'] = adx_df.apply(lambda row: f"{row['adx_trend']} ({row['adx_direction']})" if row['adx_trend'] != 'No strong trend' else f"No strong trend ({row['adx_direction']})", axis=1)
+    # Combine trend and direction, e.g. "Strong trend (Up)"
+    adx_df['adx_full_trend'] = adx_df['adx_trend'] + ' (' + adx_df['adx_direction'] + ')'
 
     return adx_df
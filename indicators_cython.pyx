@@ -0,0 +1,462 @@
+# cython: cdivision=True
+"""
+Native implementations of the indicators in indicators.py.
+
+Every function works on contiguous float64 buffers and reproduces the exact
+recurrences used by pandas (rolling/ewm) and the `ta` library, so results stay
+interchangeable with the pure Python path. Inputs are expected to be free of NaN;
+indicators.py falls back to pandas/ta otherwise. Division follows IEEE rules
+(x/0 gives inf or NaN) to match numpy instead of raising ZeroDivisionError.
+"""
+import numpy as np
+cimport numpy as np
+cimport cython
+from libc.math cimport sqrt, fabs, fmax, fmin, signbit, NAN
+
+ctypedef np.float64_t DTYPE_t
+
+# Running state of pandas' ewm(adjust=False, ignore_na=False).mean()
+cdef struct EwmState:
+    double alpha
+    double old_wt_factor
+    double weighted
+    double old_wt
+    Py_ssize_t nobs
+    bint started
+
+# Running state of pandas' rolling().mean() with Kahan compensation
+cdef struct RollingMeanState:
+    double sum_x
+    double compensation_add
+    double compensation_remove
+    double prev_value
+    Py_ssize_t nobs
+    Py_ssize_t neg_ct
+    Py_ssize_t num_consecutive_same_value
+
+# Running state of pandas' rolling().var() (Welford with Kahan compensation)
+cdef struct RollingVarState:
+    double nobs
+    double mean_x
+    double ssqdm_x
+    double compensation_add
+    double compensation_remove
+    double prev_value
+    Py_ssize_t num_consecutive_same_value
+
+cdef inline void ewm_init(EwmState* state, double com) noexcept nogil:
+    state.alpha = 1. / (1. + com)
+    state.old_wt_factor = 1. - state.alpha
+    state.weighted = NAN
+    state.old_wt = 1.
+    state.nobs = 0
+    state.started = 0
+
+cdef inline double ewm_update(EwmState* state, double cur, Py_ssize_t minp) noexcept nogil:
+    """Feeds one value and returns the current mean (NaN until minp observations)."""
+    cdef bint is_observation = cur == cur
+    state.nobs += is_observation
+    if not state.started:
+        state.weighted = cur
+        state.old_wt = 1.
+        state.started = 1
+    elif state.weighted == state.weighted:
+        state.old_wt *= state.old_wt_factor
+        if is_observation:
+            # avoid numerical errors on constant series
+            if state.weighted != cur:
+                state.weighted = state.old_wt * state.weighted + state.alpha * cur
+                state.weighted /= (state.old_wt + state.alpha)
+            state.old_wt = 1.
+    elif is_observation:
+        state.weighted = cur
+    if state.nobs >= minp:
+        return state.weighted
+    return NAN
+
+cdef inline void rolling_mean_add(RollingMeanState* state, double val) noexcept nogil:
+    cdef double y, t
+    if val != val:
+        return
+    state.nobs += 1
+    y = val - state.compensation_add
+    t = state.sum_x + y
+    state.compensation_add = t - state.sum_x - y
+    state.sum_x = t
+    if signbit(val):
+        state.neg_ct += 1
+    if val == state.prev_value:
+        state.num_consecutive_same_value += 1
+    else:
+        state.num_consecutive_same_value = 1
+    state.prev_value = val
+
+cdef inline void rolling_mean_remove(RollingMeanState* state, double val) noexcept nogil:
+    cdef double y, t
+    if val != val:
+        return
+    state.nobs -= 1
+    y = -val - state.compensation_remove
+    t = state.sum_x + y
+    state.compensation_remove = t - state.sum_x - y
+    state.sum_x = t
+    if signbit(val):
+        state.neg_ct -= 1
+
+cdef inline double rolling_mean_value(RollingMeanState* state, Py_ssize_t minp) noexcept nogil:
+    cdef double result
+    if state.nobs >= minp and state.nobs > 0:
+        result = state.sum_x / <double>state.nobs
+        if state.num_consecutive_same_value >= state.nobs:
+            result = state.prev_value
+        elif state.neg_ct == 0 and result < 0:
+            result = 0
+        elif state.neg_ct == state.nobs and result > 0:
+            result = 0
+        return result
+    return NAN
+
+cdef inline void rolling_var_add(RollingVarState* state, double val) noexcept nogil:
+    cdef double prev_mean, y, t
+    if val != val:
+        return
+    state.nobs = state.nobs + 1
+    if val == state.prev_value:
+        state.num_consecutive_same_value += 1
+    else:
+        state.num_consecutive_same_value = 1
+    state.prev_value = val
+    prev_mean = state.mean_x - state.compensation_add
+    y = val - state.compensation_add
+    t = y - state.mean_x
+    state.compensation_add = t + state.mean_x - y
+    if state.nobs:
+        state.mean_x = state.mean_x + t / state.nobs
+    else:
+        state.mean_x = 0
+    state.ssqdm_x = state.ssqdm_x + (val - prev_mean) * (val - state.mean_x)
+
+cdef inline void rolling_var_remove(RollingVarState* state, double val) noexcept nogil:
+    cdef double prev_mean, y, t
+    if val != val:
+        return
+    state.nobs = state.nobs - 1
+    if state.nobs:
+        prev_mean = state.mean_x - state.compensation_remove
+        y = val - state.compensation_remove
+        t = y - state.mean_x
+        state.compensation_remove = t + state.mean_x - y
+        state.mean_x = state.mean_x - t / state.nobs
+        state.ssqdm_x = state.ssqdm_x - (val - prev_mean) * (val - state.mean_x)
+    else:
+        state.mean_x = 0
+        state.ssqdm_x = 0
+
+cdef inline double rolling_var_value(RollingVarState* state, Py_ssize_t minp, int ddof) noexcept nogil:
+    if state.nobs >= minp and state.nobs > ddof:
+        if state.nobs == 1 or state.num_consecutive_same_value >= state.nobs:
+            return 0
+        return state.ssqdm_x / (state.nobs - <double>ddof)
+    return NAN
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef double pairwise_sum(const double* a, Py_ssize_t n) noexcept nogil:
+    """Same blocked pairwise summation numpy uses for float64 reductions."""
+    cdef Py_ssize_t i, n2
+    cdef double res
+    cdef double r[8]
+    if n < 8:
+        res = 0.
+        for i in range(n):
+            res += a[i]
+        return res
+    elif n <= 128:
+        for i in range(8):
+            r[i] = a[i]
+        i = 8
+        while i < n - (n % 8):
+            r[0] += a[i + 0]
+            r[1] += a[i + 1]
+            r[2] += a[i + 2]
+            r[3] += a[i + 3]
+            r[4] += a[i + 4]
+            r[5] += a[i + 5]
+            r[6] += a[i + 6]
+            r[7] += a[i + 7]
+            i += 8
+        res = ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]))
+        # do non multiple of 8 rest
+        while i < n:
+            res += a[i]
+            i += 1
+        return res
+    else:
+        n2 = n // 2
+        n2 -= n2 % 8
+        return pairwise_sum(a, n2) + pairwise_sum(a + n2, n - n2)
+
+cdef inline double numpy_sum(const double* a, Py_ssize_t n) noexcept nogil:
+    """Equivalent of ndarray.sum(): the first element seeds the reduction."""
+    if n <= 0:
+        return 0.
+    return a[0] + pairwise_sum(a + 1, n - 1)
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def sma(const DTYPE_t[::1] close, Py_ssize_t window):
+    """close.rolling(window).mean(); all NaN when window >= len(close)."""
+    cdef Py_ssize_t n = close.shape[0]
+    cdef Py_ssize_t i
+    cdef RollingMeanState state
+    cdef np.ndarray[DTYPE_t, ndim=1] result = np.empty(n, dtype=np.float64)
+    cdef double* out = <double*> result.data
+
+    if window < 1:
+        raise ValueError("window must be >= 1")
+    if window >= n:
+        result.fill(np.nan)
+        return result
+
+    with nogil:
+        state.sum_x = 0
+        state.compensation_add = 0
+        state.compensation_remove = 0
+        state.prev_value = close[0]
+        state.nobs = 0
+        state.neg_ct = 0
+        state.num_consecutive_same_value = 0
+        for i in range(n):
+            if i >= window:
+                rolling_mean_remove(&state, close[i - window])
+            rolling_mean_add(&state, close[i])
+            out[i] = rolling_mean_value(&state, window)
+    return result
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def ema(const DTYPE_t[::1] values, Py_ssize_t span, Py_ssize_t min_periods=0):
+    """values.ewm(span=span, min_periods=min_periods, adjust=False).mean()"""
+    cdef Py_ssize_t n = values.shape[0]
+    cdef Py_ssize_t i
+    cdef EwmState state
+    cdef np.ndarray[DTYPE_t, ndim=1] result = np.empty(n, dtype=np.float64)
+    cdef double* out = <double*> result.data
+    cdef Py_ssize_t minp = min_periods if min_periods > 1 else 1
+
+    if span < 1:
+        raise ValueError("span must satisfy: span >= 1")
+
+    with nogil:
+        ewm_init(&state, (span - 1) / 2.0)
+        for i in range(n):
+            out[i] = ewm_update(&state, values[i], minp)
+    return result
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def rsi(const DTYPE_t[::1] close, Py_ssize_t window=14):
+    """ta.momentum.rsi(close, window) computed in a single pass."""
+    cdef Py_ssize_t n = close.shape[0]
+    cdef Py_ssize_t i
+    cdef EwmState up_state, down_state
+    cdef double diff, up, down, emaup, emadn
+    cdef double alpha
+    cdef np.ndarray[DTYPE_t, ndim=1] result = np.empty(n, dtype=np.float64)
+    cdef double* out = <double*> result.data
+
+    if window < 1:
+        raise ValueError("window must be >= 1")
+
+    with nogil:
+        alpha = 1. / window
+        ewm_init(&up_state, (1 - alpha) / alpha)
+        ewm_init(&down_state, (1 - alpha) / alpha)
+        for i in range(n):
+            # close.diff(1) is NaN on the first bar, which where() maps to 0.0
+            if i == 0:
+                up = 0.0
+                down = -0.0
+            else:
+                diff = close[i] - close[i - 1]
+                up = diff if diff > 0 else 0.0
+                down = -(diff if diff < 0 else 0.0)
+            emaup = ewm_update(&up_state, up, window)
+            emadn = ewm_update(&down_state, down, window)
+            if emadn == 0:
+                out[i] = 100
+            else:
+                out[i] = 100 - (100 / (1 + emaup / emadn))
+    return result
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def macd(const DTYPE_t[::1] close, Py_ssize_t window_slow=26, Py_ssize_t window_fast=12, Py_ssize_t window_sign=9):
+    """ta.trend.macd and ta.trend.macd_signal computed together in a single pass."""
+    cdef Py_ssize_t n = close.shape[0]
+    cdef Py_ssize_t i
+    cdef EwmState fast_state, slow_state, sign_state
+    cdef double macd_value
+    cdef np.ndarray[DTYPE_t, ndim=1] macd_line = np.empty(n, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] macd_signal = np.empty(n, dtype=np.float64)
+    cdef double* line_out = <double*> macd_line.data
+    cdef double* signal_out = <double*> macd_signal.data
+
+    if window_slow < 1 or window_fast < 1 or window_sign < 1:
+        raise ValueError("MACD windows must be >= 1")
+
+    with nogil:
+        ewm_init(&fast_state, (window_fast - 1) / 2.0)
+        ewm_init(&slow_state, (window_slow - 1) / 2.0)
+        ewm_init(&sign_state, (window_sign - 1) / 2.0)
+        for i in range(n):
+            macd_value = ewm_update(&fast_state, close[i], window_fast) - ewm_update(&slow_state, close[i], window_slow)
+            line_out[i] = macd_value
+            signal_out[i] = ewm_update(&sign_state, macd_value, window_sign)
+    return macd_line, macd_signal
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def bbands(const DTYPE_t[::1] close, Py_ssize_t window=20, double window_dev=2):
+    """ta.volatility.BollingerBands mavg/hband/lband computed in a single pass."""
+    cdef Py_ssize_t n = close.shape[0]
+    cdef Py_ssize_t i
+    cdef RollingMeanState mean_state
+    cdef RollingVarState var_state
+    cdef double mavg, mstd, var
+    cdef np.ndarray[DTYPE_t, ndim=1] bb_mavg = np.empty(n, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] bb_hband = np.empty(n, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] bb_lband = np.empty(n, dtype=np.float64)
+    cdef double* mavg_out = <double*> bb_mavg.data
+    cdef double* hband_out = <double*> bb_hband.data
+    cdef double* lband_out = <double*> bb_lband.data
+
+    if window < 1:
+        raise ValueError("window must be >= 1")
+    if n == 0:
+        return bb_mavg, bb_hband, bb_lband
+
+    with nogil:
+        mean_state.sum_x = 0
+        mean_state.compensation_add = 0
+        mean_state.compensation_remove = 0
+        mean_state.prev_value = close[0]
+        mean_state.nobs = 0
+        mean_state.neg_ct = 0
+        mean_state.num_consecutive_same_value = 0
+        var_state.nobs = 0
+        var_state.mean_x = 0
+        var_state.ssqdm_x = 0
+        var_state.compensation_add = 0
+        var_state.compensation_remove = 0
+        var_state.prev_value = close[0]
+        var_state.num_consecutive_same_value = 0
+        for i in range(n):
+            if i >= window:
+                rolling_mean_remove(&mean_state, close[i - window])
+                rolling_var_remove(&var_state, close[i - window])
+            rolling_mean_add(&mean_state, close[i])
+            rolling_var_add(&var_state, close[i])
+            mavg = rolling_mean_value(&mean_state, window)
+            var = rolling_var_value(&var_state, window, 0)
+            mstd = sqrt(fmax(var, 0.0)) if var == var else NAN
+            mavg_out[i] = mavg
+            hband_out[i] = mavg + window_dev * mstd
+            lband_out[i] = mavg - window_dev * mstd
+    return bb_mavg, bb_hband, bb_lband
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def atr(const DTYPE_t[::1] high, const DTYPE_t[::1] low, const DTYPE_t[::1] close, Py_ssize_t window=14):
+    """ta.volatility.average_true_range; the first window - 1 values are 0 like ta."""
+    cdef Py_ssize_t n = close.shape[0]
+    cdef Py_ssize_t i
+    cdef np.ndarray[DTYPE_t, ndim=1] result = np.zeros(n, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] true_range = np.empty(n, dtype=np.float64)
+    cdef double* out = <double*> result.data
+    cdef double* tr = <double*> true_range.data
+
+    if high.shape[0] != n or low.shape[0] != n:
+        raise ValueError("high, low and close must have the same length")
+    if window < 1 or window > n:
+        raise ValueError("window must satisfy 1 <= window <= len(close)")
+
+    with nogil:
+        tr[0] = high[0] - low[0]
+        for i in range(1, n):
+            tr[i] = fmax(high[i] - low[i], fmax(fabs(high[i] - close[i - 1]), fabs(low[i] - close[i - 1])))
+        out[window - 1] = numpy_sum(tr, window) / window
+        for i in range(window, n):
+            out[i] = (out[i - 1] * (window - 1) + tr[i]) / <double>window
+    return result
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def adx(const DTYPE_t[::1] high, const DTYPE_t[::1] low, const DTYPE_t[::1] close, Py_ssize_t window=14):
+    """ta.trend.ADXIndicator adx/adx_pos/adx_neg, sharing the smoothed sums between the three."""
+    cdef Py_ssize_t n = close.shape[0]
+    cdef Py_ssize_t length, i, seed
+    cdef double diff_up, diff_down
+    cdef double dip_i, din_i
+
+    if high.shape[0] != n or low.shape[0] != n:
+        raise ValueError("high, low and close must have the same length")
+    if window < 1 or window > n:
+        raise ValueError("window must satisfy 1 <= window <= len(close)")
+
+    length = n - (window - 1)
+    cdef np.ndarray[DTYPE_t, ndim=1] adx_out = np.zeros(n, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] pdi_out = np.zeros(n, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] ndi_out = np.zeros(n, dtype=np.float64)
+    # Directional movement and true range per bar; index 0 is undefined (no previous close)
+    cdef np.ndarray[DTYPE_t, ndim=1] dm_arr = np.zeros(n, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] pos_arr = np.zeros(n, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] neg_arr = np.zeros(n, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] trs_arr = np.zeros(length, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] dip_arr = np.zeros(length, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] din_arr = np.zeros(length, dtype=np.float64)
+    cdef np.ndarray[DTYPE_t, ndim=1] di_arr = np.zeros(length, dtype=np.float64)
+    cdef double* dm = <double*> dm_arr.data
+    cdef double* pos = <double*> pos_arr.data
+    cdef double* neg = <double*> neg_arr.data
+    cdef double* trs = <double*> trs_arr.data
+    cdef double* dip = <double*> dip_arr.data
+    cdef double* din = <double*> din_arr.data
+    cdef double* di = <double*> di_arr.data
+    cdef double* adx_ptr = <double*> adx_out.data
+    cdef double* pdi_ptr = <double*> pdi_out.data
+    cdef double* ndi_ptr = <double*> ndi_out.data
+
+    with nogil:
+        for i in range(1, n):
+            dm[i] = fmax(high[i], close[i - 1]) - fmin(low[i], close[i - 1])
+            diff_up = high[i] - high[i - 1]
+            diff_down = low[i - 1] - low[i]
+            pos[i] = fabs(diff_up) if (diff_up > diff_down and diff_up > 0) else 0.0
+            neg[i] = fabs(diff_down) if (diff_down > diff_up and diff_down > 0) else 0.0
+
+        # ta seeds each smoothed series with the sum of the first `window` defined values
+        seed = window if window < n - 1 else n - 1
+        trs[0] = numpy_sum(dm + 1, seed)
+        dip[0] = numpy_sum(pos + 1, seed)
+        din[0] = numpy_sum(neg + 1, seed)
+        for i in range(1, length - 1):
+            trs[i] = trs[i - 1] - (trs[i - 1] / <double>window) + dm[window + i]
+            dip[i] = dip[i - 1] - (dip[i - 1] / <double>window) + pos[window + i]
+            din[i] = din[i - 1] - (din[i - 1] / <double>window) + neg[window + i]
+
+        for i in range(length):
+            dip_i = 100 * (dip[i] / trs[i])
+            din_i = 100 * (din[i] / trs[i])
+            di[i] = 100 * fabs((dip_i - din_i) / (dip_i + din_i))
+
+        seed = window if window < length else length
+        adx_ptr[window - 1] = numpy_sum(di, seed) / seed
+        for i in range(1, length):
+            adx_ptr[window - 1 + i] = ((adx_ptr[window - 2 + i] * (window - 1)) + di[i - 1]) / <double>window
+
+        for i in range(1, length - 1):
+            pdi_ptr[i + window] = 100 * (dip[i] / trs[i])
+            ndi_ptr[i + window] = 100 * (din[i] / trs[i])
+
+    return adx_out, pdi_out, ndi_out
@@ -1,61 +1,80 @@
+import numpy as np
 import pandas as pd
 from scipy.stats import linregress
-from itertools import combinations
 
-def find_swing_points(df, percentage_change=0.05, min_bars_confirmation=2):
-    swing_highs = []
-    swing_lows = []
+try:
+    import lines_cython
+    NATIVE_LINES_AVAILABLE = True
+except ImportError:
+    lines_cython = None
+    NATIVE_LINES_AVAILABLE = False
+
+def _sweep_swing_points_python(prices, percentages, min_bars_confirmation):
+    """Pure Python version of lines_cython.sweep_swing_points, run one threshold at a time on plain floats."""
+    values = prices.tolist()
+    n = len(values)
+    high_indices = np.zeros((len(percentages), n), dtype=np.int64)
+    low_indices = np.zeros((len(percentages), n), dtype=np.int64)
+    high_counts = np.zeros(len(percentages), dtype=np.int64)
+    low_counts = np.zeros(len(percentages), dtype=np.int64)
+    if n < min_bars_confirmation + 2:
+        return high_indices[:, :0], high_counts, low_indices[:, :0], low_counts
+
+    for p, percentage_change in enumerate(percentages.tolist()):
+        highs, lows = [], []
+        last_index = 0
+        current_trend = None  # 'up' or 'down'
+        for i in range(1, n):
+            price = values[i]
+            last_price = values[last_index]
+            if current_trend is None:
+                # Determine initial trend
+                if price > last_price * (1 + percentage_change):
+                    current_trend = 'up'
+                elif price < last_price * (1 - percentage_change):
+                    current_trend = 'down'
+            elif current_trend == 'up':
+                if price < last_price * (1 - percentage_change):
+                    # Potential trend reversal: the next bars must keep falling
+                    if i + min_bars_confirmation < n and all(values[i + j] < price for j in range(1, min_bars_confirmation + 1)):
+                        highs.append(last_index)
+                        last_index = i
+                        current_trend = 'down'
+                elif price > last_price:
+                    last_index = i
+            else:
+                if price > last_price * (1 + percentage_change):
+                    # Potential trend reversal: the next bars must keep rising
+                    if i + min_bars_confirmation < n and all(values[i + j] > price for j in range(1, min_bars_confirmation + 1)):
+                        lows.append(last_index)
+                        last_index = i
+                        current_trend = 'up'
+                elif price < last_price:
+                    last_index = i
+        high_indices[p, :len(highs)] = highs
+        low_indices[p, :len(lows)] = lows
+        high_counts[p] = len(highs)
+        low_counts[p] = len(lows)
+    return high_indices, high_counts, low_indices, low_counts
+
+def sweep_swing_points(prices, percentages, min_bars_confirmation=2):
+    """
+    Swing detection for several percentage thresholds in one call. Returns, per
+    threshold, the (swing_high_bars, swing_low_bars) integer index arrays.
+    """
+    prices = np.ascontiguousarray(prices, dtype=np.float64)
+    percentages = np.ascontiguousarray(percentages, dtype=np.float64)
+    sweep = lines_cython.sweep_swing_points if NATIVE_LINES_AVAILABLE else _sweep_swing_points_python
+    high_indices, high_counts, low_indices, low_counts = sweep(prices, percentages, int(min_bars_confirmation))
+    return [(high_indices[p, :high_counts[p]], low_indices[p, :low_counts[p]]) for p in range(len(percentages))]
 
+def find_swing_points(df, percentage_change=0.05, min_bars_confirmation=2):
     if len(df) < min_bars_confirmation + 2:
-        return pd.DataFrame(swing_highs), pd.DataFrame(swing_lows)
-
-    # Initialize with the first point
-    last_swing_point = df.iloc[0]
-    current_trend = None  # 'up' or 'down'
-
-    for i in range(1, len(df)):
-        current_price = df.iloc[i]
-
-        if current_trend is None:
-            # Determine initial trend
-            if current_price['price'] > last_swing_point['price'] * (1 + percentage_change):
-                current_trend = 'up'
-            elif current_price['price'] < last_swing_point['price'] * (1 - percentage_change):
-                current_trend = 'down'
-
-        elif current_trend == 'up':
-            if current_price['price'] < last_swing_point['price'] * (1 - percentage_change):
-                # Potential trend reversal: check for confirmation
-                confirmed = True
-                for j in range(1, min_bars_confirmation + 1):
-                    if (i + j) >= len(df) or df.iloc[i + j]['price'] >= current_price['price']:
-                        confirmed = False
-                        break
-                if confirmed:
-                    swing_highs.append(last_swing_point)
-                    last_swing_point = current_price
-                    current_trend = 'down'
-            elif current_price['price'] > last_swing_point['price']:
-                # Continue up trend, update last swing point if higher
-                last_swing_point = current_price
-
-        elif current_trend == 'down':
-            if current_price['price'] > last_swing_point['price'] * (1 + percentage_change):
-                # Potential trend reversal: check for confirmation
-                confirmed = True
-                for j in range(1, min_bars_confirmation + 1):
-                    if (i + j) >= len(df) or df.iloc[i + j]['price'] <= current_price['price']:
-                        confirmed = False
-                        break
-                if confirmed:
-                    swing_lows.append(last_swing_point)
-                    last_swing_point = current_price
-                    current_trend = 'up'
-            elif current_price['price'] < last_swing_point['price']:
-                # Continue down trend, update last swing point if lower
-                last_swing_point = current_price
+        return pd.DataFrame([]), pd.DataFrame([])
 
-    return pd.DataFrame(swing_highs).reset_index(), pd.DataFrame(swing_lows).reset_index()
+    (high_bars, low_bars), = sweep_swing_points(df['price'].to_numpy(dtype=np.float64), [percentage_change], min_bars_confirmation)
+    # Same layout as before: the bar timestamps in an 'index' first column, then the df columns
+    return df.iloc[high_bars].rename_axis(None).reset_index(), df.iloc[low_bars].rename_axis(None).reset_index()
 
 def calculate_line_equation(points, first_timestamp):
     if len(points) < 2:
@@ -68,25 +87,56 @@ def calculate_line_equation(points, first_timestamp):
     slope, intercept, r_value, p_value, std_err = linregress(x, y)
     return slope, intercept, r_value, std_err
 
+def _relative_seconds(timestamps, first_timestamp):
+    """Seconds from first_timestamp, as Timedelta.total_seconds() computes them."""
+    return np.asarray((pd.DatetimeIndex(timestamps) - first_timestamp).total_seconds(), dtype=np.float64)
+
+def fit_point_pairs(x, y):
+    """
+    Least-squares lines through every pair of points, in itertools.combinations order.
+    Returns (first, second, slope, intercept, r_value) arrays using linregress's
+    formulas; pairs sharing the same x (which linregress rejects) are left out.
+    """
+    first, second = np.triu_indices(len(x), 1)
+    x_a, x_b, y_a, y_b = x[first], x[second], y[first], y[second]
+    x_mean = (x_a + x_b) / 2
+    y_mean = (y_a + y_b) / 2
+    dx_a, dx_b, dy_a, dy_b = x_a - x_mean, x_b - x_mean, y_a - y_mean, y_b - y_mean
+    ssxm = (dx_a * dx_a + dx_b * dx_b) / 2
+    ssym = (dy_a * dy_a + dy_b * dy_b) / 2
+    ssxym = (dx_a * dy_a + dx_b * dy_b) / 2
+
+    valid = ssxm != 0
+    first, second, ssxm, ssym, ssxym, x_mean, y_mean = (
+        values[valid] for values in (first, second, ssxm, ssym, ssxym, x_mean, y_mean))
+    r_den = np.sqrt(ssxm * ssym)
+    with np.errstate(divide='ignore', invalid='ignore'):
+        r_value = np.where(r_den == 0, 0.0, np.clip(ssxym / r_den, -1.0, 1.0))
+    slope = ssxym / ssxm
+    intercept = y_mean - slope * x_mean
+    return first, second, slope, intercept, r_value
+
 def find_support_resistance_lines(swing_points_df, line_type, first_timestamp):
     lines = []
-    # Consider combinations of 2 points
-    for num_points in [2]:
-        for combo in combinations(swing_points_df.itertuples(index=False), num_points):
-            # Convert namedtuple to dictionary for calculate_line_equation
-            points = [{'timestamp': p[0], 'price': p.price} for p in combo]
-            slope, intercept, r_value, std_err = calculate_line_equation(points, first_timestamp)
-
-            if slope is not None:
-                lines.append({
-                    'type': line_type,
-                    'points': [p[0] for p in combo],
-                    'equation': f"y = {slope:.6f}x + {intercept:.2f}",
-                    'slope': slope,
-                    'intercept': intercept,
-                    'r_value': r_value,
-                    'std_err': std_err
-                })
+    if len(swing_points_df) < 2:
+        return lines
+    # Lines through every combination of 2 swing points
+    timestamps = swing_points_df.iloc[:, 0]
+    x = _relative_seconds(timestamps, first_timestamp)
+    y = swing_points_df['price'].to_numpy(dtype=np.float64)
+    first, second, slope, intercept, r_value = fit_point_pairs(x, y)
+    points = timestamps.tolist()
+    for a, b, line_slope, line_intercept, line_r in zip(first.tolist(), second.tolist(), slope.tolist(),
+                                                        intercept.tolist(), r_value.tolist()):
+        lines.append({
+            'type': line_type,
+            'points': [points[a], points[b]],
+            'equation': f"y = {line_slope:.6f}x + {line_intercept:.2f}",
+            'slope': line_slope,
+            'intercept': line_intercept,
+            'r_value': line_r,
+            'std_err': 0.0 # Exact fit through 2 points (linregress also reports 0)
+        })
     return lines
 
 def analyze_line_durations(df, resistance_lines, support_lines, first_timestamp):
@@ -307,34 +357,37 @@ def auto_discover_percentage_change(df, first_timestamp, min_percent=0.001, max_
     best_percentage = None
     best_score = -1
 
-    for pc in [i / 1000 for i in range(int(min_percent * 1000), int(max_percent * 1000) + int(step * 1000), int(step * 1000))]:
-        swing_highs_df, swing_lows_df = find_swing_points(df, percentage_change=pc)
+    percentages = [i / 1000 for i in range(int(min_percent * 1000), int(max_percent * 1000) + int(step * 1000), int(step * 1000))]
+    prices = df['price'].to_numpy(dtype=np.float64)
+    x = _relative_seconds(df.index, first_timestamp)
 
-        if not swing_highs_df.empty and not swing_lows_df.empty:
-            resistance_lines = find_support_resistance_lines(swing_highs_df, 'resistance', first_timestamp)
-            support_lines = find_support_resistance_lines(swing_lows_df, 'support', first_timestamp)
+    # All thresholds are swept in one pass; only the |r| of each candidate line is needed for scoring
+    for pc, (high_bars, low_bars) in zip(percentages, sweep_swing_points(prices, percentages)):
+        if len(high_bars) < 2 or len(low_bars) < 2:
+            continue
+        resistance_r = fit_point_pairs(x[high_bars], prices[high_bars])[4]
+        support_r = fit_point_pairs(x[low_bars], prices[low_bars])[4]
 
-            if resistance_lines and support_lines:
-                total_r_value = 0
-                for line in resistance_lines + support_lines:
-                    total_r_value += abs(line['r_value'])
-                
-                avg_r_value = total_r_value / (len(resistance_lines) + len(support_lines))
-                
-                num_lines = len(resistance_lines) + len(support_lines)
-                
-                line_penalty = 0
-                if num_lines > 20: # If more than 20 lines, start penalizing
-                    line_penalty = (num_lines - 20) * 0.1 # Penalty per line
+        if len(resistance_r) and len(support_r):
+            total_r_value = 0
+            for r_value in np.abs(np.concatenate([resistance_r, support_r])).tolist():
+                total_r_value += r_value
+
+            num_lines = len(resistance_r) + len(support_r)
+            avg_r_value = total_r_value / num_lines
+
+            line_penalty = 0
+            if num_lines > 20: # If more than 20 lines, start penalizing
+                line_penalty = (num_lines - 20) * 0.1 # Penalty per line
 
-                line_count_reward = 0
-                if 2 <= num_lines <= 20:
-                    line_count_reward = 0.2 # Reward for being in the sweet spot
+            line_count_reward = 0
+            if 2 <= num_lines <= 20:
+                line_count_reward = 0.2 # Reward for being in the sweet spot
 
-                score = avg_r_value + line_count_reward - line_penalty
+            score = avg_r_value + line_count_reward - line_penalty
 
-                if score > best_score:
-                    best_score = score
-                    best_percentage = pc
+            if score > best_score:
+                best_score = score
+                best_percentage = pc
 
     return best_percentage
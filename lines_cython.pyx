@@ -0,0 +1,90 @@
+"""
+Native swing-point detection for lines.py.
+
+sweep_swing_points runs the find_swing_points state machine for many percentage
+thresholds at once, in a single pass over a contiguous float64 price array, and
+returns the bar indices of the confirmed swing highs and lows of every threshold.
+"""
+import numpy as np
+cimport numpy as np
+cimport cython
+
+ctypedef np.float64_t DTYPE_t
+ctypedef np.int64_t INDEX_t
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef inline bint confirmed_reversal(const DTYPE_t[::1] prices, Py_ssize_t i, Py_ssize_t n,
+                                    Py_ssize_t min_bars_confirmation, int direction) noexcept nogil:
+    """The min_bars_confirmation bars after i keep moving in direction (False if they run past the end)."""
+    cdef Py_ssize_t j
+    for j in range(1, min_bars_confirmation + 1):
+        if i + j >= n:
+            return 0
+        if direction < 0 and prices[i + j] >= prices[i]:
+            return 0
+        if direction > 0 and prices[i + j] <= prices[i]:
+            return 0
+    return 1
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def sweep_swing_points(const DTYPE_t[::1] prices, const DTYPE_t[::1] percentages, Py_ssize_t min_bars_confirmation):
+    """
+    Returns (high_indices, high_counts, low_indices, low_counts): row p of the (P, n)
+    index matrices holds, in its first counts[p] entries, the bars of the swing highs
+    (lows) find_swing_points detects with percentage_change=percentages[p].
+    """
+    cdef Py_ssize_t n = prices.shape[0]
+    cdef Py_ssize_t n_percentages = percentages.shape[0]
+    cdef Py_ssize_t i, p
+    cdef double price, last_price
+
+    high_indices = np.zeros((n_percentages, n), dtype=np.int64)
+    low_indices = np.zeros((n_percentages, n), dtype=np.int64)
+    high_counts = np.zeros(n_percentages, dtype=np.int64)
+    low_counts = np.zeros(n_percentages, dtype=np.int64)
+    if n < min_bars_confirmation + 2:
+        return high_indices[:, :0], high_counts, low_indices[:, :0], low_counts
+
+    cdef INDEX_t[:, ::1] highs = high_indices
+    cdef INDEX_t[:, ::1] lows = low_indices
+    cdef INDEX_t[::1] n_highs = high_counts
+    cdef INDEX_t[::1] n_lows = low_counts
+    # Per threshold: bar of the last swing point candidate and trend (0 undetermined, 1 up, -1 down)
+    last = np.zeros(n_percentages, dtype=np.int64)
+    trend = np.zeros(n_percentages, dtype=np.int8)
+    cdef INDEX_t[::1] last_index = last
+    cdef np.int8_t[::1] current_trend = trend
+
+    with nogil:
+        for i in range(1, n):
+            price = prices[i]
+            for p in range(n_percentages):
+                last_price = prices[last_index[p]]
+                if current_trend[p] == 0:
+                    # Determine initial trend
+                    if price > last_price * (1 + percentages[p]):
+                        current_trend[p] = 1
+                    elif price < last_price * (1 - percentages[p]):
+                        current_trend[p] = -1
+                elif current_trend[p] == 1:
+                    if price < last_price * (1 - percentages[p]):
+                        if confirmed_reversal(prices, i, n, min_bars_confirmation, -1):
+                            highs[p, n_highs[p]] = last_index[p]
+                            n_highs[p] += 1
+                            last_index[p] = i
+                            current_trend[p] = -1
+                    elif price > last_price:
+                        last_index[p] = i
+                else:
+                    if price > last_price * (1 + percentages[p]):
+                        if confirmed_reversal(prices, i, n, min_bars_confirmation, 1):
+                            lows[p, n_lows[p]] = last_index[p]
+                            n_lows[p] += 1
+                            last_index[p] = i
+                            current_trend[p] = 1
+                    elif price < last_price:
+                        last_index[p] = i
+
+    return high_indices, high_counts, low_indices, low_counts
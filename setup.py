@@ -1,8 +1,40 @@
-from setuptools import setup
+import sys
+from setuptools import setup, Extension
 from Cython.Build import cythonize
 import numpy # Import numpy
 
+# OpenMP lets run_backtest_batch_cython spread candidates across cores.
+# Apple clang ships without it, so the batch kernel runs serially there.
+openmp_args = [] if sys.platform == "darwin" else ["-fopenmp"]
+
+extensions = [
+    Extension(
+        "backtester_cython",
+        ["backtester_cython.pyx"],
+        include_dirs=[numpy.get_include()],
+        extra_compile_args=openmp_args,
+        extra_link_args=openmp_args,
+    ),
+    # No FMA contraction, so the rolling/ewm recurrences round exactly like pandas and ta.
+    Extension(
+        "indicators_cython",
+        ["indicators_cython.pyx"],
+        include_dirs=[numpy.get_include()],
+        extra_compile_args=[] if sys.platform == "win32" else ["-ffp-contract=off"],
+    ),
+    Extension(
+        "signals_cython",
+        ["signals_cython.pyx"],
+        include_dirs=[numpy.get_include()],
+    ),
+    Extension(
+        "lines_cython",
+        ["lines_cython.pyx"],
+        include_dirs=[numpy.get_include()],
+    ),
+]
+
 setup(
-    ext_modules = cythonize("backtester_cython.pyx", compiler_directives={'language_level': "3"}),
+    ext_modules = cythonize(extensions, compiler_directives={'language_level': "3"}),
     include_dirs=[numpy.get_include()] # Add numpy include directory
-)
\ No newline at end of file
+)
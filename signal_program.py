@@ -0,0 +1,224 @@
+"""
+Strategy configurations compiled into signal programs.
+
+A strategy's four signal lists (long_entry, short_entry, long_exit, short_exit) are
+resolved once into clauses over a fixed table of base signals: every output is the
+AND of its clauses and every clause the OR of its base signals (the all_*_or meta
+signals expand into multi-signal clauses). The program is then evaluated for all
+four outputs in a single pass over the bars by signals_cython, or by the numpy
+fallback when the extension is not built. Name resolution, required-indicator
+detection and the Combined_Trigger_Verifier fallbacks happen at compile time only.
+"""
+
+import logging
+from collections import namedtuple
+
+import numpy as np
+
+from config import strategy_configs
+
+try:
+    import signals_cython
+    NATIVE_SIGNALS_AVAILABLE = True
+except ImportError:
+    signals_cython = None
+    NATIVE_SIGNALS_AVAILABLE = False
+
+SIGNAL_KEYS = ('long_entry', 'short_entry', 'long_exit', 'short_exit')
+
+# Rows of the series matrix handed to the evaluator (same order as signals_cython)
+SERIES = ('close', 'high', 'low', 'short_sma', 'long_sma', 'short_ema', 'long_ema', 'rsi',
+          'macd_line', 'macd_signal', 'bb_hband', 'bb_lband', 'bb_mavg', 'adx', 'pdi', 'ndi')
+SERIES_INDEX = {name: row for row, name in enumerate(SERIES)}
+
+# Entries of the thresholds vector handed to the evaluator
+THRESHOLDS = ('rsi_overbought', 'rsi_oversold', 'adx_threshold')
+
+# Base signals by opcode (same order as signals_cython): (name, indicator it needs)
+BASE_SIGNALS = (
+    ('sma_crossover', 'sma'),
+    ('sma_crossunder', 'sma'),
+    ('ema_crossover', 'ema'),
+    ('ema_crossunder', 'ema'),
+    ('rsi_is_not_overbought', 'rsi'),
+    ('rsi_is_not_oversold', 'rsi'),
+    ('rsi_is_overbought', 'rsi'),
+    ('rsi_is_oversold', 'rsi'),
+    ('macd_is_bullish', 'macd'),
+    ('macd_is_bearish', 'macd'),
+    ('price_breaks_upper_band', 'bbands'),
+    ('price_breaks_lower_band', 'bbands'),
+    ('price_crosses_middle_band_from_top', 'bbands'),
+    ('price_crosses_middle_band_from_bottom', 'bbands'),
+    ('adx_uptrend_confirmed', 'adx'),
+    ('adx_downtrend_confirmed', 'adx'),
+)
+BASE_SIGNAL_OPCODES = {name: opcode for opcode, (name, _) in enumerate(BASE_SIGNALS)}
+BASE_SIGNAL_INDICATORS = dict(BASE_SIGNALS)
+
+# Meta signals: (indicators they pull in, of which at least one computed makes the signal exist; OR-ed base signals)
+META_SIGNALS = {
+    'all_triggers_long_or': (('sma', 'ema', 'bbands'),
+                             ('sma_crossover', 'ema_crossover', 'price_breaks_upper_band', 'price_crosses_middle_band_from_bottom')),
+    'all_triggers_short_or': (('sma', 'ema', 'bbands'),
+                              ('sma_crossunder', 'ema_crossunder', 'price_breaks_lower_band', 'price_crosses_middle_band_from_top')),
+    'all_verificators_long_or': (('rsi',), ('rsi_is_not_overbought',)),
+    'all_verificators_short_or': (('rsi',), ('rsi_is_not_oversold',)),
+    'all_exits_long_or': (('sma', 'ema', 'bbands', 'rsi'),
+                          ('sma_crossunder', 'ema_crossunder', 'price_crosses_middle_band_from_top', 'rsi_is_overbought')),
+    'all_exits_short_or': (('sma', 'ema', 'bbands', 'rsi'),
+                           ('sma_crossover', 'ema_crossover', 'price_crosses_middle_band_from_bottom', 'rsi_is_oversold')),
+}
+
+# clauses: per output, a tuple of clauses, each a tuple of base signal names (an empty clause is always False).
+# opcodes/clause_offsets/output_offsets: the same clauses flattened into int32 arrays for the kernel.
+CompiledStrategy = namedtuple('CompiledStrategy', ['required_indicators', 'clauses', 'opcodes', 'clause_offsets', 'output_offsets'])
+
+def required_indicators_for(strategy_config):
+    """Determines which indicators are required based on the strategy configuration."""
+    required_indicators = set()
+    for key in SIGNAL_KEYS:
+        for signal_name in strategy_config.get(key, []):
+            if signal_name in META_SIGNALS:
+                required_indicators.update(META_SIGNALS[signal_name][0])
+            elif 'sma' in signal_name:
+                required_indicators.add('sma')
+            elif 'ema' in signal_name:
+                required_indicators.add('ema')
+            elif 'rsi' in signal_name:
+                required_indicators.add('rsi')
+            elif 'macd' in signal_name:
+                required_indicators.add('macd')
+            elif 'band' in signal_name: # For Bollinger Bands
+                required_indicators.add('bbands')
+            elif 'adx' in signal_name: # For ADX
+                required_indicators.add('adx')
+    return required_indicators
+
+def _compile_clause(name, required_indicators, is_combined_strategy):
+    """Returns the clause for one configured signal name, or None when the name is skipped."""
+    if name in BASE_SIGNAL_INDICATORS:
+        if BASE_SIGNAL_INDICATORS[name] in required_indicators:
+            return (name,)
+    elif name in META_SIGNALS:
+        groups, operands = META_SIGNALS[name]
+        if required_indicators.intersection(groups):
+            return tuple(operand for operand in operands if BASE_SIGNAL_INDICATORS[operand] in required_indicators)
+        if is_combined_strategy:
+            return ()  # A missing combined signal counts as False for Combined_Trigger_Verifier
+        logging.warning(f"Signal '{name}' not found in base_signals and not handled as a combined signal for Combined_Trigger_Verifier.")
+        return None
+    logging.warning(f"Signal '{name}' not found in base_signals. This might indicate a misconfiguration in strategy_config or missing indicator calculation.")
+    return None
+
+def _compile(signal_lists, is_combined_strategy):
+    strategy_config = dict(zip(SIGNAL_KEYS, signal_lists))
+    required_indicators = frozenset(required_indicators_for(strategy_config))
+    clauses = []
+    for names in signal_lists:
+        output = [_compile_clause(name, required_indicators, is_combined_strategy) for name in names]
+        clauses.append(tuple(clause for clause in output if clause is not None))
+
+    opcodes, clause_offsets, output_offsets = [], [0], [0]
+    for output in clauses:
+        for clause in output:
+            opcodes.extend(BASE_SIGNAL_OPCODES[name] for name in clause)
+            clause_offsets.append(len(opcodes))
+        output_offsets.append(len(clause_offsets) - 1)
+    return CompiledStrategy(required_indicators, tuple(clauses),
+                            np.array(opcodes, dtype=np.int32),
+                            np.array(clause_offsets, dtype=np.int32),
+                            np.array(output_offsets, dtype=np.int32))
+
+_compiled_cache = {}
+
+def compile_strategy(strategy_config):
+    """Returns the (memoized) compiled program of a strategy configuration."""
+    signal_lists = tuple(tuple(strategy_config.get(key, ())) for key in SIGNAL_KEYS)
+    is_combined_strategy = 'Combined_Trigger_Verifier' in strategy_config.values()
+    key = (signal_lists, is_combined_strategy)
+    compiled = _compiled_cache.get(key)
+    if compiled is None:
+        compiled = _compile(signal_lists, is_combined_strategy)
+        _compiled_cache[key] = compiled
+    return compiled
+
+# Every configured strategy is compiled once at import
+COMPILED_STRATEGIES = {name: compile_strategy(config) for name, config in strategy_configs.items()}
+
+def _shift(values):
+    """numpy equivalent of Series.shift(1): the first element becomes NaN."""
+    shifted = np.empty(len(values), dtype=np.float64)
+    shifted[:1] = np.nan
+    shifted[1:] = values[:-1]
+    return shifted
+
+def _base_signal_numpy(name, series, thresholds):
+    """Vectorized evaluation of one base signal over all bars."""
+    row = lambda series_name: series[SERIES_INDEX[series_name]]
+    crosses_above = lambda a, b: (_shift(row(a)) < _shift(row(b))) & (row(a) > row(b))
+    rsi_overbought, rsi_oversold, adx_threshold = thresholds
+    if name == 'sma_crossover':
+        return crosses_above('short_sma', 'long_sma')
+    if name == 'sma_crossunder':
+        return crosses_above('long_sma', 'short_sma')
+    if name == 'ema_crossover':
+        return crosses_above('short_ema', 'long_ema')
+    if name == 'ema_crossunder':
+        return crosses_above('long_ema', 'short_ema')
+    if name == 'rsi_is_not_overbought':
+        return row('rsi') < rsi_overbought
+    if name == 'rsi_is_not_oversold':
+        return row('rsi') > rsi_oversold
+    if name == 'rsi_is_overbought':
+        return row('rsi') > rsi_overbought
+    if name == 'rsi_is_oversold':
+        return row('rsi') < rsi_oversold
+    if name == 'macd_is_bullish':
+        return row('macd_line') > row('macd_signal')
+    if name == 'macd_is_bearish':
+        return row('macd_line') < row('macd_signal')
+    if name == 'price_breaks_upper_band':
+        return row('high') > row('bb_hband')
+    if name == 'price_breaks_lower_band':
+        return row('low') < row('bb_lband')
+    if name == 'price_crosses_middle_band_from_top':
+        return (_shift(row('close')) > _shift(row('bb_mavg'))) & (row('close') <= row('bb_mavg'))
+    if name == 'price_crosses_middle_band_from_bottom':
+        return (_shift(row('close')) < _shift(row('bb_mavg'))) & (row('close') >= row('bb_mavg'))
+    if name == 'adx_uptrend_confirmed':
+        return crosses_above('pdi', 'ndi') & (row('adx') > adx_threshold)
+    if name == 'adx_downtrend_confirmed':
+        return crosses_above('ndi', 'pdi') & (row('adx') > adx_threshold)
+    raise KeyError(name)
+
+def evaluate_numpy(compiled, series, thresholds):
+    """Reference evaluation of a compiled program with numpy, used when signals_cython is not built."""
+    n = series.shape[1]
+    masks = np.zeros((len(SIGNAL_KEYS), n), dtype=np.uint8)
+    base = {}
+    for output, clauses in enumerate(compiled.clauses):
+        if not clauses:
+            continue
+        result = np.ones(n, dtype=bool)
+        for clause in clauses:
+            hit = np.zeros(n, dtype=bool)
+            for name in clause:
+                if name not in base:
+                    base[name] = _base_signal_numpy(name, series, thresholds)
+                hit |= base[name]
+            result &= hit
+        masks[output] = result
+    return masks
+
+def evaluate(compiled, series, thresholds):
+    """
+    Evaluates a compiled program on a (len(SERIES), n) float64 matrix and returns the
+    (4, n) uint8 masks of long_entry, short_entry, long_exit and short_exit. Only the
+    rows of the required indicators need to be filled.
+    """
+    thresholds = np.asarray(thresholds, dtype=np.float64)
+    if NATIVE_SIGNALS_AVAILABLE:
+        return signals_cython.evaluate_program(np.ascontiguousarray(series, dtype=np.float64), thresholds,
+                                               compiled.opcodes, compiled.clause_offsets, compiled.output_offsets)
+    return evaluate_numpy(compiled, series, thresholds)
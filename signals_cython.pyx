@@ -0,0 +1,158 @@
+"""
+Native evaluator of the signal programs built by signal_program.py.
+
+A program lists, for each of the four outputs (long_entry, short_entry, long_exit,
+short_exit), clauses of base-signal opcodes: an output is the AND of its clauses and
+a clause the OR of its opcodes. All four outputs are produced in one pass over the
+bars, straight from the indicator series, without intermediate boolean arrays.
+NaN operands compare False, like the numpy expressions they replace.
+"""
+import numpy as np
+cimport numpy as np
+cimport cython
+
+ctypedef np.float64_t DTYPE_t
+ctypedef np.uint8_t UBYTE_t
+
+# Rows of the series matrix (must match signal_program.SERIES)
+cdef enum:
+    S_CLOSE = 0
+    S_HIGH = 1
+    S_LOW = 2
+    S_SHORT_SMA = 3
+    S_LONG_SMA = 4
+    S_SHORT_EMA = 5
+    S_LONG_EMA = 6
+    S_RSI = 7
+    S_MACD_LINE = 8
+    S_MACD_SIGNAL = 9
+    S_BB_HBAND = 10
+    S_BB_LBAND = 11
+    S_BB_MAVG = 12
+    S_ADX = 13
+    S_PDI = 14
+    S_NDI = 15
+    N_SERIES = 16
+
+# Entries of the thresholds vector (must match signal_program.THRESHOLDS)
+cdef enum:
+    T_RSI_OVERBOUGHT = 0
+    T_RSI_OVERSOLD = 1
+    T_ADX_THRESHOLD = 2
+    N_THRESHOLDS = 3
+
+# Base signal opcodes (must match signal_program.BASE_SIGNALS)
+cdef enum:
+    OP_SMA_CROSSOVER = 0
+    OP_SMA_CROSSUNDER = 1
+    OP_EMA_CROSSOVER = 2
+    OP_EMA_CROSSUNDER = 3
+    OP_RSI_IS_NOT_OVERBOUGHT = 4
+    OP_RSI_IS_NOT_OVERSOLD = 5
+    OP_RSI_IS_OVERBOUGHT = 6
+    OP_RSI_IS_OVERSOLD = 7
+    OP_MACD_IS_BULLISH = 8
+    OP_MACD_IS_BEARISH = 9
+    OP_PRICE_BREAKS_UPPER_BAND = 10
+    OP_PRICE_BREAKS_LOWER_BAND = 11
+    OP_PRICE_CROSSES_MIDDLE_FROM_TOP = 12
+    OP_PRICE_CROSSES_MIDDLE_FROM_BOTTOM = 13
+    OP_ADX_UPTREND_CONFIRMED = 14
+    OP_ADX_DOWNTREND_CONFIRMED = 15
+    N_OPCODES = 16
+
+# long_entry, short_entry, long_exit, short_exit
+cdef enum:
+    N_OUTPUTS = 4
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef inline bint crosses_above(const DTYPE_t[:, ::1] s, int a, int b, Py_ssize_t i) noexcept nogil:
+    """Series a was below b on the previous bar and is above it now (False on the first bar)."""
+    return i > 0 and s[a, i - 1] < s[b, i - 1] and s[a, i] > s[b, i]
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef inline bint base_signal(int opcode, const DTYPE_t[:, ::1] s, const DTYPE_t[::1] t, Py_ssize_t i) noexcept nogil:
+    if opcode == OP_SMA_CROSSOVER:
+        return crosses_above(s, S_SHORT_SMA, S_LONG_SMA, i)
+    elif opcode == OP_SMA_CROSSUNDER:
+        return crosses_above(s, S_LONG_SMA, S_SHORT_SMA, i)
+    elif opcode == OP_EMA_CROSSOVER:
+        return crosses_above(s, S_SHORT_EMA, S_LONG_EMA, i)
+    elif opcode == OP_EMA_CROSSUNDER:
+        return crosses_above(s, S_LONG_EMA, S_SHORT_EMA, i)
+    elif opcode == OP_RSI_IS_NOT_OVERBOUGHT:
+        return s[S_RSI, i] < t[T_RSI_OVERBOUGHT]
+    elif opcode == OP_RSI_IS_NOT_OVERSOLD:
+        return s[S_RSI, i] > t[T_RSI_OVERSOLD]
+    elif opcode == OP_RSI_IS_OVERBOUGHT:
+        return s[S_RSI, i] > t[T_RSI_OVERBOUGHT]
+    elif opcode == OP_RSI_IS_OVERSOLD:
+        return s[S_RSI, i] < t[T_RSI_OVERSOLD]
+    elif opcode == OP_MACD_IS_BULLISH:
+        return s[S_MACD_LINE, i] > s[S_MACD_SIGNAL, i]
+    elif opcode == OP_MACD_IS_BEARISH:
+        return s[S_MACD_LINE, i] < s[S_MACD_SIGNAL, i]
+    elif opcode == OP_PRICE_BREAKS_UPPER_BAND:
+        return s[S_HIGH, i] > s[S_BB_HBAND, i]
+    elif opcode == OP_PRICE_BREAKS_LOWER_BAND:
+        return s[S_LOW, i] < s[S_BB_LBAND, i]
+    elif opcode == OP_PRICE_CROSSES_MIDDLE_FROM_TOP:
+        return i > 0 and s[S_CLOSE, i - 1] > s[S_BB_MAVG, i - 1] and s[S_CLOSE, i] <= s[S_BB_MAVG, i]
+    elif opcode == OP_PRICE_CROSSES_MIDDLE_FROM_BOTTOM:
+        return i > 0 and s[S_CLOSE, i - 1] < s[S_BB_MAVG, i - 1] and s[S_CLOSE, i] >= s[S_BB_MAVG, i]
+    elif opcode == OP_ADX_UPTREND_CONFIRMED:
+        return crosses_above(s, S_PDI, S_NDI, i) and s[S_ADX, i] > t[T_ADX_THRESHOLD]
+    elif opcode == OP_ADX_DOWNTREND_CONFIRMED:
+        return crosses_above(s, S_NDI, S_PDI, i) and s[S_ADX, i] > t[T_ADX_THRESHOLD]
+    return 0
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def evaluate_program(const DTYPE_t[:, ::1] series, const DTYPE_t[::1] thresholds,
+                     const np.int32_t[::1] opcodes, const np.int32_t[::1] clause_offsets,
+                     const np.int32_t[::1] output_offsets):
+    """
+    Returns the (4, n) uint8 masks of a compiled program. Clauses of output o are
+    clause_offsets[output_offsets[o]:output_offsets[o + 1]]; opcodes of clause c are
+    opcodes[clause_offsets[c]:clause_offsets[c + 1]]. An output without clauses is
+    always False, and so is an empty clause.
+    """
+    cdef Py_ssize_t n = series.shape[1]
+    cdef Py_ssize_t i, c, k
+    cdef int o
+    cdef bint result, hit
+
+    if series.shape[0] != N_SERIES:
+        raise ValueError(f"series must have {N_SERIES} rows, got {series.shape[0]}")
+    if thresholds.shape[0] != N_THRESHOLDS:
+        raise ValueError(f"thresholds must have {N_THRESHOLDS} entries, got {thresholds.shape[0]}")
+    if output_offsets.shape[0] != N_OUTPUTS + 1 or output_offsets[N_OUTPUTS] >= clause_offsets.shape[0]:
+        raise ValueError("output_offsets do not match clause_offsets")
+    if clause_offsets[clause_offsets.shape[0] - 1] > opcodes.shape[0]:
+        raise ValueError("clause_offsets do not match opcodes")
+    for k in range(opcodes.shape[0]):
+        if opcodes[k] < 0 or opcodes[k] >= N_OPCODES:
+            raise ValueError(f"Unknown signal opcode {opcodes[k]}")
+
+    masks = np.zeros((N_OUTPUTS, n), dtype=np.uint8)
+    cdef UBYTE_t[:, ::1] out = masks
+
+    with nogil:
+        for i in range(n):
+            for o in range(N_OUTPUTS):
+                if output_offsets[o] == output_offsets[o + 1]:
+                    continue
+                result = 1
+                for c in range(output_offsets[o], output_offsets[o + 1]):
+                    hit = 0
+                    for k in range(clause_offsets[c], clause_offsets[c + 1]):
+                        if base_signal(opcodes[k], series, thresholds, i):
+                            hit = 1
+                            break
+                    if not hit:
+                        result = 0
+                        break
+                out[o, i] = result
+    return masks
@@ -1,9 +1,10 @@
+import numpy as np
 import pandas as pd
-from functools import reduce
-import operator
 import logging
-from indicators import calculate_sma, calculate_ema, calculate_rsi, calculate_macd, calculate_bbands, calculate_atr, calculate_adx
+from indicators import calculate_sma, calculate_ema, calculate_rsi, calculate_macd, calculate_bbands, calculate_atr, calculate_adx, calculate_adx_values
 from config import indicator_defaults # Added this import
+from core.indicator_cache import cached_indicator
+from signal_program import SERIES, SERIES_INDEX, compile_strategy, evaluate as evaluate_signal_program
 
 
 
@@ -11,178 +12,120 @@ def _get_required_indicators(strategy_config):
     """
     Determines which indicators are required based on the strategy configuration.
     """
-    required_indicators = set()
-    all_signals = []
-    for key in ['long_entry', 'short_entry', 'long_exit', 'short_exit']:
-        all_signals.extend(strategy_config.get(key, []))
-
-    meta_signal_map = {
-        "all_triggers_long_or": ["sma", "ema", "bbands"],
-        "all_triggers_short_or": ["sma", "ema", "bbands"],
-        "all_verificators_long_or": ["rsi"],
-        "all_verificators_short_or": ["rsi"],
-        "all_exits_long_or": ["sma", "ema", "bbands", "rsi"],
-        "all_exits_short_or": ["sma", "ema", "bbands", "rsi"],
-    }
-
-    for signal_name in all_signals:
-        if signal_name in meta_signal_map:
-            for indicator in meta_signal_map[signal_name]:
-                required_indicators.add(indicator)
-        elif 'sma' in signal_name:
-            required_indicators.add('sma')
-        elif 'ema' in signal_name:
-            required_indicators.add('ema')
-        elif 'rsi' in signal_name:
-            required_indicators.add('rsi')
-        elif 'macd' in signal_name:
-            required_indicators.add('macd')
-        elif 'band' in signal_name: # For Bollinger Bands
-            required_indicators.add('bbands')
-        elif 'adx' in signal_name: # For ADX
-            required_indicators.add('adx')
-        # Add other indicators as needed
-    return required_indicators
-
-def get_trade_signal(df: pd.DataFrame, strategy_config: dict, params: dict):
+    return set(compile_strategy(strategy_config).required_indicators)
+
+def indicator_requests(strategy_config: dict, params: dict) -> dict:
     """
-    Determines the trade signal for the latest data point.
+    The indicators get_trade_signal needs for strategy_config and params, as
+    role -> (indicator, params tuple, compute(df)); (indicator, params tuple) is the
+    indicator cache key, so callers can precompute exactly what the signals will look up.
     """
-    df_copy = df.copy()
-    base_signals = {}
-    required_indicators = _get_required_indicators(strategy_config)
-
-    # --- 1. Conditionally calculate indicators and base signals ---
+    required_indicators = compile_strategy(strategy_config).required_indicators
+    requests = {}
 
     # Moving Averages (SMA)
     if 'sma' in required_indicators:
         short_sma_period = params.get('short_sma_period', indicator_defaults['short_sma_period'])
         long_sma_period = params.get('long_sma_period', indicator_defaults['long_sma_period'])
-        short_sma = calculate_sma(df_copy, short_sma_period)
-        long_sma = calculate_sma(df_copy, long_sma_period)
-        base_signals['sma_crossover'] = (short_sma.shift(1) < long_sma.shift(1)) & (short_sma > long_sma)
-        base_signals['sma_crossunder'] = (short_sma.shift(1) > long_sma.shift(1)) & (short_sma < long_sma)
+        requests['short_sma'] = ('sma', (short_sma_period,), lambda df: calculate_sma(df, short_sma_period))
+        requests['long_sma'] = ('sma', (long_sma_period,), lambda df: calculate_sma(df, long_sma_period))
 
     # Moving Averages (EMA)
     if 'ema' in required_indicators:
         short_ema_period = params.get('short_ema_period', indicator_defaults['short_ema'])
         long_ema_period = params.get('long_ema_period', indicator_defaults['long_ema'])
-        short_ema = calculate_ema(df_copy, short_ema_period)
-        long_ema = calculate_ema(df_copy, long_ema_period)
-        base_signals['ema_crossover'] = (short_ema.shift(1) < long_ema.shift(1)) & (short_ema > long_ema)
-        base_signals['ema_crossunder'] = (short_ema.shift(1) > long_ema.shift(1)) & (short_ema < long_ema)
+        requests['short_ema'] = ('ema', (short_ema_period,), lambda df: calculate_ema(df, short_ema_period))
+        requests['long_ema'] = ('ema', (long_ema_period,), lambda df: calculate_ema(df, long_ema_period))
 
     # RSI
     if 'rsi' in required_indicators:
-        rsi = calculate_rsi(df_copy, params.get('rsi_period', indicator_defaults['rsi_period']))
-        if (rsi < 0).any() or (rsi > 100).any():
-            logging.warning(f"RSI values out of expected 0-100 range. Min: {rsi.min()}, Max: {rsi.max()}")
-        base_signals['rsi_is_not_overbought'] = rsi < params.get('rsi_overbought', indicator_defaults['rsi_overbought'])
-        base_signals['rsi_is_not_oversold'] = rsi > params.get('rsi_oversold', indicator_defaults['rsi_oversold'])
-        base_signals['rsi_is_overbought'] = rsi > params.get('rsi_overbought', indicator_defaults['rsi_overbought'])
-        base_signals['rsi_is_oversold'] = rsi < params.get('rsi_oversold', indicator_defaults['rsi_oversold'])
+        rsi_period = params.get('rsi_period', indicator_defaults['rsi_period'])
+        requests['rsi'] = ('rsi', (rsi_period,), lambda df: calculate_rsi(df, rsi_period))
 
     # MACD
     if 'macd' in required_indicators:
         macd_fast_period = params.get('macd_fast_period', indicator_defaults['macd_fast_period'])
         macd_slow_period = params.get('macd_slow_period', indicator_defaults['macd_slow_period'])
         macd_signal_period = params.get('macd_signal_period', indicator_defaults['macd_signal_period'])
-        macd_data = calculate_macd(df_copy, macd_fast_period, macd_slow_period, macd_signal_period)
-        if (macd_data['MACD'].abs() > 1000).any() or (macd_data['Signal'].abs() > 1000).any():
-            logging.warning(f"MACD values are unusually large. MACD Max: {macd_data['MACD'].max()}, MACD Min: {macd_data['MACD'].min()}, Signal Max: {macd_data['Signal'].max()}, Signal Min: {macd_data['Signal'].min()}")
-        base_signals['macd_is_bullish'] = macd_data['MACD'] > macd_data['Signal']
-        base_signals['macd_is_bearish'] = macd_data['MACD'] < macd_data['Signal']
+        requests['macd'] = ('macd', (macd_fast_period, macd_slow_period, macd_signal_period),
+                            lambda df: calculate_macd(df, macd_fast_period, macd_slow_period, macd_signal_period))
 
     # Bollinger Bands
     if 'bbands' in required_indicators:
-        bbands = calculate_bbands(df_copy, params.get('bb_period', indicator_defaults['bb_period']), params.get('bb_std_dev', indicator_defaults['bb_std_dev']))
-        base_signals['price_breaks_upper_band'] = df_copy['high'] > bbands['bb_hband']
-        base_signals['price_breaks_lower_band'] = df_copy['low'] < bbands['bb_lband']
-        base_signals['price_crosses_middle_band_from_top'] = (df_copy['close'].shift(1) > bbands['bb_mavg'].shift(1)) & (df_copy['close'] <= bbands['bb_mavg'])
-        base_signals['price_crosses_middle_band_from_bottom'] = (df_copy['close'].shift(1) < bbands['bb_mavg'].shift(1)) & (df_copy['close'] >= bbands['bb_mavg'])
-    
+        bb_period = params.get('bb_period', indicator_defaults['bb_period'])
+        bb_std_dev = params.get('bb_std_dev', indicator_defaults['bb_std_dev'])
+        requests['bbands'] = ('bbands', (bb_period, bb_std_dev), lambda df: calculate_bbands(df, bb_period, bb_std_dev))
+
     # ADX
     if 'adx' in required_indicators:
         adx_period = params.get('adx_period', indicator_defaults.get('adx_period', 14))
-        adx_threshold = params.get('adx_threshold', indicator_defaults.get('adx_threshold', 20))
-        adx_data = calculate_adx(df_copy, window=adx_period)
-        base_signals['adx_uptrend_confirmed'] = (adx_data['pdi'].shift(1) < adx_data['ndi'].shift(1)) & (adx_data['pdi'] > adx_data['ndi']) & (adx_data['adx'] > adx_threshold)
-        base_signals['adx_downtrend_confirmed'] = (adx_data['ndi'].shift(1) < adx_data['pdi'].shift(1)) & (adx_data['ndi'] > adx_data['pdi']) & (adx_data['adx'] > adx_threshold)
-
-    # Combined OR signals for new strategy (these are hardcoded and might need review based on actual strategy definitions)
-    # For now, I'll keep them as is, assuming they are used by 'Combined_Trigger_Verifier'
-    # and will only be evaluated if the relevant base signals are present.
-    if 'sma' in required_indicators or 'ema' in required_indicators or 'bbands' in required_indicators:
-        base_signals['all_triggers_long_or'] = (
-            base_signals.get('sma_crossover', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('ema_crossover', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('price_breaks_upper_band', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('price_crosses_middle_band_from_bottom', pd.Series(False, index=df_copy.index))
-        )
-        base_signals['all_triggers_short_or'] = (
-            base_signals.get('sma_crossunder', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('ema_crossunder', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('price_breaks_lower_band', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('price_crosses_middle_band_from_top', pd.Series(False, index=df_copy.index))
-        )
-    if 'rsi' in required_indicators:
-        base_signals['all_verificators_long_or'] = (
-            base_signals.get('rsi_is_not_overbought', pd.Series(False, index=df_copy.index))
-        )
-        base_signals['all_verificators_short_or'] = (
-            base_signals.get('rsi_is_not_oversold', pd.Series(False, index=df_copy.index))
-        )
-
-    if 'sma' in required_indicators or 'ema' in required_indicators or 'bbands' in required_indicators or 'rsi' in required_indicators:
-        base_signals['all_exits_long_or'] = (
-            base_signals.get('sma_crossunder', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('ema_crossunder', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('price_crosses_middle_band_from_top', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('rsi_is_overbought', pd.Series(False, index=df_copy.index))
-        )
-        base_signals['all_exits_short_or'] = (
-            base_signals.get('sma_crossover', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('ema_crossover', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('price_crosses_middle_band_from_bottom', pd.Series(False, index=df_copy.index)) |
-            base_signals.get('rsi_is_oversold', pd.Series(False, index=df_copy.index))
-        )
-
-    # --- 2. Combine base signals based on the selected strategy ---
-    def combine_signals(signal_names):
-        signals_to_combine = []
-        for name in signal_names:
-            if name in base_signals:
-                signals_to_combine.append(base_signals[name])
-            elif name.startswith('all_'): # Handle combined signals that might not be directly in base_signals if their components are missing
-                # This is a fallback for combined signals if their components are not calculated
-                # due to required_indicators. It assumes these combined signals are only used
-                # by the 'Combined_Trigger_Verifier' strategy.
-                if name == 'all_triggers_long_or' and 'Combined_Trigger_Verifier' in strategy_config.values():
-                    signals_to_combine.append(base_signals.get('all_triggers_long_or', pd.Series(False, index=df_copy.index)))
-                elif name == 'all_triggers_short_or' and 'Combined_Trigger_Verifier' in strategy_config.values():
-                    signals_to_combine.append(base_signals.get('all_triggers_short_or', pd.Series(False, index=df_copy.index)))
-                elif name == 'all_verificators_long_or' and 'Combined_Trigger_Verifier' in strategy_config.values():
-                    signals_to_combine.append(base_signals.get('all_verificators_long_or', pd.Series(False, index=df_copy.index)))
-                elif name == 'all_verificators_short_or' and 'Combined_Trigger_Verifier' in strategy_config.values():
-                    signals_to_combine.append(base_signals.get('all_verificators_short_or', pd.Series(False, index=df_copy.index)))
-                elif name == 'all_exits_long_or' and 'Combined_Trigger_Verifier' in strategy_config.values():
-                    signals_to_combine.append(base_signals.get('all_exits_long_or', pd.Series(False, index=df_copy.index)))
-                elif name == 'all_exits_short_or' and 'Combined_Trigger_Verifier' in strategy_config.values():
-                    signals_to_combine.append(base_signals.get('all_exits_short_or', pd.Series(False, index=df_copy.index)))
-                else:
-                    logging.warning(f"Signal '{name}' not found in base_signals and not handled as a combined signal for Combined_Trigger_Verifier.")
-            else:
-                logging.warning(f"Signal '{name}' not found in base_signals. This might indicate a misconfiguration in strategy_config or missing indicator calculation.")
-
-        if not signals_to_combine:
-            return pd.Series(False, index=df_copy.index)
-        return reduce(operator.and_, signals_to_combine)
-
-    long_entry_final = combine_signals(strategy_config['long_entry'])
-    short_entry_final = combine_signals(strategy_config['short_entry'])
-    long_exit_final = combine_signals(strategy_config['long_exit'])
-    short_exit_final = combine_signals(strategy_config['short_exit'])
+        requests['adx'] = ('adx', (adx_period,), lambda df: calculate_adx_values(df, window=adx_period))
+
+    return requests
+
+def get_trade_signal(df: pd.DataFrame, strategy_config: dict, params: dict, indicator_cache=None):
+    """
+    Determines the trade signal for the latest data point.
+
+    The strategy is compiled once (signal_program.py) into clauses over base signals;
+    only the indicators it needs are computed, from indicators.py (native engine when
+    built), and all four signals come out of a single fused pass over the bars.
+    When indicator_cache (a DatasetIndicatorCache for df) is given, indicators are
+    looked up there first.
+    """
+    compiled = compile_strategy(strategy_config)
+    requests = indicator_requests(strategy_config, params)
+    series = np.full((len(SERIES), len(df)), np.nan)
+    series[SERIES_INDEX['close']] = df['close'].to_numpy(dtype=np.float64)
 
+    def lookup(role):
+        indicator, key, compute = requests[role]
+        return cached_indicator(indicator_cache, indicator, key, lambda: compute(df))
+
+    # --- 1. Conditionally calculate indicators ---
+
+    for role in ('short_sma', 'long_sma', 'short_ema', 'long_ema'):
+        if role in requests:
+            series[SERIES_INDEX[role]] = lookup(role).to_numpy(dtype=np.float64)
+
+    if 'rsi' in requests:
+        rsi = lookup('rsi').to_numpy(dtype=np.float64)
+        if (rsi < 0).any() or (rsi > 100).any():
+            logging.warning(f"RSI values out of expected 0-100 range. Min: {np.nanmin(rsi)}, Max: {np.nanmax(rsi)}")
+        series[SERIES_INDEX['rsi']] = rsi
+
+    if 'macd' in requests:
+        macd_data = lookup('macd')
+        macd_line = macd_data['MACD'].to_numpy(dtype=np.float64)
+        macd_signal = macd_data['Signal'].to_numpy(dtype=np.float64)
+        if (np.abs(macd_line) > 1000).any() or (np.abs(macd_signal) > 1000).any():
+            logging.warning(f"MACD values are unusually large. MACD Max: {np.nanmax(macd_line)}, MACD Min: {np.nanmin(macd_line)}, Signal Max: {np.nanmax(macd_signal)}, Signal Min: {np.nanmin(macd_signal)}")
+        series[SERIES_INDEX['macd_line']] = macd_line
+        series[SERIES_INDEX['macd_signal']] = macd_signal
+
+    if 'bbands' in requests:
+        bbands = lookup('bbands')
+        for name in ('bb_hband', 'bb_lband', 'bb_mavg'):
+            series[SERIES_INDEX[name]] = bbands[name].to_numpy(dtype=np.float64)
+        series[SERIES_INDEX['high']] = df['high'].to_numpy(dtype=np.float64)
+        series[SERIES_INDEX['low']] = df['low'].to_numpy(dtype=np.float64)
+
+    if 'adx' in requests:
+        adx_data = lookup('adx')
+        for name in ('adx', 'pdi', 'ndi'):
+            series[SERIES_INDEX[name]] = adx_data[name].to_numpy(dtype=np.float64)
+
+    thresholds = (
+        params.get('rsi_overbought', indicator_defaults['rsi_overbought']),
+        params.get('rsi_oversold', indicator_defaults['rsi_oversold']),
+        params.get('adx_threshold', indicator_defaults.get('adx_threshold', 20)),
+    )
+
+    # --- 2. Combine base signals in one pass, as compiled for the selected strategy ---
+    masks = evaluate_signal_program(compiled, series, thresholds)
+    long_entry_final, short_entry_final, long_exit_final, short_exit_final = (
+        pd.Series(mask.view(bool), index=df.index) for mask in masks
+    )
     return long_entry_final, short_entry_final, long_exit_final, short_exit_final
 
 
@@ -197,6 +140,6 @@ class Strategy:
     def set_params(self, params):
         self.params = params
 
-    def generate_signals(self, data, params, override_config=None):
+    def generate_signals(self, data, params, override_config=None, indicator_cache=None):
         config_to_use = override_config if override_config is not None else self.config
-        return get_trade_signal(data, config_to_use, params)
+        return get_trade_signal(data, config_to_use, params, indicator_cache=indicator_cache)
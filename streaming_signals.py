@@ -0,0 +1,465 @@
+"""
+Incremental (O(1) per bar) versions of the indicators and signal algebra in strategy.py.
+
+A StreamingSignalEvaluator is fed one candle at a time and answers what
+get_trade_signal would return for the newest bar of the whole history pushed so
+far. The accumulators replay the exact recurrences of indicators_cython (and
+therefore pandas/ta), so the signals match the batch path bar for bar.
+
+The history is everything pushed since the evaluator started (or was reset), not
+the window of the latest update: EWM and RSI state carries back past the start of
+a sliding window, so the signals can differ from get_trade_signal on that window.
+"""
+
+import json
+import math
+import threading
+from collections import deque
+
+from config import indicator_defaults
+from signal_program import compile_strategy
+
+NAN = float('nan')
+
+class _EwmMean:
+    """pandas ewm(com=com, min_periods=min_periods, adjust=False).mean(), one value at a time."""
+
+    def __init__(self, com, min_periods=1):
+        self.alpha = 1. / (1. + com)
+        self.old_wt_factor = 1. - self.alpha
+        self.min_periods = max(min_periods, 1)
+        self.weighted = NAN
+        self.old_wt = 1.
+        self.nobs = 0
+        self.started = False
+
+    def save(self):
+        return self.weighted, self.old_wt, self.nobs, self.started
+
+    def restore(self, state):
+        self.weighted, self.old_wt, self.nobs, self.started = state
+
+    def update(self, cur):
+        is_observation = cur == cur
+        self.nobs += is_observation
+        if not self.started:
+            self.weighted = cur
+            self.old_wt = 1.
+            self.started = True
+        elif self.weighted == self.weighted:
+            self.old_wt *= self.old_wt_factor
+            if is_observation:
+                # avoid numerical errors on constant series
+                if self.weighted != cur:
+                    self.weighted = self.old_wt * self.weighted + self.alpha * cur
+                    self.weighted /= (self.old_wt + self.alpha)
+                self.old_wt = 1.
+        elif is_observation:
+            self.weighted = cur
+        return self.weighted if self.nobs >= self.min_periods else NAN
+
+class _RollingMean:
+    """pandas rolling(window).mean() with its Kahan-compensated running sum."""
+
+    def __init__(self, window):
+        self.window = window
+        self.values = deque()
+        self.sum_x = 0.
+        self.compensation_add = 0.
+        self.compensation_remove = 0.
+        self.prev_value = None
+        self.nobs = 0
+        self.neg_ct = 0
+        self.num_consecutive_same_value = 0
+
+    def save(self):
+        # The window is undone by popping the next value and putting back the one it evicts
+        evicted = self.values[0] if len(self.values) == self.window else None
+        return (evicted, self.sum_x, self.compensation_add, self.compensation_remove, self.prev_value,
+                self.nobs, self.neg_ct, self.num_consecutive_same_value)
+
+    def restore(self, state):
+        evicted = state[0]
+        self.values.pop()
+        if evicted is not None:
+            self.values.appendleft(evicted)
+        (self.sum_x, self.compensation_add, self.compensation_remove, self.prev_value,
+         self.nobs, self.neg_ct, self.num_consecutive_same_value) = state[1:]
+
+    def update(self, val):
+        if self.prev_value is None:
+            self.prev_value = val
+        if len(self.values) == self.window:
+            self._remove(self.values.popleft())
+        self.values.append(val)
+        self._add(val)
+        if self.nobs >= self.window and self.nobs > 0:
+            result = self.sum_x / self.nobs
+            if self.num_consecutive_same_value >= self.nobs:
+                result = self.prev_value
+            elif self.neg_ct == 0 and result < 0:
+                result = 0
+            elif self.neg_ct == self.nobs and result > 0:
+                result = 0
+            return result
+        return NAN
+
+    def _add(self, val):
+        if val != val:
+            return
+        self.nobs += 1
+        y = val - self.compensation_add
+        t = self.sum_x + y
+        self.compensation_add = t - self.sum_x - y
+        self.sum_x = t
+        if math.copysign(1., val) < 0:
+            self.neg_ct += 1
+        if val == self.prev_value:
+            self.num_consecutive_same_value += 1
+        else:
+            self.num_consecutive_same_value = 1
+        self.prev_value = val
+
+    def _remove(self, val):
+        if val != val:
+            return
+        self.nobs -= 1
+        y = -val - self.compensation_remove
+        t = self.sum_x + y
+        self.compensation_remove = t - self.sum_x - y
+        self.sum_x = t
+        if math.copysign(1., val) < 0:
+            self.neg_ct -= 1
+
+class _RollingVar:
+    """pandas rolling(window).var(ddof) (Welford with Kahan compensation)."""
+
+    def __init__(self, window, ddof=0):
+        self.window = window
+        self.ddof = ddof
+        self.values = deque()
+        self.nobs = 0
+        self.mean_x = 0.
+        self.ssqdm_x = 0.
+        self.compensation_add = 0.
+        self.compensation_remove = 0.
+        self.prev_value = None
+        self.num_consecutive_same_value = 0
+
+    def save(self):
+        evicted = self.values[0] if len(self.values) == self.window else None
+        return (evicted, self.nobs, self.mean_x, self.ssqdm_x, self.compensation_add, self.compensation_remove,
+                self.prev_value, self.num_consecutive_same_value)
+
+    def restore(self, state):
+        evicted = state[0]
+        self.values.pop()
+        if evicted is not None:
+            self.values.appendleft(evicted)
+        (self.nobs, self.mean_x, self.ssqdm_x, self.compensation_add, self.compensation_remove,
+         self.prev_value, self.num_consecutive_same_value) = state[1:]
+
+    def update(self, val):
+        if self.prev_value is None:
+            self.prev_value = val
+        if len(self.values) == self.window:
+            self._remove(self.values.popleft())
+        self.values.append(val)
+        self._add(val)
+        if self.nobs >= self.window and self.nobs > self.ddof:
+            if self.nobs == 1 or self.num_consecutive_same_value >= self.nobs:
+                return 0
+            return self.ssqdm_x / (self.nobs - self.ddof)
+        return NAN
+
+    def _add(self, val):
+        if val != val:
+            return
+        self.nobs += 1
+        if val == self.prev_value:
+            self.num_consecutive_same_value += 1
+        else:
+            self.num_consecutive_same_value = 1
+        self.prev_value = val
+        prev_mean = self.mean_x - self.compensation_add
+        y = val - self.compensation_add
+        t = y - self.mean_x
+        self.compensation_add = t + self.mean_x - y
+        self.mean_x = self.mean_x + t / self.nobs
+        self.ssqdm_x = self.ssqdm_x + (val - prev_mean) * (val - self.mean_x)
+
+    def _remove(self, val):
+        if val != val:
+            return
+        self.nobs -= 1
+        if self.nobs:
+            prev_mean = self.mean_x - self.compensation_remove
+            y = val - self.compensation_remove
+            t = y - self.mean_x
+            self.compensation_remove = t + self.mean_x - y
+            self.mean_x = self.mean_x - t / self.nobs
+            self.ssqdm_x = self.ssqdm_x - (val - prev_mean) * (val - self.mean_x)
+        else:
+            self.mean_x = 0.
+            self.ssqdm_x = 0.
+
+class _RSI:
+    """ta.momentum.rsi(close, window)."""
+
+    def __init__(self, window):
+        alpha = 1. / window
+        self.up = _EwmMean((1 - alpha) / alpha, window)
+        self.down = _EwmMean((1 - alpha) / alpha, window)
+        self.prev_close = None
+
+    def save(self):
+        return self.up.save(), self.down.save(), self.prev_close
+
+    def restore(self, state):
+        self.up.restore(state[0])
+        self.down.restore(state[1])
+        self.prev_close = state[2]
+
+    def update(self, close):
+        if self.prev_close is None:
+            # close.diff(1) is NaN on the first bar, which ta maps to 0.0
+            up, down = 0.0, -0.0
+        else:
+            diff = close - self.prev_close
+            up = diff if diff > 0 else 0.0
+            down = -(diff if diff < 0 else 0.0)
+        self.prev_close = close
+        emaup = self.up.update(up)
+        emadn = self.down.update(down)
+        if emadn == 0:
+            return 100
+        return 100 - (100 / (1 + emaup / emadn))
+
+class _MACD:
+    """ta.trend.macd / macd_signal; returns (line, signal)."""
+
+    def __init__(self, window_slow, window_fast, window_sign):
+        self.fast = _EwmMean((window_fast - 1) / 2.0, window_fast)
+        self.slow = _EwmMean((window_slow - 1) / 2.0, window_slow)
+        self.sign = _EwmMean((window_sign - 1) / 2.0, window_sign)
+
+    def save(self):
+        return self.fast.save(), self.slow.save(), self.sign.save()
+
+    def restore(self, state):
+        for stream, saved in zip((self.fast, self.slow, self.sign), state):
+            stream.restore(saved)
+
+    def update(self, close):
+        line = self.fast.update(close) - self.slow.update(close)
+        return line, self.sign.update(line)
+
+class _BollingerBands:
+    """ta.volatility.BollingerBands; returns (mavg, hband, lband)."""
+
+    def __init__(self, window, window_dev):
+        self.window_dev = window_dev
+        self.mean = _RollingMean(window)
+        self.var = _RollingVar(window, ddof=0)
+
+    def save(self):
+        return self.mean.save(), self.var.save()
+
+    def restore(self, state):
+        self.mean.restore(state[0])
+        self.var.restore(state[1])
+
+    def update(self, close):
+        mavg = self.mean.update(close)
+        var = self.var.update(close)
+        mstd = math.sqrt(max(var, 0.0)) if var == var else NAN
+        return mavg, mavg + self.window_dev * mstd, mavg - self.window_dev * mstd
+
+class StreamingSignalEvaluator:
+    """
+    Keeps the indicator state of one (strategy, params) pair on one price series and
+    evaluates the strategy's four signals on the newest bar.
+    """
+
+    def __init__(self, strategy_config: dict, params: dict):
+        self.strategy_config = strategy_config
+        self.params = params
+        self.compiled = compile_strategy(strategy_config)
+        self.required_indicators = self.compiled.required_indicators
+        self.bars = 0
+        self.last_timestamp = None
+        self._last_bar = None
+        self._snapshot = None  # State before the newest bar, so a revised candle can be re-applied
+        self.lock = threading.Lock() # Held around update + latest_signals by callers sharing the evaluator
+        self._build_streams()
+
+    def _build_streams(self):
+        params = self.params
+        self._streams = {}
+        if 'sma' in self.required_indicators:
+            self.short_sma_period = params.get('short_sma_period', indicator_defaults['short_sma_period'])
+            self.long_sma_period = params.get('long_sma_period', indicator_defaults['long_sma_period'])
+            self._streams['short_sma'] = _RollingMean(self.short_sma_period)
+            self._streams['long_sma'] = _RollingMean(self.long_sma_period)
+        if 'ema' in self.required_indicators:
+            self._streams['short_ema'] = _EwmMean((params.get('short_ema_period', indicator_defaults['short_ema']) - 1) / 2.0)
+            self._streams['long_ema'] = _EwmMean((params.get('long_ema_period', indicator_defaults['long_ema']) - 1) / 2.0)
+        if 'rsi' in self.required_indicators:
+            self._streams['rsi'] = _RSI(params.get('rsi_period', indicator_defaults['rsi_period']))
+        if 'macd' in self.required_indicators:
+            # Same argument order as strategy.get_trade_signal's calculate_macd call
+            self._streams['macd'] = _MACD(params.get('macd_fast_period', indicator_defaults['macd_fast_period']),
+                                          params.get('macd_slow_period', indicator_defaults['macd_slow_period']),
+                                          params.get('macd_signal_period', indicator_defaults['macd_signal_period']))
+        if 'bbands' in self.required_indicators:
+            self._streams['bbands'] = _BollingerBands(params.get('bb_period', indicator_defaults['bb_period']),
+                                                      params.get('bb_std_dev', indicator_defaults['bb_std_dev']))
+        self._current = {}
+        self._previous = {}
+
+    def push(self, high: float, low: float, close: float, timestamp=None) -> None:
+        """Feeds one closed or forming candle."""
+        values = {'close': close, 'high': high, 'low': low}
+        for name, stream in self._streams.items():
+            result = stream.update(close)
+            if name == 'macd':
+                values['macd_line'], values['macd_signal'] = result
+            elif name == 'bbands':
+                values['bb_mavg'], values['bb_hband'], values['bb_lband'] = result
+            else:
+                values[name] = result
+        self._previous = self._current
+        self._current = values
+        self.bars += 1
+        self.last_timestamp = timestamp
+        self._last_bar = (high, low, close)
+
+    def update(self, df) -> int:
+        """
+        Pushes the rows of df newer than the last pushed bar and returns how many were
+        pushed. If the last pushed candle was revised (it was still forming), it is
+        replaced first. A window that does not contain the last pushed bar (a gap in
+        the data, or older data) restarts the evaluator on df alone.
+        """
+        if len(df) == 0:
+            return 0
+        highs = df['high'].to_numpy(dtype=float)
+        lows = df['low'].to_numpy(dtype=float)
+        closes = df['close'].to_numpy(dtype=float)
+        start = 0
+        if self.last_timestamp is not None and not (df.index[0] <= self.last_timestamp <= df.index[-1]):
+            self.reset()
+        if self.last_timestamp is not None:
+            start = int(df.index.searchsorted(self.last_timestamp, side='right'))
+            revised_row = start - 1
+            if (revised_row >= 0 and df.index[revised_row] == self.last_timestamp and self._snapshot is not None
+                    and (highs[revised_row], lows[revised_row], closes[revised_row]) != self._last_bar):
+                self._restore(self._snapshot)
+                start = revised_row
+        pushed = len(df) - start
+        for row in range(start, len(df)):
+            if row == len(df) - 1:
+                self._snapshot = self._state()
+            self.push(highs[row], lows[row], closes[row], df.index[row])
+        return pushed
+
+    def reset(self) -> None:
+        """Forgets every pushed bar."""
+        self.bars = 0
+        self.last_timestamp = None
+        self._last_bar = None
+        self._snapshot = None
+        self._build_streams()
+
+    def _state(self):
+        # O(1): the accumulators' scalars, and for rolling windows the value the next push evicts;
+        # push() replaces the value dicts rather than mutating them
+        return ({name: stream.save() for name, stream in self._streams.items()},
+                self._current, self._previous, self.bars, self.last_timestamp, self._last_bar)
+
+    def _restore(self, state):
+        # Only valid right after the push that followed the snapshot
+        streams, self._current, self._previous, self.bars, self.last_timestamp, self._last_bar = state
+        for name, saved in streams.items():
+            self._streams[name].restore(saved)
+        self._snapshot = None
+
+    def _value(self, name, previous=False):
+        source = self._previous if previous else self._current
+        return source.get(name, NAN)
+
+    def _base_signals(self):
+        """strategy.get_trade_signal's base signals, evaluated on the newest bar only."""
+        params = self.params
+        base_signals = {}
+        cur, prev = self._value, lambda name: self._value(name, previous=True)
+
+        if 'sma' in self.required_indicators:
+            short_now, long_now = cur('short_sma'), cur('long_sma')
+            short_prev, long_prev = prev('short_sma'), prev('long_sma')
+            # calculate_sma returns all NaN when the window covers the whole frame
+            if self.short_sma_period >= self.bars:
+                short_now = short_prev = NAN
+            if self.long_sma_period >= self.bars:
+                long_now = long_prev = NAN
+            base_signals['sma_crossover'] = short_prev < long_prev and short_now > long_now
+            base_signals['sma_crossunder'] = short_prev > long_prev and short_now < long_now
+
+        if 'ema' in self.required_indicators:
+            base_signals['ema_crossover'] = prev('short_ema') < prev('long_ema') and cur('short_ema') > cur('long_ema')
+            base_signals['ema_crossunder'] = prev('short_ema') > prev('long_ema') and cur('short_ema') < cur('long_ema')
+
+        if 'rsi' in self.required_indicators:
+            rsi = cur('rsi')
+            base_signals['rsi_is_not_overbought'] = rsi < params.get('rsi_overbought', indicator_defaults['rsi_overbought'])
+            base_signals['rsi_is_not_oversold'] = rsi > params.get('rsi_oversold', indicator_defaults['rsi_oversold'])
+            base_signals['rsi_is_overbought'] = rsi > params.get('rsi_overbought', indicator_defaults['rsi_overbought'])
+            base_signals['rsi_is_oversold'] = rsi < params.get('rsi_oversold', indicator_defaults['rsi_oversold'])
+
+        if 'macd' in self.required_indicators:
+            base_signals['macd_is_bullish'] = cur('macd_line') > cur('macd_signal')
+            base_signals['macd_is_bearish'] = cur('macd_line') < cur('macd_signal')
+
+        if 'bbands' in self.required_indicators:
+            base_signals['price_breaks_upper_band'] = cur('high') > cur('bb_hband')
+            base_signals['price_breaks_lower_band'] = cur('low') < cur('bb_lband')
+            base_signals['price_crosses_middle_band_from_top'] = prev('close') > prev('bb_mavg') and cur('close') <= cur('bb_mavg')
+            base_signals['price_crosses_middle_band_from_bottom'] = prev('close') < prev('bb_mavg') and cur('close') >= cur('bb_mavg')
+
+        if 'adx' in self.required_indicators:
+            # ta's ADXIndicator leaves +DI/-DI at 0 on the last bar, so on the newest bar
+            # (pdi > ndi) and (ndi > pdi) are always False in the batch path as well
+            base_signals['adx_uptrend_confirmed'] = False
+            base_signals['adx_downtrend_confirmed'] = False
+
+        return base_signals
+
+    def latest_signals(self):
+        """(long_entry, short_entry, long_exit, short_exit) on the newest bar."""
+        if self.bars == 0:
+            return False, False, False, False
+        base_signals = self._base_signals()
+        # Same clauses get_trade_signal evaluates: AND of clauses, each an OR of base signals
+        return tuple(bool(clauses) and all(any(base_signals[name] for name in clause) for clause in clauses)
+                     for clauses in self.compiled.clauses)
+
+# Evaluators of the process by (crypto, strategy, params): analysis jobs build a new
+# PaperTradingEngine every cycle, so the indicator state has to outlive the engine
+_evaluators = {}
+_evaluators_lock = threading.Lock()
+
+def get_signal_stream(crypto_id: str, strategy_config: dict, params: dict) -> StreamingSignalEvaluator:
+    """The shared evaluator of crypto_id for this strategy and parameter set, created on first use."""
+    key = (crypto_id, strategy_config.get('name', 'N/A'), json.dumps(params, sort_keys=True, default=str))
+    with _evaluators_lock:
+        stream = _evaluators.get(key)
+        if stream is None:
+            stream = StreamingSignalEvaluator(strategy_config, params)
+            _evaluators[key] = stream
+        return stream
+
+def prune_signal_streams(crypto_ids) -> None:
+    """Drops the evaluators of cryptos that are no longer analyzed."""
+    with _evaluators_lock:
+        for key in [key for key in _evaluators if key[0] not in crypto_ids]:
+            del _evaluators[key]
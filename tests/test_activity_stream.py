@@ -0,0 +1,69 @@
+import os
+import sys
+import threading
+import time
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.activity_stream import ActivityStream, BATCH_EVENT
+
+class RecordingSocket:
+    def __init__(self, delay=0.0):
+        self.delay = delay
+        self.batches = []
+
+    def emit(self, event, data):
+        time.sleep(self.delay)
+        self.batches.append((event, data))
+
+def _entry(stage, message, crypto_id=None):
+    return {'stage': stage, 'message': message, 'crypto_id': crypto_id, 'details': {}}
+
+class TestActivityStream(unittest.TestCase):
+
+    def test_noisy_stages_are_coalesced_per_crypto(self):
+        socket = RecordingSocket()
+        stream = ActivityStream(socket, flush_seconds=3600)
+        stream.push(_entry('Analysis', 'Analyzing...', 'bitcoin'))
+        stream.push(_entry('Analysis', 'Analyzing...', 'ethereum'))
+        stream.push(_entry('Decision', 'Holding. No action taken.', 'bitcoin'))
+        stream.push(_entry('Analysis', 'Skipping: Max concurrent positions reached.', 'bitcoin'))
+        stream.close()
+
+        event, batch = socket.batches[0]
+        self.assertEqual(event, BATCH_EVENT)
+        self.assertEqual([(e['crypto_id'], e['message']) for e in batch], [
+            ('ethereum', 'Analyzing...'),
+            ('bitcoin', 'Holding. No action taken.'),
+            ('bitcoin', 'Skipping: Max concurrent positions reached.'),
+        ])
+
+    def test_overflow_drops_the_oldest_noisy_entries_only(self):
+        socket = RecordingSocket()
+        stream = ActivityStream(socket, capacity=3, flush_seconds=3600, max_batch=100)
+        stream.push(_entry('Lifecycle', 'Starting analysis task.'))
+        for i in range(10):
+            stream.push(_entry('Data', f'message {i}', f'coin-{i}'))
+        stream.close()
+
+        messages = [e['message'] for _, batch in socket.batches for e in batch]
+        self.assertEqual(messages, ['Starting analysis task.', 'message 7', 'message 8', 'message 9'])
+
+    def test_push_does_not_wait_for_a_slow_client(self):
+        socket = RecordingSocket(delay=0.2)
+        stream = ActivityStream(socket, flush_seconds=0.01, max_batch=5)
+        stream.push(_entry('Lifecycle', 'first'))
+        time.sleep(0.05) # The emitter is now inside the slow emit
+        start = time.perf_counter()
+        for i in range(20):
+            stream.push(_entry('Decision', f'decision {i}', 'bitcoin'))
+        self.assertLess(time.perf_counter() - start, 0.1)
+        stream.close()
+
+        messages = [e['message'] for _, batch in socket.batches for e in batch]
+        self.assertEqual(messages, ['first'] + [f'decision {i}' for i in range(20)])
+        self.assertTrue(all(len(batch) <= 5 for _, batch in socket.batches))
+
+if __name__ == '__main__':
+    unittest.main()
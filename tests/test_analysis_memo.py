@@ -0,0 +1,95 @@
+import os
+import pickle
+import shutil
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.analysis_memo import AnalysisMemo, analysis_memo_key
+from core.result_index import ResultIndex
+
+class _IndexedResults:
+    """The part of ResultManager the memo uses, backed by a real ResultIndex."""
+
+    def __init__(self, results_dir):
+        self.results_dir = results_dir
+        self.index = ResultIndex(results_dir)
+        self.lookups = 0
+
+    def save(self, name, document):
+        self.index.write(os.path.join(self.results_dir, f"analysis_{name}_20240101_000000.json"), 'analysis',
+                         document, crypto_id=name)
+
+    def get_analysis_by_memo_key(self, memo_key):
+        self.lookups += 1
+        for entry in self.index.query('analysis', content_key=memo_key, limit=1):
+            return entry.document
+        return None
+
+class TestAnalysisMemoKey(unittest.TestCase):
+
+    def test_key_ignores_parameter_order(self):
+        a = analysis_memo_key('bitcoin', 'EMA_Only', {'short_ema_period': 5, 'long_ema_period': 20}, 7, '2024-01-01 00:00:00')
+        b = analysis_memo_key('bitcoin', 'EMA_Only', {'long_ema_period': 20, 'short_ema_period': 5}, 7.0, '2024-01-01 00:00:00')
+        self.assertEqual(a, b)
+
+    def test_new_candle_changes_key(self):
+        a = analysis_memo_key('bitcoin', 'EMA_Only', {}, 7, '2024-01-01 00:00:00')
+        b = analysis_memo_key('bitcoin', 'EMA_Only', {}, 7, '2024-01-01 00:30:00')
+        self.assertNotEqual(a, b)
+        self.assertNotEqual(a, analysis_memo_key('bitcoin', 'EMA_Only', {}, 30, '2024-01-01 00:00:00'))
+
+    def test_revised_candle_and_other_source_change_key(self):
+        a = analysis_memo_key('bitcoin', None, {}, 7, '2024-01-01 00:00:00', [100.0, 101.0, 99.0, 100.5])
+        revised = analysis_memo_key('bitcoin', None, {}, 7, '2024-01-01 00:00:00', [100.0, 101.5, 99.0, 101.2])
+        self.assertNotEqual(a, revised)
+        newer_result = analysis_memo_key('bitcoin', None, {}, 7, '2024-01-01 00:00:00', [100.0, 101.0, 99.0, 100.5],
+                                         source=['EMA_Only', '2024-01-01T00:10:00'])
+        self.assertNotEqual(a, newer_result)
+
+class TestAnalysisMemo(unittest.TestCase):
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.results = _IndexedResults(self.temp_dir)
+        self.key = analysis_memo_key('bitcoin', 'EMA_Only', {}, 7, '2024-01-01 00:00:00')
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_saved_analysis_is_found_by_a_fresh_memo(self):
+        self.results.save('bitcoin', {'analysis_id': 'a1', 'memo_key': self.key})
+        memo = AnalysisMemo(self.results)
+        self.assertEqual(memo.get(self.key)['analysis_id'], 'a1')
+        self.assertEqual(memo.get(self.key)['analysis_id'], 'a1')
+        self.assertEqual(self.results.lookups, 1)  # Second lookup served in-process
+        self.assertEqual(memo.stats()['persistent_hits'], 1)
+        self.assertEqual(memo.stats()['hits'], 1)
+
+    def test_miss_and_lru_eviction(self):
+        memo = AnalysisMemo(self.results, max_entries=2)
+        self.assertIsNone(memo.get(self.key))
+        for i in range(3):
+            memo.put(f"k{i}", {'analysis_id': i})
+        self.assertEqual(memo.stats()['entries'], 2)
+        self.assertIsNone(memo.get('k0'))
+        self.assertEqual(memo.get('k2')['analysis_id'], 2)
+
+    def test_returned_results_are_copies(self):
+        memo = AnalysisMemo(self.results)
+        memo.put(self.key, {'analysis_id': 'a1', 'lines': []})
+        memo.get(self.key)['lines'].append('mutated')
+        self.assertEqual(memo.get(self.key)['lines'], [])
+
+    def test_pickles_without_its_in_process_tier(self):
+        memo = AnalysisMemo(self.results)
+        memo.put(self.key, {'analysis_id': 'a1'})
+        clone = pickle.loads(pickle.dumps(memo))
+        self.assertEqual(clone.stats()['entries'], 0)
+        clone.put(self.key, {'analysis_id': 'a2'})
+        self.assertEqual(clone.get(self.key)['analysis_id'], 'a2')
+
+if __name__ == '__main__':
+    unittest.main()
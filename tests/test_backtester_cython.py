@@ -34,5 +34,323 @@ class TestBacktesterCython(unittest.TestCase):
         self.assertEqual(results['losing_trades'], 0)
         self.assertGreater(results['final_capital'], initial_capital)
 
+    def test_run_backtest_batch_cython_matches_single_runs(self):
+        # Arrange
+        rng = np.random.default_rng(42)
+        n = 200
+        prices = 100 + np.cumsum(rng.normal(0, 1, n))
+        long_entry = (rng.random((3, n)) > 0.9).astype(np.uint8)
+        short_entry = (rng.random((3, n)) > 0.9).astype(np.uint8)
+        long_exit = (rng.random((3, n)) > 0.9).astype(np.uint8)
+        short_exit = (rng.random((3, n)) > 0.9).astype(np.uint8)
+        atr_values = np.abs(rng.normal(1, 0.2, (1, n)))
+        pdi = np.full(n, 25.0)
+        ndi = np.full(n, 20.0)
+        adx = np.full(n, 30.0)
+        atr_multiple = np.array([1.5, 2.0, 3.0])
+        fixed_stop_loss_percentage = np.array([0.02, 0.05, 0.1])
+        take_profit_multiple = np.array([1.5, 2.0, 3.0])
+        long_exit_before = long_exit.copy()
+
+        # Act
+        batch = backtester_cython.run_backtest_batch_cython(
+            prices, long_entry, short_entry, long_exit, short_exit,
+            atr_values, adx, pdi, ndi, atr_multiple, fixed_stop_loss_percentage,
+            take_profit_multiple, 100.0, 0.01, 0.0005, 0.05, 2
+        )
+
+        # Assert
+        self.assertEqual(len(batch), 3)
+        np.testing.assert_array_equal(long_exit, long_exit_before)
+        for k in range(3):
+            single = backtester_cython.run_backtest_cython(
+                prices, long_entry[k], short_entry[k], long_exit[k].copy(), short_exit[k].copy(),
+                atr_values[0], adx, pdi, ndi, atr_multiple[k], fixed_stop_loss_percentage[k],
+                take_profit_multiple[k], 100.0, 0.01, 0.0005, 0.05
+            )
+            self.assertAlmostEqual(batch['final_capital'][k], single['final_capital'])
+            self.assertEqual(batch['total_trades'][k], single['total_trades'])
+            self.assertEqual(batch['winning_trades'][k], single['winning_trades'])
+            self.assertAlmostEqual(batch['max_drawdown'][k], single['max_drawdown'])
+            self.assertEqual(batch['backtest_trend'][k], 1)
+
+    def test_run_backtest_cython_records_trades_and_equity(self):
+        # Arrange
+        prices = np.array([100, 102, 104, 103, 101, 100, 98, 99], dtype=np.float64)
+        long_entry = np.array([1, 0, 0, 0, 0, 0, 0, 0], dtype=np.uint8)
+        short_entry = np.array([0, 0, 0, 0, 1, 0, 0, 0], dtype=np.uint8)
+        long_exit = np.array([0, 0, 1, 0, 0, 0, 0, 0], dtype=np.uint8)
+        short_exit = np.zeros(8, dtype=np.uint8)
+        atr_values = np.zeros(8, dtype=np.float64)
+        adx = np.full(8, 30.0)
+        pdi = np.full(8, 25.0)
+        ndi = np.full(8, 20.0)
+
+        # Act
+        results = backtester_cython.run_backtest_cython(
+            prices, long_entry, short_entry, long_exit, short_exit,
+            atr_values, adx, pdi, ndi, 2.0, 0.5, 2.0, 100.0, 0.0, 0.0, 0.05,
+            True, 365.0
+        )
+
+        # Assert
+        trades = results['trades']
+        self.assertEqual(len(trades), results['total_trades'])
+        self.assertEqual(list(trades['entry_index']), [0, 4])
+        self.assertEqual(list(trades['exit_index']), [2, 7])
+        self.assertEqual(list(trades['direction']), [1, -1])
+        self.assertEqual(backtester_cython.EXIT_REASONS[trades['exit_reason'][0]], 'signal')
+        self.assertEqual(backtester_cython.EXIT_REASONS[trades['exit_reason'][1]], 'end_of_data')
+        self.assertAlmostEqual(trades['profit_loss'].sum(), results['total_profit_loss'])
+        self.assertEqual(len(results['equity_curve']), len(prices))
+        self.assertAlmostEqual(results['equity_curve'][-1], results['final_capital'])
+        self.assertNotEqual(results['sharpe_ratio'], 0.0)
+        self.assertGreater(results['max_drawdown_duration'], 0)
+
+    def test_read_only_inputs_and_preallocated_results(self):
+        # Arrange
+        rng = np.random.default_rng(11)
+        n = 120
+        prices = 100 + np.cumsum(rng.normal(0, 1, n))
+        long_entry = rng.random(n) > 0.9
+        short_entry = rng.random(n) > 0.9
+        long_exit = rng.random(n) > 0.9
+        short_exit = rng.random(n) > 0.9
+        atr_values = np.abs(rng.normal(1, 0.2, n))
+        adx = np.full(n, 30.0)
+        pdi = np.full(n, 20.0)
+        ndi = np.full(n, 25.0)
+        for array in (prices, long_entry, short_entry, long_exit, short_exit, atr_values):
+            array.flags.writeable = False
+        results = np.zeros(2, dtype=backtester_cython.BATCH_RESULT_DTYPE)
+
+        # Act
+        single = backtester_cython.run_backtest_cython(
+            prices, long_entry, short_entry, long_exit, short_exit,
+            atr_values, adx, pdi, ndi, 2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, 0.05
+        )
+        backtester_cython.run_backtest_into(
+            results, 1, prices, long_entry, short_entry, long_exit, short_exit,
+            atr_values, pdi, ndi, 2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, 0.05
+        )
+
+        # Assert
+        self.assertAlmostEqual(results['final_capital'][1], single['final_capital'])
+        self.assertEqual(results['total_trades'][1], single['total_trades'])
+        self.assertAlmostEqual(results['win_rate'][1], single['win_rate'])
+        self.assertEqual(results['backtest_trend'][1], -1)
+        self.assertEqual(results['total_trades'][0], 0)
+
+    def test_run_backtest_cython_equity_checkpoints(self):
+        prices = np.linspace(100, 120, 10)
+        long_entry = np.array([1, 0, 0, 0, 0, 0, 0, 0, 0, 0], dtype=np.uint8)
+        signals = np.zeros(10, dtype=np.uint8)
+        flat = np.full(10, 20.0)
+
+        results = backtester_cython.run_backtest_cython(
+            prices, long_entry, signals, signals, signals, np.zeros(10), flat, flat, flat,
+            2.0, 0.5, 20.0, 100.0, 0.0, 0.0, 0.05, True, 0.0, 3
+        )
+
+        # Equity after bars 3, 6 and 9 and at the last bar, taken from the per-bar curve
+        np.testing.assert_allclose(results['equity_checkpoints'], results['equity_curve'][[2, 5, 8, 9]])
+        self.assertGreater(results['equity_checkpoints'][-1], results['equity_checkpoints'][0])
+
+    def test_stepped_backtest_matches_single_run(self):
+        # Arrange
+        rng = np.random.default_rng(5)
+        n = 200
+        prices = 100 + np.cumsum(rng.normal(0, 1, n))
+        long_entry = (rng.random(n) > 0.9).astype(np.uint8)
+        short_entry = (rng.random(n) > 0.9).astype(np.uint8)
+        long_exit = (rng.random(n) > 0.9).astype(np.uint8)
+        short_exit = (rng.random(n) > 0.9).astype(np.uint8)
+        atr_values = np.abs(rng.normal(1, 0.2, n))
+        flat = np.full(n, 20.0)
+        args = (prices, long_entry, short_entry, long_exit, short_exit, atr_values, flat, flat, flat,
+                2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, 0.05, True, 365.0)
+        single = backtester_cython.run_backtest_cython(*args, 30)
+
+        # Act: the position and stops carry over between slices of 30 bars
+        run = backtester_cython.SteppedBacktest(*args)
+        equities = []
+        while not run.done:
+            equities.append(run.advance(30))
+        stepped = run.results()
+
+        # Assert
+        self.assertEqual(run.bars_done, n)
+        np.testing.assert_allclose(equities, single['equity_checkpoints'])
+        for key in ('final_capital', 'total_trades', 'win_rate', 'max_drawdown', 'sharpe_ratio'):
+            self.assertAlmostEqual(stepped[key], single[key])
+        np.testing.assert_allclose(stepped['equity_curve'], single['equity_curve'])
+        self.assertEqual(list(stepped['trades']['exit_index']), list(single['trades']['exit_index']))
+
+    def test_stepped_backtest_results_need_every_bar(self):
+        prices = np.linspace(100, 120, 10)
+        signals = np.zeros(10, dtype=np.uint8)
+        flat = np.full(10, 20.0)
+        run = backtester_cython.SteppedBacktest(prices, signals, signals, signals, signals, np.zeros(10),
+                                                flat, flat, flat, 2.0, 0.5, 2.0, 100.0, 0.0, 0.0)
+
+        run.advance(4)
+
+        self.assertEqual(run.bars_done, 4)
+        self.assertFalse(run.done)
+        with self.assertRaises(RuntimeError):
+            run.results()
+
+    def test_run_backtest_windows_cython_matches_runs_on_each_slice(self):
+        # Arrange
+        rng = np.random.default_rng(7)
+        n = 150
+        prices = 100 + np.cumsum(rng.normal(0, 1, n))
+        long_entry = rng.random(n) > 0.9
+        short_entry = rng.random(n) > 0.9
+        long_exit = rng.random(n) > 0.9
+        short_exit = rng.random(n) > 0.9
+        atr_values = np.abs(rng.normal(1, 0.2, n))
+        adx = np.full(n, 30.0)
+        pdi = np.where(np.arange(n) < 100, 25.0, 15.0)
+        ndi = np.full(n, 20.0)
+        bounds = np.array([0, 50, 100, 150])
+
+        # Act
+        windows = backtester_cython.run_backtest_windows_cython(
+            prices, long_entry, short_entry, long_exit, short_exit,
+            atr_values, pdi, ndi, bounds, 2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, 365.0
+        )
+
+        # Assert
+        self.assertEqual(len(windows), 3)
+        for k in range(3):
+            start, end = bounds[k], bounds[k + 1]
+            volatility = abs((prices[end - 1] - prices[start]) / prices[start])
+            single = backtester_cython.run_backtest_cython(
+                prices[start:end], long_entry[start:end], short_entry[start:end], long_exit[start:end],
+                short_exit[start:end], atr_values[start:end], adx[start:end], pdi[start:end], ndi[start:end],
+                2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, volatility, False, 365.0
+            )
+            self.assertEqual((windows['start'][k], windows['end'][k]), (start, end))
+            self.assertAlmostEqual(windows['final_capital'][k], single['final_capital'])
+            self.assertEqual(windows['total_trades'][k], single['total_trades'])
+            self.assertAlmostEqual(windows['max_drawdown'][k], single['max_drawdown'])
+            self.assertAlmostEqual(windows['sharpe_ratio'][k], single['sharpe_ratio'])
+        self.assertEqual(list(windows['backtest_trend']), [1, 1, -1])
+
+    def test_monte_carlo_without_perturbation_matches_single_run(self):
+        rng = np.random.default_rng(7)
+        n = 300
+        prices = 100 + np.cumsum(rng.normal(0, 1, n))
+        long_entry = rng.random(n) > 0.9
+        short_entry = rng.random(n) > 0.9
+        long_exit = rng.random(n) > 0.9
+        short_exit = rng.random(n) > 0.9
+        atr_values = np.abs(rng.normal(1, 0.2, n))
+        ones = np.ones(n)
+
+        paths = backtester_cython.run_backtest_monte_carlo_cython(
+            prices, long_entry, short_entry, long_exit, short_exit, atr_values,
+            2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, 8
+        )
+        single = backtester_cython.run_backtest_cython(
+            prices, long_entry, short_entry, long_exit, short_exit, atr_values, ones, ones, ones,
+            2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, abs((prices[-1] - prices[0]) / prices[0])
+        )
+
+        np.testing.assert_allclose(paths['final_capital'], single['final_capital'])
+        np.testing.assert_allclose(paths['max_drawdown'], single['max_drawdown'])
+        np.testing.assert_array_equal(paths['total_trades'], single['total_trades'])
+        np.testing.assert_allclose(paths['spread_percentage'], 0.01)
+
+    def test_monte_carlo_is_reproducible_across_thread_counts(self):
+        rng = np.random.default_rng(11)
+        n = 200
+        prices = 100 + np.cumsum(rng.normal(0, 1, n))
+        signals = [(rng.random(n) > 0.9).astype(np.uint8) for _ in range(4)]
+        atr_values = np.abs(rng.normal(1, 0.2, n))
+
+        def run(seed, num_threads):
+            return backtester_cython.run_backtest_monte_carlo_cython(
+                prices, *signals, atr_values, 2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, 64,
+                noise_sigma=0.01, cost_multiple_max=3.0, seed=seed, num_threads=num_threads
+            )
+
+        first = run(5, 1)
+        np.testing.assert_array_equal(first, run(5, 4))
+        self.assertFalse(np.array_equal(first['final_capital'], run(6, 1)['final_capital']))
+        self.assertTrue(np.all((first['spread_percentage'] >= 0.01) & (first['spread_percentage'] <= 0.03)))
+        self.assertGreater(len(np.unique(first['final_capital'])), 1) # The paths differ
+
+        with self.assertRaises(ValueError):
+            backtester_cython.run_backtest_monte_carlo_cython(
+                prices, *signals, atr_values, 2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, 4, cost_multiple_max=0.5
+            )
+
+    def test_run_backtest_windows_cython_rejects_bad_bounds(self):
+        prices = np.linspace(100, 110, 10)
+        signals = np.zeros(10, dtype=np.uint8)
+        ones = np.ones(10)
+        for bounds in ([0], [0, 5, 5, 10], [0, 11]):
+            with self.assertRaises(ValueError):
+                backtester_cython.run_backtest_windows_cython(
+                    prices, signals, signals, signals, signals, ones, ones, ones,
+                    np.array(bounds), 2.0, 0.05, 2.0, 100.0, 0.0, 0.0
+                )
+
+    def test_portfolio_of_one_asset_matches_single_run(self):
+        # Arrange
+        rng = np.random.default_rng(5)
+        n = 200
+        prices = 100 + np.cumsum(rng.normal(0, 0.5, n))
+        long_entry = (rng.random(n) > 0.9).astype(np.uint8)
+        short_entry = (rng.random(n) > 0.9).astype(np.uint8)
+        long_exit = (rng.random(n) > 0.9).astype(np.uint8)
+        short_exit = (rng.random(n) > 0.9).astype(np.uint8)
+        long_entry[-1] = short_entry[-1] = 0  # The portfolio takes no entries on the last bar
+        atr_values = np.abs(rng.normal(1, 0.2, n))
+        flat = np.full(n, 20.0)
+
+        # Act
+        single = backtester_cython.run_backtest_cython(
+            prices, long_entry, short_entry, long_exit, short_exit,
+            atr_values, flat, flat, flat, 2.0, 0.05, 2.0, 100.0, 0.01, 0.0005, 0.05
+        )
+        portfolio = backtester_cython.run_portfolio_backtest_cython(
+            prices[None, :], long_entry[None, :], short_entry[None, :], long_exit[None, :],
+            short_exit[None, :], atr_values[None, :], 2.0, 0.05, 2.0, 100.0, 0.01, 0.0005
+        )
+
+        # Assert
+        self.assertAlmostEqual(portfolio['final_capital'], single['final_capital'])
+        self.assertEqual(portfolio['total_trades'], single['total_trades'])
+        self.assertAlmostEqual(portfolio['max_drawdown'], single['max_drawdown'])
+        self.assertEqual(portfolio['assets']['total_trades'][0], single['total_trades'])
+
+    def test_portfolio_shares_capital_and_position_slots(self):
+        # Arrange: both assets signal a long entry on bar 1, only one slot is available
+        prices = np.array([[100, 100, 105, 110, 110], [50, 50, 40, 30, 30]], dtype=np.float64)
+        long_entry = np.zeros((2, 5), dtype=np.uint8)
+        long_entry[:, 1] = 1
+        long_exit = np.zeros((2, 5), dtype=np.uint8)
+        long_exit[:, 3] = 1
+        none = np.zeros((2, 5), dtype=np.uint8)
+        atr_values = np.zeros((2, 5))
+
+        # Act
+        results = backtester_cython.run_portfolio_backtest_cython(
+            prices, long_entry, none, long_exit, none, atr_values,
+            2.0, 0.5, 10.0, 100.0, 0.0, 0.0, 1, 0.0, True
+        )
+
+        # Assert
+        self.assertEqual(results['skipped_entries'], 1)
+        self.assertEqual(results['max_open_positions'], 1)
+        self.assertEqual(list(results['assets']['total_trades']), [1, 0])
+        self.assertEqual(list(results['trades']['asset']), [0])
+        self.assertAlmostEqual(results['trades']['size'][0], 20.0)  # 20% base sizing of the pool
+        self.assertAlmostEqual(results['final_capital'], 102.0)
+        self.assertAlmostEqual(results['equity_curve'][2], 101.0)  # Open position marked to market
+
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file
@@ -0,0 +1,48 @@
+import os
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from benchmarks.harness import Benchmark, append_run, baseline, compare, load_history, time_case
+
+def _result(name, median_s, size='1k'):
+    return {'name': name, 'size': size, 'median_s': median_s}
+
+class TestBenchmarkHarness(unittest.TestCase):
+
+    def test_time_case_runs_setup_once_and_reports_per_bar(self):
+        setups = []
+        def setup(n_bars):
+            setups.append(n_bars)
+            return list(range(n_bars))
+        result = time_case(Benchmark('sum', setup, sum), '1k', repeat=3, min_time=0.001)
+        self.assertEqual(setups, [1000])
+        self.assertEqual(result['repeat'], 3)
+        self.assertLessEqual(result['min_s'], result['median_s'])
+        self.assertAlmostEqual(result['ns_per_bar'], result['median_s'] / 1000 * 1e9)
+
+    def test_baseline_is_the_median_of_the_latest_runs(self):
+        history = [{'results': [_result('a', seconds)]} for seconds in (9.0, 1.0, 2.0, 3.0)]
+        history.append({'results': [_result('b', 5.0)]})  # Runs missing a case do not count for it
+        self.assertEqual(baseline(history, last_runs=3), {('a', '1k'): 2.0, ('b', '1k'): 5.0})
+
+    def test_only_slowdowns_past_the_threshold_are_regressions(self):
+        reference = {('a', '1k'): 1.0, ('b', '1k'): 1.0}
+        results = [_result('a', 1.2), _result('b', 1.5), _result('new', 9.0)]
+        regressions = compare(results, reference, threshold=1.25)
+        self.assertEqual([(r['name'], r['ratio']) for r in regressions], [('b', 1.5)])
+
+    def test_history_round_trip_skips_torn_lines(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, 'results', 'host.jsonl')
+            append_run(path, [_result('a', 1.0)], {'machine': 'host'})
+            with open(path, 'a') as f:
+                f.write('{"timestamp": ')
+            history = load_history(path)
+        self.assertEqual(len(history), 1)
+        self.assertEqual(history[0]['environment'], {'machine': 'host'})
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,69 @@
+import os
+import sys
+import unittest
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.candle_resampler import CandleResampler, can_resample, resample_records
+from core.ohlc_store import rows_to_records
+
+BAR_MS = 30 * 60 * 1000
+
+def make_records(start_bar, count):
+    # Candle i closes at (start_bar + i) half hours; high/low bracket the close by the bar number
+    return rows_to_records([[(start_bar + i) * BAR_MS, 100.0 + i, 101.0 + i + (i % 3), 99.0 + i - (i % 2), 100.5 + i]
+                            for i in range(count)])
+
+class TestResampleRecords(unittest.TestCase):
+
+    def test_hourly_candles_aggregate_pairs_of_half_hours(self):
+        records = make_records(1, 6) # Closes at 0:30 .. 3:00
+
+        hourly = resample_records(records, '30m', '1h')
+
+        self.assertEqual(list(hourly['timestamp']), [2 * BAR_MS, 4 * BAR_MS, 6 * BAR_MS])
+        # The 1:30 and 2:00 candles make the bucket closing at 2:00
+        self.assertEqual(hourly['open'][1], records['open'][2])
+        self.assertEqual(hourly['close'][1], records['close'][3])
+        self.assertEqual(hourly['high'][1], records['high'][2:4].max())
+        self.assertEqual(hourly['low'][1], records['low'][2:4].min())
+
+    def test_partial_leading_bucket_is_dropped(self):
+        records = make_records(2, 5) # The hour closing at 1:00 only has its 1:00 candle
+
+        hourly = resample_records(records, '30m', '1h')
+
+        self.assertEqual(list(hourly['timestamp']), [4 * BAR_MS, 6 * BAR_MS])
+        self.assertEqual(hourly['open'][0], records['open'][1])
+
+    def test_incompatible_intervals(self):
+        self.assertTrue(can_resample('30m', '4h'))
+        self.assertFalse(can_resample('4h', '1h'))
+        self.assertTrue(can_resample('4h', '1d'))
+        with self.assertRaises(ValueError):
+            resample_records(make_records(0, 4), '4h', '1h')
+
+class TestCandleResampler(unittest.TestCase):
+
+    def test_cached_until_the_history_changes(self):
+        resampler = CandleResampler()
+        records = make_records(0, 16)
+
+        first = resampler.resample('bitcoin', records, '30m', '4h')
+        self.assertIs(resampler.resample('bitcoin', records, '30m', '4h'), first)
+        self.assertFalse(first.flags.writeable)
+
+        grown = make_records(0, 17)
+        self.assertIsNot(resampler.resample('bitcoin', grown, '30m', '4h'), first)
+
+    def test_start_ms_slices_the_derived_series(self):
+        resampler = CandleResampler()
+        records = make_records(0, 16)
+
+        recent = resampler.resample('bitcoin', records, '30m', '1h', start_ms=10 * BAR_MS)
+
+        self.assertEqual(recent['timestamp'][0], 10 * BAR_MS)
+
+if __name__ == '__main__':
+    unittest.main()
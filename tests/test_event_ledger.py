@@ -0,0 +1,126 @@
+import json
+import os
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.event_ledger import EventLedger, open_ledger
+from core.paper_ledger import (apply_trade_event, initial_trades_state, load_analysis_history,
+                               trades_from_legacy, apply_analysis_event, initial_analysis_state,
+                               ANALYSIS_HISTORY_LIMIT, ANALYSIS_LEDGER)
+
+class TestEventLedger(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.base = os.path.join(self.tmp.name, 'paper_trades')
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def _open(self, **kwargs):
+        return EventLedger(self.base, initial_trades_state(100.0), apply_trade_event, **kwargs)
+
+    def _trade_events(self, ledger):
+        ledger.append('open', {'position': {'position_id': 'a', 'stop_loss_price': 9.0}, 'available_capital': 90.0})
+        ledger.append('open', {'position': {'position_id': 'b', 'stop_loss_price': 5.0}, 'available_capital': 80.0})
+        ledger.append('update', {'position_id': 'a', 'fields': {'stop_loss_price': 9.5}})
+        ledger.append('close', {'position_id': 'b', 'trade': {'position_id': 'b', 'pnl_usd': 1.0}, 'available_capital': 91.0})
+
+    def test_state_is_rebuilt_from_the_event_log(self):
+        ledger = self._open()
+        self._trade_events(ledger)
+        ledger.close()
+        reopened = self._open()
+        state = reopened.snapshot()
+        reopened.close()
+        self.assertEqual(state['open_positions'], [{'position_id': 'a', 'stop_loss_price': 9.5}])
+        self.assertEqual(state['trade_history'], [{'position_id': 'b', 'pnl_usd': 1.0}])
+        self.assertEqual(state['available_capital'], 91.0)
+
+    def test_compaction_snapshots_and_truncates_the_log(self):
+        ledger = self._open(snapshot_every=3)
+        self._trade_events(ledger)
+        ledger.close()
+        with open(self.base + '.snapshot.json') as f:
+            self.assertEqual(json.load(f)['seq'], 3)
+        with open(self.base + '.events.jsonl') as f:
+            self.assertEqual(len(f.readlines()), 1)  # Only the close is replayed
+        reopened = self._open(snapshot_every=3)
+        self.assertEqual(reopened.seq, 4)
+        self.assertEqual(reopened.snapshot('available_capital'), 91.0)
+        reopened.close()
+
+    def test_two_instances_share_the_log(self):
+        # Two engines (threads or processes) writing the same ledger
+        first = self._open(snapshot_every=3)
+        second = self._open(snapshot_every=3)
+        first.append('open', {'position': {'position_id': 'a', 'stop_loss_price': 9.0}, 'available_capital': 90.0})
+        second.append('open', {'position': {'position_id': 'b', 'stop_loss_price': 5.0}, 'available_capital': 80.0})
+        first.append('update', {'position_id': 'a', 'fields': {'stop_loss_price': 9.5}}) # Compacts
+        second.append('close', {'position_id': 'b', 'trade': {'position_id': 'b', 'pnl_usd': 1.0}, 'available_capital': 91.0})
+        self.assertEqual(first.snapshot('available_capital'), 91.0)
+        first.close()
+        second.close()
+
+        with open(self.base + '.events.jsonl') as f:
+            self.assertEqual([json.loads(line)['seq'] for line in f], [4])
+        reopened = self._open()
+        state = reopened.snapshot()
+        reopened.close()
+        self.assertEqual(reopened.seq, 4)
+        self.assertEqual(state['open_positions'], [{'position_id': 'a', 'stop_loss_price': 9.5}])
+        self.assertEqual(state['trade_history'], [{'position_id': 'b', 'pnl_usd': 1.0}])
+
+    def test_open_ledger_shares_one_instance_per_path(self):
+        ledger = open_ledger(self.base, initial_trades_state(100.0), apply_trade_event)
+        self.assertIs(open_ledger(self.base, initial_trades_state(100.0), apply_trade_event), ledger)
+        ledger.close()
+        reopened = open_ledger(self.base, initial_trades_state(100.0), apply_trade_event)
+        self.assertIsNot(reopened, ledger)
+        reopened.close()
+
+    def test_torn_last_line_is_dropped(self):
+        ledger = self._open()
+        self._trade_events(ledger)
+        ledger.close()
+        with open(self.base + '.events.jsonl', 'a') as f:
+            f.write('{"seq": 5, "type": "open", "da')
+        ledger = self._open()
+        self.assertEqual(ledger.seq, 4)
+        ledger.append('open', {'position': {'position_id': 'c'}, 'available_capital': 81.0})
+        ledger.close()
+        reopened = self._open()
+        self.assertEqual([p['position_id'] for p in reopened.snapshot('open_positions')], ['a', 'c'])
+        reopened.close()
+
+    def test_legacy_file_is_imported_once(self):
+        legacy_path = os.path.join(self.tmp.name, 'paper_trades.json')
+        with open(legacy_path, 'w') as f:
+            json.dump({'open_positions': [{'crypto_id': 'bitcoin'}], 'trade_history': [], 'portfolio_value': 70.0}, f)
+        ledger = self._open(legacy_path=legacy_path, from_legacy=trades_from_legacy)
+        position = ledger.snapshot('open_positions')[0]
+        self.assertIn('position_id', position)  # Assigned so later events can refer to it
+        self.assertEqual(ledger.snapshot('available_capital'), 70.0)
+        ledger.append('close', {'position_id': position['position_id'], 'trade': position, 'available_capital': 75.0})
+        ledger.close()
+        reopened = self._open(legacy_path=legacy_path, from_legacy=trades_from_legacy)
+        state = reopened.snapshot()
+        reopened.close()
+        self.assertEqual(state['open_positions'], [])
+        self.assertEqual(state['available_capital'], 75.0)
+
+    def test_analysis_history_keeps_the_latest_entries(self):
+        ledger = EventLedger(os.path.join(self.tmp.name, ANALYSIS_LEDGER), initial_analysis_state(),
+                             apply_analysis_event, snapshot_every=50)
+        for i in range(ANALYSIS_HISTORY_LIMIT + 20):
+            ledger.append('analysis', {'cycle': i})
+        history = load_analysis_history(self.tmp.name)  # Read-only, as ResultManager does
+        self.assertEqual(len(history), ANALYSIS_HISTORY_LIMIT)
+        self.assertEqual(history[-1], {'cycle': ANALYSIS_HISTORY_LIMIT + 19})
+        ledger.close()
+
+if __name__ == '__main__':
+    unittest.main()
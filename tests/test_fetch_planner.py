@@ -0,0 +1,82 @@
+import os
+import sys
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.fetch_planner import FetchPlanner, request_count
+
+class FakeFetcher:
+    """DataFetcher stand-in recording the upstream calls the planner makes."""
+
+    def __init__(self, cached_ohlc=(), cached_prices=None):
+        self.cached_ohlc = set(cached_ohlc)
+        self._cached_prices = dict(cached_prices or {})
+        self.calls = []
+
+    def is_ohlc_cached(self, crypto_id, days):
+        return (crypto_id, days) in self.cached_ohlc
+
+    def read_cached_ohlc(self, crypto_id, days):
+        return []
+
+    def cached_prices(self, crypto_ids):
+        return {c: self._cached_prices[c] for c in crypto_ids if c in self._cached_prices}
+
+    def remember_prices(self, prices):
+        pass
+
+    def _get_current_prices_from_api(self, crypto_ids):
+        self.calls.append(('prices', tuple(crypto_ids)))
+        return {c: 1.0 for c in crypto_ids}
+
+    def make_coingecko_request(self, url, params=None):
+        self.calls.append(('markets', params['ids']))
+        return [{'id': c, 'current_price': 2.0} for c in params['ids'].split(',')]
+
+    def fetch_ohlc_data(self, crypto_id, days):
+        self.calls.append(('ohlc', crypto_id, days))
+        if crypto_id == 'broken':
+            raise RuntimeError("upstream down")
+        return []
+
+class TestFetchPlanner(unittest.TestCase):
+
+    def test_windows_of_one_interval_fold_into_the_widest(self):
+        planner = FetchPlanner(FakeFetcher())
+        for days in (1, 2, 7, 30, 90):
+            planner.need_ohlc('bitcoin', days)
+        plan = planner.plan()
+        # 1-2 days are 30m candles, 3-30 days 4h, more 4d
+        self.assertEqual(plan.ohlc_fetches, {('bitcoin', '30m'): 2, ('bitcoin', '4h'): 30, ('bitcoin', '4d'): 90})
+
+    def test_cached_needs_make_no_requests(self):
+        fetcher = FakeFetcher(cached_ohlc={('bitcoin', 1)}, cached_prices={'bitcoin': 5.0})
+        planner = FetchPlanner(fetcher)
+        planner.need_prices(['bitcoin'])
+        planner.need_ohlc('bitcoin', 1)
+        self.assertEqual(request_count(planner.plan()), 0)
+        result = planner.execute()
+        self.assertEqual(result.prices, {'bitcoin': 5.0})
+        self.assertEqual(fetcher.calls, [])
+
+    def test_prices_are_batched_and_served_from_market_rows(self):
+        fetcher = FakeFetcher()
+        planner = FetchPlanner(fetcher)
+        planner.need_prices(['a', 'b', 'c'])
+        planner.need_markets(['c'])
+        result = planner.execute()
+        self.assertEqual(sorted(fetcher.calls), [('markets', 'c'), ('prices', ('a', 'b'))])
+        self.assertEqual(result.prices, {'a': 1.0, 'b': 1.0, 'c': 2.0})
+
+    def test_failed_fetch_is_reported_per_need(self):
+        planner = FetchPlanner(FakeFetcher())
+        planner.need_ohlc('broken', 1)
+        planner.need_ohlc('broken', 2)
+        planner.need_ohlc('bitcoin', 1)
+        result = planner.execute()
+        self.assertEqual(set(result.errors), {('ohlc', 'broken', 1), ('ohlc', 'broken', 2)})
+        self.assertIsNone(result.ohlc[('bitcoin', 1)])  # Fetched, but nothing stored
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,53 @@
+import os
+import sys
+import unittest
+from unittest import mock
+
+import requests
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core import http_client
+from core.http_client import RetryPolicy
+
+def _response(status_code, headers=None):
+    response = requests.Response()
+    response.status_code = status_code
+    response.headers.update(headers or {})
+    return response
+
+class TestRetryPolicy(unittest.TestCase):
+
+    def setUp(self):
+        self.policy = RetryPolicy(retries=3, base_delay=1.0, max_delay=30.0)
+
+    def test_transient_failures_back_off_with_jitter(self):
+        for attempt in range(3):
+            delay = self.policy.delay(attempt, _response(503))
+            self.assertGreaterEqual(delay, 0.0)
+            self.assertLessEqual(delay, 2 ** attempt)
+        self.assertIsNotNone(self.policy.delay(0, error=requests.exceptions.ConnectionError()))
+        self.assertIsNotNone(self.policy.delay(0, error=requests.exceptions.ReadTimeout()))
+        self.assertIsNone(self.policy.delay(3, _response(503))) # Out of retries
+
+    def test_other_outcomes_are_returned_as_is(self):
+        self.assertIsNone(self.policy.delay(0, _response(200)))
+        self.assertIsNone(self.policy.delay(0, _response(404)))
+        self.assertIsNone(self.policy.delay(0, error=ValueError("bad json")))
+
+    def test_retry_after_is_honoured_within_the_cap(self):
+        self.assertGreaterEqual(self.policy.delay(0, _response(429, {'Retry-After': '12'})), 12.0)
+        self.assertEqual(self.policy.delay(0, _response(429, {'Retry-After': '600'})), 30.0)
+
+class TestSession(unittest.TestCase):
+
+    def test_one_pooled_session_per_process(self):
+        with mock.patch.object(http_client, '_session', None):
+            session = http_client.get_session()
+            self.assertIs(http_client.get_session(), session)
+            self.assertIn('gzip', session.headers['Accept-Encoding'])
+            with mock.patch.object(http_client.os, 'getpid', return_value=-1): # As in a forked child
+                self.assertIsNot(http_client.get_session(), session)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,77 @@
+import os
+import sys
+import threading
+import time
+import unittest
+import numpy as np
+import pandas as pd
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.indicator_cache import IndicatorCache
+
+class TestIndicatorCache(unittest.TestCase):
+
+    def setUp(self):
+        dates = pd.date_range('2023-01-01', periods=50, freq='30min')
+        self.data = pd.DataFrame({'close': np.arange(50, dtype=np.float64)}, index=dates)
+
+    def test_repeated_lookup_is_a_hit(self):
+        cache = IndicatorCache()
+        view = cache.for_dataset('bitcoin', '30m', self.data)
+        calls = []
+
+        def compute():
+            calls.append(1)
+            return self.data['close'].rolling(5).mean()
+
+        first = view.get_or_compute('sma', (5,), compute)
+        second = view.get_or_compute('sma', (5,), compute)
+
+        self.assertIs(first, second)
+        self.assertEqual(len(calls), 1)
+        self.assertEqual(cache.stats()['hits'], 1)
+        self.assertEqual(cache.stats()['misses'], 1)
+
+    def test_datasets_do_not_share_entries(self):
+        cache = IndicatorCache()
+        other = self.data.iloc[:-1]
+        a = cache.for_dataset('bitcoin', '30m', self.data).get_or_compute('sma', (5,), lambda: 'a')
+        b = cache.for_dataset('bitcoin', '30m', other).get_or_compute('sma', (5,), lambda: 'b')
+        c = cache.for_dataset('ethereum', '30m', self.data).get_or_compute('sma', (5,), lambda: 'c')
+        self.assertEqual((a, b, c), ('a', 'b', 'c'))
+
+    def test_memory_budget_evicts_least_recently_used(self):
+        series = self.data['close']
+        cache = IndicatorCache(max_bytes=2 * series.nbytes)
+        view = cache.for_dataset('bitcoin', '30m', self.data)
+        for period in (1, 2, 3):
+            view.get_or_compute('sma', (period,), lambda: series.copy())
+
+        stats = cache.stats()
+        self.assertEqual(stats['entries'], 2)
+        self.assertEqual(stats['evictions'], 1)
+        self.assertLessEqual(stats['bytes'], stats['max_bytes'])
+
+    def test_concurrent_misses_compute_once(self):
+        cache = IndicatorCache()
+        view = cache.for_dataset('bitcoin', '30m', self.data)
+        calls = []
+
+        def compute():
+            calls.append(1)
+            time.sleep(0.05)
+            return self.data['close']
+
+        threads = [threading.Thread(target=view.get_or_compute, args=('atr', (14,), compute)) for _ in range(8)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        self.assertEqual(len(calls), 1)
+        self.assertEqual(cache.stats()['misses'], 1)
+        self.assertEqual(cache.stats()['hits'], 7)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,58 @@
+import unittest
+import numpy as np
+import pandas as pd
+import ta
+import indicators_cython
+
+class TestIndicatorsCython(unittest.TestCase):
+    """The native engine must reproduce the pandas/ta reference values."""
+
+    def setUp(self):
+        rng = np.random.default_rng(7)
+        prices = 100 + np.cumsum(rng.normal(0, 0.5, 300))
+        self.df = pd.DataFrame({
+            'high': prices + np.abs(rng.normal(0, 0.2, 300)),
+            'low': prices - np.abs(rng.normal(0, 0.2, 300)),
+            'close': prices,
+        })
+        self.high = self.df['high'].to_numpy()
+        self.low = self.df['low'].to_numpy()
+        self.close = self.df['close'].to_numpy()
+
+    def assertMatches(self, native, reference):
+        np.testing.assert_allclose(native, np.asarray(reference, dtype=np.float64), rtol=1e-10, atol=1e-10, equal_nan=True)
+
+    def test_sma_matches_pandas(self):
+        self.assertMatches(indicators_cython.sma(self.close, 20), self.df['close'].rolling(window=20).mean())
+
+    def test_ema_matches_pandas(self):
+        self.assertMatches(indicators_cython.ema(self.close, 12), self.df['close'].ewm(span=12, adjust=False).mean())
+
+    def test_rsi_matches_ta(self):
+        self.assertMatches(indicators_cython.rsi(self.close, 14), ta.momentum.rsi(self.df['close'], window=14))
+
+    def test_macd_matches_ta(self):
+        macd_line, macd_signal = indicators_cython.macd(self.close, 26, 12, 9)
+        self.assertMatches(macd_line, ta.trend.macd(self.df['close'], window_slow=26, window_fast=12))
+        self.assertMatches(macd_signal, ta.trend.macd_signal(self.df['close'], window_slow=26, window_fast=12, window_sign=9))
+
+    def test_bbands_matches_ta(self):
+        bb_mavg, bb_hband, bb_lband = indicators_cython.bbands(self.close, 20, 2)
+        indicator_bb = ta.volatility.BollingerBands(close=self.df['close'], window=20, window_dev=2)
+        self.assertMatches(bb_mavg, indicator_bb.bollinger_mavg())
+        self.assertMatches(bb_hband, indicator_bb.bollinger_hband())
+        self.assertMatches(bb_lband, indicator_bb.bollinger_lband())
+
+    def test_atr_matches_ta(self):
+        self.assertMatches(indicators_cython.atr(self.high, self.low, self.close, 14),
+                           ta.volatility.average_true_range(high=self.df['high'], low=self.df['low'], close=self.df['close'], window=14))
+
+    def test_adx_matches_ta(self):
+        adx, pdi, ndi = indicators_cython.adx(self.high, self.low, self.close, 14)
+        adx_indicator = ta.trend.ADXIndicator(high=self.df['high'], low=self.df['low'], close=self.df['close'], window=14)
+        self.assertMatches(adx, adx_indicator.adx())
+        self.assertMatches(pdi, adx_indicator.adx_pos())
+        self.assertMatches(ndi, adx_indicator.adx_neg())
+
+if __name__ == '__main__':
+    unittest.main()
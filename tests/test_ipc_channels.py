@@ -0,0 +1,89 @@
+import multiprocessing
+import os
+import sys
+import threading
+import unittest
+
+import requests
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.ipc_channels import ARENA_MIN_BYTES, PayloadArena, ReplyChannel, ReplySender
+
+def _response(body: bytes, status_code: int = 200) -> requests.Response:
+    response = requests.Response()
+    response.status_code = status_code
+    response.url = 'https://api.coingecko.com/api/v3/coins/markets'
+    response.encoding = 'utf-8'
+    response._content = body
+    return response
+
+def _send_replies(reply_to, replies):
+    sender = ReplySender(reply_to)
+    for request_id, result in replies:
+        sender.send(request_id, result)
+    sender.close()
+
+class TestPayloadArena(unittest.TestCase):
+
+    def setUp(self):
+        self.arena = PayloadArena(size=100)
+        self.producer = PayloadArena(name=self.arena.name)
+
+    def tearDown(self):
+        self.producer.close()
+        self.arena.close()
+
+    def test_bodies_wrap_to_the_start_once_released(self):
+        first = self.producer.write(b'a' * 60)
+        self.assertEqual(first, (0, 60))
+        self.assertIsNone(self.producer.write(b'b' * 60))  # Not released yet
+        self.assertEqual(bytes(self.arena.view(*first)), b'a' * 60)
+        self.arena.release(sum(first))
+        second = self.producer.write(b'b' * 60)
+        self.assertEqual(second, (100, 60))  # The 40-byte tail is skipped
+        self.assertEqual(bytes(self.arena.view(*second)), b'b' * 60)
+
+    def test_oversized_bodies_do_not_fit(self):
+        self.assertIsNone(self.producer.write(b'x' * 101))
+
+class TestReplyChannel(unittest.TestCase):
+
+    def setUp(self):
+        self.replies = {}
+        self.done = threading.Event()
+        def on_reply(request_id, result):
+            self.replies[request_id] = result
+            if len(self.replies) == 3:
+                self.done.set()
+        self.channel = ReplyChannel(on_reply, arena_bytes=4 * ARENA_MIN_BYTES)
+
+    def tearDown(self):
+        self.channel.close()
+
+    def test_replies_from_another_process(self):
+        large = b'[' + b','.join([b'1'] * ARENA_MIN_BYTES) + b']'  # Passed through the arena
+        replies = [('small', _response(b'{"ok": true}')), ('large', _response(large)), ('error', ValueError("boom"))]
+        process = multiprocessing.Process(target=_send_replies, args=(self.channel.reply_to, replies))
+        process.start()
+        self.assertTrue(self.done.wait(10))
+        process.join(10)
+
+        self.assertEqual(self.replies['small'].json(), {'ok': True})
+        self.assertEqual(len(self.replies['large'].json()), ARENA_MIN_BYTES)
+        self.assertEqual(self.replies['large'].status_code, 200)
+        self.assertIsInstance(self.replies['error'], ValueError)
+
+    def test_http_errors_survive_the_arena(self):
+        body = b'x' * ARENA_MIN_BYTES
+        process = multiprocessing.Process(target=_send_replies, args=(self.channel.reply_to, [
+            ('a', _response(body, 429)), ('b', _response(b'{}')), ('c', _response(b'{}'))]))
+        process.start()
+        self.assertTrue(self.done.wait(10))
+        process.join(10)
+        with self.assertRaises(requests.exceptions.HTTPError):
+            self.replies['a'].raise_for_status()
+        self.assertEqual(self.replies['a'].content, body)
+
+if __name__ == '__main__':
+    unittest.main()
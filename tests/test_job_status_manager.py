@@ -0,0 +1,92 @@
+import json
+import os
+import sys
+import tempfile
+import time
+import unittest
+from pathlib import Path
+from unittest import mock
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core import job_status_manager
+
+class TestJobControl(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.control = job_status_manager._JobControl()
+        patches = [mock.patch.object(job_status_manager, 'JOB_STATUS_DIR', Path(self.tmp.name)),
+                   mock.patch.object(job_status_manager, '_control', self.control),
+                   mock.patch.object(job_status_manager, 'CONTROL_POLL_SECONDS', 0.01),
+                   mock.patch.object(job_status_manager, 'STATUS_FLUSH_SECONDS', 3600)]
+        for patch in patches:
+            patch.start()
+            self.addCleanup(patch.stop)
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def _on_disk(self, job_id):
+        with open(job_status_manager._get_status_filepath(job_id)) as f:
+            return json.load(f)
+
+    def _wait_for(self, condition):
+        deadline = time.monotonic() + 2.0
+        while not condition() and time.monotonic() < deadline:
+            time.sleep(0.01)
+        return condition()
+
+    def test_stop_written_by_another_process_reaches_the_cached_flag(self):
+        job_status_manager.update_job_status('job', 'running', 'Optimization started.')
+        self.assertFalse(job_status_manager.is_job_stop_requested('job')) # Starts watching the job
+
+        # What request_job_stop writes from the API process
+        status = self._on_disk('job')
+        status['stop_requested'] = True
+        job_status_manager._write_status_file(job_status_manager._get_status_filepath('job'), status)
+        os.utime(job_status_manager._get_status_filepath('job'), ns=(0, 0)) # A visible mtime change on coarse filesystems
+
+        self.assertTrue(self._wait_for(lambda: job_status_manager.is_job_stop_requested('job')))
+
+    def test_stop_in_this_process_is_seen_at_once(self):
+        job_status_manager.update_job_status('job', 'running')
+        with mock.patch.object(job_status_manager.os, 'kill') as kill:
+            job_status_manager.register_job_process('job', 4242)
+            job_status_manager.request_job_stop('job')
+        kill.assert_called_once_with(4242, job_status_manager.signal.SIGTERM)
+        self.assertTrue(job_status_manager.is_job_stop_requested('job'))
+        self.assertEqual(self._on_disk('job')['pids'], [])
+
+    def test_progress_updates_are_batched_until_the_status_changes(self):
+        job_status_manager.update_job_status('job', 'running', 'Optimization started.', log_path='job.log')
+        job_status_manager.update_job_status('job', 'running', 'Trial 1', progress=0.1)
+        job_status_manager.update_job_status('job', 'running', 'Trial 2', progress=0.2)
+
+        self.assertEqual(self._on_disk('job')['message'], 'Optimization started.')
+        self.assertEqual(job_status_manager.get_job_status('job')['message'], 'Trial 2') # Pending fields overlaid
+
+        job_status_manager.update_job_status('job', 'completed', 'Done.')
+        status = self._on_disk('job')
+        self.assertEqual((status['status'], status['message'], status['progress']), ('completed', 'Done.', 0.2))
+        self.assertEqual(status['log_path'], 'job.log')
+
+    def test_flush_writes_batched_updates(self):
+        job_status_manager.update_job_status('job', 'running')
+        job_status_manager.update_job_status('job', 'running', 'Trial 1', progress=0.5)
+        job_status_manager.flush_job_status('job')
+        self.assertEqual(self._on_disk('job')['progress'], 0.5)
+
+    def test_batched_updates_keep_fields_written_meanwhile(self):
+        job_status_manager.update_job_status('job', 'running')
+        job_status_manager.update_job_status('job', 'running', 'Trial 1')
+        job_status_manager.register_job_process('job', 7)
+        job_status_manager.register_job_process('job', 7) # Registered once
+        job_status_manager.flush_job_status()
+        status = self._on_disk('job')
+        self.assertEqual((status['message'], status['pids']), ('Trial 1', [7]))
+        job_status_manager.unregister_job_process('job', 7)
+        self.assertEqual(self._on_disk('job')['pids'], [])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -1,7 +1,10 @@
 
 import unittest
+import numpy as np
 import pandas as pd
+import lines
 from lines import find_swing_points, calculate_line_equation, find_support_resistance_lines, analyze_line_durations
+from lines import sweep_swing_points, fit_point_pairs, _sweep_swing_points_python
 
 class TestLines(unittest.TestCase):
 
@@ -91,5 +94,38 @@ class TestLines(unittest.TestCase):
         self.assertEqual(durations[0]['num_occurrences'], 1)
         self.assertAlmostEqual(durations[0]['avg_duration_seconds'], 240.0)
 
+    def test_sweep_matches_single_threshold_runs(self):
+        rng = np.random.default_rng(7)
+        prices = 100 + np.cumsum(rng.normal(0, 1, 400))
+        df = pd.DataFrame({'price': prices}, index=pd.date_range('2023-01-01', periods=len(prices), freq='30min', name='timestamp'))
+        percentages = [0.005, 0.01, 0.02, 0.05]
+
+        for pc, (high_bars, low_bars) in zip(percentages, sweep_swing_points(prices, percentages)):
+            swing_highs, swing_lows = find_swing_points(df, percentage_change=pc)
+            self.assertEqual(swing_highs['price'].tolist(), prices[high_bars].tolist())
+            self.assertEqual(swing_lows['price'].tolist(), prices[low_bars].tolist())
+
+    @unittest.skipUnless(lines.NATIVE_LINES_AVAILABLE, "lines_cython is not built")
+    def test_native_sweep_matches_python(self):
+        rng = np.random.default_rng(11)
+        prices = np.ascontiguousarray(100 + np.cumsum(rng.normal(0, 1, 300)))
+        percentages = np.array([i / 1000 for i in range(1, 101)])
+        native = lines.lines_cython.sweep_swing_points(prices, percentages, 2)
+        python = _sweep_swing_points_python(prices, percentages, 2)
+        for native_values, python_values in zip(native, python):
+            np.testing.assert_array_equal(native_values, python_values)
+
+    def test_fit_point_pairs_matches_linregress(self):
+        from scipy.stats import linregress
+        x = np.array([0.0, 60.0, 180.0, 420.0])
+        y = np.array([100.0, 103.0, 99.0, 99.0])
+        first, second, slope, intercept, r_value = fit_point_pairs(x, y)
+        self.assertEqual(list(zip(first.tolist(), second.tolist())), [(0, 1), (0, 2), (0, 3), (1, 2), (1, 3), (2, 3)])
+        for a, b, line_slope, line_intercept, line_r in zip(first, second, slope, intercept, r_value):
+            expected = linregress([x[a], x[b]], [y[a], y[b]])
+            self.assertAlmostEqual(line_slope, expected.slope)
+            self.assertAlmostEqual(line_intercept, expected.intercept)
+            self.assertAlmostEqual(line_r, expected.rvalue)
+
 if __name__ == '__main__':
     unittest.main()
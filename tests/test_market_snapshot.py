@@ -0,0 +1,82 @@
+import os
+import sys
+import json
+import shutil
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.market_snapshot import MarketSnapshot, get_snapshot, publish_snapshot
+
+def row(crypto_id, symbol, change, rank):
+    return {'id': crypto_id, 'symbol': symbol, 'name': crypto_id.title(), 'market_cap_rank': rank,
+            'price_change_percentage_24h': change, 'volatility_score': abs(change)}
+
+ROWS = [
+    row('bitcoin', 'BTC', 3.0, 1),
+    row('ethereum', 'ETH', -8.0, 2),
+    row('solana', 'SOL', 12.0, 5),
+    row('dogecoin', 'DOGE', -15.0, 9),
+    row('bittensor', 'TAO', 8.0, 30),
+    row('pepe', 'PEPE', 6.0, 40),
+]
+
+def reference_volatile(rows, min_volatility, limit):
+    # The list-based ranking the snapshot replaces
+    volatile = [r for r in rows if abs(r.get('price_change_percentage_24h', 0)) >= min_volatility]
+    volatile.sort(key=lambda r: r['volatility_score'], reverse=True)
+    return volatile[:limit]
+
+class TestMarketSnapshot(unittest.TestCase):
+
+    def setUp(self):
+        self.snapshot = MarketSnapshot(ROWS)
+
+    def test_volatile_matches_filter_and_sort(self):
+        for min_volatility, limit in [(5.0, 100), (5.0, 2), (8.0, 10), (20.0, 10), (0.0, 3)]:
+            self.assertEqual(self.snapshot.volatile(min_volatility, limit), reference_volatile(ROWS, min_volatility, limit))
+
+    def test_results_are_copies(self):
+        self.snapshot.volatile(5.0, 1)[0]['annotated'] = True
+
+        self.assertNotIn('annotated', self.snapshot.volatile(5.0, 1)[0])
+
+    def test_top_movers(self):
+        movers = self.snapshot.top_movers(2, min_volatility=5.0, limit=100)
+
+        self.assertEqual([r['id'] for r in movers['gainers']], ['solana', 'bittensor'])
+        # Losers keep the descending change order: the biggest loss comes last
+        self.assertEqual([r['id'] for r in movers['losers']], ['ethereum', 'dogecoin'])
+
+    def test_search_prefers_exact_matches(self):
+        results, exact = self.snapshot.search('bit', 10)
+        self.assertFalse(exact)
+        self.assertEqual([r['id'] for r in results], ['bitcoin', 'bittensor']) # By market cap rank
+
+        results, exact = self.snapshot.search('TAO', 10)
+        self.assertTrue(exact)
+        self.assertEqual([r['id'] for r in results], ['bittensor'])
+
+class TestSnapshotRegistry(unittest.TestCase):
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.cache_file = os.path.join(self.temp_dir, 'volatile_cryptos.json')
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_snapshot_follows_the_cache_file(self):
+        with open(self.cache_file, 'w') as f:
+            json.dump(ROWS, f)
+        snapshot = publish_snapshot(self.cache_file, ROWS)
+        self.assertIs(get_snapshot(self.cache_file), snapshot)
+
+        with open(self.cache_file, 'w') as f:
+            json.dump(ROWS[:2], f)
+        os.utime(self.cache_file, ns=(0, 0)) # A rewrite with a different mtime
+        self.assertIsNone(get_snapshot(self.cache_file))
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,104 @@
+import json
+import os
+import sys
+import tempfile
+import threading
+import unittest
+from pathlib import Path
+from unittest import mock
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core import job_status_manager, metrics
+from core.metrics import BUCKETS, MetricsRegistry
+
+class TestMetricsRegistry(unittest.TestCase):
+
+    def test_histogram_buckets_and_merge(self):
+        registry = MetricsRegistry()
+        registry.observe('stage', 0.0001)
+        registry.observe('stage', 0.3)
+        registry.observe('stage', 120.0)  # Past the last bound
+        worker = MetricsRegistry()
+        worker.observe('stage', 0.3)
+        worker.inc('indicator_cache.hits', 3)
+        worker.inc('indicator_cache.misses')
+        registry.merge(worker.snapshot())
+
+        snapshot = registry.snapshot()
+        buckets = snapshot['histograms']['stage']['buckets']
+        self.assertEqual(buckets[0], 1)
+        self.assertEqual(buckets[BUCKETS.index(0.5)], 2)
+        self.assertEqual(buckets[-1], 1)
+        self.assertEqual(snapshot['histograms']['stage']['count'], 4)
+        self.assertAlmostEqual(snapshot['histograms']['stage']['sum'], 120.6001)
+        self.assertEqual(snapshot['hit_ratios'], {'indicator_cache': 0.75})
+
+    def test_bound_registries_only_see_their_thread(self):
+        job = MetricsRegistry()
+        with metrics.bind(job):
+            metrics.inc('optimizer.trials')
+            other = threading.Thread(target=metrics.inc, args=('optimizer.trials',))
+            other.start()
+            other.join()
+        metrics.inc('optimizer.trials')  # Unbound again
+        self.assertEqual(job.counters, {'optimizer.trials': 1})
+
+    def test_prometheus_exposition(self):
+        registry = MetricsRegistry()
+        with metrics.bind(registry):
+            with metrics.timer('backtest.native_loop'):
+                pass
+            metrics.inc('optimizer.trials', 2)
+            metrics.set_gauge('rate_limiter.waiting', 3)
+        text = metrics.render_prometheus([({'job_id': 'j"1'}, registry.snapshot())])
+        lines = text.splitlines()
+        self.assertIn('# TYPE pricer_backtest_native_loop_seconds histogram', lines)
+        self.assertIn('pricer_backtest_native_loop_seconds_bucket{job_id="j\\"1",le="+Inf"} 1', lines)
+        self.assertIn('pricer_backtest_native_loop_seconds_count{job_id="j\\"1"} 1', lines)
+        self.assertIn('pricer_optimizer_trials_total{job_id="j\\"1"} 2', lines)
+        self.assertIn('# TYPE pricer_rate_limiter_waiting gauge', lines)
+        counts = [int(line.rsplit(' ', 1)[1]) for line in lines if line.startswith('pricer_backtest_native_loop_seconds_bucket')]
+        self.assertEqual(counts, sorted(counts))  # Cumulative
+        self.assertEqual(len(counts), len(BUCKETS) + 1)
+
+class TestPublishedMetrics(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.config = mock.Mock(DATA_DIR=self.tmp.name, METRICS_ENABLED=True, METRICS_PUBLISH_SECONDS=5.0, METRICS_RECENT_JOBS=1)
+        patches = [mock.patch.object(metrics, '_config', self.config),
+                   mock.patch.object(job_status_manager, 'JOB_STATUS_DIR', Path(self.tmp.name) / 'job_status')]
+        for patch in patches:
+            patch.start()
+            self.addCleanup(patch.stop)
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def test_processes_of_dead_pids_are_dropped(self):
+        directory = os.path.join(self.tmp.name, 'metrics')
+        os.makedirs(directory)
+        for name in ('rate_limiter-1', f'gone-{2 ** 22 + 1}', f'self-{os.getpid()}'):
+            with open(os.path.join(directory, name + '.json'), 'w') as f:
+                json.dump({'counters': {}}, f)
+        names = [name for name, _, _ in metrics.published_processes()]
+        self.assertEqual(names, ['rate_limiter'])  # PID 1 is alive; this process is served directly
+        self.assertFalse(os.path.exists(os.path.join(directory, f'gone-{2 ** 22 + 1}.json')))
+
+    def test_job_metrics_are_stored_in_the_status_file(self):
+        job_status_manager.update_job_status('running-job', 'running')
+        job_status_manager.update_job_status('old-job', 'completed')
+        job_status_manager.update_job_status('new-job', 'completed')
+        for job_id in ('running-job', 'old-job', 'new-job'):
+            with metrics.bind(metrics.job_registry(job_id)):
+                metrics.inc('optimizer.trials')
+            metrics.publish_job(job_id)
+        os.utime(job_status_manager._get_status_filepath('old-job'), (0, 0))
+
+        self.assertEqual(job_status_manager.get_job_status('new-job')['metrics']['counters'], {'optimizer.trials': 1})
+        # Running jobs are always exported; finished ones only up to METRICS_RECENT_JOBS
+        self.assertEqual(set(job_status_manager.recent_job_metrics(limit=1)), {'running-job', 'new-job'})
+
+if __name__ == '__main__':
+    unittest.main()
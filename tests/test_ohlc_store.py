@@ -0,0 +1,65 @@
+import os
+import sys
+import shutil
+import tempfile
+import unittest
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.ohlc_store import OHLCStore, records_to_dataframe
+
+BAR_MS = 30 * 60 * 1000
+
+def make_rows(start_bar, count, close_offset=0.0):
+    return [[(start_bar + i) * BAR_MS, 1.0, 2.0, 0.5, 100.0 + start_bar + i + close_offset] for i in range(count)]
+
+class TestOHLCStore(unittest.TestCase):
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.store = OHLCStore(self.temp_dir)
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_incremental_fetch_appends_only_new_candles(self):
+        self.assertEqual(self.store.merge('bitcoin', '30m', make_rows(0, 10)), 10)
+        size_before = os.path.getsize(self.store.path('bitcoin', '30m'))
+
+        added = self.store.merge('bitcoin', '30m', make_rows(5, 10, close_offset=0.5))
+
+        records = self.store.read('bitcoin', '30m')
+        self.assertEqual(added, 5)
+        self.assertEqual(len(records), 15)
+        self.assertGreater(os.path.getsize(self.store.path('bitcoin', '30m')), size_before)
+        self.assertTrue(np.all(np.diff(records['timestamp']) == BAR_MS))
+        # The previously last (still forming) candle is refreshed, older ones are kept
+        self.assertEqual(records['close'][9], 109.5)
+        self.assertEqual(records['close'][8], 108.0)
+
+    def test_backfill_rewrites_history_in_order(self):
+        self.store.merge('bitcoin', '30m', make_rows(10, 5))
+        added = self.store.merge('bitcoin', '30m', make_rows(0, 12))
+
+        records = self.store.read('bitcoin', '30m')
+        self.assertEqual(added, 10)
+        self.assertEqual(list(records['timestamp'] // BAR_MS), list(range(15)))
+
+    def test_range_read_is_a_read_only_view(self):
+        self.store.merge('bitcoin', '30m', make_rows(0, 20))
+
+        records = self.store.read('bitcoin', '30m', start_ms=5 * BAR_MS, end_ms=9 * BAR_MS)
+
+        self.assertEqual(list(records['timestamp'] // BAR_MS), [5, 6, 7, 8, 9])
+        self.assertFalse(records.flags.writeable)
+        df = records_to_dataframe(records)
+        self.assertEqual(list(df.columns), ['open', 'high', 'low', 'close'])
+        self.assertTrue(df.index.is_monotonic_increasing)
+
+    def test_missing_history_reads_empty(self):
+        self.assertEqual(len(self.store.read('ethereum', '4h')), 0)
+        self.assertIsNone(self.store.age_seconds('ethereum', '4h'))
+
+if __name__ == '__main__':
+    unittest.main()
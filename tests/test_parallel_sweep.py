@@ -0,0 +1,63 @@
+import os
+import sys
+import unittest
+import numpy as np
+import pandas as pd
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from backtester import Backtester, CYTHON_AVAILABLE
+from config import strategy_configs, DEFAULT_SPREAD_PERCENTAGE, DEFAULT_SLIPPAGE_PERCENTAGE
+from core.parallel_sweep import SharedIndicators, SharedIndicatorView, run_parameter_sweep, sweep_indicator_requests
+from indicators import Indicators, calculate_atr, calculate_macd
+from strategy import Strategy
+
+def _synthetic_ohlc(n_bars=400):
+    rng = np.random.default_rng(11)
+    close = 100 * np.exp(np.cumsum(rng.normal(0, 0.01, n_bars)))
+    return pd.DataFrame({'open': close, 'high': close * 1.01, 'low': close * 0.99, 'close': close},
+                        index=pd.date_range('2023-01-01', periods=n_bars, freq='30min'))
+
+class TestSharedIndicators(unittest.TestCase):
+
+    def test_view_serves_published_series_and_frames(self):
+        data = _synthetic_ohlc(50)
+        atr = calculate_atr(data, 14)
+        macd = calculate_macd(data, 26, 12, 9)
+        shared = SharedIndicators({('atr', (14,)): atr, ('macd', (12, 26, 9)): macd}, len(data))
+        try:
+            view = SharedIndicatorView(shared.descriptor(), data.index)
+            computed = []
+            np.testing.assert_array_equal(view.get_or_compute('atr', (14,), lambda: computed.append(1)).to_numpy(), atr.to_numpy())
+            pd.testing.assert_frame_equal(view.get_or_compute('macd', (12, 26, 9), lambda: computed.append(1)), macd, check_freq=False)
+            view.get_or_compute('atr', (7,), lambda: calculate_atr(data, 7)) # Not published: computed locally
+            self.assertEqual((view.hits, view.misses, computed), (2, 1, []))
+            del view
+        finally:
+            shared.close()
+
+    def test_requests_cover_the_stop_indicators(self):
+        keys = {(indicator, params) for indicator, params, _ in
+                sweep_indicator_requests(strategy_configs['EMA_Only'], {'atr_period': 10})}
+        self.assertIn(('atr', (10,)), keys)
+        self.assertIn(('adx', (14,)), keys)
+
+@unittest.skipUnless(CYTHON_AVAILABLE, "Cython backtester not built")
+class TestParameterSweep(unittest.TestCase):
+
+    def test_matches_serial_backtests(self):
+        data = _synthetic_ohlc()
+        grid = [{'short_ema_period': short, 'long_ema_period': long_, 'atr_period': atr,
+                 'spread_percentage': DEFAULT_SPREAD_PERCENTAGE, 'slippage_percentage': DEFAULT_SLIPPAGE_PERCENTAGE}
+                for short in (5, 9, 12) for long_ in (21, 26, 50) for atr in (10, 14)]
+        ranked = run_parameter_sweep(data, 'EMA_Only', grid, workers=2, top_n=3, chunk_size=4)
+
+        backtester = Backtester(Strategy(Indicators(), strategy_configs['EMA_Only']), None, data_fetcher=object())
+        backtester.set_data(data)
+        serial = sorted(((backtester.run_backtest(params)['final_capital'], -k) for k, params in enumerate(grid)), reverse=True)[:3]
+        self.assertEqual([params for params, _ in ranked], [grid[-neg_index] for _, neg_index in serial])
+        for (_, result), (final_capital, _) in zip(ranked, serial):
+            self.assertAlmostEqual(result['final_capital'], final_capital)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,71 @@
+import os
+import sys
+import unittest
+import numpy as np
+import pandas as pd
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from collections import OrderedDict
+
+from core import parallel_trials
+from core.parallel_trials import SharedOHLC, attach_shared_ohlc, get_worker_pool, discard_worker_pool
+
+class TestSharedOHLC(unittest.TestCase):
+
+    def test_round_trip_preserves_columns_and_index(self):
+        dates = pd.date_range('2023-01-01', periods=20, freq='30min', tz='UTC', name='timestamp')
+        rng = np.random.default_rng(3)
+        close = 100 + np.cumsum(rng.normal(0, 1, 20))
+        data = pd.DataFrame({'open': close, 'high': close + 1, 'low': close - 1, 'close': close}, index=dates)
+
+        shared = SharedOHLC(data)
+        try:
+            attached = attach_shared_ohlc(shared.descriptor())
+        finally:
+            shared.close()
+
+        pd.testing.assert_frame_equal(attached, data, check_freq=False)
+
+    def test_range_index_round_trip(self):
+        data = pd.DataFrame({'close': np.arange(5, dtype=np.float64)})
+        shared = SharedOHLC(data)
+        try:
+            attached = attach_shared_ohlc(shared.descriptor())
+        finally:
+            shared.close()
+
+        pd.testing.assert_frame_equal(attached, data)
+
+class TestWarmWorkerPool(unittest.TestCase):
+
+    def tearDown(self):
+        discard_worker_pool()
+
+    def test_pool_is_shared_per_settings(self):
+        pool = get_worker_pool(2, 1024)
+        self.assertIs(get_worker_pool(2, 1024), pool)
+        self.assertIsNot(get_worker_pool(3, 1024), pool)
+
+        discard_worker_pool(pool)
+        self.assertIsNot(get_worker_pool(2, 1024), pool)
+
+    def test_worker_keeps_recent_datasets(self):
+        parallel_trials._worker_state['datasets'] = OrderedDict()
+        shared = [SharedOHLC(pd.DataFrame({'close': np.arange(3, dtype=np.float64) + k}))
+                  for k in range(parallel_trials.WORKER_DATASETS + 1)]
+        try:
+            first = parallel_trials._worker_dataset(shared[0].descriptor())
+            self.assertIs(parallel_trials._worker_dataset(shared[0].descriptor()), first)
+            for block in shared[1:]:
+                parallel_trials._worker_dataset(block.descriptor())
+        finally:
+            for block in shared:
+                block.close()
+
+        datasets = parallel_trials._worker_state.pop('datasets')
+        self.assertEqual(len(datasets), parallel_trials.WORKER_DATASETS)
+        self.assertNotIn(shared[0].descriptor()['name'], datasets)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,85 @@
+import asyncio
+import os
+import sys
+import threading
+import time
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.rate_limiter import RateLimiter, request_key
+
+class TestRateLimiter(unittest.TestCase):
+
+    def setUp(self):
+        self.limiter = RateLimiter(requests_per_minute=2, seconds_per_request=0.05)
+        self.limiter.WINDOW_SECONDS = 0.3  # Shrink the 60s window so the test runs quickly
+
+    def tearDown(self):
+        self.limiter.shutdown()
+
+    def test_window_and_spacing_are_enforced(self):
+        call_times = []
+        def call():
+            call_times.append(time.monotonic())
+            return len(call_times)
+
+        futures = [self.limiter.submit_threadsafe(call) for _ in range(3)]
+        self.assertEqual(sorted(f.result(timeout=5) for f in futures), [1, 2, 3])
+        self.assertGreaterEqual(call_times[1] - call_times[0], 0.045)
+        # The third call needs the first token back
+        self.assertGreaterEqual(call_times[2] - call_times[0], 0.29)
+
+    def test_identical_inflight_requests_are_coalesced(self):
+        release = threading.Event()
+        calls = []
+        def fetch(url, params=None):
+            calls.append(url)
+            release.wait(5)
+            return {'url': url}
+
+        key = request_key(fetch, ('http://x',), {'params': {'a': 1}})
+        first = self.limiter.submit_threadsafe(fetch, 'http://x', coalesce_key=key, params={'a': 1})
+        while not calls:  # Wait until the first call is upstream
+            time.sleep(0.01)
+        second = self.limiter.submit_threadsafe(fetch, 'http://x', coalesce_key=key, params={'a': 1})
+        release.set()
+        self.assertEqual(first.result(timeout=5), second.result(timeout=5))
+        self.assertEqual(calls, ['http://x'])
+        self.assertEqual(self.limiter.stats()['coalesced_requests'], 1)
+
+    def test_errors_reach_every_caller(self):
+        def fail():
+            raise ValueError("upstream down")
+        with self.assertRaises(ValueError):
+            self.limiter.make_request(fail)
+
+    def test_retries_wait_on_the_loop_and_take_new_tokens(self):
+        class FlakyPolicy:
+            def delay(self, attempt, result=None, error=None):
+                return 0.01 if error is not None and attempt < 2 else None
+        limiter = RateLimiter(requests_per_minute=5, seconds_per_request=0.0, retry_policy=FlakyPolicy())
+        self.addCleanup(limiter.shutdown)
+        attempts = []
+        def flaky():
+            attempts.append(threading.current_thread().name)
+            if len(attempts) < 3:
+                raise ConnectionError("reset by peer")
+            return 'ok'
+
+        self.assertEqual(limiter.make_request(flaky), 'ok')
+        self.assertEqual(len(attempts), 3)
+        stats = limiter.stats()
+        self.assertEqual((stats['upstream_requests'], stats['retried_requests'], stats['tokens_available']), (3, 2, 2))
+
+    def test_async_callers_await_the_result(self):
+        async def main():
+            return await asyncio.gather(*(self.limiter.make_request_async(lambda i=i: i) for i in range(2)))
+        self.assertEqual(sorted(asyncio.run(main())), [0, 1])
+
+    def test_request_key_ignores_kwarg_order(self):
+        self.assertEqual(request_key(len, ('u',), {'params': {'a': 1, 'b': 2}, 'timeout': 30}),
+                         request_key(len, ('u',), {'timeout': 30, 'params': {'b': 2, 'a': 1}}))
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,63 @@
+import json
+import os
+import shutil
+import sys
+import tempfile
+import time
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from core.result_index import ResultIndex
+
+class TestResultIndex(unittest.TestCase):
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.index = ResultIndex(self.temp_dir)
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def _write(self, filename, kind, document, **keys):
+        path = os.path.join(self.temp_dir, filename)
+        self.index.write(path, kind, document, **keys)
+        return path
+
+    def test_history_is_newest_first_and_filtered(self):
+        self._write("backtest_bitcoin_EMA_Only_20240101_000000.json", 'backtest', {'n': 1}, crypto_id='bitcoin', strategy='EMA_Only')
+        self._write("backtest_ethereum_Strict_20240101_000001.json", 'backtest', {'n': 2}, crypto_id='ethereum', strategy='Strict')
+        self._write("backtest_bitcoin_Strict_20240101_000002.json", 'backtest', {'n': 3}, crypto_id='bitcoin', strategy='Strict')
+
+        self.assertEqual([e.document['n'] for e in self.index.query('backtest')], [3, 2, 1])
+        self.assertEqual([e.document['n'] for e in self.index.query('backtest', crypto_id='bitcoin')], [3, 1])
+        self.assertEqual([e.document['n'] for e in self.index.query('backtest', strategy='Strict', limit=1)], [3])
+
+    def test_top_by_profit_skips_missing_values(self):
+        for crypto, value in (('a', 1.5), ('b', None), ('c', 7.0), ('d', -2.0)):
+            self._write(f"best_params_{crypto}_EMA_Only.json", 'optimization',
+                        {'crypto': crypto, 'strategy': 'EMA_Only', 'best_value': value}, crypto_id=crypto, strategy='EMA_Only')
+        top = [e.crypto_id for e in self.index.query('optimization', order_by='profit')]
+        self.assertEqual(top, ['c', 'a', 'd'])
+
+    def test_lookup_by_record_id(self):
+        self._write("analysis_bitcoin_20240101_000000.json", 'analysis', {'analysis_id': 'abc'}, crypto_id='bitcoin')
+        found = list(self.index.query('analysis', record_id='abc'))
+        self.assertEqual(len(found), 1)
+        self.assertTrue(self.index.exists('analysis', 'bitcoin'))
+        self.assertFalse(self.index.exists('analysis', 'ethereum'))
+
+    def test_files_written_outside_the_index_are_picked_up(self):
+        time.sleep(0.01)  # Let the directory mtime move past the one recorded at startup
+        path = os.path.join(self.temp_dir, "best_params_solana_Strict.json")
+        with open(path, 'w') as f:
+            json.dump({'crypto': 'solana', 'strategy': 'Strict', 'best_value': 3.0}, f)
+
+        entries = list(ResultIndex(self.temp_dir).query('optimization'))
+        self.assertEqual([(e.crypto_id, e.strategy) for e in entries], [('solana', 'Strict')])
+
+        os.remove(path)
+        self.assertEqual(list(self.index.query('optimization')), [])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,92 @@
+import os
+import sys
+import unittest
+import numpy as np
+import pandas as pd
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import signal_program
+from config import strategy_configs
+from indicators import calculate_ema
+from signal_program import SERIES, COMPILED_STRATEGIES, compile_strategy, evaluate_numpy
+from strategy import get_trade_signal
+
+class TestCompileStrategy(unittest.TestCase):
+
+    def test_meta_signals_expand_into_or_clauses(self):
+        compiled = COMPILED_STRATEGIES['Combined_Trigger_Verifier']
+        long_entry, short_entry, long_exit, short_exit = compiled.clauses
+        self.assertEqual(long_entry, (
+            ('sma_crossover', 'ema_crossover', 'price_breaks_upper_band', 'price_crosses_middle_band_from_bottom'),
+            ('rsi_is_not_overbought',),
+        ))
+        self.assertEqual(long_exit, (
+            ('sma_crossunder', 'ema_crossunder', 'price_crosses_middle_band_from_top', 'rsi_is_overbought'),
+        ))
+        self.assertEqual(compiled.required_indicators, frozenset({'sma', 'ema', 'bbands', 'rsi'}))
+
+    def test_flattened_offsets_match_clauses(self):
+        for name, compiled in COMPILED_STRATEGIES.items():
+            with self.subTest(strategy=name):
+                self.assertEqual(len(compiled.output_offsets), 5)
+                self.assertEqual(compiled.clause_offsets[-1], len(compiled.opcodes))
+                self.assertEqual(compiled.output_offsets[-1], sum(len(clauses) for clauses in compiled.clauses))
+
+    def test_unknown_signals_are_skipped(self):
+        config = {'long_entry': ['no_such_signal'], 'short_entry': ['ema_crossunder', 'no_such_signal'],
+                  'long_exit': [], 'short_exit': []}
+        with self.assertLogs(level='WARNING'):
+            compiled = compile_strategy(dict(config, name='unknown_signals_test'))
+        self.assertEqual(compiled.clauses[0], ())
+        self.assertEqual(compiled.clauses[1], (('ema_crossunder',),))
+
+    def test_programs_are_memoized(self):
+        config = dict(strategy_configs['EMA_Only'])
+        self.assertIs(compile_strategy(config), COMPILED_STRATEGIES['EMA_Only'])
+
+class TestEvaluate(unittest.TestCase):
+
+    def setUp(self):
+        rng = np.random.default_rng(5)
+        n = 200
+        close = 100 + np.cumsum(rng.normal(0, 1, n))
+        self.df = pd.DataFrame({'open': close, 'high': close + rng.uniform(0, 1, n),
+                                'low': close - rng.uniform(0, 1, n), 'close': close},
+                               index=pd.date_range('2024-01-01', periods=n, freq='30min'))
+        self.series = rng.normal(50, 10, (len(SERIES), n))
+        self.series[:, :5] = np.nan  # Indicator warm-up
+        self.thresholds = np.array([60.0, 40.0, 45.0])
+
+    def test_ema_only_matches_direct_crossovers(self):
+        params = {'short_ema_period': 5, 'long_ema_period': 20}
+        long_entry, short_entry, long_exit, short_exit = get_trade_signal(self.df, strategy_configs['EMA_Only'], params)
+        short_ema = calculate_ema(self.df, 5)
+        long_ema = calculate_ema(self.df, 20)
+        crossover = (short_ema.shift(1) < long_ema.shift(1)) & (short_ema > long_ema)
+        crossunder = (short_ema.shift(1) > long_ema.shift(1)) & (short_ema < long_ema)
+        pd.testing.assert_series_equal(long_entry, crossover, check_names=False)
+        pd.testing.assert_series_equal(short_entry, crossunder, check_names=False)
+        pd.testing.assert_series_equal(long_exit, crossunder, check_names=False)
+        pd.testing.assert_series_equal(short_exit, crossover, check_names=False)
+
+    def test_outputs_without_clauses_are_false(self):
+        long_entry, short_entry, long_exit, short_exit = get_trade_signal(
+            self.df, strategy_configs['Debug_Single_Long_Entry'], {})
+        self.assertFalse(short_entry.any() or long_exit.any() or short_exit.any())
+
+    @unittest.skipUnless(signal_program.NATIVE_SIGNALS_AVAILABLE, "signals_cython is not built")
+    def test_native_kernel_matches_numpy(self):
+        # Every configured strategy, plus one single-signal program per base signal
+        programs = dict(COMPILED_STRATEGIES)
+        for signal_name, _ in signal_program.BASE_SIGNALS:
+            programs[signal_name] = compile_strategy({'long_entry': [signal_name], 'short_entry': [],
+                                                      'long_exit': [], 'short_exit': []})
+        for name, compiled in programs.items():
+            with self.subTest(strategy=name):
+                native = signal_program.signals_cython.evaluate_program(
+                    self.series, self.thresholds, compiled.opcodes, compiled.clause_offsets, compiled.output_offsets)
+                np.testing.assert_array_equal(native, evaluate_numpy(compiled, self.series, self.thresholds))
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,107 @@
+import os
+import sys
+import unittest
+import numpy as np
+import pandas as pd
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from config import strategy_configs
+from strategy import get_trade_signal
+from streaming_signals import StreamingSignalEvaluator, get_signal_stream, prune_signal_streams
+
+PARAMS = {
+    'short_sma_period': 5, 'long_sma_period': 12,
+    'short_ema_period': 5, 'long_ema_period': 12,
+    'rsi_period': 7, 'rsi_overbought': 60, 'rsi_oversold': 40,
+    'macd_fast_period': 6, 'macd_slow_period': 13, 'macd_signal_period': 4,
+    'bb_period': 10, 'bb_std_dev': 2.0,
+    'adx_period': 7, 'adx_threshold': 20,
+}
+
+def make_ohlc(n=80, seed=11):
+    rng = np.random.default_rng(seed)
+    close = 100 + np.cumsum(rng.normal(0, 1.5, n))
+    dates = pd.date_range('2024-01-01', periods=n, freq='30min', name='timestamp')
+    return pd.DataFrame({'open': close, 'high': close + rng.uniform(0.1, 1.0, n),
+                         'low': close - rng.uniform(0.1, 1.0, n), 'close': close}, index=dates)
+
+def batch_latest(df, strategy_name):
+    signals = get_trade_signal(df, strategy_configs[strategy_name], PARAMS)
+    return tuple(bool(signal.iloc[-1]) for signal in signals)
+
+class TestStreamingSignalEvaluator(unittest.TestCase):
+
+    def test_matches_batch_signals_on_every_bar(self):
+        df = make_ohlc()
+        for strategy_name in ('EMA_Only', 'Strict', 'BB_RSI', 'Combined_Trigger_Verifier'):
+            if strategy_name not in strategy_configs:
+                continue
+            with self.subTest(strategy=strategy_name):
+                stream = StreamingSignalEvaluator(strategy_configs[strategy_name], PARAMS)
+                for end in range(1, len(df) + 1):
+                    window = df.iloc[:end]
+                    stream.update(window)
+                    self.assertEqual(stream.latest_signals(), batch_latest(window, strategy_name),
+                                     f"bar {end - 1}")
+
+    def test_update_only_pushes_new_bars(self):
+        df = make_ohlc()
+        stream = StreamingSignalEvaluator(strategy_configs['EMA_Only'], PARAMS)
+        self.assertEqual(stream.update(df.iloc[:50]), 50)
+        self.assertEqual(stream.update(df.iloc[:50]), 0)
+        self.assertEqual(stream.update(df), len(df) - 50)
+        self.assertEqual(stream.bars, len(df))
+
+    def test_revised_last_candle_is_replaced(self):
+        df = make_ohlc()
+        stream = StreamingSignalEvaluator(strategy_configs['BB_RSI'], PARAMS)
+        stream.update(df)
+        revised = df.copy()
+        revised.iloc[-1, revised.columns.get_loc('close')] += 5.0
+        self.assertEqual(stream.update(revised), 1)
+        self.assertEqual(stream.bars, len(df))
+        self.assertEqual(stream.latest_signals(), batch_latest(revised, 'BB_RSI'))
+
+    def test_gap_restarts_the_evaluator_on_the_window(self):
+        df = make_ohlc()
+        stream = StreamingSignalEvaluator(strategy_configs['EMA_Only'], PARAMS)
+        stream.update(df.iloc[:30])
+
+        window = df.iloc[40:] # Candles 30 to 39 were never seen
+        self.assertEqual(stream.update(window), len(window))
+
+        self.assertEqual(stream.bars, len(window))
+        self.assertEqual(stream.latest_signals(), batch_latest(window, 'EMA_Only'))
+
+class TestSignalStreamRegistry(unittest.TestCase):
+
+    def tearDown(self):
+        prune_signal_streams(set())
+
+    def test_second_cycle_only_pushes_new_candles(self):
+        df = make_ohlc()
+        config = dict(strategy_configs['EMA_Only'], name='EMA_Only')
+
+        # Each analysis cycle builds a new engine, which looks the evaluator up again
+        first_cycle = get_signal_stream('bitcoin', config, dict(PARAMS))
+        self.assertEqual(first_cycle.update(df.iloc[:70]), 70)
+        second_cycle = get_signal_stream('bitcoin', config, dict(PARAMS))
+
+        self.assertIs(second_cycle, first_cycle)
+        window = df.iloc[2:]
+        self.assertEqual(second_cycle.update(window), len(df) - 70) # Sliding window: only the new candles
+        # Signals cover every candle pushed so far (df), not only the window of this cycle
+        self.assertEqual(second_cycle.bars, len(df))
+        self.assertEqual(second_cycle.latest_signals(), batch_latest(df, 'EMA_Only'))
+
+    def test_streams_are_keyed_by_params_and_pruned_by_crypto(self):
+        config = dict(strategy_configs['EMA_Only'], name='EMA_Only')
+        stream = get_signal_stream('bitcoin', config, PARAMS)
+
+        self.assertIsNot(get_signal_stream('bitcoin', config, dict(PARAMS, short_ema_period=6)), stream)
+        prune_signal_streams({'ethereum'})
+        self.assertIsNot(get_signal_stream('bitcoin', config, PARAMS), stream)
+
+if __name__ == '__main__':
+    unittest.main()
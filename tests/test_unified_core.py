@@ -360,6 +360,107 @@ class TestBayesianOptimizer(unittest.TestCase):
         # mock_job_manager.register_job_process.assert_called_with('test-job-123', 12345)
         # mock_job_manager.unregister_job_process.assert_called_with('test-job-123', 12345)
     
+    @patch('core.optimizer.job_status_manager')
+    @patch('core.backtester_wrapper.BacktesterWrapper.run_single_backtest')
+    def test_objective_reports_checkpoints_while_backtest_runs(self, mock_run_single_backtest, mock_job_manager):
+        """Each checkpoint is reported as the backtest runs and the pruner's verdict is returned to it."""
+        mock_job_manager.is_job_stop_requested.return_value = False
+        mock_trial = MagicMock()
+        mock_trial.number = 3
+        mock_trial.should_prune.side_effect = [False, True]
+
+        def run_single_backtest(**kwargs):
+            verdicts = [kwargs['on_checkpoint'](1, 99.0), kwargs['on_checkpoint'](2, 95.0)]
+            self.assertEqual(verdicts, [False, True])
+            return {'success': True, 'final_capital': 90.0, 'equity_checkpoints': [99.0, 95.0, 90.0]}
+        mock_run_single_backtest.side_effect = run_single_backtest
+        self.optimizer.param_manager.suggest_parameters = MagicMock(return_value={'atr_period': 14})
+        self.optimizer.config.OPTIMIZER_PRUNER = 'median'
+
+        value = self.optimizer._objective_function(mock_trial, 'bitcoin', 'EMA_Only', 'test-job-123')
+
+        self.assertEqual(value, 90.0)
+        # The last checkpoint is reported with the result
+        self.assertEqual([c.args for c in mock_trial.report.call_args_list], [(99.0, 1), (95.0, 2), (90.0, 3)])
+        self.assertGreater(mock_run_single_backtest.call_args.kwargs['checkpoints'], 0)
+
+    @patch('core.optimizer.job_status_manager')
+    @patch('core.backtester_wrapper.BacktesterWrapper.run_single_backtest')
+    def test_objective_raises_trial_pruned_for_stopped_backtest(self, mock_run_single_backtest, mock_job_manager):
+        """A backtest stopped at a checkpoint ends the trial as pruned rather than failed."""
+        import optuna
+        mock_job_manager.is_job_stop_requested.return_value = False
+        mock_run_single_backtest.return_value = {
+            'success': False,
+            'pruned': True,
+            'stopped_at_checkpoint': 2,
+            'bars_simulated': 200,
+            'equity_checkpoints': [99.0, 95.0]
+        }
+        self.optimizer.param_manager.suggest_parameters = MagicMock(return_value={'atr_period': 14})
+        mock_trial = MagicMock()
+        mock_trial.number = 5
+        self.optimizer.config.OPTIMIZER_PRUNER = 'median'
+
+        with self.assertRaises(optuna.TrialPruned):
+            self.optimizer._objective_function(mock_trial, 'bitcoin', 'EMA_Only', 'test-job-123')
+
+    @patch('core.optimizer.job_status_manager')
+    @patch('core.backtester_wrapper.BacktesterWrapper.run_single_backtest')
+    def test_objective_stores_scalar_summary_in_study(self, mock_run_single_backtest, mock_job_manager):
+        """Trials keep only scalar statistics in the study; the full result stays with the run."""
+        mock_job_manager.is_job_stop_requested.return_value = False
+        full_result = {
+            'success': True,
+            'final_capital': 120.0,
+            'total_profit_percentage': 20.0,
+            'equity_checkpoints': [105.0, 120.0],
+            'metrics': {'backtest.native_loop': {'count': 1}}
+        }
+        mock_run_single_backtest.return_value = full_result
+        self.optimizer.param_manager.suggest_parameters = MagicMock(return_value={'atr_period': 14})
+        mock_trial = MagicMock()
+        mock_trial.number = 4
+        trial_results = {}
+
+        self.optimizer._objective_function(mock_trial, 'bitcoin', 'EMA_Only', 'test-job-123', trial_results=trial_results)
+
+        mock_trial.set_user_attr.assert_any_call("backtest_summary", {
+            'success': True, 'final_capital': 120.0, 'total_profit_percentage': 20.0})
+        self.assertIs(trial_results[4], full_result)
+
+    def test_warm_start_enqueues_saved_and_top_archived_trials(self):
+        """The best archived parameter sets are re-evaluated in the run's own study."""
+        import optuna
+        self.optimizer.config.OPTIMIZER_STUDY_STORAGE = f"sqlite:///{os.path.join(self.temp_dir, 'studies.db')}"
+        self.optimizer.config.OPTIMIZER_WARM_START_TRIALS = 2
+        storage = self.optimizer._get_study_storage()
+        archive = optuna.create_study(direction='maximize', storage=storage,
+                                      study_name=self.optimizer._archive_study_name('bitcoin', 'EMA_Only'))
+        distributions = {'atr_period': optuna.distributions.IntDistribution(5, 30)}
+        for period, value in ((10, 101.0), (20, 130.0), (30, 90.0)):
+            archive.add_trial(optuna.trial.create_trial(params={'atr_period': period}, distributions=distributions, value=value))
+        with open(os.path.join(self.temp_dir, 'best_params_bitcoin_EMA_Only.json'), 'w') as f:
+            json.dump({'best_params': {'atr_period': 14}}, f)
+        study = optuna.create_study(direction='maximize')
+
+        self.optimizer._warm_start(study, archive, 'bitcoin', 'EMA_Only')
+
+        waiting = study.get_trials(states=(optuna.trial.TrialState.WAITING,))
+        self.assertEqual([t.system_attrs['fixed_params'] for t in waiting], [{'atr_period': 14}, {'atr_period': 20}])
+        # Archived values rank the candidates but are not trials of the run's study
+        self.assertEqual(study.get_trials(states=(optuna.trial.TrialState.COMPLETE,)), [])
+
+    def test_archive_study_name_includes_objective_fingerprint(self):
+        """Trials scored with other walk-forward settings go to another archive."""
+        self.optimizer.config.OPTIMIZER_WALK_FORWARD_WINDOWS = 0
+        self.optimizer.config.OPTIMIZER_WALK_FORWARD_STD_PENALTY = 0.5
+        plain = self.optimizer._archive_study_name('bitcoin', 'EMA_Only')
+        self.optimizer.config.OPTIMIZER_WALK_FORWARD_WINDOWS = 4
+
+        self.assertNotEqual(self.optimizer._archive_study_name('bitcoin', 'EMA_Only'), plain)
+        self.assertTrue(plain.endswith('_wf0_p0.5'))
+
     def test_save_and_load_results(self):
         """Test results saving and loading."""
         # Create test results
@@ -183,6 +183,18 @@ class TestBacktester(unittest.TestCase):
         self.assertIsInstance(backtester, Backtester)
         self.assertEqual(backtester.initial_capital, 100.0)
 
+    def test_checkpoint_interval_keeps_slice_count(self):
+        """Checkpoint slices never outnumber the requested checkpoints"""
+        from backtester import checkpoint_interval
+
+        self.assertEqual(checkpoint_interval(105, 10), 11)
+        self.assertEqual(checkpoint_interval(100, 10), 10)
+        self.assertEqual(checkpoint_interval(5, 10), 1)
+        self.assertEqual(checkpoint_interval(100, 0), 0)
+        for n in (5, 99, 100, 101, 1999):
+            every = checkpoint_interval(n, 10)
+            self.assertLessEqual(-(-n // every), 10)
+
 class TestConfiguration(unittest.TestCase):
     """Test configuration validity"""
     
@@ -60,7 +60,8 @@ class BacktestAPI(Resource):
             "crypto_id": "bitcoin",
             "strategy_name": "EMA_Only",
             "parameters": {...},
-            "timeframe": "7d"
+            "timeframe": "7d",
+            "include_trades": false
         }
 
         Expected JSON body for optimization:
@@ -86,6 +87,7 @@ class BacktestAPI(Resource):
                 parameters = data.get('parameters', {})
                 timeframe = data.get('timeframe', '7d')
                 interval = data.get('interval', '30m')
+                include_trades = bool(data.get('include_trades', False))
 
                 if not crypto_id or not strategy_name:
                     return {'error': 'crypto_id and strategy_name are required for backtest'}, 400
@@ -95,7 +97,8 @@ class BacktestAPI(Resource):
                     strategy_name=strategy_name,
                     parameters=parameters,
                     timeframe=timeframe,
-                    interval=interval
+                    interval=interval,
+                    include_trades=include_trades
                 )
                 return {'action': 'backtest', 'result': result}
 
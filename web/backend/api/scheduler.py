@@ -109,7 +109,8 @@ class JobAPI(Resource):
                 'next_run_time': str(job.next_run_time),
                 'status': job_status.get('status', 'unknown'),
                 'message': job_status.get('message', ''),
-                'log_path': job_status.get('log_path')
+                'log_path': job_status.get('log_path'),
+                'metrics': job_status.get('metrics') # Stage timings and counters, see core/metrics.py
             }
         return {'error': 'Job not found'}, 404
 
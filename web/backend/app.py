@@ -9,7 +9,7 @@ import sqlite3
 from datetime import datetime
 import threading
 import uuid
-from flask import Flask, jsonify, request, send_from_directory, g
+from flask import Flask, Response, jsonify, request, send_from_directory, g
 from flask_restful import Api
 from dotenv import load_dotenv
 from flask_compress import Compress
@@ -29,6 +29,7 @@ from core.rate_limiter_process import start_rate_limiter_process # Add this (Mov
 load_dotenv(dotenv_path=os.path.join(os.path.dirname(__file__), '.env'), override=True)
 
 from core import job_status_manager
+from core import metrics
 
 from core.data_fetcher import DataFetcher
 from core.rate_limiter import get_shared_rate_limiter
@@ -158,6 +159,17 @@ def health_check():
             'timestamp': datetime.now().isoformat()
         }), 500
 
+# Metrics endpoint (Prometheus text format)
+@app.route('/api/metrics')
+@requires_auth('read:metrics')
+def prometheus_metrics():
+    """Stage timings, counters and gauges of this process, the rate limiter process and recent jobs."""
+    try:
+        return Response(metrics.render_prometheus(metrics.collect_sources()), mimetype='text/plain; version=0.0.4')
+    except Exception as e:
+        logger.error(f"Error rendering metrics: {e}")
+        return jsonify({'error': 'Failed to render metrics'}), 500
+
 # Auth test endpoint
 @app.route('/api/auth/test')
 @requires_auth('read:auth_test')
@@ -109,8 +109,9 @@ const TraderActivityLog: React.FC = () => {
       setIsConnected(false);
     });
 
-    socket.on('trader_activity', (data: Activity) => {
-      setActivities(prev => [data, ...prev.slice(0, 99)]); // Keep last 100 activities
+    socket.on('trader_activity_batch', (batch: Activity[]) => {
+      // Batches arrive oldest first; the list shows the newest on top
+      setActivities(prev => [...batch.slice().reverse(), ...prev].slice(0, 100)); // Keep last 100 activities
     });
 
     return () => {